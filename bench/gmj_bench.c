@@ -0,0 +1,759 @@
+#if !defined(_WIN32) && !defined(_XOPEN_SOURCE)
+#define _XOPEN_SOURCE 700
+#endif
+
+#include "godot_mujoco/gmj_bridge.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/* Headless benchmark for the bridge. Generates the sphere scenes of
+   example/scripts/PhysicsBenchmark.cs plus articulated creature scenes and
+   measures, through the public API only:
+     - single-data step throughput and mjData size per scene,
+     - per-call cost of the slice getters/setters against a raw view copy,
+     - batch throughput across thread-pool sizes,
+     - batched raycast throughput with a torso-mounted ray fan.
+   Results are written as JSON (stdout or --out) so runs can be diffed
+   between releases; progress goes to stderr. */
+
+#define GMJ_BENCH_SCHEMA 1
+#define GMJ_BENCH_MAX_SCENES 8
+#define GMJ_BENCH_MAX_RESULTS 64
+
+typedef struct bench_text {
+  char* chars;
+  size_t length;
+  size_t capacity;
+} bench_text;
+
+typedef struct bench_options {
+  const char* out_path;
+  double duration;
+  int envs;
+  int quick;
+} bench_options;
+
+typedef struct bench_scene {
+  char name[32];
+  int creature;
+  gmj_model* model;
+  int nq;
+  int nv;
+  int nu;
+  int nbody;
+} bench_scene;
+
+typedef struct bench_step_result {
+  const bench_scene* scene;
+  long long steps;
+  double seconds;
+  long long data_bytes;
+  long long arena_peak_bytes;
+  int ncon_max;
+} bench_step_result;
+
+typedef struct bench_ffi_result {
+  const bench_scene* scene;
+  const char* api;
+  int count;
+  long long calls;
+  double seconds;
+} bench_ffi_result;
+
+typedef struct bench_batch_result {
+  const bench_scene* scene;
+  int envs;
+  int threads;
+  long long env_steps;
+  double seconds;
+  long long bytes_per_env;
+} bench_batch_result;
+
+typedef struct bench_ray_result {
+  const bench_scene* scene;
+  int envs;
+  int threads;
+  int rays_per_env;
+  long long rays;
+  double seconds;
+} bench_ray_result;
+
+typedef enum bench_slice_op {
+  BENCH_GET_QPOS = 0,
+  BENCH_SET_QPOS,
+  BENCH_GET_QVEL,
+  BENCH_SET_QVEL,
+  BENCH_GET_CTRL,
+  BENCH_SET_CTRL,
+  BENCH_GET_QPOS_F32,
+  BENCH_SET_CTRL_F32,
+  BENCH_VIEW_COPY
+} bench_slice_op;
+
+static const char* const bench_slice_names[] = {
+    "gmj_get_qpos_slice", "gmj_set_qpos_slice", "gmj_get_qvel_slice",
+    "gmj_set_qvel_slice", "gmj_get_ctrl_slice", "gmj_set_ctrl_slice",
+    "gmj_get_qpos_slice_f32", "gmj_set_ctrl_slice_f32", "view_memcpy"};
+
+static bench_scene bench_scenes[GMJ_BENCH_MAX_SCENES];
+static int bench_scene_count = 0;
+static bench_step_result bench_steps[GMJ_BENCH_MAX_RESULTS];
+static int bench_step_count = 0;
+static bench_ffi_result bench_ffi[GMJ_BENCH_MAX_RESULTS];
+static int bench_ffi_count = 0;
+static bench_batch_result bench_batches[GMJ_BENCH_MAX_RESULTS];
+static int bench_batch_count = 0;
+static bench_ray_result bench_rays[GMJ_BENCH_MAX_RESULTS];
+static int bench_ray_count = 0;
+static volatile double bench_sink = 0.0;
+
+#if defined(_WIN32)
+static double bench_now_seconds(void) {
+  LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+  return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
+#else
+static double bench_now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+#endif
+
+static void bench_fail(const char* what) {
+  fprintf(stderr, "gmj_bench: %s: %s\n", what, gmj_last_mujoco_error());
+  exit(1);
+}
+
+static void bench_append(bench_text* text, const char* format, ...) {
+  for (;;) {
+    const size_t room = text->capacity - text->length;
+    va_list args;
+    int written = 0;
+    va_start(args, format);
+    written = vsnprintf(text->chars + text->length, room, format, args);
+    va_end(args);
+    if (written < 0) {
+      fprintf(stderr, "gmj_bench: format failed\n");
+      exit(1);
+    }
+    if ((size_t)written < room) {
+      text->length += (size_t)written;
+      return;
+    }
+    text->capacity = text->capacity * 2 + (size_t)written + 1;
+    text->chars = (char*)realloc(text->chars, text->capacity);
+    if (text->chars == NULL) {
+      fprintf(stderr, "gmj_bench: out of memory\n");
+      exit(1);
+    }
+  }
+}
+
+/* Same layout as PhysicsBenchmark.BuildMujocoXml: a cube of free spheres
+   0.3 apart above a plane. */
+static void bench_sphere_xml(bench_text* text, int count) {
+  const int side = (int)ceil(cbrt((double)count));
+  int i = 0;
+  bench_append(text, "<mujoco model=\"benchmark_%d\">\n", count);
+  bench_append(text,
+               "  <option timestep=\"0.0166666667\" gravity=\"0 0 -9.81\"/>\n"
+               "  <worldbody>\n"
+               "    <geom type=\"plane\" size=\"80 80 0.1\"/>\n");
+  for (i = 0; i < count; ++i) {
+    const int x = i % side;
+    const int y = (i / side) % side;
+    const int z = i / (side * side);
+    bench_append(text, "    <body pos=\"%.3f %.3f %.3f\">\n",
+                 (x - side / 2) * 0.30, (y - side / 2) * 0.30,
+                 1.2 + z * 0.24);
+    bench_append(text,
+                 "      <freejoint/>\n"
+                 "      <geom type=\"sphere\" size=\"0.1\"/>\n"
+                 "    </body>\n");
+  }
+  bench_append(text, "  </worldbody>\n</mujoco>\n");
+}
+
+/* A free-floating torso with legs spread evenly around it. Each leg has a
+   hip yaw, hip pitch and knee hinge, all motor driven. */
+static void bench_creature_xml(bench_text* text, int legs) {
+  const double pi = 3.14159265358979323846;
+  int leg = 0;
+  bench_append(text,
+               "<mujoco model=\"creature_%d\">\n"
+               "  <option timestep=\"0.005\"/>\n"
+               "  <default>\n"
+               "    <joint type=\"hinge\" limited=\"true\" damping=\"0.5\" "
+               "armature=\"0.01\"/>\n"
+               "    <geom density=\"500\" friction=\"1 0.1 0.1\"/>\n"
+               "    <motor ctrllimited=\"true\" ctrlrange=\"-1 1\" "
+               "gear=\"30\"/>\n"
+               "  </default>\n"
+               "  <worldbody>\n"
+               "    <geom type=\"plane\" size=\"20 20 0.1\"/>\n"
+               "    <body name=\"torso\" pos=\"0 0 0.6\">\n"
+               "      <freejoint/>\n"
+               "      <geom type=\"sphere\" size=\"0.25\"/>\n",
+               legs);
+  for (leg = 0; leg < legs; ++leg) {
+    const double angle = 2.0 * pi * leg / legs;
+    const double c = cos(angle);
+    const double s = sin(angle);
+    bench_append(text, "      <body name=\"hip_%d\" pos=\"%.4f %.4f 0\">\n",
+                 leg, 0.25 * c, 0.25 * s);
+    bench_append(text,
+                 "        <joint name=\"hip_yaw_%d\" axis=\"0 0 1\" "
+                 "range=\"-40 40\"/>\n",
+                 leg);
+    bench_append(text,
+                 "        <joint name=\"hip_pitch_%d\" axis=\"%.4f %.4f 0\" "
+                 "range=\"-60 60\"/>\n",
+                 leg, -s, c);
+    bench_append(text,
+                 "        <geom type=\"capsule\" fromto=\"0 0 0 %.4f %.4f 0\" "
+                 "size=\"0.05\"/>\n",
+                 0.3 * c, 0.3 * s);
+    bench_append(text, "        <body pos=\"%.4f %.4f 0\">\n", 0.3 * c,
+                 0.3 * s);
+    bench_append(text,
+                 "          <joint name=\"knee_%d\" axis=\"%.4f %.4f 0\" "
+                 "range=\"-90 0\"/>\n",
+                 leg, -s, c);
+    bench_append(text,
+                 "          <geom type=\"capsule\" "
+                 "fromto=\"0 0 0 %.4f %.4f -0.3\" size=\"0.04\"/>\n"
+                 "        </body>\n"
+                 "      </body>\n",
+                 0.2 * c, 0.2 * s);
+  }
+  bench_append(text, "    </body>\n  </worldbody>\n  <actuator>\n");
+  for (leg = 0; leg < legs; ++leg) {
+    bench_append(text,
+                 "    <motor joint=\"hip_yaw_%d\"/>\n"
+                 "    <motor joint=\"hip_pitch_%d\"/>\n"
+                 "    <motor joint=\"knee_%d\"/>\n",
+                 leg, leg, leg);
+  }
+  bench_append(text, "  </actuator>\n</mujoco>\n");
+}
+
+static void bench_add_scene(const char* name, int creature, int size) {
+  bench_scene* scene = &bench_scenes[bench_scene_count];
+  bench_text text = {NULL, 0, 4096};
+  char error[512] = {0};
+
+  text.chars = (char*)malloc(text.capacity);
+  if (text.chars == NULL) {
+    fprintf(stderr, "gmj_bench: out of memory\n");
+    exit(1);
+  }
+  if (creature) {
+    bench_creature_xml(&text, size);
+  } else {
+    bench_sphere_xml(&text, size);
+  }
+  fprintf(stderr, "gmj_bench: compiling %s\n", name);
+  scene->model =
+      gmj_model_load_xml_string(text.chars, NULL, error, sizeof(error));
+  free(text.chars);
+  if (scene->model == NULL) {
+    fprintf(stderr, "gmj_bench: %s failed to load: %s\n", name,
+            error[0] != '\0' ? error : gmj_last_mujoco_error());
+    exit(1);
+  }
+
+  snprintf(scene->name, sizeof(scene->name), "%s", name);
+  scene->creature = creature;
+  scene->nq = gmj_nq(scene->model);
+  scene->nv = gmj_nv(scene->model);
+  scene->nu = gmj_nu(scene->model);
+  scene->nbody = gmj_nbody(scene->model);
+  ++bench_scene_count;
+}
+
+/* Open-loop gait so creatures keep making and breaking contacts. */
+static void bench_fill_ctrl(double* ctrl, int nu, int envs, double t) {
+  int e = 0;
+  int i = 0;
+  for (e = 0; e < envs; ++e) {
+    for (i = 0; i < nu; ++i) {
+      ctrl[e * nu + i] = 0.8 * sin(6.0 * t + 0.7 * i + 0.3 * e);
+    }
+  }
+}
+
+static void bench_step_scene(const bench_scene* scene, double duration) {
+  bench_step_result* result = &bench_steps[bench_step_count];
+  gmj_data* data = gmj_data_create(scene->model);
+  double* ctrl = NULL;
+  gmj_stats stats;
+  double start = 0.0;
+  double elapsed = 0.0;
+  long long steps = 0;
+
+  if (data == NULL) {
+    bench_fail("gmj_data_create");
+  }
+  if (scene->nu > 0) {
+    ctrl = (double*)calloc((size_t)scene->nu, sizeof(double));
+  }
+
+  /* Warm up so the arena and contact buffers reach steady state. */
+  if (gmj_step(scene->model, data, 10) != GMJ_OK) {
+    bench_fail("gmj_step");
+  }
+  gmj_data_reset_stats(data);
+
+  start = bench_now_seconds();
+  while (elapsed < duration) {
+    if (ctrl != NULL) {
+      bench_fill_ctrl(ctrl, scene->nu, 1, elapsed);
+      gmj_set_ctrl_slice(scene->model, data, 0, scene->nu, ctrl);
+    }
+    if (gmj_step(scene->model, data, 1) != GMJ_OK) {
+      bench_fail("gmj_step");
+    }
+    ++steps;
+    elapsed = bench_now_seconds() - start;
+  }
+
+  if (gmj_data_stats(scene->model, data, &stats) != GMJ_OK) {
+    bench_fail("gmj_data_stats");
+  }
+  result->scene = scene;
+  result->steps = steps;
+  result->seconds = elapsed;
+  result->data_bytes = stats.buffer_bytes + stats.arena_bytes;
+  result->arena_peak_bytes = stats.arena_peak_bytes;
+  result->ncon_max = stats.ncon_max;
+  ++bench_step_count;
+  fprintf(stderr, "gmj_bench: %-16s %12.1f steps/s\n", scene->name,
+          (double)steps / elapsed);
+
+  free(ctrl);
+  gmj_data_free(data);
+}
+
+static gmj_error_code bench_slice_call(const bench_scene* scene,
+                                       gmj_data* data, bench_slice_op op,
+                                       int count, double* values,
+                                       float* values_f32,
+                                       const gmj_view* view) {
+  switch (op) {
+    case BENCH_GET_QPOS:
+      return gmj_get_qpos_slice(scene->model, data, 0, count, values);
+    case BENCH_SET_QPOS:
+      return gmj_set_qpos_slice(scene->model, data, 0, count, values);
+    case BENCH_GET_QVEL:
+      return gmj_get_qvel_slice(scene->model, data, 0, count, values);
+    case BENCH_SET_QVEL:
+      return gmj_set_qvel_slice(scene->model, data, 0, count, values);
+    case BENCH_GET_CTRL:
+      return gmj_get_ctrl_slice(scene->model, data, 0, count, values);
+    case BENCH_SET_CTRL:
+      return gmj_set_ctrl_slice(scene->model, data, 0, count, values);
+    case BENCH_GET_QPOS_F32:
+      return gmj_get_qpos_slice_f32(scene->model, data, 0, count, values_f32);
+    case BENCH_SET_CTRL_F32:
+      return gmj_set_ctrl_slice_f32(scene->model, data, 0, count, values_f32);
+    case BENCH_VIEW_COPY:
+      memcpy(values, view->values, (size_t)count * sizeof(double));
+      return GMJ_OK;
+  }
+  return GMJ_ERR_INVALID_ARGUMENT;
+}
+
+/* Times one slice API in blocks of calls so the clock read stays out of
+   the per-call figure. view_memcpy copies the same qpos range through a
+   zero-copy view and is the floor the slice calls are compared against. */
+static void bench_slice_api(const bench_scene* scene, gmj_data* data,
+                            bench_slice_op op, int count, double duration) {
+  enum { block = 1024 };
+  bench_ffi_result* result = &bench_ffi[bench_ffi_count];
+  double* values = (double*)calloc((size_t)count + 1, sizeof(double));
+  float* values_f32 = (float*)calloc((size_t)count + 1, sizeof(float));
+  gmj_view view;
+  double start = 0.0;
+  double elapsed = 0.0;
+  long long calls = 0;
+  int i = 0;
+
+  if (values == NULL || values_f32 == NULL) {
+    fprintf(stderr, "gmj_bench: out of memory\n");
+    exit(1);
+  }
+  if (gmj_data_view(scene->model, data, GMJ_FIELD_QPOS, &view) != GMJ_OK) {
+    bench_fail("gmj_data_view");
+  }
+  if (op == BENCH_SET_QPOS) {
+    /* Write back what is there so the state stays valid. */
+    gmj_get_qpos_slice(scene->model, data, 0, count, values);
+  }
+
+  start = bench_now_seconds();
+  while (elapsed < duration) {
+    for (i = 0; i < block; ++i) {
+      if (bench_slice_call(scene, data, op, count, values, values_f32,
+                           &view) != GMJ_OK) {
+        bench_fail(bench_slice_names[op]);
+      }
+    }
+    bench_sink += values[0] + values_f32[0];
+    calls += block;
+    elapsed = bench_now_seconds() - start;
+  }
+
+  result->scene = scene;
+  result->api = bench_slice_names[op];
+  result->count = count;
+  result->calls = calls;
+  result->seconds = elapsed;
+  ++bench_ffi_count;
+  free(values);
+  free(values_f32);
+}
+
+static void bench_ffi_scene(const bench_scene* scene, double duration) {
+  gmj_data* data = gmj_data_create(scene->model);
+  const double slice = duration / 10.0;
+  if (data == NULL) {
+    bench_fail("gmj_data_create");
+  }
+
+  /* One element isolates the fixed cost of a call; full length adds the
+     copy itself. */
+  bench_slice_api(scene, data, BENCH_GET_QPOS, 1, slice);
+  bench_slice_api(scene, data, BENCH_GET_QPOS, scene->nq, slice);
+  bench_slice_api(scene, data, BENCH_SET_QPOS, scene->nq, slice);
+  bench_slice_api(scene, data, BENCH_GET_QVEL, scene->nv, slice);
+  bench_slice_api(scene, data, BENCH_SET_QVEL, scene->nv, slice);
+  if (scene->nu > 0) {
+    bench_slice_api(scene, data, BENCH_GET_CTRL, scene->nu, slice);
+    bench_slice_api(scene, data, BENCH_SET_CTRL, scene->nu, slice);
+    bench_slice_api(scene, data, BENCH_SET_CTRL_F32, scene->nu, slice);
+  }
+  bench_slice_api(scene, data, BENCH_GET_QPOS_F32, scene->nq, slice);
+  bench_slice_api(scene, data, BENCH_VIEW_COPY, scene->nq, slice);
+  gmj_data_free(data);
+}
+
+static void bench_batch_threads(const bench_scene* scene, int envs,
+                                int threads, double duration) {
+  enum { steps_per_call = 4 };
+  bench_batch_result* result = &bench_batches[bench_batch_count];
+  gmj_batch* batch = gmj_batch_create(scene->model, envs);
+  gmj_thread_pool* pool = gmj_thread_pool_create(threads);
+  double* ctrl = (double*)calloc((size_t)envs * (size_t)scene->nu + 1,
+                                 sizeof(double));
+  gmj_stats stats;
+  double start = 0.0;
+  double elapsed = 0.0;
+  long long calls = 0;
+
+  if (batch == NULL || pool == NULL || ctrl == NULL) {
+    bench_fail("gmj_batch_create");
+  }
+  if (gmj_batch_set_thread_pool(batch, pool) != GMJ_OK ||
+      gmj_batch_step(batch, ctrl, steps_per_call, NULL, NULL) != GMJ_OK) {
+    bench_fail("gmj_batch_step");
+  }
+
+  start = bench_now_seconds();
+  while (elapsed < duration) {
+    bench_fill_ctrl(ctrl, scene->nu, envs, elapsed);
+    if (gmj_batch_step(batch, ctrl, steps_per_call, NULL, NULL) != GMJ_OK) {
+      bench_fail("gmj_batch_step");
+    }
+    ++calls;
+    elapsed = bench_now_seconds() - start;
+  }
+
+  if (gmj_batch_stats(batch, &stats) != GMJ_OK) {
+    bench_fail("gmj_batch_stats");
+  }
+  result->scene = scene;
+  result->envs = envs;
+  result->threads = gmj_thread_pool_size(pool);
+  result->env_steps = calls * steps_per_call * envs;
+  result->seconds = elapsed;
+  result->bytes_per_env = (stats.buffer_bytes + stats.arena_bytes) / envs;
+  ++bench_batch_count;
+  fprintf(stderr, "gmj_bench: %-16s %3d envs %3d threads %12.1f env-steps/s\n",
+          scene->name, envs, result->threads,
+          (double)result->env_steps / elapsed);
+
+  gmj_batch_free(batch);
+  gmj_thread_pool_free(pool);
+  free(ctrl);
+}
+
+static void bench_batch_scene(const bench_scene* scene, int envs,
+                              double duration) {
+  gmj_thread_pool* probe = gmj_thread_pool_create(0);
+  const int cpus = probe != NULL ? gmj_thread_pool_size(probe) : 1;
+  int threads = 1;
+  gmj_thread_pool_free(probe);
+
+  for (threads = 1; threads < cpus; threads *= 2) {
+    bench_batch_threads(scene, envs, threads, duration);
+  }
+  bench_batch_threads(scene, envs, cpus, duration);
+}
+
+/* 32 azimuths x 32 elevations from 80 degrees down to 10 degrees up, the
+   kind of fan a creature uses for terrain height and obstacle rays. */
+static void bench_ray_scene(const bench_scene* scene, int envs,
+                            double duration) {
+  enum { azimuths = 32, elevations = 32, rays = azimuths * elevations };
+  const double pi = 3.14159265358979323846;
+  const double origin[3] = {0.0, 0.0, 0.0};
+  bench_ray_result* result = &bench_rays[bench_ray_count];
+  gmj_batch* batch = gmj_batch_create(scene->model, envs);
+  gmj_thread_pool* pool = gmj_thread_pool_create(0);
+  gmj_ray_set* set = gmj_ray_set_create(scene->model);
+  const int torso = gmj_body_id(scene->model, "torso");
+  double* directions = (double*)malloc(3 * rays * sizeof(double));
+  float* distances =
+      (float*)malloc((size_t)envs * (size_t)rays * sizeof(float));
+  double start = 0.0;
+  double elapsed = 0.0;
+  long long calls = 0;
+  int a = 0;
+  int e = 0;
+
+  if (batch == NULL || pool == NULL || set == NULL || torso < 0 ||
+      directions == NULL || distances == NULL) {
+    bench_fail("gmj_ray_set_create");
+  }
+  for (a = 0; a < azimuths; ++a) {
+    for (e = 0; e < elevations; ++e) {
+      const double yaw = 2.0 * pi * a / azimuths;
+      const double pitch = (-80.0 + 90.0 * e / (elevations - 1)) * pi / 180.0;
+      double* v = directions + 3 * (a * elevations + e);
+      v[0] = cos(pitch) * cos(yaw);
+      v[1] = cos(pitch) * sin(yaw);
+      v[2] = sin(pitch);
+    }
+  }
+  if (gmj_ray_set_add(set, torso, torso, origin, directions, rays) != GMJ_OK ||
+      gmj_batch_set_thread_pool(batch, pool) != GMJ_OK ||
+      gmj_batch_step(batch, NULL, 1, NULL, NULL) != GMJ_OK) {
+    bench_fail("gmj_ray_set_add");
+  }
+
+  start = bench_now_seconds();
+  while (elapsed < duration) {
+    if (gmj_batch_raycast_f32(set, batch, distances, NULL) != GMJ_OK) {
+      bench_fail("gmj_batch_raycast_f32");
+    }
+    bench_sink += distances[0];
+    ++calls;
+    elapsed = bench_now_seconds() - start;
+  }
+
+  result->scene = scene;
+  result->envs = envs;
+  result->threads = gmj_thread_pool_size(pool);
+  result->rays_per_env = rays;
+  result->rays = calls * rays * envs;
+  result->seconds = elapsed;
+  ++bench_ray_count;
+  fprintf(stderr, "gmj_bench: %-16s %3d envs %3d threads %12.1f rays/s\n",
+          scene->name, envs, result->threads,
+          (double)result->rays / elapsed);
+
+  gmj_ray_set_free(set);
+  gmj_batch_free(batch);
+  gmj_thread_pool_free(pool);
+  free(directions);
+  free(distances);
+}
+
+static double bench_rate(long long count, double seconds) {
+  return seconds > 0.0 ? (double)count / seconds : 0.0;
+}
+
+static void bench_write_json(FILE* out, const bench_options* options) {
+  int i = 0;
+  fprintf(out, "{\n");
+  fprintf(out, "  \"schema\": %d,\n", GMJ_BENCH_SCHEMA);
+  fprintf(out, "  \"mujoco_version\": \"%s\",\n", gmj_mujoco_version());
+  fprintf(out, "  \"duration_seconds\": %g,\n", options->duration);
+  fprintf(out, "  \"quick\": %s,\n", options->quick ? "true" : "false");
+
+  fprintf(out, "  \"scenes\": [\n");
+  for (i = 0; i < bench_step_count; ++i) {
+    const bench_step_result* r = &bench_steps[i];
+    fprintf(out,
+            "    {\"name\": \"%s\", \"nq\": %d, \"nv\": %d, \"nu\": %d, "
+            "\"nbody\": %d, \"steps\": %lld, \"seconds\": %.6f, "
+            "\"steps_per_second\": %.3f, \"us_per_step\": %.4f, "
+            "\"ncon_max\": %d, \"data_bytes\": %lld, "
+            "\"arena_peak_bytes\": %lld}%s\n",
+            r->scene->name, r->scene->nq, r->scene->nv, r->scene->nu,
+            r->scene->nbody, r->steps, r->seconds,
+            bench_rate(r->steps, r->seconds),
+            r->steps > 0 ? r->seconds * 1e6 / (double)r->steps : 0.0,
+            r->ncon_max, r->data_bytes, r->arena_peak_bytes,
+            i + 1 < bench_step_count ? "," : "");
+  }
+  fprintf(out, "  ],\n");
+
+  fprintf(out, "  \"ffi\": [\n");
+  for (i = 0; i < bench_ffi_count; ++i) {
+    const bench_ffi_result* r = &bench_ffi[i];
+    fprintf(out,
+            "    {\"scene\": \"%s\", \"api\": \"%s\", \"count\": %d, "
+            "\"calls\": %lld, \"ns_per_call\": %.3f}%s\n",
+            r->scene->name, r->api, r->count, r->calls,
+            r->calls > 0 ? r->seconds * 1e9 / (double)r->calls : 0.0,
+            i + 1 < bench_ffi_count ? "," : "");
+  }
+  fprintf(out, "  ],\n");
+
+  fprintf(out, "  \"batch\": [\n");
+  for (i = 0; i < bench_batch_count; ++i) {
+    const bench_batch_result* r = &bench_batches[i];
+    const bench_batch_result* base = r;
+    int j = 0;
+    for (j = i; j >= 0 && bench_batches[j].scene == r->scene; --j) {
+      base = &bench_batches[j];
+    }
+    fprintf(out,
+            "    {\"scene\": \"%s\", \"envs\": %d, \"threads\": %d, "
+            "\"env_steps\": %lld, \"seconds\": %.6f, "
+            "\"env_steps_per_second\": %.3f, \"speedup\": %.3f, "
+            "\"bytes_per_env\": %lld}%s\n",
+            r->scene->name, r->envs, r->threads, r->env_steps, r->seconds,
+            bench_rate(r->env_steps, r->seconds),
+            bench_rate(base->env_steps, base->seconds) > 0.0
+                ? bench_rate(r->env_steps, r->seconds) /
+                      bench_rate(base->env_steps, base->seconds)
+                : 0.0,
+            r->bytes_per_env, i + 1 < bench_batch_count ? "," : "");
+  }
+  fprintf(out, "  ],\n");
+
+  fprintf(out, "  \"rays\": [\n");
+  for (i = 0; i < bench_ray_count; ++i) {
+    const bench_ray_result* r = &bench_rays[i];
+    fprintf(out,
+            "    {\"scene\": \"%s\", \"envs\": %d, \"threads\": %d, "
+            "\"rays_per_env\": %d, \"rays\": %lld, \"seconds\": %.6f, "
+            "\"rays_per_second\": %.3f}%s\n",
+            r->scene->name, r->envs, r->threads, r->rays_per_env, r->rays,
+            r->seconds, bench_rate(r->rays, r->seconds),
+            i + 1 < bench_ray_count ? "," : "");
+  }
+  fprintf(out, "  ]\n}\n");
+}
+
+static void bench_usage(void) {
+  fprintf(stderr,
+          "usage: gmj_bench [--out FILE] [--duration SECONDS] [--envs N] "
+          "[--quick]\n"
+          "  --duration  seconds per measurement (default 2, --quick 0.25)\n"
+          "  --envs      envs per batch for thread scaling (default 64)\n"
+          "  --quick     skip the 10000-sphere scene, for CI smoke runs\n");
+}
+
+static int bench_parse(int argc, char** argv, bench_options* options) {
+  int i = 0;
+  int duration_set = 0;
+  options->out_path = NULL;
+  options->duration = 2.0;
+  options->envs = 64;
+  options->quick = 0;
+
+  for (i = 1; i < argc; ++i) {
+    const int has_value = i + 1 < argc;
+    if (strcmp(argv[i], "--out") == 0 && has_value) {
+      options->out_path = argv[++i];
+    } else if (strcmp(argv[i], "--duration") == 0 && has_value) {
+      options->duration = atof(argv[++i]);
+      duration_set = 1;
+    } else if (strcmp(argv[i], "--envs") == 0 && has_value) {
+      options->envs = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--quick") == 0) {
+      options->quick = 1;
+    } else {
+      return 0;
+    }
+  }
+  if (options->quick && !duration_set) {
+    options->duration = 0.25;
+  }
+  return options->duration > 0.0 && options->envs > 0;
+}
+
+int main(int argc, char** argv) {
+  bench_options options;
+  FILE* out = stdout;
+  int i = 0;
+
+  if (!bench_parse(argc, argv, &options)) {
+    bench_usage();
+    return 2;
+  }
+
+  bench_add_scene("spheres_100", 0, 100);
+  bench_add_scene("spheres_1000", 0, 1000);
+  if (!options.quick) {
+    bench_add_scene("spheres_10000", 0, 10000);
+  }
+  bench_add_scene("creature_4_legs", 1, 4);
+  bench_add_scene("creature_8_legs", 1, 8);
+
+  for (i = 0; i < bench_scene_count; ++i) {
+    bench_step_scene(&bench_scenes[i], options.duration);
+  }
+  for (i = 0; i < bench_scene_count; ++i) {
+    if (bench_scenes[i].creature) {
+      bench_ffi_scene(&bench_scenes[i], options.duration);
+    }
+  }
+  for (i = 0; i < bench_scene_count; ++i) {
+    if (bench_scenes[i].creature) {
+      bench_batch_scene(&bench_scenes[i], options.envs, options.duration);
+    }
+  }
+  for (i = 0; i < bench_scene_count; ++i) {
+    if (bench_scenes[i].creature) {
+      bench_ray_scene(&bench_scenes[i], options.envs, options.duration);
+    }
+  }
+
+  if (options.out_path != NULL) {
+    out = fopen(options.out_path, "w");
+    if (out == NULL) {
+      fprintf(stderr, "gmj_bench: cannot open %s\n", options.out_path);
+      return 1;
+    }
+  }
+  bench_write_json(out, &options);
+  if (out != stdout) {
+    fclose(out);
+  }
+
+  for (i = 0; i < bench_scene_count; ++i) {
+    gmj_model_free(bench_scenes[i].model);
+  }
+  return 0;
+}
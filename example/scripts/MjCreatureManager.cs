@@ -20,6 +20,15 @@ public partial class MjCreatureManager : Node3D
     [Export]
     public int StepsPerTick = 1;
 
+    [Export]
+    public bool UseSimThread = false;
+
+    [Export]
+    public float SimTickRateHz = 120.0f;
+
+    [Export]
+    public bool ProfileMujocoTimers = false;
+
     [Export]
     public float ActionAmplitude = 0.5f;
 
@@ -29,6 +38,18 @@ public partial class MjCreatureManager : Node3D
     [Export]
     public float TerminationMinHeight = 0.2f;
 
+    [Export]
+    public float DomainRandomization = 0.0f;
+
+    [Export]
+    public bool HotReloadModel = false;
+
+    [Export]
+    public float ModelPollIntervalSec = 0.5f;
+
+    [Export]
+    public string CompileCacheDir = "user://mujoco_compile_cache";
+
     [Export]
     public string PolicyExportDir = "/Users/shnidi/claude/robots/AI-orchestrator/data/runs/run-1770436362-0001-refine-4b11/artifacts/checkpoints/left";
 
@@ -53,7 +74,9 @@ public partial class MjCreatureManager : Node3D
     private readonly List<List<MeshInstance3D>> _bodyVisuals = new List<List<MeshInstance3D>>();
     private double[] _observationBuffer = new double[1];
     private double[] _actionBuffer = new double[1];
+    private float[] _bodyTransformBuffer = Array.Empty<float>();
     private double _elapsed;
+    private IntPtr _modelReloader = IntPtr.Zero;
 
     public override void _Ready()
     {
@@ -65,6 +88,17 @@ public partial class MjCreatureManager : Node3D
             : ProjectSettings.GlobalizePath(PolicyExportDir);
         Directory.CreateDirectory(exportDirAbsolutePath);
 
+        if (!string.IsNullOrWhiteSpace(CompileCacheDir))
+        {
+            string cacheDirAbsolutePath = Path.IsPathRooted(CompileCacheDir)
+                ? CompileCacheDir
+                : ProjectSettings.GlobalizePath(CompileCacheDir);
+            Directory.CreateDirectory(cacheDirAbsolutePath);
+            MujocoNative.gmj_compile_cache_set_dir(cacheDirAbsolutePath);
+        }
+
+        MujocoNative.gmj_stats_enable_timers(ProfileMujocoTimers ? 1 : 0);
+
         int observationSize = ResolveObservationSizeFromVecNorm(exportDirAbsolutePath, VecNormSelector);
         _observationBuffer = new double[Math.Max(1, observationSize)];
 
@@ -80,6 +114,36 @@ public partial class MjCreatureManager : Node3D
             return;
         }
 
+        if (!_trainer.ConfigureTask(TerminationMinHeight))
+        {
+            GD.PushError("Failed to configure native reward/termination task.");
+            return;
+        }
+
+        if (DomainRandomization > 0.0f && !_trainer.ConfigureRandomization(DomainRandomization))
+        {
+            GD.PushError("Failed to configure domain randomization.");
+            return;
+        }
+
+        if (HotReloadModel)
+        {
+            string modelAbsolutePath = Path.IsPathRooted(ModelPath)
+                ? ModelPath
+                : ProjectSettings.GlobalizePath(ModelPath);
+            _modelReloader = MujocoNative.gmj_reloader_create(modelAbsolutePath, Math.Max(0.05, ModelPollIntervalSec));
+            if (_modelReloader == IntPtr.Zero)
+            {
+                GD.PushWarning("Model hot reload disabled: " + MujocoNative.LastError());
+            }
+        }
+
+        if (UseSimThread && !_trainer.StartSimThreads(SimTickRateHz, StepsPerTick))
+        {
+            GD.PushError("Failed to start native sim threads.");
+            return;
+        }
+
         _policyReloader.Configure(
             exportDirAbsolutePath,
             PolicyPollIntervalSec,
@@ -137,10 +201,18 @@ public partial class MjCreatureManager : Node3D
             _bodyVisuals.Add(bodyMarkers);
         }
 
+        _bodyTransformBuffer = new float[Math.Max(1, _trainer.GetBodyCount(0)) * MujocoNative.MultiMeshTransformFloats];
+
         int actionSize = Math.Max(1, _trainer.GetActionSize(0));
         _actionBuffer = new double[actionSize];
 
         GD.Print("Creatures initialized: " + _trainer.CreatureCount);
+        if (_trainer.TryGetLoadInfo(out MujocoNative.LoadInfo loadInfo))
+        {
+            GD.Print("Model load: " + (loadInfo.CacheHit != 0 ? "binary cache hit" : "compiled from XML") +
+                     " in " + (loadInfo.LoadSeconds * 1000.0).ToString("F1") + " ms" +
+                     (loadInfo.CacheWritten != 0 ? " (cache written)" : ""));
+        }
     }
 
     public override void _PhysicsProcess(double delta)
@@ -148,10 +220,15 @@ public partial class MjCreatureManager : Node3D
         _elapsed += delta;
         _policyReloader.Update(delta);
 
-        for (int i = 0; i < _trainer.CreatureCount; i++)
+        if (_modelReloader != IntPtr.Zero && _trainer.PollModelReload(_modelReloader) > 0)
         {
-            var marker = _creatureVisuals[i];
+            MujocoNative.gmj_reloader_info(_modelReloader, out MujocoNative.ReloadInfo reloadInfo);
+            GD.Print("Model reloaded: generation=" + reloadInfo.Generation +
+                     " compile_ms=" + (reloadInfo.LastCompileSeconds * 1000.0).ToString("F1"));
+        }
 
+        for (int i = 0; i < _trainer.CreatureCount; i++)
+        {
             if (_trainer.FillObservation(i, _observationBuffer) != 0)
             {
                 GD.PushWarning("Observation fetch failed for creature " + i + " / " + MujocoNative.LastError());
@@ -174,50 +251,85 @@ public partial class MjCreatureManager : Node3D
                 }
             }
 
-            int rc = _trainer.StepCreature(i, StepsPerTick);
+            int rc = UseSimThread
+                ? _trainer.SyncCreatureSimThread(i, out double reward, out bool done)
+                : _trainer.StepCreatureTask(i, StepsPerTick, out reward, out done);
             if (rc != 0)
             {
                 GD.PushWarning("Creature step failed: " + rc + " / " + MujocoNative.LastError());
                 continue;
             }
 
-            bool hasRoot = _trainer.TryGetRootPosition(i, out Vector3 rootPosition);
-            if (hasRoot)
+            if ((i == 0) && (_elapsed % 1.0 < delta))
             {
-                marker.Position = new Vector3(rootPosition.X + i * CreatureSpacing, rootPosition.Y, rootPosition.Z);
+                GD.Print("Creature 0 reward_x=" + reward + " done=" + done + " obs0=" + _observationBuffer[0] +
+                         " hot_policy=" + hasHotPolicy + " onnx=" + _policyReloader.LastOnnxPath);
+                if (_trainer.TryGetSimStats(i, out MujocoNative.SimStats simStats))
+                {
+                    GD.Print("Sim thread ticks=" + simStats.Ticks + " missed=" + simStats.MissedDeadlines +
+                             " queue=" + simStats.QueueDepth + "/" + simStats.QueueCapacity +
+                             " tick_ms=" + (simStats.LastTickSeconds * 1000.0).ToString("F3"));
+                }
+                else if (_trainer.TryGetStats(i, out MujocoNative.Stats stats))
+                {
+                    double stepUs = stats.Steps > 0 ? stats.StepSeconds * 1.0e6 / stats.Steps : 0.0;
+                    GD.Print("Stats steps=" + stats.Steps + " step_us=" + stepUs.ToString("F1") +
+                             " ncon=" + stats.Ncon + "/" + stats.NconMax +
+                             " solver_iter=" + stats.SolverIterations + "/" + stats.SolverIterationsMax +
+                             " arena_peak=" + stats.ArenaPeakBytes + "/" + stats.ArenaBytes +
+                             " lifetime_peak=" + (stats.ArenaPeakMaxBytes + stats.StackPeakMaxBytes));
+                }
             }
+        }
+    }
 
-            List<MeshInstance3D> bodyMarkers = _bodyVisuals[i];
-            for (int bodyIndex = 1; bodyIndex <= bodyMarkers.Count; bodyIndex++)
+    // Visuals are placed every rendered frame from poses blended between the
+    // last two physics ticks, so a physics rate below the frame rate does not
+    // show up as stutter.
+    public override void _Process(double delta)
+    {
+        float alpha = (float)Engine.GetPhysicsInterpolationFraction();
+        for (int i = 0; i < _trainer.CreatureCount; i++)
+        {
+            if (_trainer.ExportInterpolatedTransforms(i, alpha, _bodyTransformBuffer, null) != 0)
             {
-                if (hasRoot && _trainer.TryGetBodyPosition(i, bodyIndex, out Vector3 bodyPosition))
-                {
-                    bodyMarkers[bodyIndex - 1].Position = bodyPosition - rootPosition;
-                }
+                continue;
             }
 
-            double reward = _trainer.ComputeRewardForwardX(i);
-            if (_trainer.IsTerminated(i, TerminationMinHeight))
+            int exportedBodies = _bodyTransformBuffer.Length / MujocoNative.MultiMeshTransformFloats;
+            int rootBody = _trainer.GetTrackedBodyId(i);
+            if (rootBody < 0 || rootBody >= exportedBodies)
             {
-                int resetRc = _trainer.ResetCreature(i);
-                if (resetRc != 0)
-                {
-                    GD.PushWarning("Creature reset failed: " + resetRc + " / " + MujocoNative.LastError());
-                }
+                continue;
             }
 
-            if ((i == 0) && (_elapsed % 1.0 < delta))
+            Vector3 rootPosition = RecordPosition(rootBody);
+            _creatureVisuals[i].Position = new Vector3(rootPosition.X + i * CreatureSpacing, rootPosition.Y, rootPosition.Z);
+
+            List<MeshInstance3D> bodyMarkers = _bodyVisuals[i];
+            for (int bodyIndex = 1; bodyIndex <= bodyMarkers.Count && bodyIndex < exportedBodies; bodyIndex++)
             {
-                GD.Print("Creature 0 reward_x=" + reward + " obs0=" + _observationBuffer[0] +
-                         " hot_policy=" + hasHotPolicy + " onnx=" + _policyReloader.LastOnnxPath);
+                bodyMarkers[bodyIndex - 1].Position = RecordPosition(bodyIndex) - rootPosition;
             }
         }
     }
 
+    private Vector3 RecordPosition(int bodyIndex)
+    {
+        int record = bodyIndex * MujocoNative.MultiMeshTransformFloats;
+        return new Vector3(
+            _bodyTransformBuffer[record + 3],
+            _bodyTransformBuffer[record + 7],
+            _bodyTransformBuffer[record + 11]
+        );
+    }
+
     public override void _ExitTree()
     {
         _policyReloader.Dispose();
         _trainer.Dispose();
+        MujocoNative.gmj_reloader_free(_modelReloader);
+        _modelReloader = IntPtr.Zero;
         _creatureVisuals.Clear();
         _bodyVisuals.Clear();
     }
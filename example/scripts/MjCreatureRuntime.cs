@@ -6,8 +6,22 @@ public sealed class MjCreatureRuntime : IDisposable
     private readonly MjSceneRuntime _scene = new MjSceneRuntime();
     private double[] _actions = Array.Empty<double>();
     private readonly double[] _observationTemplate;
-    private double[] _qposRead = Array.Empty<double>();
+    private MujocoNative.View _qposView;
     private int _trackedBodyId = -1;
+    private IntPtr _task = IntPtr.Zero;
+    private IntPtr _sim = IntPtr.Zero;
+    private IntPtr _poseBuffer = IntPtr.Zero;
+    private IntPtr _sensors = IntPtr.Zero;
+    private IntPtr _tickCommands = IntPtr.Zero;
+    private int _tickCommandSteps;
+    private string _trackedBodyName = "";
+    private double? _taskMinHeight;
+    private double _randomSpread;
+    private ulong _randomSeed;
+    private ulong _modelGeneration;
+    private readonly double[] _rootXpos = MujocoNative.AllocatePinned<double>(3);
+    private MujocoNative.SimState _simState;
+    private MujocoNative.SimStats _simStats;
     private Vector3 _lastRootPosition = Vector3.Zero;
 
     public MjCreatureRuntime(int observationSize)
@@ -20,6 +34,10 @@ public sealed class MjCreatureRuntime : IDisposable
     public int ActionSize => _actions.Length;
     public int ObservationSize => _observationTemplate.Length;
     public int BodyCount => _scene.Nbody;
+    public int SensorValueCount => _sensors != IntPtr.Zero ? MujocoNative.gmj_sensor_map_size(_sensors) : 0;
+    public bool IsSimThreadRunning => _sim != IntPtr.Zero;
+    public int TrackedBodyId => _trackedBodyId;
+    public MujocoNative.SimStats SimStats => _simStats;
 
     public bool Initialize(string modelPath, string trackedBodyName)
     {
@@ -28,6 +46,7 @@ public sealed class MjCreatureRuntime : IDisposable
             return false;
         }
 
+        _trackedBodyName = trackedBodyName;
         _trackedBodyId = _scene.ResolveBodyId(trackedBodyName);
         if (_trackedBodyId < 0)
         {
@@ -37,9 +56,29 @@ public sealed class MjCreatureRuntime : IDisposable
         }
 
         int nu = _scene.Nu;
-        _actions = nu > 0 ? new double[nu] : Array.Empty<double>();
-        int nq = _scene.Nq;
-        _qposRead = nq > 0 ? new double[nq] : Array.Empty<double>();
+        _actions = MujocoNative.AllocatePinned<double>(nu);
+        if (!_scene.TryGetView(MujocoNative.StateField.Qpos, out _qposView))
+        {
+            GD.PushError("Failed to map qpos view: " + MujocoNative.LastError());
+            _scene.Dispose();
+            return false;
+        }
+
+        _poseBuffer = MujocoNative.gmj_pose_buffer_create(_scene.ModelHandle);
+        if (_poseBuffer == IntPtr.Zero)
+        {
+            GD.PushError("Failed to create pose buffer: " + MujocoNative.LastError());
+            _scene.Dispose();
+            return false;
+        }
+
+        _sensors = MujocoNative.gmj_sensor_map_create(_scene.ModelHandle);
+        if (_sensors == IntPtr.Zero || MujocoNative.gmj_sensor_map_add_all(_sensors) != 0)
+        {
+            GD.PushError("Failed to bind sensors: " + MujocoNative.LastError());
+            Dispose();
+            return false;
+        }
 
         return true;
     }
@@ -56,11 +95,17 @@ public sealed class MjCreatureRuntime : IDisposable
             _actions[i] = 0.0;
         }
 
+        if (IsSimThreadRunning)
+        {
+            return MujocoNative.gmj_sim_post_reset(_sim);
+        }
+
         int rc = _scene.Reset();
         if (rc != 0)
         {
             return rc;
         }
+        PushPose();
 
         if (TryGetRootPosition(out Vector3 position))
         {
@@ -81,7 +126,180 @@ public sealed class MjCreatureRuntime : IDisposable
 
     public int Step(int stepsPerTick)
     {
-        if (!IsReady)
+        if (!IsReady || IsSimThreadRunning)
+        {
+            return 1;
+        }
+
+        stepsPerTick = Math.Max(1, stepsPerTick);
+        if (_tickCommandSteps != stepsPerTick && !RecordTickCommands(stepsPerTick))
+        {
+            return 1;
+        }
+
+        int rc = MujocoNative.gmj_execute(_tickCommands, _scene.DataHandle);
+        if (rc == 0)
+        {
+            _lastRootPosition = new Vector3((float)_rootXpos[0], (float)_rootXpos[1], (float)_rootXpos[2]);
+            PushPose();
+        }
+        return rc;
+    }
+
+    // ctrl <- actions, step, tracked body xpos -> _rootXpos: recorded once
+    // per steps-per-tick value so a tick is a single native call.
+    private bool RecordTickCommands(int stepsPerTick)
+    {
+        if (_tickCommands == IntPtr.Zero)
+        {
+            _tickCommands = MujocoNative.gmj_cmd_list_create(_scene.ModelHandle);
+        }
+        else
+        {
+            MujocoNative.gmj_cmd_list_clear(_tickCommands);
+        }
+
+        _tickCommandSteps = 0;
+        if (_tickCommands == IntPtr.Zero ||
+            (_actions.Length > 0 &&
+             MujocoNative.gmj_cmd_set_ctrl(_tickCommands, 0, _actions.Length, MujocoNative.AddressOf(_actions)) != 0) ||
+            MujocoNative.gmj_cmd_step(_tickCommands, stepsPerTick) != 0 ||
+            MujocoNative.gmj_cmd_copy(_tickCommands, MujocoNative.StateField.Xpos, 3 * _trackedBodyId, 3,
+                MujocoNative.AddressOf(_rootXpos)) != 0)
+        {
+            GD.PushError("Failed to record tick commands: " + MujocoNative.LastError());
+            return false;
+        }
+
+        _tickCommandSteps = stepsPerTick;
+        return true;
+    }
+
+    // Forward-x reward on the tracked body and a minimum-height termination,
+    // evaluated natively by StepTask.
+    public bool ConfigureTask(double terminationMinHeight)
+    {
+        if (!IsReady || IsSimThreadRunning)
+        {
+            return false;
+        }
+
+        IntPtr task = MujocoNative.gmj_task_create(_scene.ModelHandle);
+        if (task == IntPtr.Zero ||
+            MujocoNative.gmj_task_add_reward(task, MujocoNative.RewardTerm.Forward, _trackedBodyId, 0, 0.0, 1.0) != 0 ||
+            MujocoNative.gmj_task_add_termination(task, MujocoNative.Termination.Below, _trackedBodyId, 2, terminationMinHeight) != 0)
+        {
+            GD.PushError("Failed to configure creature task: " + MujocoNative.LastError());
+            MujocoNative.gmj_task_free(task);
+            return false;
+        }
+
+        MujocoNative.gmj_task_free(_task);
+        _task = task;
+        _taskMinHeight = terminationMinHeight;
+        return true;
+    }
+
+    // Mass, friction, damping and gear each scaled by a uniform draw in
+    // [1 - spread, 1 + spread], redrawn natively on every reset. The terms are
+    // copied into the data, so the randomizer is released right away.
+    public bool ConfigureRandomization(double spread, ulong seed)
+    {
+        if (!IsReady || IsSimThreadRunning)
+        {
+            return false;
+        }
+
+        double low = Math.Max(0.0, 1.0 - spread);
+        double high = 1.0 + spread;
+        IntPtr randomizer = MujocoNative.gmj_randomizer_create(_scene.ModelHandle);
+        bool ok = randomizer != IntPtr.Zero &&
+                  MujocoNative.gmj_randomizer_add(randomizer, MujocoNative.Param.BodyMass, null, MujocoNative.RandOp.Scale, MujocoNative.Dist.Uniform, low, high) == 0 &&
+                  MujocoNative.gmj_randomizer_add(randomizer, MujocoNative.Param.GeomFriction, null, MujocoNative.RandOp.Scale, MujocoNative.Dist.Uniform, low, high) == 0 &&
+                  MujocoNative.gmj_randomizer_add(randomizer, MujocoNative.Param.DofDamping, null, MujocoNative.RandOp.Scale, MujocoNative.Dist.Uniform, low, high) == 0 &&
+                  MujocoNative.gmj_randomizer_add(randomizer, MujocoNative.Param.ActuatorGear, null, MujocoNative.RandOp.Scale, MujocoNative.Dist.Uniform, low, high) == 0 &&
+                  MujocoNative.gmj_data_randomize(_scene.ModelHandle, _scene.DataHandle, randomizer, seed) == 0;
+        if (!ok)
+        {
+            GD.PushError("Failed to configure domain randomization: " + MujocoNative.LastError());
+        }
+        MujocoNative.gmj_randomizer_free(randomizer);
+
+        _randomSpread = ok ? spread : 0.0;
+        _randomSeed = seed;
+        return ok;
+    }
+
+    // Picks up a newer compile from the reloader between ticks: the data is
+    // migrated in place and everything bound to the old model is rebuilt.
+    // Skipped while the sim thread owns the data; the reload is then applied
+    // on the first poll after StopSimThread.
+    public bool PollModelReload(IntPtr reloader)
+    {
+        if (!IsReady || IsSimThreadRunning || reloader == IntPtr.Zero)
+        {
+            return false;
+        }
+
+        IntPtr model = MujocoNative.gmj_reloader_latest(reloader, ref _modelGeneration);
+        if (model == IntPtr.Zero)
+        {
+            return false;
+        }
+
+        int trackedBodyId = MujocoNative.gmj_body_id(model, _trackedBodyName);
+        IntPtr poseBuffer = MujocoNative.gmj_pose_buffer_create(model);
+        IntPtr sensors = MujocoNative.gmj_sensor_map_create(model);
+        IntPtr task = _taskMinHeight.HasValue ? MujocoNative.gmj_task_create(model) : IntPtr.Zero;
+        bool bound = trackedBodyId >= 0 && poseBuffer != IntPtr.Zero && sensors != IntPtr.Zero &&
+                     MujocoNative.gmj_sensor_map_add_all(sensors) == 0 &&
+                     (!_taskMinHeight.HasValue ||
+                      (task != IntPtr.Zero &&
+                       MujocoNative.gmj_task_add_reward(task, MujocoNative.RewardTerm.Forward, trackedBodyId, 0, 0.0, 1.0) == 0 &&
+                       MujocoNative.gmj_task_add_termination(task, MujocoNative.Termination.Below, trackedBodyId, 2, _taskMinHeight.Value) == 0));
+        if (!bound || !_scene.Migrate(model))
+        {
+            GD.PushError("Failed to apply reloaded model: " + MujocoNative.LastError());
+            MujocoNative.gmj_pose_buffer_free(poseBuffer);
+            MujocoNative.gmj_sensor_map_free(sensors);
+            MujocoNative.gmj_task_free(task);
+            MujocoNative.gmj_model_free(model);
+            return false;
+        }
+
+        MujocoNative.gmj_pose_buffer_free(_poseBuffer);
+        _poseBuffer = poseBuffer;
+        MujocoNative.gmj_sensor_map_free(_sensors);
+        _sensors = sensors;
+        MujocoNative.gmj_task_free(_task);
+        _task = task;
+        MujocoNative.gmj_cmd_list_free(_tickCommands);
+        _tickCommands = IntPtr.Zero;
+        _tickCommandSteps = 0;
+        _trackedBodyId = trackedBodyId;
+        if (_randomSpread > 0.0)
+        {
+            ConfigureRandomization(_randomSpread, _randomSeed);
+        }
+
+        int nu = _scene.Nu;
+        if (nu != _actions.Length)
+        {
+            double[] actions = MujocoNative.AllocatePinned<double>(nu);
+            Array.Copy(_actions, actions, Math.Min(nu, _actions.Length));
+            _actions = actions;
+        }
+
+        PushPose();
+        return true;
+    }
+
+    // Step, reward, termination check and auto-reset in one native call.
+    public int StepTask(int stepsPerTick, out double reward, out bool done)
+    {
+        reward = 0.0;
+        done = false;
+        if (!IsReady || IsSimThreadRunning || _task == IntPtr.Zero)
         {
             return 1;
         }
@@ -95,12 +313,90 @@ public sealed class MjCreatureRuntime : IDisposable
             }
         }
 
-        return _scene.Step(stepsPerTick);
+        int rc = MujocoNative.gmj_task_step(_task, _scene.DataHandle, Math.Max(1, stepsPerTick), out reward, out byte doneFlag);
+        done = doneFlag != MujocoNative.DoneNone;
+        if (done)
+        {
+            Array.Clear(_actions, 0, _actions.Length);
+        }
+        if (rc == 0)
+        {
+            PushPose();
+        }
+        return rc;
+    }
+
+    // Hands the data to a native fixed-rate sim thread (running the task when
+    // one is configured). Until StopSimThread, actions are posted with
+    // SyncSimThread and every read comes from the latest published tick.
+    public bool StartSimThread(double tickRateHz, int stepsPerTick)
+    {
+        if (!IsReady || IsSimThreadRunning)
+        {
+            return false;
+        }
+
+        _sim = MujocoNative.gmj_sim_thread_start(_scene.ModelHandle, _scene.DataHandle, _task, tickRateHz, Math.Max(1, stepsPerTick), 0);
+        if (_sim == IntPtr.Zero)
+        {
+            GD.PushError("Failed to start sim thread: " + MujocoNative.LastError());
+            return false;
+        }
+        return MujocoNative.gmj_sim_latest_state(_sim, out _simState, out _simStats) == 0;
+    }
+
+    public void StopSimThread()
+    {
+        MujocoNative.gmj_sim_thread_stop(_sim);
+        _sim = IntPtr.Zero;
+        _simState = default;
+    }
+
+    // Posts the current actions and picks up the latest completed tick
+    // without waiting for the sim thread.
+    public int SyncSimThread(out double reward, out bool done)
+    {
+        reward = 0.0;
+        done = false;
+        if (!IsSimThreadRunning)
+        {
+            return 1;
+        }
+
+        int rc = _actions.Length > 0 ? MujocoNative.gmj_sim_post_ctrl(_sim, 0, _actions.Length, _actions) : 0;
+        if (rc != 0 && rc != MujocoNative.ErrorQueueFull)
+        {
+            return rc;
+        }
+
+        ulong previousTick = _simState.Tick;
+        rc = MujocoNative.gmj_sim_latest_state(_sim, out _simState, out _simStats);
+        if (rc == 0 && _simState.Tick != previousTick)
+        {
+            reward = _simState.Reward;
+            done = _simState.Done != MujocoNative.DoneNone;
+        }
+        return rc;
+    }
+
+    private bool TryGetSimBodyPosition(int bodyId, out Vector3 position)
+    {
+        position = Vector3.Zero;
+        if (bodyId < 0 || bodyId >= _simState.Nbody)
+        {
+            return false;
+        }
+
+        ReadOnlySpan<double> xpos = MujocoNative.AsSpan(_simState.Xpos, 3 * _simState.Nbody);
+        position = new Vector3((float)xpos[3 * bodyId], (float)xpos[3 * bodyId + 1], (float)xpos[3 * bodyId + 2]);
+        return true;
     }
 
     public bool TryGetRootPosition(out Vector3 position)
     {
-        bool ok = _scene.TryGetBodyWorldPosition(_trackedBodyId, out position);
+        bool ok = IsSimThreadRunning
+            ? TryGetSimBodyPosition(_trackedBodyId, out position)
+            : _scene.TryGetBodyWorldPosition(_trackedBodyId, out position);
         if (ok)
         {
             _lastRootPosition = position;
@@ -110,11 +406,74 @@ public sealed class MjCreatureRuntime : IDisposable
 
     public Vector3 LastRootPosition => _lastRootPosition;
 
+    // Step counters, MuJoCo timers/warnings and high-water marks. The data is
+    // owned by the sim thread while it runs, so this refuses in that mode.
+    public bool TryGetStats(out MujocoNative.Stats stats)
+    {
+        stats = default;
+        if (!IsReady || IsSimThreadRunning)
+        {
+            return false;
+        }
+        return MujocoNative.gmj_data_stats(_scene.ModelHandle, _scene.DataHandle, out stats) == 0;
+    }
+
+    // All of sensordata in model order; destination needs SensorValueCount entries.
+    public bool TryReadSensors(double[] destination)
+    {
+        if (!IsReady || IsSimThreadRunning || destination == null || destination.Length < SensorValueCount)
+        {
+            return false;
+        }
+        return SensorValueCount == 0 || MujocoNative.gmj_sensor_read(_sensors, _scene.DataHandle, destination) == 0;
+    }
+
+    public bool TryGetLoadInfo(out MujocoNative.LoadInfo info)
+    {
+        return _scene.TryGetLoadInfo(out info);
+    }
+
     public bool TryGetBodyPosition(int bodyIndex, out Vector3 position)
     {
+        if (IsSimThreadRunning)
+        {
+            return TryGetSimBodyPosition(bodyIndex, out position);
+        }
         return _scene.TryGetBodyWorldPosition(bodyIndex, out position);
     }
 
+    public int ExportBodyTransforms(float[] destination, float[]? worldOffset)
+    {
+        if (IsSimThreadRunning)
+        {
+            return 1;
+        }
+        return _scene.ExportBodyTransforms(destination, worldOffset);
+    }
+
+    private void PushPose()
+    {
+        MujocoNative.gmj_pose_buffer_push(_poseBuffer, _scene.DataHandle);
+    }
+
+    // Body transforms blended between the last two physics ticks, in the
+    // MultiMesh layout. alpha is the physics interpolation fraction; with the
+    // sim thread running it is derived natively from the tick clock instead.
+    public int ExportInterpolatedTransforms(float alpha, float[] destination, float[]? worldOffset)
+    {
+        if (!IsReady || destination == null)
+        {
+            return 1;
+        }
+
+        int bodyCount = Math.Min(_scene.Nbody, destination.Length / MujocoNative.MultiMeshTransformFloats);
+        return IsSimThreadRunning
+            ? MujocoNative.gmj_sim_interpolate_transforms(_sim, MujocoNative.SimAlphaAuto, null, bodyCount, worldOffset,
+                MujocoNative.TransformLayout.MultiMesh, 0, destination)
+            : MujocoNative.gmj_pose_buffer_interpolate(_poseBuffer, alpha, null, bodyCount, worldOffset,
+                MujocoNative.TransformLayout.MultiMesh, 0, destination);
+    }
+
     public int FillObservation(double[] destination)
     {
         if (!IsReady || destination == null)
@@ -122,25 +481,40 @@ public sealed class MjCreatureRuntime : IDisposable
             return 1;
         }
 
-        int sampleCount = Math.Min(destination.Length, _qposRead.Length);
-        Array.Clear(destination, 0, destination.Length);
-        if (sampleCount <= 0)
+        if (IsSimThreadRunning)
         {
+            ReadOnlySpan<double> published = MujocoNative.AsSpan(_simState.Qpos, _simState.Nq);
+            int publishedCount = Math.Min(destination.Length, published.Length);
+            published.Slice(0, publishedCount).CopyTo(destination);
+            Array.Clear(destination, publishedCount, destination.Length - publishedCount);
             return 0;
         }
 
-        int rc = _scene.GetQposSlice(0, _qposRead);
-        if (rc != 0)
+        if (_qposView.Generation != _scene.DataGeneration &&
+            !_scene.TryGetView(MujocoNative.StateField.Qpos, out _qposView))
         {
-            return rc;
+            return 1;
         }
 
-        Array.Copy(_qposRead, destination, sampleCount);
+        ReadOnlySpan<double> qpos = MujocoNative.AsSpan(_qposView);
+        int sampleCount = Math.Min(destination.Length, qpos.Length);
+        qpos.Slice(0, sampleCount).CopyTo(destination);
+        Array.Clear(destination, sampleCount, destination.Length - sampleCount);
         return 0;
     }
 
     public void Dispose()
     {
+        StopSimThread();
+        MujocoNative.gmj_cmd_list_free(_tickCommands);
+        _tickCommands = IntPtr.Zero;
+        _tickCommandSteps = 0;
+        MujocoNative.gmj_task_free(_task);
+        _task = IntPtr.Zero;
+        MujocoNative.gmj_pose_buffer_free(_poseBuffer);
+        _poseBuffer = IntPtr.Zero;
+        MujocoNative.gmj_sensor_map_free(_sensors);
+        _sensors = IntPtr.Zero;
         _scene.Dispose();
     }
 }
@@ -27,6 +27,12 @@ public sealed class MjCreatureTrainerBridge : IDisposable
         return _creatures[creatureIndex].ActionSize;
     }
 
+    public bool TryGetLoadInfo(out MujocoNative.LoadInfo info)
+    {
+        info = default;
+        return _creatures.Count > 0 && _creatures[0].TryGetLoadInfo(out info);
+    }
+
     public bool InitializeCreatures(int count, string modelPath, string trackedBodyName, int observationSize)
     {
         Dispose();
@@ -87,6 +93,120 @@ public sealed class MjCreatureTrainerBridge : IDisposable
         return 0;
     }
 
+    public bool ConfigureTask(double terminationMinHeight)
+    {
+        foreach (var creature in _creatures)
+        {
+            if (!creature.ConfigureTask(terminationMinHeight))
+            {
+                return false;
+            }
+        }
+        return _creatures.Count > 0;
+    }
+
+    public int StepCreatureTask(int creatureIndex, int stepsPerTick, out double reward, out bool done)
+    {
+        reward = 0.0;
+        done = false;
+        if (creatureIndex < 0 || creatureIndex >= _creatures.Count)
+        {
+            return 1;
+        }
+
+        int rc = _creatures[creatureIndex].StepTask(stepsPerTick, out reward, out done);
+        if (rc == 0 && _creatures[creatureIndex].TryGetRootPosition(out Vector3 position))
+        {
+            _lastPositions[creatureIndex] = position;
+        }
+        return rc;
+    }
+
+    public bool ConfigureRandomization(double spread)
+    {
+        for (int i = 0; i < _creatures.Count; i++)
+        {
+            if (!_creatures[i].ConfigureRandomization(spread, (ulong)i))
+            {
+                return false;
+            }
+        }
+        return _creatures.Count > 0;
+    }
+
+    // Number of creatures moved onto a newer model compiled by reloader.
+    public int PollModelReload(IntPtr reloader)
+    {
+        int reloaded = 0;
+        foreach (var creature in _creatures)
+        {
+            if (creature.PollModelReload(reloader))
+            {
+                reloaded++;
+            }
+        }
+        return reloaded;
+    }
+
+    public bool StartSimThreads(double tickRateHz, int stepsPerTick)
+    {
+        foreach (var creature in _creatures)
+        {
+            if (!creature.StartSimThread(tickRateHz, stepsPerTick))
+            {
+                StopSimThreads();
+                return false;
+            }
+        }
+        return _creatures.Count > 0;
+    }
+
+    public void StopSimThreads()
+    {
+        foreach (var creature in _creatures)
+        {
+            creature.StopSimThread();
+        }
+    }
+
+    public int SyncCreatureSimThread(int creatureIndex, out double reward, out bool done)
+    {
+        reward = 0.0;
+        done = false;
+        if (creatureIndex < 0 || creatureIndex >= _creatures.Count)
+        {
+            return 1;
+        }
+
+        int rc = _creatures[creatureIndex].SyncSimThread(out reward, out done);
+        if (rc == 0 && _creatures[creatureIndex].TryGetRootPosition(out Vector3 position))
+        {
+            _lastPositions[creatureIndex] = position;
+        }
+        return rc;
+    }
+
+    public bool TryGetSimStats(int creatureIndex, out MujocoNative.SimStats stats)
+    {
+        stats = default;
+        if (creatureIndex < 0 || creatureIndex >= _creatures.Count || !_creatures[creatureIndex].IsSimThreadRunning)
+        {
+            return false;
+        }
+        stats = _creatures[creatureIndex].SimStats;
+        return true;
+    }
+
+    public bool TryGetStats(int creatureIndex, out MujocoNative.Stats stats)
+    {
+        stats = default;
+        if (creatureIndex < 0 || creatureIndex >= _creatures.Count)
+        {
+            return false;
+        }
+        return _creatures[creatureIndex].TryGetStats(out stats);
+    }
+
     public int FillObservation(int creatureIndex, double[] destination)
     {
         if (creatureIndex < 0 || creatureIndex >= _creatures.Count)
@@ -117,6 +237,33 @@ public sealed class MjCreatureTrainerBridge : IDisposable
         return _creatures[creatureIndex].TryGetBodyPosition(bodyIndex, out position);
     }
 
+    public int ExportBodyTransforms(int creatureIndex, float[] destination, float[]? worldOffset)
+    {
+        if (creatureIndex < 0 || creatureIndex >= _creatures.Count)
+        {
+            return 1;
+        }
+        return _creatures[creatureIndex].ExportBodyTransforms(destination, worldOffset);
+    }
+
+    public int GetTrackedBodyId(int creatureIndex)
+    {
+        if (creatureIndex < 0 || creatureIndex >= _creatures.Count)
+        {
+            return -1;
+        }
+        return _creatures[creatureIndex].TrackedBodyId;
+    }
+
+    public int ExportInterpolatedTransforms(int creatureIndex, float alpha, float[] destination, float[]? worldOffset)
+    {
+        if (creatureIndex < 0 || creatureIndex >= _creatures.Count)
+        {
+            return 1;
+        }
+        return _creatures[creatureIndex].ExportInterpolatedTransforms(alpha, destination, worldOffset);
+    }
+
     public double ComputeRewardForwardX(int creatureIndex)
     {
         if (creatureIndex < 0 || creatureIndex >= _creatures.Count)
@@ -1,5 +1,6 @@
 using System;
 using System.IO;
+using System.Text;
 using System.Text.Json;
 using Godot;
 
@@ -20,8 +21,14 @@ public sealed class MjPolicyHotReloader : IDisposable
     private VecNormalizeStats? _vecNorm;
     private LinearPolicy? _linearPolicy;
     private OnnxPolicy? _onnxPolicy;
+    private string _vecNormPath = string.Empty;
+    private string _linearPath = string.Empty;
+    private IntPtr _nativePolicy = IntPtr.Zero;
+    private double[] _workingObs = Array.Empty<double>();
 
     public bool HasLinearPolicy => _linearPolicy != null;
+    public bool HasNativePolicy => _nativePolicy != IntPtr.Zero;
+    public IntPtr NativePolicy => _nativePolicy;
     public bool HasOnnxPolicy => _onnxPolicy != null;
     public bool HasVecNorm => _vecNorm != null;
     public string LastOnnxPath { get; private set; } = string.Empty;
@@ -69,29 +76,71 @@ public sealed class MjPolicyHotReloader : IDisposable
             return false;
         }
 
-        double[] workingObs = new double[observation.Length];
-        Array.Copy(observation, workingObs, observation.Length);
+        if (_onnxPolicy == null && _nativePolicy != IntPtr.Zero)
+        {
+            return MujocoNative.gmj_policy_infer(
+                _nativePolicy,
+                observation,
+                observation.Length,
+                outActions,
+                outActions.Length
+            ) == 0;
+        }
+
+        if (_workingObs.Length != observation.Length)
+        {
+            _workingObs = new double[observation.Length];
+        }
+        Array.Copy(observation, _workingObs, observation.Length);
 
         if (_vecNorm != null)
         {
-            _vecNorm.NormalizeInPlace(workingObs);
+            _vecNorm.NormalizeInPlace(_workingObs);
         }
 
         if (_onnxPolicy != null)
         {
-            _onnxPolicy.Infer(workingObs, outActions);
+            _onnxPolicy.Infer(_workingObs, outActions);
             return true;
         }
 
         if (_linearPolicy != null)
         {
-            _linearPolicy.Infer(workingObs, outActions);
+            _linearPolicy.Infer(_workingObs, outActions);
             return true;
         }
 
         return false;
     }
 
+    // The native policy fuses normalization, the linear/MLP layers and
+    // clipping; the managed LinearPolicy stays as fallback if it fails to load.
+    private void ReloadNativePolicy()
+    {
+        if (string.IsNullOrWhiteSpace(_linearPath))
+        {
+            return;
+        }
+
+        byte[] errorBuffer = MujocoNative.CreateErrorBuffer();
+        IntPtr policy = MujocoNative.gmj_policy_load(
+            _linearPath,
+            _vecNorm != null ? _vecNormPath : null,
+            errorBuffer,
+            (UIntPtr)errorBuffer.Length
+        );
+        if (policy == IntPtr.Zero)
+        {
+            GD.PushWarning("Native policy load failed: " + Encoding.UTF8.GetString(errorBuffer).TrimEnd('\0'));
+        }
+
+        if (_nativePolicy != IntPtr.Zero)
+        {
+            MujocoNative.gmj_policy_free(_nativePolicy);
+        }
+        _nativePolicy = policy;
+    }
+
     private void ReloadVecNormIfNeeded()
     {
         string vecNormPath = ResolveSelectedFile(_vecNormSelector, "*vecnorm*.json");
@@ -113,7 +162,9 @@ public sealed class MjPolicyHotReloader : IDisposable
         if (VecNormalizeStats.TryLoad(vecNormPath, out VecNormalizeStats stats, out string error))
         {
             _vecNorm = stats;
+            _vecNormPath = vecNormPath;
             _lastVecNormWriteUtc = writeTime;
+            ReloadNativePolicy();
             GD.Print("Reloaded VecNormalize stats: " + vecNormPath);
         }
         else
@@ -143,7 +194,9 @@ public sealed class MjPolicyHotReloader : IDisposable
         if (LinearPolicy.TryLoad(policyPath, out LinearPolicy policy, out string error))
         {
             _linearPolicy = policy;
+            _linearPath = policyPath;
             _lastPolicyWriteUtc = writeTime;
+            ReloadNativePolicy();
             GD.Print("Reloaded linear policy: " + policyPath);
         }
         else
@@ -189,6 +242,11 @@ public sealed class MjPolicyHotReloader : IDisposable
     {
         _onnxPolicy?.Dispose();
         _onnxPolicy = null;
+        if (_nativePolicy != IntPtr.Zero)
+        {
+            MujocoNative.gmj_policy_free(_nativePolicy);
+            _nativePolicy = IntPtr.Zero;
+        }
     }
 
     private string ResolveSelectedFile(string selector, string fallbackPattern)
@@ -24,7 +24,8 @@ public sealed class MjSceneRuntime : IDisposable
             ? modelPath
             : ProjectSettings.GlobalizePath(modelPath);
 
-        ModelHandle = MujocoNative.gmj_model_load_xml(xmlAbsolutePath, errorBuffer, (UIntPtr)errorBuffer.Length);
+        // Creatures loading the same file share one compiled model; Dispose releases our reference.
+        ModelHandle = MujocoNative.gmj_model_acquire_xml(xmlAbsolutePath, errorBuffer, (UIntPtr)errorBuffer.Length);
         if (ModelHandle == IntPtr.Zero)
         {
             string fromBuffer = Encoding.UTF8.GetString(errorBuffer).TrimEnd('\0');
@@ -44,6 +45,35 @@ public sealed class MjSceneRuntime : IDisposable
         return true;
     }
 
+    // Moves the data onto newModel, keeping matching joint and actuator
+    // state, and takes over the reference to it. On failure the caller keeps
+    // newModel and the scene is unchanged.
+    public bool Migrate(IntPtr newModel)
+    {
+        if (!IsReady || newModel == IntPtr.Zero || MujocoNative.gmj_data_migrate(ModelHandle, DataHandle, newModel) != 0)
+        {
+            return false;
+        }
+
+        MujocoNative.gmj_model_free(ModelHandle);
+        ModelHandle = newModel;
+        return true;
+    }
+
+    public ulong DataGeneration => IsReady ? MujocoNative.gmj_data_generation(DataHandle) : 0;
+
+    public bool TryGetView(MujocoNative.StateField field, out MujocoNative.View view)
+    {
+        view = default;
+        return IsReady && MujocoNative.gmj_data_view(ModelHandle, DataHandle, field, out view) == 0;
+    }
+
+    public bool TryGetLoadInfo(out MujocoNative.LoadInfo info)
+    {
+        info = default;
+        return ModelHandle != IntPtr.Zero && MujocoNative.gmj_model_load_info(ModelHandle, out info) == 0;
+    }
+
     public int ResolveBodyId(string bodyName)
     {
         if (!IsReady)
@@ -108,6 +138,27 @@ public sealed class MjSceneRuntime : IDisposable
         return true;
     }
 
+    // Writes every body as a 12-float Godot MultiMesh/Transform3D record.
+    public int ExportBodyTransforms(float[] destination, float[]? worldOffset)
+    {
+        if (!IsReady || destination == null)
+        {
+            return 1;
+        }
+
+        int bodyCount = Math.Min(Nbody, destination.Length / MujocoNative.MultiMeshTransformFloats);
+        return MujocoNative.gmj_export_body_transforms(
+            ModelHandle,
+            DataHandle,
+            null,
+            bodyCount,
+            worldOffset,
+            MujocoNative.TransformLayout.MultiMesh,
+            0,
+            destination
+        );
+    }
+
     public void Dispose()
     {
         if (DataHandle != IntPtr.Zero)
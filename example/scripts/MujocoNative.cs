@@ -8,6 +8,242 @@ public static class MujocoNative
     private const string LibraryName = "godot_mujoco_bridge";
     private const int ErrorBufferBytes = 1024;
 
+    public enum StateField
+    {
+        Qpos = 0,
+        Qvel = 1,
+        Ctrl = 2,
+        Act = 3,
+        Xpos = 4,
+        Xquat = 5,
+        Xmat = 6,
+        SensorData = 7,
+    }
+
+    public enum TransformLayout
+    {
+        MultiMesh = 0,
+        PosQuat = 1,
+    }
+
+    public enum ObsSource
+    {
+        Qpos = 0,
+        Qvel = 1,
+        SensorData = 2,
+        PrevAction = 3,
+        BodyPosRel = 4,
+        BodyPosLocal = 5,
+    }
+
+    public enum SimdLevel
+    {
+        Scalar = 0,
+        Avx2 = 1,
+        Avx512 = 2,
+    }
+
+    public enum RewardTerm
+    {
+        Forward = 0,
+        Height = 1,
+        CtrlCost = 2,
+    }
+
+    public enum Termination
+    {
+        Below = 0,
+        Above = 1,
+    }
+
+    public enum Param
+    {
+        BodyMass = 0,
+        GeomFriction = 1,
+        DofDamping = 2,
+        ActuatorGear = 3,
+    }
+
+    public enum RandOp
+    {
+        Scale = 0,
+        Set = 1,
+    }
+
+    public enum Dist
+    {
+        Uniform = 0,
+        LogUniform = 1,
+        Normal = 2,
+    }
+
+    public const byte DoneNone = 0;
+    public const byte DoneTerminated = 1;
+    public const byte DoneTruncated = 2;
+
+    [Flags]
+    public enum StateSignature
+    {
+        Time = 1 << 0,
+        Qpos = 1 << 1,
+        Qvel = 1 << 2,
+        Act = 1 << 3,
+        Warmstart = 1 << 4,
+        Ctrl = 1 << 5,
+        QfrcApplied = 1 << 6,
+        XfrcApplied = 1 << 7,
+        EqActive = 1 << 8,
+        MocapPos = 1 << 9,
+        MocapQuat = 1 << 10,
+        UserData = 1 << 11,
+        Plugin = 1 << 12,
+        Physics = Qpos | Qvel | Act,
+        FullPhysics = Time | Physics | Plugin,
+        User = Ctrl | QfrcApplied | XfrcApplied | EqActive | MocapPos | MocapQuat | UserData,
+        Integration = FullPhysics | User | Warmstart,
+    }
+
+    public const int ErrorQueueFull = 6;
+    public const float SimAlphaAuto = -1.0f;
+
+    public const int TransformFlagYUp = 1;
+    public const int MultiMeshTransformFloats = 12;
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct View
+    {
+        public IntPtr Values;
+        public int Count;
+        public int Width;
+        public ulong Generation;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct LoadInfo
+    {
+        public int CacheHit;
+        public int CacheWritten;
+        public double LoadSeconds;
+        public ulong ContentHash;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct ReloadInfo
+    {
+        public ulong Generation;
+        public long Polls;
+        public long Failures;
+        public double LastCompileSeconds;
+        public ulong ContentHash;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct ReplayInfo
+    {
+        public long FrameCount;
+        public int Signature;
+        public int Nu;
+        public int StateSize;
+        public int KeyframeInterval;
+        public double Quantum;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct ThreadStats
+    {
+        public long ItemsProcessed;
+        public long ItemsStolen;
+        public long Dispatches;
+        public double BusySeconds;
+    }
+
+    public const int StatsTimerCount = 16;
+    public const int StatsWarningCount = 8;
+
+    // Timer slots follow mjtTimer, warning slots follow mjtWarning.
+    [StructLayout(LayoutKind.Sequential)]
+    public struct Stats
+    {
+        public long Steps;
+        public double StepSeconds;
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = StatsTimerCount)]
+        public double[] TimerSeconds;
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = StatsTimerCount)]
+        public long[] TimerCalls;
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = StatsWarningCount)]
+        public long[] Warnings;
+        public int SolverIterations;
+        public int SolverIterationsMax;
+        public int Ncon;
+        public int NconMax;
+        public int Nefc;
+        public int NefcMax;
+        public long BufferBytes;
+        public long ArenaBytes;
+        public long ArenaPeakBytes;
+        public long StackPeakBytes;
+        public long ArenaPeakMaxBytes;
+        public long StackPeakMaxBytes;
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct DataPoolInfo
+    {
+        public int Idle;
+        public long IdleBytes;
+        public long Created;
+        public long Reused;
+    }
+
+    // Matches gmj_contact; force is [normal, friction, friction] in the contact frame.
+    [StructLayout(LayoutKind.Sequential)]
+    public unsafe struct Contact
+    {
+        public int Geom1;
+        public int Geom2;
+        public int Body1;
+        public int Body2;
+        public fixed float Pos[3];
+        public fixed float Normal[3];
+        public float Penetration;
+        public fixed float Force[3];
+    }
+
+    [StructLayout(LayoutKind.Sequential)]
+    public struct SimStats
+    {
+        public long Ticks;
+        public long Steps;
+        public long Resets;
+        public long MissedDeadlines;
+        public long CommandsApplied;
+        public long CommandsRejected;
+        public int QueueDepth;
+        public int QueueHighWater;
+        public int QueueCapacity;
+        public double LastTickSeconds;
+        public double MaxLatenessSeconds;
+    }
+
+    // Arrays are owned by the sim thread and valid until the next gmj_sim_latest_state call.
+    [StructLayout(LayoutKind.Sequential)]
+    public struct SimState
+    {
+        public ulong Tick;
+        public double Time;
+        public double Reward;
+        public int Done;
+        public int Nq;
+        public int Nv;
+        public int Nu;
+        public int Nbody;
+        public IntPtr Qpos;
+        public IntPtr Qvel;
+        public IntPtr Ctrl;
+        public IntPtr Xpos;
+        public IntPtr Xquat;
+    }
+
     static MujocoNative()
     {
         NativeLibrary.SetDllImportResolver(
@@ -62,15 +298,119 @@ public static class MujocoNative
         UIntPtr errorBufferSize
     );
 
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_model_acquire_xml(
+        [MarshalAs(UnmanagedType.LPUTF8Str)] string xmlPath,
+        byte[] errorBuffer,
+        UIntPtr errorBufferSize
+    );
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_model_load_xml_string(
+        [MarshalAs(UnmanagedType.LPUTF8Str)] string xml,
+        IntPtr vfs,
+        byte[] errorBuffer,
+        UIntPtr errorBufferSize
+    );
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_model_load_buffer(
+        [MarshalAs(UnmanagedType.LPUTF8Str)] string name,
+        byte[] buffer,
+        UIntPtr size,
+        IntPtr vfs,
+        byte[] errorBuffer,
+        UIntPtr errorBufferSize
+    );
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_vfs_create();
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_vfs_free(IntPtr vfs);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_vfs_add_buffer(IntPtr vfs, [MarshalAs(UnmanagedType.LPUTF8Str)] string name, byte[] buffer, UIntPtr size);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_vfs_remove(IntPtr vfs, [MarshalAs(UnmanagedType.LPUTF8Str)] string name);
+
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
     public static extern void gmj_model_free(IntPtr model);
 
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_model_cache_count();
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_model_refcount(IntPtr model);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_reloader_create([MarshalAs(UnmanagedType.LPUTF8Str)] string xmlPath, double pollSeconds);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_reloader_free(IntPtr reloader);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_reloader_latest(IntPtr reloader, ref ulong inoutGeneration);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_reloader_info(IntPtr reloader, out ReloadInfo outInfo);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_reloader_last_error(IntPtr reloader, byte[] buffer, UIntPtr bufferSize);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_compile_cache_set_dir([MarshalAs(UnmanagedType.LPUTF8Str)] string? cacheDir);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_model_load_info(IntPtr model, out LoadInfo outInfo);
+
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
     public static extern IntPtr gmj_data_create(IntPtr model);
 
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_data_create_sized(IntPtr model, UIntPtr arenaBytes);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_data_pool_create(int maxIdle);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_data_pool_free(IntPtr pool);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_data_pool_acquire(IntPtr pool, IntPtr model, UIntPtr arenaBytes);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_data_pool_release(IntPtr pool, IntPtr model, IntPtr data);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_data_pool_trim(IntPtr pool, IntPtr model);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_data_pool_stats(IntPtr pool, out DataPoolInfo outInfo);
+
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
     public static extern void gmj_data_free(IntPtr data);
 
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_data_migrate(IntPtr oldModel, IntPtr data, IntPtr newModel);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_randomizer_create(IntPtr model);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_randomizer_free(IntPtr randomizer);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_randomizer_add(IntPtr randomizer, Param param, [MarshalAs(UnmanagedType.LPUTF8Str)] string? name,
+        RandOp op, Dist dist, double a, double b);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_data_randomize(IntPtr model, IntPtr data, IntPtr randomizer, ulong seed);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_data_param(IntPtr model, IntPtr data, Param param, int index, out double outValue);
+
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
     public static extern int gmj_reset_data(IntPtr model, IntPtr data);
 
@@ -98,9 +438,504 @@ public static class MujocoNative
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
     public static extern int gmj_set_ctrl_slice(IntPtr model, IntPtr data, int startIndex, int count, double[] values);
 
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_get_qpos_slice_f32(IntPtr model, IntPtr data, int startIndex, int count, float[] outValues);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_set_qpos_slice_f32(IntPtr model, IntPtr data, int startIndex, int count, float[] values);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_get_qvel_slice_f32(IntPtr model, IntPtr data, int startIndex, int count, float[] outValues);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_set_qvel_slice_f32(IntPtr model, IntPtr data, int startIndex, int count, float[] values);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_get_ctrl_slice_f32(IntPtr model, IntPtr data, int startIndex, int count, float[] outValues);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_set_ctrl_slice_f32(IntPtr model, IntPtr data, int startIndex, int count, float[] values);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_get_slice_f32(IntPtr model, IntPtr data, StateField field, int startIndex, int count, float[] outValues);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_set_slice_f32(IntPtr model, IntPtr data, StateField field, int startIndex, int count, float[] values);
+
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
     public static extern int gmj_body_world_position(IntPtr model, IntPtr data, int bodyIndex, double[] outXyz3);
 
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_data_view(IntPtr model, IntPtr data, StateField field, out View outView);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern ulong gmj_data_generation(IntPtr data);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_data_stats(IntPtr model, IntPtr data, out Stats outStats);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_data_reset_stats(IntPtr data);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_stats_enable_timers(int enabled);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_export_body_transforms(
+        IntPtr model,
+        IntPtr data,
+        int[]? bodyIds,
+        int bodyCount,
+        float[]? worldOffsetXyz,
+        TransformLayout layout,
+        int flags,
+        float[] outTransforms
+    );
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_pose_buffer_create(IntPtr model);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_pose_buffer_free(IntPtr buffer);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_pose_buffer_push(IntPtr buffer, IntPtr data);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_pose_buffer_interpolate(
+        IntPtr buffer,
+        float alpha,
+        int[]? bodyIds,
+        int bodyCount,
+        float[]? worldOffsetXyz,
+        TransformLayout layout,
+        int flags,
+        float[] outTransforms
+    );
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_export_body_transforms(
+        IntPtr batch,
+        int[]? bodyIds,
+        int bodyCount,
+        float[]? envOffsetsXyz,
+        TransformLayout layout,
+        int flags,
+        float[] outTransforms
+    );
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_nsensor(IntPtr model);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_nsensordata(IntPtr model);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_sensor_id(IntPtr model, [MarshalAs(UnmanagedType.LPUTF8Str)] string sensorName);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_sensor_adr(IntPtr model, int sensorId);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_sensor_dim(IntPtr model, int sensorId);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_sensor_map_create(IntPtr model);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_sensor_map_free(IntPtr map);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_sensor_map_size(IntPtr map);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_sensor_map_add(
+        IntPtr map,
+        [MarshalAs(UnmanagedType.LPUTF8Str)] string sensorName,
+        out int outOffset
+    );
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_sensor_map_add_all(IntPtr map);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_sensor_map_offset(IntPtr map, int sensorId);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_sensor_read(IntPtr map, IntPtr data, double[] outValues);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_sensor_read_f32(IntPtr map, IntPtr data, float[] outValues);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_sensor_read(IntPtr map, IntPtr batch, double[] outValues);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_sensor_read_f32(IntPtr map, IntPtr batch, float[] outValues);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_contact_filter_create(IntPtr model);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_contact_filter_free(IntPtr filter);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_contact_filter_add_body(IntPtr filter, int bodyId);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_contact_filter_set_min_force(IntPtr filter, double minNormalForce);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_export_contacts(
+        IntPtr model,
+        IntPtr data,
+        IntPtr filter,
+        int flags,
+        [Out] Contact[] outContacts,
+        int capacity,
+        out int outCount
+    );
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_export_contacts(
+        IntPtr batch,
+        IntPtr filter,
+        int flags,
+        [Out] Contact[] outContacts,
+        int capacityPerEnv,
+        int[] outCounts
+    );
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_ray_set_create(IntPtr model);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_ray_set_free(IntPtr set);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_ray_set_size(IntPtr set);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_ray_set_add(
+        IntPtr set,
+        int frameBodyId,
+        int excludeBodyId,
+        double[] originXyz,
+        double[] directionsXyz,
+        int count
+    );
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_ray_set_filter(IntPtr set, int groupMask, int includeStatic);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_ray_set_max_distance(IntPtr set, double maxDistance);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_raycast(IntPtr set, IntPtr data, double[] outDistances, int[]? outGeomIds);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_raycast_f32(IntPtr set, IntPtr data, float[] outDistances, int[]? outGeomIds);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_raycast(IntPtr set, IntPtr batch, double[] outDistances, int[]? outGeomIds);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_raycast_f32(IntPtr set, IntPtr batch, float[] outDistances, int[]? outGeomIds);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_batch_create(IntPtr model, int envCount);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_batch_create_sized(IntPtr model, int envCount, UIntPtr arenaBytes);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_batch_free(IntPtr batch);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_size(IntPtr batch);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_batch_env(IntPtr batch, int envIndex);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_state_size(IntPtr model, StateSignature signature);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_state_save(IntPtr model, IntPtr data, StateSignature signature, double[] outState);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_state_restore(IntPtr model, IntPtr data, StateSignature signature, double[] state);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_snapshot_ring_configure(IntPtr model, IntPtr data, int capacity, StateSignature signature);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_snapshot_push(IntPtr model, IntPtr data);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_snapshot_count(IntPtr data);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_snapshot_restore(IntPtr model, IntPtr data, int age);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_snapshot_rollback(IntPtr model, IntPtr data, int age);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_recorder_open(
+        IntPtr model,
+        [MarshalAs(UnmanagedType.LPUTF8Str)] string path,
+        StateSignature signature,
+        int keyframeInterval,
+        double quantum,
+        byte[] errorBuffer,
+        UIntPtr errorBufferSize
+    );
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_recorder_attach(IntPtr recorder, IntPtr data);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_recorder_append(IntPtr recorder, IntPtr data);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern long gmj_recorder_frame_count(IntPtr recorder);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_recorder_close(IntPtr recorder);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_replay_open(
+        [MarshalAs(UnmanagedType.LPUTF8Str)] string path,
+        byte[] errorBuffer,
+        UIntPtr errorBufferSize
+    );
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_replay_close(IntPtr replay);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_replay_get_info(IntPtr replay, out ReplayInfo info);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_replay_read(IntPtr replay, long step, double[]? outCtrl, double[]? outState);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_replay_apply(IntPtr replay, IntPtr model, IntPtr data, long step);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_sim_thread_start(
+        IntPtr model,
+        IntPtr data,
+        IntPtr task,
+        double tickRateHz,
+        int stepsPerTick,
+        int queueCapacity
+    );
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_sim_thread_stop(IntPtr sim);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_sim_post_ctrl(IntPtr sim, int startIndex, int count, double[] values);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_sim_post_reset(IntPtr sim);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_sim_latest_state(IntPtr sim, out SimState state, out SimStats stats);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_sim_interpolate_transforms(
+        IntPtr sim,
+        float alpha,
+        int[]? bodyIds,
+        int bodyCount,
+        float[]? worldOffsetXyz,
+        TransformLayout layout,
+        int flags,
+        float[] outTransforms
+    );
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_thread_pool_create(int threadCount);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_thread_pool_free(IntPtr pool);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_thread_pool_size(IntPtr pool);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_thread_pool_stats(IntPtr pool, int threadIndex, out ThreadStats outStats);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_thread_pool_reset_stats(IntPtr pool);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_set_thread_pool(IntPtr batch, IntPtr pool);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_reset(IntPtr batch);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_reset_env(IntPtr batch, int envIndex);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_reload(IntPtr batch, IntPtr newModel);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_randomize(IntPtr batch, IntPtr randomizer, ulong seed);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_step(IntPtr batch, double[]? ctrl, int steps, double[]? outQpos, double[]? outQvel);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_get_state(IntPtr batch, double[]? outQpos, double[]? outQvel);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_step_f32(IntPtr batch, float[]? ctrl, int steps, float[]? outQpos, float[]? outQvel);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_get_state_f32(IntPtr batch, float[]? outQpos, float[]? outQvel);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_get_slice_f32(IntPtr batch, StateField field, int startIndex, int count, float[] outValues);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_set_slice_f32(IntPtr batch, StateField field, int startIndex, int count, float[] values);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_stats(IntPtr batch, out Stats outStats);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_obs_spec_create(IntPtr model);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_obs_spec_free(IntPtr spec);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_obs_spec_size(IntPtr spec);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_obs_spec_add_range(IntPtr spec, ObsSource source, int startIndex, int count);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_obs_spec_add_body(IntPtr spec, ObsSource source, int bodyId, int rootBodyId);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_obs_fill(IntPtr spec, IntPtr data, double[] outValues);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_obs_fill_f32(IntPtr spec, IntPtr data, float[] outValues);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_obs_fill(IntPtr spec, IntPtr batch, double[] outValues);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_obs_fill_f32(IntPtr spec, IntPtr batch, float[] outValues);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_cmd_list_create(IntPtr model);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_cmd_list_free(IntPtr list);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_cmd_list_size(IntPtr list);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_cmd_list_clear(IntPtr list);
+
+    // Buffer arguments are kept by the list: pass AllocatePinned arrays.
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_cmd_set_ctrl(IntPtr list, int startIndex, int count, IntPtr values);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_cmd_step(IntPtr list, int steps);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_cmd_copy(IntPtr list, StateField field, int startIndex, int count, IntPtr outValues);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_cmd_export_transforms(
+        IntPtr list,
+        int[]? bodyIds,
+        int bodyCount,
+        float[]? worldOffsetXyz,
+        TransformLayout layout,
+        int flags,
+        IntPtr outTransforms
+    );
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_execute(IntPtr list, IntPtr data);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern SimdLevel gmj_simd_get_level();
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_simd_set_limit(SimdLevel maxLevel);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_policy_load(
+        [MarshalAs(UnmanagedType.LPUTF8Str)] string policyPath,
+        [MarshalAs(UnmanagedType.LPUTF8Str)] string? vecNormPath,
+        byte[] errorBuffer,
+        UIntPtr errorBufferSize
+    );
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_policy_load_json(
+        [MarshalAs(UnmanagedType.LPUTF8Str)] string policyJson,
+        [MarshalAs(UnmanagedType.LPUTF8Str)] string? vecNormJson,
+        byte[] errorBuffer,
+        UIntPtr errorBufferSize
+    );
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_policy_free(IntPtr policy);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_policy_obs_size(IntPtr policy);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_policy_action_size(IntPtr policy);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_policy_infer(IntPtr policy, double[] observation, int obsCount, double[] outActions, int actionCount);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_policy_apply(IntPtr policy, IntPtr spec, IntPtr data, int ctrlStart, double[]? outActions);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_apply_policy(IntPtr batch, IntPtr policy, IntPtr spec, int ctrlStart, double[]? outActions);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern IntPtr gmj_task_create(IntPtr model);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern void gmj_task_free(IntPtr task);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_task_add_reward(IntPtr task, RewardTerm term, int bodyId, int axis, double threshold, double weight);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_task_add_termination(IntPtr task, Termination condition, int bodyId, int axis, double threshold);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_task_set_time_limit(IntPtr task, double seconds);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_task_set_reset_keyframe(IntPtr task, int keyIndex);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_task_step(IntPtr task, IntPtr data, int steps, out double reward, out byte done);
+
+    [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
+    public static extern int gmj_batch_step_task(IntPtr batch, IntPtr task, double[]? ctrl, int steps, double[]? outRewards, byte[]? outDone);
+
     [DllImport(LibraryName, CallingConvention = CallingConvention.Cdecl)]
     private static extern IntPtr gmj_last_mujoco_error();
 
@@ -110,6 +945,33 @@ public static class MujocoNative
         return ptr == IntPtr.Zero ? string.Empty : Marshal.PtrToStringUTF8(ptr) ?? string.Empty;
     }
 
+    // Only valid while gmj_data_generation(data) == view.Generation.
+    public static unsafe Span<double> AsSpan(View view)
+    {
+        return view.Values == IntPtr.Zero || view.Count <= 0
+            ? Span<double>.Empty
+            : new Span<double>((void*)view.Values, view.Count);
+    }
+
+    public static unsafe ReadOnlySpan<double> AsSpan(IntPtr values, int count)
+    {
+        return values == IntPtr.Zero || count <= 0
+            ? ReadOnlySpan<double>.Empty
+            : new ReadOnlySpan<double>((void*)values, count);
+    }
+
+    // Arrays on the pinned object heap never move, so their address can be
+    // recorded into a gmj_cmd_list once and used on every gmj_execute.
+    public static T[] AllocatePinned<T>(int length) where T : unmanaged
+    {
+        return length > 0 ? GC.AllocateArray<T>(length, pinned: true) : Array.Empty<T>();
+    }
+
+    public static IntPtr AddressOf<T>(T[] pinned) where T : unmanaged
+    {
+        return pinned.Length > 0 ? Marshal.UnsafeAddrOfPinnedArrayElement(pinned, 0) : IntPtr.Zero;
+    }
+
     public static byte[] CreateErrorBuffer()
     {
         return new byte[ErrorBufferBytes];
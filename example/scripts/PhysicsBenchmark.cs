@@ -1,7 +1,6 @@
 using System;
 using System.Collections.Generic;
 using System.Diagnostics;
-using System.IO;
 using System.Text;
 using System.Threading.Tasks;
 using Godot;
@@ -101,10 +100,10 @@ public partial class PhysicsBenchmark : Node3D
 
     private double RunMujocoBenchmark(int objectCount, double durationSec)
     {
-        string xmlPath = WriteMujocoBenchmarkXml(objectCount);
+        string xml = BuildMujocoXml(objectCount);
         byte[] errorBuffer = MujocoNative.CreateErrorBuffer();
 
-        IntPtr model = MujocoNative.gmj_model_load_xml(xmlPath, errorBuffer, (UIntPtr)errorBuffer.Length);
+        IntPtr model = MujocoNative.gmj_model_load_xml_string(xml, IntPtr.Zero, errorBuffer, (UIntPtr)errorBuffer.Length);
         if (model == IntPtr.Zero)
         {
             GD.PushError("MuJoCo benchmark load failed: " + MujocoNative.LastError());
@@ -138,17 +137,6 @@ public partial class PhysicsBenchmark : Node3D
         return executedSteps / sw.Elapsed.TotalSeconds;
     }
 
-    private static string WriteMujocoBenchmarkXml(int objectCount)
-    {
-        string path = ProjectSettings.GlobalizePath("user://mujoco_benchmark_" + objectCount + ".xml");
-        if (!File.Exists(path))
-        {
-            string xml = BuildMujocoXml(objectCount);
-            File.WriteAllText(path, xml);
-        }
-        return path;
-    }
-
     private static string BuildMujocoXml(int objectCount)
     {
         var sb = new StringBuilder();
@@ -9,6 +9,23 @@ extern "C" {
 
 typedef struct gmj_model gmj_model;
 typedef struct gmj_data gmj_data;
+typedef struct gmj_batch gmj_batch;
+typedef struct gmj_thread_pool gmj_thread_pool;
+typedef struct gmj_vfs gmj_vfs;
+typedef struct gmj_obs_spec gmj_obs_spec;
+typedef struct gmj_policy gmj_policy;
+typedef struct gmj_task gmj_task;
+typedef struct gmj_recorder gmj_recorder;
+typedef struct gmj_replay gmj_replay;
+typedef struct gmj_sim_thread gmj_sim_thread;
+typedef struct gmj_pose_buffer gmj_pose_buffer;
+typedef struct gmj_cmd_list gmj_cmd_list;
+typedef struct gmj_contact_filter gmj_contact_filter;
+typedef struct gmj_sensor_map gmj_sensor_map;
+typedef struct gmj_ray_set gmj_ray_set;
+typedef struct gmj_reloader gmj_reloader;
+typedef struct gmj_randomizer gmj_randomizer;
+typedef struct gmj_data_pool gmj_data_pool;
 
 typedef enum gmj_error_code {
   GMJ_OK = 0,
@@ -16,18 +33,300 @@ typedef enum gmj_error_code {
   GMJ_ERR_LOAD_MODEL = 2,
   GMJ_ERR_ALLOCATION = 3,
   GMJ_ERR_INDEX_OUT_OF_RANGE = 4,
-  GMJ_ERR_MUJOCO = 5
+  GMJ_ERR_MUJOCO = 5,
+  GMJ_ERR_QUEUE_FULL = 6
 } gmj_error_code;
 
+typedef enum gmj_state_field {
+  GMJ_FIELD_QPOS = 0,
+  GMJ_FIELD_QVEL = 1,
+  GMJ_FIELD_CTRL = 2,
+  GMJ_FIELD_ACT = 3,
+  GMJ_FIELD_XPOS = 4,
+  GMJ_FIELD_XQUAT = 5,
+  GMJ_FIELD_XMAT = 6,
+  GMJ_FIELD_SENSORDATA = 7
+} gmj_state_field;
+
+typedef struct gmj_view {
+  double* values;
+  int count;
+  int width;
+  unsigned long long generation;
+} gmj_view;
+
+typedef enum gmj_transform_layout {
+  GMJ_TRANSFORM_MULTIMESH = 0,
+  GMJ_TRANSFORM_POS_QUAT = 1
+} gmj_transform_layout;
+
+#define GMJ_TRANSFORM_Y_UP 1
+
+typedef enum gmj_obs_source {
+  GMJ_OBS_QPOS = 0,
+  GMJ_OBS_QVEL = 1,
+  GMJ_OBS_SENSORDATA = 2,
+  GMJ_OBS_PREV_ACTION = 3,
+  GMJ_OBS_BODY_POS_REL = 4,
+  GMJ_OBS_BODY_POS_LOCAL = 5
+} gmj_obs_source;
+
+typedef enum gmj_simd_level {
+  GMJ_SIMD_SCALAR = 0,
+  GMJ_SIMD_AVX2 = 1,
+  GMJ_SIMD_AVX512 = 2
+} gmj_simd_level;
+
+typedef enum gmj_reward_term {
+  GMJ_REWARD_FORWARD = 0,
+  GMJ_REWARD_HEIGHT = 1,
+  GMJ_REWARD_CTRL_COST = 2
+} gmj_reward_term;
+
+typedef enum gmj_termination {
+  GMJ_TERMINATE_BELOW = 0,
+  GMJ_TERMINATE_ABOVE = 1
+} gmj_termination;
+
+typedef enum gmj_done_flag {
+  GMJ_DONE_NONE = 0,
+  GMJ_DONE_TERMINATED = 1,
+  GMJ_DONE_TRUNCATED = 2
+} gmj_done_flag;
+
+/* Randomizable model parameters. Friction is the sliding coefficient and
+   gear the first gear entry; mass scales body inertia along with it. */
+typedef enum gmj_param {
+  GMJ_PARAM_BODY_MASS = 0,
+  GMJ_PARAM_GEOM_FRICTION = 1,
+  GMJ_PARAM_DOF_DAMPING = 2,
+  GMJ_PARAM_ACTUATOR_GEAR = 3
+} gmj_param;
+
+typedef enum gmj_rand_op {
+  GMJ_RAND_SCALE = 0,
+  GMJ_RAND_SET = 1
+} gmj_rand_op;
+
+/* a/b are low/high for the uniform kinds and mean/stddev for normal. */
+typedef enum gmj_dist {
+  GMJ_DIST_UNIFORM = 0,
+  GMJ_DIST_LOG_UNIFORM = 1,
+  GMJ_DIST_NORMAL = 2
+} gmj_dist;
+
+typedef struct gmj_load_info {
+  int cache_hit;
+  int cache_written;
+  double load_seconds;
+  unsigned long long content_hash;
+} gmj_load_info;
+
+typedef struct gmj_reload_info {
+  unsigned long long generation;
+  long long polls;
+  long long failures;
+  double last_compile_seconds;
+  unsigned long long content_hash;
+} gmj_reload_info;
+
+typedef struct gmj_replay_info {
+  long long frame_count;
+  int signature;
+  int nu;
+  int state_size;
+  int keyframe_interval;
+  double quantum;
+} gmj_replay_info;
+
+typedef struct gmj_thread_stats {
+  long long items_processed;
+  long long items_stolen;
+  long long dispatches;
+  double busy_seconds;
+} gmj_thread_stats;
+
+#define GMJ_STATS_TIMERS 16
+#define GMJ_STATS_WARNINGS 8
+
+/* Per-data diagnostics. steps/step_seconds and the *_max high-water marks
+   accumulate over the data's lifetime (or since gmj_data_reset_stats), as do
+   warnings (indexed like mjtWarning; a bad-state reset inside mj_step counts
+   once). timer_* (indexed like mjtTimer: step, forward, ..., constraint,
+   ..., collision broad/narrow phase), arena/stack peaks and the current ncon/nefc/solver_iterations are read from mjData and
+   restart when the data is reset; *_peak_max_bytes keep the lifetime peaks
+   for sizing arenas. buffer_bytes + arena_bytes is the mjData allocation.
+   Timer durations need gmj_stats_enable_timers. */
+typedef struct gmj_stats {
+  long long steps;
+  double step_seconds;
+  double timer_seconds[GMJ_STATS_TIMERS];
+  long long timer_calls[GMJ_STATS_TIMERS];
+  long long warnings[GMJ_STATS_WARNINGS];
+  int solver_iterations;
+  int solver_iterations_max;
+  int ncon;
+  int ncon_max;
+  int nefc;
+  int nefc_max;
+  long long buffer_bytes;
+  long long arena_bytes;
+  long long arena_peak_bytes;
+  long long stack_peak_bytes;
+  long long arena_peak_max_bytes;
+  long long stack_peak_max_bytes;
+} gmj_stats;
+
+typedef struct gmj_data_pool_info {
+  int idle;
+  long long idle_bytes;
+  long long created;
+  long long reused;
+} gmj_data_pool_info;
+
+typedef struct gmj_sim_stats {
+  long long ticks;
+  long long steps;
+  long long resets;
+  long long missed_deadlines;
+  long long commands_applied;
+  long long commands_rejected;
+  int queue_depth;
+  int queue_high_water;
+  int queue_capacity;
+  double last_tick_seconds;
+  double max_lateness_seconds;
+} gmj_sim_stats;
+
+/* Read-only arrays of the latest published tick; xpos is [nbody x 3] and
+   xquat [nbody x 4] (w x y z). */
+typedef struct gmj_sim_state {
+  unsigned long long tick;
+  double time;
+  double reward;
+  int done;
+  int nq;
+  int nv;
+  int nu;
+  int nbody;
+  const double* qpos;
+  const double* qvel;
+  const double* ctrl;
+  const double* xpos;
+  const double* xquat;
+} gmj_sim_state;
+
 const char* gmj_mujoco_version(void);
 
 gmj_model* gmj_model_load_xml(const char* xml_path, char* error_buffer,
                               size_t error_buffer_size);
+/* Returns a shared model for the file, compiling it only when no cached
+   model exists for the same canonical path and contents (the XML, its
+   includes and referenced assets, hashed as for the compile cache). Each
+   acquire must be paired with gmj_model_free, which releases one
+   reference. */
+gmj_model* gmj_model_acquire_xml(const char* xml_path, char* error_buffer,
+                                 size_t error_buffer_size);
 void gmj_model_free(gmj_model* model);
+int gmj_model_cache_count(void);
+int gmj_model_refcount(const gmj_model* model);
+
+/* Watches an MJCF file (and its includes and assets) from a background
+   thread, recompiling once the content hash has been stable for two polls.
+   gmj_reloader_latest returns a new reference to the newest compile when it
+   is newer than *inout_generation (start at 0) and advances it; otherwise
+   NULL. Release returned models with gmj_model_free. */
+gmj_reloader* gmj_reloader_create(const char* xml_path, double poll_seconds);
+void gmj_reloader_free(gmj_reloader* reloader);
+gmj_model* gmj_reloader_latest(gmj_reloader* reloader,
+                               unsigned long long* inout_generation);
+gmj_error_code gmj_reloader_info(gmj_reloader* reloader,
+                                 gmj_reload_info* out_info);
+gmj_error_code gmj_reloader_last_error(gmj_reloader* reloader, char* buffer,
+                                       size_t buffer_size);
+
+/* When set, XML loads are served from <cache_dir>/<name>-<hash>-mj<ver>.mjb.
+   The hash covers the XML, its includes and referenced asset files; a miss
+   compiles the XML and writes the binary. NULL or "" disables the cache. */
+gmj_error_code gmj_compile_cache_set_dir(const char* cache_dir);
+gmj_error_code gmj_model_load_info(const gmj_model* model,
+                                   gmj_load_info* out_info);
+
+/* In-memory assets. Files are matched by the name the MJCF uses to refer to
+   them; the vfs copies each buffer. */
+gmj_vfs* gmj_vfs_create(void);
+void gmj_vfs_free(gmj_vfs* vfs);
+gmj_error_code gmj_vfs_add_buffer(gmj_vfs* vfs, const char* name,
+                                  const void* buffer, size_t size);
+gmj_error_code gmj_vfs_remove(gmj_vfs* vfs, const char* name);
+
+/* Loads a model from memory. Names ending in .mjb are read as compiled
+   binaries, anything else as MJCF. vfs may be NULL when the model has no
+   in-memory assets. */
+gmj_model* gmj_model_load_buffer(const char* name, const void* buffer,
+                                 size_t size, gmj_vfs* vfs,
+                                 char* error_buffer,
+                                 size_t error_buffer_size);
+gmj_model* gmj_model_load_xml_string(const char* xml, gmj_vfs* vfs,
+                                     char* error_buffer,
+                                     size_t error_buffer_size);
 
 gmj_data* gmj_data_create(const gmj_model* model);
+/* arena_bytes sizes the mjData arena, which also holds the MuJoCo stack;
+   0 keeps the model's <size memory>. Sizes below a per-model floor (64 KiB
+   plus two dense nv x nv matrices) are rejected. Size it from the lifetime
+   arena_peak_max_bytes + stack_peak_max_bytes with some margin: a stack
+   overflow is a fatal MuJoCo error. */
+gmj_data* gmj_data_create_sized(const gmj_model* model, size_t arena_bytes);
 void gmj_data_free(gmj_data* data);
 
+/* Recycles data by model and arena size. acquire hands out a reset idle
+   data (generation bumped, stats cleared) or creates one; release returns
+   it with its snapshot ring, randomization and recorder dropped, or frees
+   it once max_idle (0 = unbounded) data are idle. Thread-safe. Idle data
+   hold a reference on their model, so gmj_model_free may come first; the
+   model is released once its idle data are trimmed (NULL = all models),
+   reused or freed with the pool. */
+gmj_data_pool* gmj_data_pool_create(int max_idle);
+void gmj_data_pool_free(gmj_data_pool* pool);
+gmj_data* gmj_data_pool_acquire(gmj_data_pool* pool, const gmj_model* model,
+                                size_t arena_bytes);
+void gmj_data_pool_release(gmj_data_pool* pool, const gmj_model* model,
+                           gmj_data* data);
+int gmj_data_pool_trim(gmj_data_pool* pool, const gmj_model* model);
+gmj_error_code gmj_data_pool_stats(gmj_data_pool* pool,
+                                   gmj_data_pool_info* out_info);
+
+/* Rebuilds data for new_model in place, carrying time, qpos/qvel by joint
+   name and ctrl by actuator name; anything without a match keeps the new
+   model's defaults. The snapshot ring and any randomization are cleared and
+   a recorder detached.
+   data must not be in use by another thread. */
+gmj_error_code gmj_data_migrate(const gmj_model* old_model, gmj_data* data,
+                                const gmj_model* new_model);
+
+/* Domain randomization. Each term draws one value per element, either
+   scaling the base value or replacing it; name picks one body, geom, joint
+   (all of its dofs) or actuator, NULL every element. A randomized data
+   shares the base model and owns copies of only the arrays its terms touch.
+   New values are drawn on every reset (gmj_reset_data, batch resets, task
+   and sim-thread auto-resets) without allocating. Derived constants other
+   than subtree mass and inertia keep their base values. */
+gmj_randomizer* gmj_randomizer_create(const gmj_model* model);
+void gmj_randomizer_free(gmj_randomizer* randomizer);
+gmj_error_code gmj_randomizer_add(gmj_randomizer* randomizer, gmj_param param,
+                                  const char* name, gmj_rand_op op,
+                                  gmj_dist dist, double a, double b);
+/* Copies the randomizer's terms and makes the first draw; NULL randomizer
+   restores the base parameters. */
+gmj_error_code gmj_data_randomize(const gmj_model* model, gmj_data* data,
+                                  const gmj_randomizer* randomizer,
+                                  unsigned long long seed);
+/* The value data currently steps with; index is a body, geom, dof or
+   actuator id. */
+gmj_error_code gmj_data_param(const gmj_model* model, const gmj_data* data,
+                              gmj_param param, int index, double* out_value);
+
 gmj_error_code gmj_reset_data(const gmj_model* model, gmj_data* data);
 gmj_error_code gmj_step(const gmj_model* model, gmj_data* data, int steps);
 
@@ -35,14 +334,21 @@ int gmj_nq(const gmj_model* model);
 int gmj_nv(const gmj_model* model);
 int gmj_nu(const gmj_model* model);
 int gmj_nbody(const gmj_model* model);
+int gmj_nsensor(const gmj_model* model);
+int gmj_nsensordata(const gmj_model* model);
 
 int gmj_body_id(const gmj_model* model, const char* body_name);
 int gmj_joint_id(const gmj_model* model, const char* joint_name);
 int gmj_actuator_id(const gmj_model* model, const char* actuator_name);
+int gmj_sensor_id(const gmj_model* model, const char* sensor_name);
 
 const char* gmj_body_name(const gmj_model* model, int body_id);
 const char* gmj_joint_name(const gmj_model* model, int joint_id);
 const char* gmj_actuator_name(const gmj_model* model, int actuator_id);
+const char* gmj_sensor_name(const gmj_model* model, int sensor_id);
+/* Where the sensor's values start in sensordata, and how many there are. */
+int gmj_sensor_adr(const gmj_model* model, int sensor_id);
+int gmj_sensor_dim(const gmj_model* model, int sensor_id);
 
 gmj_error_code gmj_set_ctrl(const gmj_model* model, gmj_data* data,
                             int actuator_index, double value);
@@ -80,12 +386,477 @@ gmj_error_code gmj_set_ctrl_slice(const gmj_model* model, gmj_data* data,
                                   int start_index, int count,
                                   const double* values);
 
+/* float32 variants of the slice accessors. gmj_get_slice_f32 reads any
+   state field over its flattened array; gmj_set_slice_f32 writes qpos,
+   qvel, ctrl or act. Conversion uses the SIMD level of gmj_simd_get_level. */
+gmj_error_code gmj_get_qpos_slice_f32(const gmj_model* model,
+                                      const gmj_data* data, int start_index,
+                                      int count, float* out_values);
+gmj_error_code gmj_set_qpos_slice_f32(const gmj_model* model, gmj_data* data,
+                                      int start_index, int count,
+                                      const float* values);
+gmj_error_code gmj_get_qvel_slice_f32(const gmj_model* model,
+                                      const gmj_data* data, int start_index,
+                                      int count, float* out_values);
+gmj_error_code gmj_set_qvel_slice_f32(const gmj_model* model, gmj_data* data,
+                                      int start_index, int count,
+                                      const float* values);
+gmj_error_code gmj_get_ctrl_slice_f32(const gmj_model* model,
+                                      const gmj_data* data, int start_index,
+                                      int count, float* out_values);
+gmj_error_code gmj_set_ctrl_slice_f32(const gmj_model* model, gmj_data* data,
+                                      int start_index, int count,
+                                      const float* values);
+gmj_error_code gmj_get_slice_f32(const gmj_model* model, const gmj_data* data,
+                                 gmj_state_field field, int start_index,
+                                 int count, float* out_values);
+gmj_error_code gmj_set_slice_f32(const gmj_model* model, gmj_data* data,
+                                 gmj_state_field field, int start_index,
+                                 int count, const float* values);
+
 gmj_error_code gmj_body_world_position(const gmj_model* model,
                                        const gmj_data* data, int body_index,
                                        double* out_xyz_3);
 
 gmj_error_code gmj_forward(const gmj_model* model, gmj_data* data);
 
+/* Zero-copy view into the mjData array for field. values stays valid while
+   gmj_data_generation(data) still equals view.generation; the generation
+   changes whenever the bridge replaces the underlying buffers. */
+gmj_error_code gmj_data_view(const gmj_model* model, gmj_data* data,
+                             gmj_state_field field, gmj_view* out_view);
+unsigned long long gmj_data_generation(const gmj_data* data);
+
+/* A plain struct copy, cheap enough to poll every frame. Not while a sim
+   thread owns the data; use the stats of gmj_sim_latest_state instead. */
+gmj_error_code gmj_data_stats(const gmj_model* model, const gmj_data* data,
+                              gmj_stats* out_stats);
+void gmj_data_reset_stats(gmj_data* data);
+/* Installs (or removes) mjcb_time so MuJoCo fills the timer durations, in
+   seconds. The callback is process-wide and costs a clock read per phase. */
+void gmj_stats_enable_timers(int enabled);
+
+/* State signatures; the bits match mjtState. */
+#define GMJ_STATE_TIME (1 << 0)
+#define GMJ_STATE_QPOS (1 << 1)
+#define GMJ_STATE_QVEL (1 << 2)
+#define GMJ_STATE_ACT (1 << 3)
+#define GMJ_STATE_WARMSTART (1 << 4)
+#define GMJ_STATE_CTRL (1 << 5)
+#define GMJ_STATE_QFRC_APPLIED (1 << 6)
+#define GMJ_STATE_XFRC_APPLIED (1 << 7)
+#define GMJ_STATE_EQ_ACTIVE (1 << 8)
+#define GMJ_STATE_MOCAP_POS (1 << 9)
+#define GMJ_STATE_MOCAP_QUAT (1 << 10)
+#define GMJ_STATE_USERDATA (1 << 11)
+#define GMJ_STATE_PLUGIN (1 << 12)
+#define GMJ_STATE_PHYSICS (GMJ_STATE_QPOS | GMJ_STATE_QVEL | GMJ_STATE_ACT)
+#define GMJ_STATE_FULLPHYSICS \
+  (GMJ_STATE_TIME | GMJ_STATE_PHYSICS | GMJ_STATE_PLUGIN)
+#define GMJ_STATE_USER                                                  \
+  (GMJ_STATE_CTRL | GMJ_STATE_QFRC_APPLIED | GMJ_STATE_XFRC_APPLIED |   \
+   GMJ_STATE_EQ_ACTIVE | GMJ_STATE_MOCAP_POS | GMJ_STATE_MOCAP_QUAT |   \
+   GMJ_STATE_USERDATA)
+#define GMJ_STATE_INTEGRATION \
+  (GMJ_STATE_FULLPHYSICS | GMJ_STATE_USER | GMJ_STATE_WARMSTART)
+
+/* Number of doubles in a state with this signature. Restores do not run
+   mj_forward; call gmj_forward if derived quantities are needed. */
+int gmj_state_size(const gmj_model* model, int signature);
+gmj_error_code gmj_state_save(const gmj_model* model, const gmj_data* data,
+                              int signature, double* out_state);
+gmj_error_code gmj_state_restore(const gmj_model* model, gmj_data* data,
+                                 int signature, const double* state);
+
+/* Fixed-capacity snapshot ring owned by data, allocated once here
+   (capacity 0 releases it). Push overwrites the oldest entry when full.
+   age 0 is the newest snapshot; rollback also discards the snapshots newer
+   than the one restored. */
+gmj_error_code gmj_snapshot_ring_configure(const gmj_model* model,
+                                           gmj_data* data, int capacity,
+                                           int signature);
+gmj_error_code gmj_snapshot_push(const gmj_model* model, gmj_data* data);
+int gmj_snapshot_count(const gmj_data* data);
+gmj_error_code gmj_snapshot_restore(const gmj_model* model, gmj_data* data,
+                                    int age);
+gmj_error_code gmj_snapshot_rollback(const gmj_model* model, gmj_data* data,
+                                     int age);
+
+/* Binary trajectory recording. While attached to a data, every mj_step run
+   by gmj_step / gmj_batch_step appends ctrl + mj_getState(signature);
+   gmj_recorder_append adds a frame by hand. Every keyframe_interval-th
+   frame is stored exactly, the rest as deltas rounded to quantum
+   (<= 0 selects 256 and 1e-6). Frames are written by a background thread;
+   close flushes them and writes the keyframe index. */
+gmj_recorder* gmj_recorder_open(const gmj_model* model, const char* path,
+                                int signature, int keyframe_interval,
+                                double quantum, char* error_buffer,
+                                size_t error_buffer_size);
+gmj_error_code gmj_recorder_attach(gmj_recorder* recorder, gmj_data* data);
+gmj_error_code gmj_recorder_append(gmj_recorder* recorder,
+                                   const gmj_data* data);
+long long gmj_recorder_frame_count(const gmj_recorder* recorder);
+gmj_error_code gmj_recorder_close(gmj_recorder* recorder);
+
+/* Memory-mapped replay. A read decodes from the nearest keyframe (or
+   continues from the previous read); apply also writes ctrl and the state
+   into data. Files that were never closed are indexed by scanning. */
+gmj_replay* gmj_replay_open(const char* path, char* error_buffer,
+                            size_t error_buffer_size);
+void gmj_replay_close(gmj_replay* replay);
+gmj_error_code gmj_replay_get_info(const gmj_replay* replay,
+                                   gmj_replay_info* out_info);
+gmj_error_code gmj_replay_read(gmj_replay* replay, long long step,
+                               double* out_ctrl, double* out_state);
+gmj_error_code gmj_replay_apply(gmj_replay* replay, const gmj_model* model,
+                                gmj_data* data, long long step);
+
+/* Writes one float32 record per body: 12 floats (Godot Transform3D /
+   MultiMesh rows: basis row + origin, three times) for
+   GMJ_TRANSFORM_MULTIMESH, or 7 floats (position, quaternion x y z w) for
+   GMJ_TRANSFORM_POS_QUAT. body_ids NULL exports bodies 0..body_count-1.
+   world_offset_xyz (may be NULL) is added to every position. */
+gmj_error_code gmj_export_body_transforms(const gmj_model* model,
+                                          const gmj_data* data,
+                                          const int* body_ids, int body_count,
+                                          const float* world_offset_xyz,
+                                          gmj_transform_layout layout,
+                                          int flags, float* out_transforms);
+
+/* Keeps the body poses of the last two pushes (call push after each
+   physics tick) and writes the same records as gmj_export_body_transforms,
+   blended at alpha in [0, 1] from the older pose to the newer one:
+   positions lerped, orientations slerped. */
+gmj_pose_buffer* gmj_pose_buffer_create(const gmj_model* model);
+void gmj_pose_buffer_free(gmj_pose_buffer* buffer);
+gmj_error_code gmj_pose_buffer_push(gmj_pose_buffer* buffer,
+                                    const gmj_data* data);
+gmj_error_code gmj_pose_buffer_interpolate(gmj_pose_buffer* buffer,
+                                           float alpha, const int* body_ids,
+                                           int body_count,
+                                           const float* world_offset_xyz,
+                                           gmj_transform_layout layout,
+                                           int flags, float* out_transforms);
+
+/* Contacts of the last step. pos and normal are in world axes (Y-up with
+   GMJ_TRANSFORM_Y_UP); normal is the first axis of the contact frame and
+   points from geom1 towards geom2. force is mj_contactForce in the contact
+   frame: [0] normal, [1] and [2] friction along the tangent axes; it is
+   zero for excluded contacts. Flex contacts report geom and body -1. */
+typedef struct gmj_contact {
+  int geom1;
+  int geom2;
+  int body1;
+  int body2;
+  float pos[3];
+  float normal[3];
+  float penetration;
+  float force[3];
+} gmj_contact;
+
+/* Keeps contacts touching any of the added bodies (all contacts when none
+   are added) whose normal force is at least min_normal_force. */
+gmj_contact_filter* gmj_contact_filter_create(const gmj_model* model);
+void gmj_contact_filter_free(gmj_contact_filter* filter);
+gmj_error_code gmj_contact_filter_add_body(gmj_contact_filter* filter,
+                                           int body_id);
+gmj_error_code gmj_contact_filter_set_min_force(gmj_contact_filter* filter,
+                                                double min_normal_force);
+
+/* filter may be NULL. Writes at most capacity records in mjData.contact
+   order; *out_count is the number that matched, which may exceed capacity
+   (grow the buffer and call again to get the rest). */
+gmj_error_code gmj_export_contacts(const gmj_model* model,
+                                   const gmj_data* data,
+                                   const gmj_contact_filter* filter, int flags,
+                                   gmj_contact* out_contacts, int capacity,
+                                   int* out_count);
+
+/* Rays registered once and cast with mj_multiRay. Each add is a fan of
+   count rays from one origin; origin and directions are in the frame of
+   frame_body_id (0 is the world) and follow that body every cast.
+   Directions are normalized when added, so distances are in meters.
+   exclude_body_id (-1 for none) is ignored by the fan, typically the body
+   the sensor sits on. Results are laid out in add order: distance (-1 when
+   nothing is hit within max_distance) and geom id (-1 likewise). */
+gmj_ray_set* gmj_ray_set_create(const gmj_model* model);
+void gmj_ray_set_free(gmj_ray_set* set);
+int gmj_ray_set_size(const gmj_ray_set* set);
+gmj_error_code gmj_ray_set_add(gmj_ray_set* set, int frame_body_id,
+                               int exclude_body_id, const double* origin_xyz,
+                               const double* directions_xyz, int count);
+/* Bit g of group_mask enables geom group g (all groups by default).
+   include_static 0 skips geoms on the world body (default 1). */
+gmj_error_code gmj_ray_set_filter(gmj_ray_set* set, int group_mask,
+                                  int include_static);
+/* Default and upper bound is mjMAXVAL. */
+gmj_error_code gmj_ray_set_max_distance(gmj_ray_set* set,
+                                        double max_distance);
+
+/* out_geom_ids may be NULL. data is not const because mj_multiRay uses
+   its stack for scratch. */
+gmj_error_code gmj_raycast(const gmj_ray_set* set, gmj_data* data,
+                           double* out_distances, int* out_geom_ids);
+gmj_error_code gmj_raycast_f32(const gmj_ray_set* set, gmj_data* data,
+                               float* out_distances, int* out_geom_ids);
+
+/* thread_count <= 0 uses one thread per online CPU. The dispatching thread
+   counts as thread 0. */
+gmj_thread_pool* gmj_thread_pool_create(int thread_count);
+void gmj_thread_pool_free(gmj_thread_pool* pool);
+int gmj_thread_pool_size(const gmj_thread_pool* pool);
+gmj_error_code gmj_thread_pool_stats(const gmj_thread_pool* pool,
+                                     int thread_index,
+                                     gmj_thread_stats* out_stats);
+void gmj_thread_pool_reset_stats(gmj_thread_pool* pool);
+
+/* The batch borrows model; keep it alive until gmj_batch_free. */
+gmj_batch* gmj_batch_create(const gmj_model* model, int env_count);
+/* Every env gets an arena of arena_bytes (see gmj_data_create_sized). */
+gmj_batch* gmj_batch_create_sized(const gmj_model* model, int env_count,
+                                  size_t arena_bytes);
+void gmj_batch_free(gmj_batch* batch);
+
+int gmj_batch_size(const gmj_batch* batch);
+gmj_data* gmj_batch_env(gmj_batch* batch, int env_index);
+
+/* NULL pool (the default) steps envs serially on the caller's thread. */
+gmj_error_code gmj_batch_set_thread_pool(gmj_batch* batch,
+                                         gmj_thread_pool* pool);
+
+gmj_error_code gmj_batch_reset(gmj_batch* batch);
+gmj_error_code gmj_batch_reset_env(gmj_batch* batch, int env_index);
+/* Migrates every env to new_model (see gmj_data_migrate) and rebinds the
+   batch; all or nothing. new_model must outlive the batch. Specs, maps and
+   ray sets built for the old model must be rebuilt. */
+gmj_error_code gmj_batch_reload(gmj_batch* batch, const gmj_model* new_model);
+/* gmj_data_randomize for every env, each seeded from seed and its index;
+   all or nothing. */
+gmj_error_code gmj_batch_randomize(gmj_batch* batch,
+                                   const gmj_randomizer* randomizer,
+                                   unsigned long long seed);
+
+/* ctrl is [env_count x nu], out_qpos [env_count x nq], out_qvel
+   [env_count x nv]. Any of them may be NULL to skip that transfer. */
+gmj_error_code gmj_batch_step(gmj_batch* batch, const double* ctrl, int steps,
+                              double* out_qpos, double* out_qvel);
+gmj_error_code gmj_batch_get_state(const gmj_batch* batch, double* out_qpos,
+                                   double* out_qvel);
+/* float32 versions with the same layouts. The slice variants move
+   [env_count x count] values of field[start, start + count). */
+gmj_error_code gmj_batch_step_f32(gmj_batch* batch, const float* ctrl,
+                                  int steps, float* out_qpos,
+                                  float* out_qvel);
+gmj_error_code gmj_batch_get_state_f32(const gmj_batch* batch, float* out_qpos,
+                                       float* out_qvel);
+gmj_error_code gmj_batch_get_slice_f32(const gmj_batch* batch,
+                                       gmj_state_field field, int start_index,
+                                       int count, float* out_values);
+gmj_error_code gmj_batch_set_slice_f32(gmj_batch* batch,
+                                       gmj_state_field field, int start_index,
+                                       int count, const float* values);
+/* Counts, times and current sizes summed over envs; high-water marks and
+   peaks are the maximum over envs. */
+gmj_error_code gmj_batch_stats(const gmj_batch* batch, gmj_stats* out_stats);
+
+/* Output is [env_count x body_count] records; env_offsets_xyz is
+   [env_count x 3] or NULL. */
+gmj_error_code gmj_batch_export_body_transforms(
+    const gmj_batch* batch, const int* body_ids, int body_count,
+    const float* env_offsets_xyz, gmj_transform_layout layout, int flags,
+    float* out_transforms);
+/* out_contacts is [env_count x capacity_per_env] records and out_counts
+   [env_count]; counts are per env, as for gmj_export_contacts. */
+gmj_error_code gmj_batch_export_contacts(const gmj_batch* batch,
+                                         const gmj_contact_filter* filter,
+                                         int flags, gmj_contact* out_contacts,
+                                         int capacity_per_env,
+                                         int* out_counts);
+/* Outputs are [env_count x gmj_ray_set_size(set)]. */
+gmj_error_code gmj_batch_raycast(const gmj_ray_set* set, gmj_batch* batch,
+                                 double* out_distances, int* out_geom_ids);
+gmj_error_code gmj_batch_raycast_f32(const gmj_ray_set* set, gmj_batch* batch,
+                                     float* out_distances, int* out_geom_ids);
+
+/* Observation layout registered once and gathered in one call. Range terms
+   (qpos, qvel, sensordata, prev action = current ctrl) copy [start, start +
+   count); body terms write 3 values: body xpos minus root xpos, in world
+   axes (REL) or in the root body frame (LOCAL). Terms are laid out in the
+   order they are added. */
+gmj_obs_spec* gmj_obs_spec_create(const gmj_model* model);
+void gmj_obs_spec_free(gmj_obs_spec* spec);
+int gmj_obs_spec_size(const gmj_obs_spec* spec);
+gmj_error_code gmj_obs_spec_add_range(gmj_obs_spec* spec,
+                                      gmj_obs_source source, int start_index,
+                                      int count);
+gmj_error_code gmj_obs_spec_add_body(gmj_obs_spec* spec,
+                                     gmj_obs_source source, int body_id,
+                                     int root_body_id);
+
+gmj_error_code gmj_obs_fill(const gmj_obs_spec* spec, const gmj_data* data,
+                            double* out_values);
+gmj_error_code gmj_obs_fill_f32(const gmj_obs_spec* spec, const gmj_data* data,
+                                float* out_values);
+/* Output is [env_count x gmj_obs_spec_size(spec)]. */
+gmj_error_code gmj_batch_obs_fill(const gmj_obs_spec* spec,
+                                  const gmj_batch* batch, double* out_values);
+gmj_error_code gmj_batch_obs_fill_f32(const gmj_obs_spec* spec,
+                                      const gmj_batch* batch,
+                                      float* out_values);
+
+/* Sensors bound by name once and read into one contiguous buffer, in the
+   order they are added. Each add returns (optionally) the offset of the
+   sensor's first value in that buffer, which gmj_sensor_map_offset also
+   looks up later. Sensors that are adjacent in sensordata are read as one
+   copy, so add_all (or adding every sensor in model order) is a single
+   memcpy. */
+gmj_sensor_map* gmj_sensor_map_create(const gmj_model* model);
+void gmj_sensor_map_free(gmj_sensor_map* map);
+/* Number of values one read writes. */
+int gmj_sensor_map_size(const gmj_sensor_map* map);
+gmj_error_code gmj_sensor_map_add(gmj_sensor_map* map,
+                                  const char* sensor_name, int* out_offset);
+gmj_error_code gmj_sensor_map_add_id(gmj_sensor_map* map, int sensor_id,
+                                     int* out_offset);
+gmj_error_code gmj_sensor_map_add_all(gmj_sensor_map* map);
+/* -1 when the sensor was not added. */
+int gmj_sensor_map_offset(const gmj_sensor_map* map, int sensor_id);
+
+gmj_error_code gmj_sensor_read(const gmj_sensor_map* map, const gmj_data* data,
+                               double* out_values);
+gmj_error_code gmj_sensor_read_f32(const gmj_sensor_map* map,
+                                   const gmj_data* data, float* out_values);
+/* Output is [env_count x gmj_sensor_map_size(map)]. */
+gmj_error_code gmj_batch_sensor_read(const gmj_sensor_map* map,
+                                     const gmj_batch* batch,
+                                     double* out_values);
+gmj_error_code gmj_batch_sensor_read_f32(const gmj_sensor_map* map,
+                                         const gmj_batch* batch,
+                                         float* out_values);
+
+/* A per-tick call sequence recorded once and run by gmj_execute in one
+   call. Indices, counts, body ids and layouts are checked while recording,
+   so gmj_execute does no argument checking and leaves the error string
+   untouched. Value buffers are borrowed: the list keeps the pointers and
+   reads or writes them on every execute, so they must stay valid (pinned,
+   for managed callers) until the list is freed. body_ids and the world
+   offset are copied. Commands run in the order they are recorded, against
+   any data made from the list's model. */
+gmj_cmd_list* gmj_cmd_list_create(const gmj_model* model);
+void gmj_cmd_list_free(gmj_cmd_list* list);
+int gmj_cmd_list_size(const gmj_cmd_list* list);
+void gmj_cmd_list_clear(gmj_cmd_list* list);
+/* ctrl[start, start + count) = values[0, count). */
+gmj_error_code gmj_cmd_set_ctrl(gmj_cmd_list* list, int start_index,
+                                int count, const double* values);
+gmj_error_code gmj_cmd_step(gmj_cmd_list* list, int steps);
+/* out_values[0, count) = field[start, start + count), over the flattened
+   field (xpos is 3 * nbody long, and so on). */
+gmj_error_code gmj_cmd_copy(gmj_cmd_list* list, gmj_state_field field,
+                            int start_index, int count, double* out_values);
+/* Same records as gmj_export_body_transforms. */
+gmj_error_code gmj_cmd_export_transforms(gmj_cmd_list* list,
+                                         const int* body_ids, int body_count,
+                                         const float* world_offset_xyz,
+                                         gmj_transform_layout layout,
+                                         int flags, float* out_transforms);
+gmj_error_code gmj_execute(const gmj_cmd_list* list, gmj_data* data);
+
+/* Highest SIMD level detected on this CPU, capped by gmj_simd_set_limit
+   (useful to compare kernels). */
+gmj_simd_level gmj_simd_get_level(void);
+void gmj_simd_set_limit(gmj_simd_level max_level);
+
+/* Native VecNormalize + policy inference in float32. policy_json is either
+   the policy_linear.json format ({"weights", "bias", "clip_action"}; tanh,
+   clipped to 1 by default) or an MLP ({"layers": [{"weights", "bias",
+   "activation"}...], "clip_action"}; activation is "tanh", "relu" or
+   "linear", and a layer without one is linear). vecnorm_json (optional)
+   is vecnorm_stats.json. Layers are limited to 1024 units. */
+gmj_policy* gmj_policy_load(const char* policy_path, const char* vecnorm_path,
+                            char* error_buffer, size_t error_buffer_size);
+gmj_policy* gmj_policy_load_json(const char* policy_json,
+                                 const char* vecnorm_json, char* error_buffer,
+                                 size_t error_buffer_size);
+void gmj_policy_free(gmj_policy* policy);
+int gmj_policy_obs_size(const gmj_policy* policy);
+int gmj_policy_action_size(const gmj_policy* policy);
+
+gmj_error_code gmj_policy_infer(const gmj_policy* policy,
+                                const double* observation, int obs_count,
+                                double* out_actions, int action_count);
+/* Gather spec -> normalize -> MLP -> write ctrl[ctrl_start...]. The spec
+   size must equal the policy input size. out_actions is optional. */
+gmj_error_code gmj_policy_apply(const gmj_policy* policy,
+                                const gmj_obs_spec* spec, gmj_data* data,
+                                int ctrl_start, double* out_actions);
+/* Same for every env; out_actions (optional) is [env_count x action_size]. */
+gmj_error_code gmj_batch_apply_policy(gmj_batch* batch,
+                                      const gmj_policy* policy,
+                                      const gmj_obs_spec* spec, int ctrl_start,
+                                      double* out_actions);
+
+/* Reward = sum of terms over one step call:
+   FORWARD    weight * displacement of body xpos[axis]
+   HEIGHT     weight when body xpos[axis] >= threshold
+   CTRL_COST  -weight * sum(ctrl^2)   (body_id/axis/threshold ignored)
+   A termination ends the episode when body xpos[axis] is below/above the
+   threshold; the time limit (0 = none) truncates it. Done envs are reset to
+   qpos0 or the reset keyframe (-1 = qpos0) within the same call. */
+gmj_task* gmj_task_create(const gmj_model* model);
+void gmj_task_free(gmj_task* task);
+gmj_error_code gmj_task_add_reward(gmj_task* task, gmj_reward_term term,
+                                   int body_id, int axis, double threshold,
+                                   double weight);
+gmj_error_code gmj_task_add_termination(gmj_task* task,
+                                        gmj_termination condition,
+                                        int body_id, int axis,
+                                        double threshold);
+gmj_error_code gmj_task_set_time_limit(gmj_task* task, double seconds);
+gmj_error_code gmj_task_set_reset_keyframe(gmj_task* task, int key_index);
+
+gmj_error_code gmj_task_step(const gmj_task* task, gmj_data* data, int steps,
+                             double* out_reward, unsigned char* out_done);
+/* ctrl is optional [env_count x nu]; out_rewards/out_done are [env_count]
+   with gmj_done_flag values. */
+gmj_error_code gmj_batch_step_task(gmj_batch* batch, const gmj_task* task,
+                                   const double* ctrl, int steps,
+                                   double* out_rewards,
+                                   unsigned char* out_done);
+
+/* Runs data on its own thread at tick_rate_hz (<= 0 runs back to back),
+   stepping steps_per_tick per tick, or running task when given (reward,
+   done and auto-reset as in gmj_task_step). Until gmj_sim_thread_stop
+   returns, data belongs to the thread: other threads post commands and read
+   published states only. queue_capacity <= 0 selects 64. */
+gmj_sim_thread* gmj_sim_thread_start(const gmj_model* model, gmj_data* data,
+                                     const gmj_task* task,
+                                     double tick_rate_hz, int steps_per_tick,
+                                     int queue_capacity);
+void gmj_sim_thread_stop(gmj_sim_thread* sim);
+
+/* Single producer: never blocks. Commands are applied in order at the
+   start of the next tick; GMJ_ERR_QUEUE_FULL when the ring is full. */
+gmj_error_code gmj_sim_post_ctrl(gmj_sim_thread* sim, int start_index,
+                                 int count, const double* values);
+gmj_error_code gmj_sim_post_reset(gmj_sim_thread* sim);
+
+/* Single consumer: never blocks. Takes the most recently completed tick;
+   out_state stays valid until the next call. out_stats may be NULL. */
+gmj_error_code gmj_sim_latest_state(gmj_sim_thread* sim,
+                                    gmj_sim_state* out_state,
+                                    gmj_sim_stats* out_stats);
+
+/* Blends between the tick before the state last returned by
+   gmj_sim_latest_state and that state. GMJ_SIM_ALPHA_AUTO derives alpha
+   from the time elapsed since that state was published. Same thread as
+   gmj_sim_latest_state. */
+#define GMJ_SIM_ALPHA_AUTO (-1.0f)
+gmj_error_code gmj_sim_interpolate_transforms(
+    gmj_sim_thread* sim, float alpha, const int* body_ids, int body_count,
+    const float* world_offset_xyz, gmj_transform_layout layout, int flags,
+    float* out_transforms);
+
 const char* gmj_last_mujoco_error(void);
 
 #ifdef __cplusplus
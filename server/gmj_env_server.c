@@ -0,0 +1,460 @@
+#define _GNU_SOURCE
+
+#include "godot_mujoco/gmj_bridge.h"
+#include "gmj_env_shm.h"
+
+#include <errno.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Vectorized env server for an external trainer. Hosts one gmj_batch with
+   a native task (forward reward, height termination, optional time limit)
+   and serves step/reset requests through the shared-memory ring described
+   in gmj_env_shm.h. Observations are qpos and qvel (plus sensordata with
+   --sensors), written as float32 straight into the shared slot. */
+
+typedef struct server_options {
+  const char* model_path;
+  const char* shm_name;
+  const char* body_name;
+  int envs;
+  int slots;
+  int threads;
+  int steps;
+  int sensors;
+  int has_seed;
+  unsigned long long seed;
+  uint32_t first_seq;
+  double min_height;
+  double time_limit;
+  double randomize;
+  double spin_seconds;
+} server_options;
+
+typedef struct server_env {
+  gmj_model* model;
+  gmj_batch* batch;
+  gmj_thread_pool* pool;
+  gmj_obs_spec* obs;
+  gmj_task* task;
+  gmj_randomizer* randomizer;
+  int nu;
+} server_env;
+
+static volatile sig_atomic_t server_stop = 0;
+
+static void server_on_signal(int signal_number) {
+  (void)signal_number;
+  server_stop = 1;
+}
+
+static double server_now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void server_fail(const char* what) {
+  fprintf(stderr, "gmj_env_server: %s: %s\n", what, gmj_last_mujoco_error());
+  exit(1);
+}
+
+static long server_futex(uint32_t* word, int op, uint32_t value,
+                         const struct timespec* timeout) {
+  return syscall(SYS_futex, word, op, value, timeout, NULL, 0);
+}
+
+static void server_cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+static uint64_t server_align(uint64_t value) { return (value + 63u) & ~63ull; }
+
+/* Spins for spin_seconds, then sleeps on request_seq. The timeout bounds
+   how long a signal can go unnoticed. */
+static uint32_t server_wait_request(gmj_shm_header* header, uint32_t handled,
+                                    double spin_seconds) {
+  const struct timespec timeout = {0, 100000000};
+  const double spin_until = server_now_seconds() + spin_seconds;
+  uint32_t seq = __atomic_load_n(&header->request_seq, __ATOMIC_SEQ_CST);
+
+  while (seq == handled && !server_stop) {
+    if (server_now_seconds() < spin_until) {
+      server_cpu_relax();
+    } else {
+      __atomic_store_n(&header->server_waiting, 1u, __ATOMIC_SEQ_CST);
+      seq = __atomic_load_n(&header->request_seq, __ATOMIC_SEQ_CST);
+      if (seq == handled) {
+        server_futex(&header->request_seq, FUTEX_WAIT, handled, &timeout);
+      }
+      __atomic_store_n(&header->server_waiting, 0u, __ATOMIC_SEQ_CST);
+    }
+    seq = __atomic_load_n(&header->request_seq, __ATOMIC_SEQ_CST);
+  }
+  return seq;
+}
+
+static void server_publish(gmj_shm_header* header, uint32_t seq) {
+  __atomic_store_n(&header->response_seq, seq, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&header->client_waiting, __ATOMIC_SEQ_CST) != 0) {
+    server_futex(&header->response_seq, FUTEX_WAKE, 1, NULL);
+  }
+}
+
+/* Wakes every sleeper so a client waiting on a request that will never be
+   answered sees stopped. */
+static void server_mark_stopped(gmj_shm_header* header) {
+  __atomic_store_n(&header->stopped, 1u, __ATOMIC_SEQ_CST);
+  server_futex(&header->response_seq, FUTEX_WAKE, INT32_MAX, NULL);
+}
+
+static void server_setup(const server_options* options, server_env* env) {
+  char error[1024] = {0};
+  int body_id = 1;
+  int i = 0;
+
+  memset(env, 0, sizeof(*env));
+  env->model = gmj_model_load_xml(options->model_path, error, sizeof(error));
+  if (env->model == NULL) {
+    fprintf(stderr, "gmj_env_server: load %s: %s\n", options->model_path,
+            error);
+    exit(1);
+  }
+  env->nu = gmj_nu(env->model);
+  if (options->body_name != NULL) {
+    body_id = gmj_body_id(env->model, options->body_name);
+    if (body_id < 0) {
+      server_fail("body");
+    }
+  }
+
+  env->batch = gmj_batch_create(env->model, options->envs);
+  if (env->batch == NULL) {
+    server_fail("batch");
+  }
+  if (options->threads > 0) {
+    env->pool = gmj_thread_pool_create(options->threads);
+    if (env->pool == NULL ||
+        gmj_batch_set_thread_pool(env->batch, env->pool) != GMJ_OK) {
+      server_fail("thread pool");
+    }
+  }
+
+  env->obs = gmj_obs_spec_create(env->model);
+  if (env->obs == NULL ||
+      gmj_obs_spec_add_range(env->obs, GMJ_OBS_QPOS, 0,
+                             gmj_nq(env->model)) != GMJ_OK ||
+      gmj_obs_spec_add_range(env->obs, GMJ_OBS_QVEL, 0,
+                             gmj_nv(env->model)) != GMJ_OK ||
+      (options->sensors && gmj_nsensordata(env->model) > 0 &&
+       gmj_obs_spec_add_range(env->obs, GMJ_OBS_SENSORDATA, 0,
+                              gmj_nsensordata(env->model)) != GMJ_OK)) {
+    server_fail("observation spec");
+  }
+
+  env->task = gmj_task_create(env->model);
+  if (env->task == NULL ||
+      gmj_task_add_reward(env->task, GMJ_REWARD_FORWARD, body_id, 0, 0.0,
+                          1.0) != GMJ_OK ||
+      (options->min_height > 0.0 &&
+       gmj_task_add_termination(env->task, GMJ_TERMINATE_BELOW, body_id, 2,
+                                options->min_height) != GMJ_OK) ||
+      (options->time_limit > 0.0 &&
+       gmj_task_set_time_limit(env->task, options->time_limit) != GMJ_OK)) {
+    server_fail("task");
+  }
+
+  if (options->randomize > 0.0) {
+    const double low = options->randomize < 1.0 ? 1.0 - options->randomize
+                                                : 0.0;
+    const double high = 1.0 + options->randomize;
+    env->randomizer = gmj_randomizer_create(env->model);
+    if (env->randomizer == NULL) {
+      server_fail("randomizer");
+    }
+    for (i = GMJ_PARAM_BODY_MASS; i <= GMJ_PARAM_ACTUATOR_GEAR; ++i) {
+      if (gmj_randomizer_add(env->randomizer, (gmj_param)i, NULL,
+                             GMJ_RAND_SCALE, GMJ_DIST_UNIFORM, low,
+                             high) != GMJ_OK) {
+        server_fail("randomizer");
+      }
+    }
+    if (gmj_batch_randomize(env->batch, env->randomizer, options->seed) !=
+        GMJ_OK) {
+      server_fail("randomize");
+    }
+  }
+}
+
+static void server_teardown(server_env* env) {
+  gmj_randomizer_free(env->randomizer);
+  gmj_task_free(env->task);
+  gmj_obs_spec_free(env->obs);
+  gmj_batch_free(env->batch);
+  gmj_thread_pool_free(env->pool);
+  gmj_model_free(env->model);
+}
+
+/* Creates the object, replacing a stale one left by a crashed server. */
+static gmj_shm_header* server_map(const server_options* options,
+                                  const server_env* env) {
+  const int obs_dim = gmj_obs_spec_size(env->obs);
+  const uint64_t envs = (uint64_t)options->envs;
+  gmj_shm_header* header = NULL;
+  uint64_t act_offset = 64;
+  uint64_t obs_offset = 0;
+  uint64_t reward_offset = 0;
+  uint64_t done_offset = 0;
+  uint64_t slot_stride = 0;
+  uint64_t total_size = 0;
+  void* mapping = NULL;
+  int fd = -1;
+
+  obs_offset = server_align(act_offset + envs * (uint64_t)env->nu * 4u);
+  reward_offset = server_align(obs_offset + envs * (uint64_t)obs_dim * 4u);
+  done_offset = server_align(reward_offset + envs * 8u);
+  slot_stride = server_align(done_offset + envs);
+  total_size = sizeof(gmj_shm_header) + slot_stride * (uint64_t)options->slots;
+
+  shm_unlink(options->shm_name);
+  fd = shm_open(options->shm_name, O_CREAT | O_EXCL | O_RDWR, 0600);
+  if (fd < 0) {
+    fprintf(stderr, "gmj_env_server: shm_open %s: %s\n", options->shm_name,
+            strerror(errno));
+    exit(1);
+  }
+  if (ftruncate(fd, (off_t)total_size) != 0) {
+    fprintf(stderr, "gmj_env_server: ftruncate: %s\n", strerror(errno));
+    shm_unlink(options->shm_name);
+    exit(1);
+  }
+  mapping = mmap(NULL, (size_t)total_size, PROT_READ | PROT_WRITE,
+                 MAP_SHARED | MAP_POPULATE, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) {
+    fprintf(stderr, "gmj_env_server: mmap: %s\n", strerror(errno));
+    shm_unlink(options->shm_name);
+    exit(1);
+  }
+
+  header = (gmj_shm_header*)mapping;
+  header->magic = GMJ_SHM_MAGIC;
+  header->version = GMJ_SHM_VERSION;
+  header->env_count = options->envs;
+  header->obs_dim = obs_dim;
+  header->act_dim = env->nu;
+  header->slot_count = options->slots;
+  header->steps_per_request = options->steps;
+  header->server_pid = (int32_t)getpid();
+  header->total_size = total_size;
+  header->slot_offset = sizeof(gmj_shm_header);
+  header->slot_stride = slot_stride;
+  header->act_offset = act_offset;
+  header->obs_offset = obs_offset;
+  header->reward_offset = reward_offset;
+  header->done_offset = done_offset;
+  header->request_seq = options->first_seq;
+  header->response_seq = options->first_seq;
+  __atomic_store_n(&header->ready, 1u, __ATOMIC_SEQ_CST);
+  return header;
+}
+
+/* Handles one request in its slot and returns its status. Done envs were
+   already reset by the task, so their observation starts the next
+   episode. */
+static gmj_shm_status server_handle(const gmj_shm_header* header,
+                                    server_env* env, uint32_t kind,
+                                    unsigned char* slot) {
+  double* rewards = (double*)(slot + header->reward_offset);
+  unsigned char* done = slot + header->done_offset;
+  gmj_error_code rc = GMJ_OK;
+  int i = 0;
+
+  if (kind == GMJ_SHM_CLOSE) {
+    return GMJ_SHM_OK;
+  }
+  if (kind != GMJ_SHM_STEP && kind != GMJ_SHM_RESET) {
+    return GMJ_SHM_BAD_KIND;
+  }
+  if (kind == GMJ_SHM_RESET) {
+    rc = gmj_batch_reset(env->batch);
+    for (i = 0; i < header->env_count && rc == GMJ_OK; ++i) {
+      rc = gmj_forward(env->model, gmj_batch_env(env->batch, i));
+    }
+    memset(rewards, 0, sizeof(double) * (size_t)header->env_count);
+    memset(done, 0, (size_t)header->env_count);
+  } else {
+    if (env->nu > 0) {
+      rc = gmj_batch_set_slice_f32(env->batch, GMJ_FIELD_CTRL, 0, env->nu,
+                                   (const float*)(slot + header->act_offset));
+    }
+    if (rc == GMJ_OK) {
+      rc = gmj_batch_step_task(env->batch, env->task, NULL,
+                               header->steps_per_request, rewards, done);
+    }
+  }
+  if (rc == GMJ_OK) {
+    rc = gmj_batch_obs_fill_f32(env->obs, env->batch,
+                                (float*)(slot + header->obs_offset));
+  }
+  if (rc != GMJ_OK) {
+    fprintf(stderr, "gmj_env_server: request: %s\n", gmj_last_mujoco_error());
+    return GMJ_SHM_FAILED;
+  }
+  return GMJ_SHM_OK;
+}
+
+static void server_usage(void) {
+  fprintf(stderr,
+          "usage: gmj_env_server --model XML [--name /SHM] [--envs N] "
+          "[--slots N] [--threads N] [--steps N] [--body NAME] "
+          "[--min-height H] [--time-limit S] [--randomize X] [--seed N] "
+          "[--sensors] [--spin-us US] [--first-seq N]\n"
+          "  --name        shared memory object (default /gmj_env)\n"
+          "  --envs        envs in the batch (default 64)\n"
+          "  --slots       request ring depth, a power of two (default 2)\n"
+          "  --threads     worker threads, 0 steps on the server thread "
+          "(default 0)\n"
+          "  --steps       mj_step calls per request (default 1)\n"
+          "  --body        body for forward reward and height check "
+          "(default body 1)\n"
+          "  --min-height  terminate below this height, 0 disables\n"
+          "  --time-limit  truncate after this many seconds, 0 disables\n"
+          "  --randomize   scale mass, friction, damping and gear by "
+          "U(1-X, 1+X) per env\n"
+          "  --seed        randomization seed (default from the clock, "
+          "printed at startup)\n"
+          "  --sensors     append sensordata to observations\n"
+          "  --spin-us     busy-wait before sleeping on the futex "
+          "(default 50)\n"
+          "  --first-seq   initial request_seq/response_seq (default 0; "
+          "set near 2^32 to test client wraparound)\n");
+}
+
+static int server_parse(int argc, char** argv, server_options* options) {
+  int i = 0;
+  memset(options, 0, sizeof(*options));
+  options->shm_name = "/gmj_env";
+  options->envs = 64;
+  options->slots = 2;
+  options->steps = 1;
+  options->spin_seconds = 50e-6;
+
+  for (i = 1; i < argc; ++i) {
+    const int has_value = i + 1 < argc;
+    if (strcmp(argv[i], "--model") == 0 && has_value) {
+      options->model_path = argv[++i];
+    } else if (strcmp(argv[i], "--name") == 0 && has_value) {
+      options->shm_name = argv[++i];
+    } else if (strcmp(argv[i], "--envs") == 0 && has_value) {
+      options->envs = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--slots") == 0 && has_value) {
+      options->slots = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--threads") == 0 && has_value) {
+      options->threads = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--steps") == 0 && has_value) {
+      options->steps = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--body") == 0 && has_value) {
+      options->body_name = argv[++i];
+    } else if (strcmp(argv[i], "--min-height") == 0 && has_value) {
+      options->min_height = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--time-limit") == 0 && has_value) {
+      options->time_limit = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--randomize") == 0 && has_value) {
+      options->randomize = atof(argv[++i]);
+    } else if (strcmp(argv[i], "--seed") == 0 && has_value) {
+      options->seed = strtoull(argv[++i], NULL, 0);
+      options->has_seed = 1;
+    } else if (strcmp(argv[i], "--sensors") == 0) {
+      options->sensors = 1;
+    } else if (strcmp(argv[i], "--spin-us") == 0 && has_value) {
+      options->spin_seconds = atof(argv[++i]) * 1e-6;
+    } else if (strcmp(argv[i], "--first-seq") == 0 && has_value) {
+      options->first_seq = (uint32_t)strtoul(argv[++i], NULL, 0);
+    } else {
+      return 0;
+    }
+  }
+  if (!options->has_seed) {
+    options->seed = (unsigned long long)time(NULL);
+  }
+  return options->model_path != NULL && options->shm_name[0] == '/' &&
+         options->envs > 0 && options->slots > 0 &&
+         (options->slots & (options->slots - 1)) == 0 &&
+         options->threads >= 0 && options->steps > 0 &&
+         options->spin_seconds >= 0.0;
+}
+
+int main(int argc, char** argv) {
+  server_options options;
+  server_env env;
+  gmj_shm_header* header = NULL;
+  struct sigaction action;
+  uint32_t handled = 0;
+  long long requests = 0;
+  double busy_seconds = 0.0;
+  int running = 1;
+  int failed = 0;
+
+  if (!server_parse(argc, argv, &options)) {
+    server_usage();
+    return 2;
+  }
+
+  memset(&action, 0, sizeof(action));
+  action.sa_handler = server_on_signal;
+  sigaction(SIGINT, &action, NULL);
+  sigaction(SIGTERM, &action, NULL);
+
+  server_setup(&options, &env);
+  header = server_map(&options, &env);
+  handled = options.first_seq;
+  fprintf(stderr,
+          "gmj_env_server: %s ready: envs=%d obs=%d act=%d slots=%d "
+          "bytes=%llu seed=%llu\n",
+          options.shm_name, header->env_count, header->obs_dim,
+          header->act_dim, header->slot_count,
+          (unsigned long long)header->total_size, options.seed);
+
+  while (running && !server_stop) {
+    const uint32_t seq =
+        server_wait_request(header, handled, options.spin_seconds);
+    while (handled != seq && running) {
+      unsigned char* slot =
+          (unsigned char*)header + header->slot_offset +
+          header->slot_stride *
+              (uint64_t)(handled & (uint32_t)(options.slots - 1));
+      const uint32_t kind = *(const uint32_t*)slot;
+      const double start = server_now_seconds();
+      const gmj_shm_status status = server_handle(header, &env, kind, slot);
+      busy_seconds += server_now_seconds() - start;
+      ((uint32_t*)slot)[1] = (uint32_t)status;
+      failed = status == GMJ_SHM_FAILED;
+      running = !failed && kind != GMJ_SHM_CLOSE;
+      requests += 1;
+      handled += 1;
+      server_publish(header, handled);
+    }
+  }
+  server_mark_stopped(header);
+
+  fprintf(stderr, "gmj_env_server: %lld requests, %.1f us mean handling\n",
+          requests, requests > 0 ? busy_seconds * 1e6 / (double)requests : 0.0);
+  munmap(header, (size_t)header->total_size);
+  shm_unlink(options.shm_name);
+  server_teardown(&env);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,91 @@
+#ifndef GODOT_MUJOCO_GMJ_ENV_SHM_H_
+#define GODOT_MUJOCO_GMJ_ENV_SHM_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+/* Shared-memory layout of gmj_env_server. The server creates the POSIX
+   shared memory object, fills the header and sets ready last; a client maps
+   the object and works from the header alone, so it needs no other
+   coordination.
+
+   Requests go through a ring of slot_count slots; slot_count is a power of
+   two. To issue request n the client writes kind (and, for a step, the
+   actions) into slot n % slot_count and then stores request_seq = n + 1.
+   The server handles requests in order, writes status, obs, reward and done
+   into the same slot, and stores response_seq = n + 1. Up to slot_count
+   requests may be in flight.
+
+   Both sequence words start at the same value, 0 unless the server was
+   started with --first-seq, so a client takes its first n from
+   response_seq once ready is set.
+
+   Sequence words are uint32 and wrap. Request n is answered once
+   (int32_t)(response_seq - (uint32_t)(n + 1)) >= 0; never compare them
+   with a plain >=. Because slot_count divides 2^32, n % slot_count picks
+   the same slot whether n is counted in 32 or 64 bits.
+
+   A request with an unknown kind is answered with GMJ_SHM_BAD_KIND and
+   changes nothing. When a request fails, the server answers it with
+   GMJ_SHM_FAILED, sets stopped, unlinks the object and exits. It also sets
+   stopped on a normal exit, so a waiting client should check it.
+
+   Both sequence words are futex words (shared, not FUTEX_PRIVATE). A side
+   about to sleep sets its *_waiting word, re-checks the sequence and then
+   calls FUTEX_WAIT. The other side stores the sequence, and issues
+   FUTEX_WAKE only when it sees the waiting flag. A handoff between two
+   spinning sides therefore costs no system call. The server also wakes
+   response_seq when it sets stopped. All accesses to these words and to
+   stopped are sequentially consistent. */
+
+#define GMJ_SHM_MAGIC 0x454A4D47u /* "GMJE" */
+#define GMJ_SHM_VERSION 1u
+
+typedef enum gmj_shm_kind {
+  GMJ_SHM_STEP = 0,  /* apply actions, step, auto-reset done envs */
+  GMJ_SHM_RESET = 1, /* reset every env; actions ignored */
+  GMJ_SHM_CLOSE = 2  /* answered, then the server exits */
+} gmj_shm_kind;
+
+typedef enum gmj_shm_status {
+  GMJ_SHM_OK = 0,
+  GMJ_SHM_FAILED = 1,  /* nothing else is answered; the server exits */
+  GMJ_SHM_BAD_KIND = 2 /* unknown kind; the slot's arrays are untouched */
+} gmj_shm_status;
+
+typedef struct gmj_shm_header {
+  uint32_t magic;
+  uint32_t version;
+  int32_t env_count;
+  int32_t obs_dim;
+  int32_t act_dim;
+  int32_t slot_count;
+  int32_t steps_per_request;
+  int32_t server_pid;
+  uint64_t total_size;
+  uint64_t slot_offset; /* from the start of the mapping */
+  uint64_t slot_stride;
+  /* Within a slot: uint32 kind at 0 (client), uint32 gmj_shm_status at 4
+     (server), then the arrays below. */
+  uint64_t act_offset;    /* float32 [env_count x act_dim] */
+  uint64_t obs_offset;    /* float32 [env_count x obs_dim] */
+  uint64_t reward_offset; /* float64 [env_count] */
+  uint64_t done_offset;   /* uint8 [env_count], 0 / 1 terminated / 2 truncated */
+  uint32_t ready;
+  uint32_t stopped;
+  uint8_t reserved0[32];
+  uint32_t request_seq; /* byte 128 */
+  uint32_t server_waiting;
+  uint8_t reserved1[56];
+  uint32_t response_seq; /* byte 192 */
+  uint32_t client_waiting;
+  uint8_t reserved2[56];
+} gmj_shm_header;
+
+_Static_assert(offsetof(gmj_shm_header, request_seq) == 128,
+               "request_seq must sit on its own cache line");
+_Static_assert(offsetof(gmj_shm_header, response_seq) == 192,
+               "response_seq must sit on its own cache line");
+_Static_assert(sizeof(gmj_shm_header) == 256, "header is 256 bytes");
+
+#endif
@@ -1,10 +1,31 @@
+#if !defined(_WIN32) && !defined(_XOPEN_SOURCE)
+#define _XOPEN_SOURCE 700
+#endif
+
 #include "../include/godot_mujoco/gmj_bridge.h"
 
+#include <float.h>
+#include <math.h>
 #include <stddef.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
 #if defined(__has_include)
 #if __has_include(<mujoco/mujoco.h>)
 #include <mujoco/mujoco.h>
@@ -20,10 +41,43 @@
 #if GMJ_HAS_MUJOCO
 struct gmj_model {
   mjModel* handle;
+  gmj_load_info load_info;
+  int refcount;
+  int cached;
+  char* cache_path;
+  unsigned long long cache_hash;
+  struct gmj_model* cache_next;
 };
 
+typedef struct gmj_env_params gmj_env_params;
+
 struct gmj_data {
   mjData* handle;
+  unsigned long long generation;
+  gmj_env_params* params;
+  mjtNum* snapshots;
+  int snapshot_capacity;
+  int snapshot_stride;
+  int snapshot_signature;
+  int snapshot_head;
+  int snapshot_count;
+  gmj_recorder* recorder;
+  long long stat_steps;
+  double stat_step_seconds;
+  int stat_ncon_max;
+  int stat_nefc_max;
+  int stat_solver_iterations_max;
+  long long stat_arena_peak_max;
+  long long stat_stack_peak_max;
+  int stat_warning_seen[GMJ_STATS_WARNINGS];
+  long long stat_warnings[GMJ_STATS_WARNINGS];
+};
+
+struct gmj_batch {
+  const gmj_model* model;
+  int env_count;
+  gmj_data* envs;
+  gmj_thread_pool* pool;
 };
 #else
 struct gmj_model {
@@ -58,6 +112,14 @@ static gmj_error_code gmj_validate_ptrs(const gmj_model* model,
   return GMJ_OK;
 }
 
+static gmj_error_code gmj_validate_signature(int signature) {
+  if (signature <= 0 || (signature & ~GMJ_STATE_INTEGRATION) != 0) {
+    gmj_set_error("invalid state signature");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  return GMJ_OK;
+}
+
 static gmj_error_code gmj_validate_slice(int start_index, int count,
                                          int length) {
   if (count < 0 || start_index < 0) {
@@ -71,814 +133,9624 @@ static gmj_error_code gmj_validate_slice(int start_index, int count,
   return GMJ_OK;
 }
 
-const char* gmj_mujoco_version(void) {
-  static _Thread_local char version[32];
-  const int ver = mj_version();
-  const int major = ver / 100;
-  const int minor = ver % 100;
-  snprintf(version, sizeof(version), "%d.%d", major, minor);
-  return version;
+static void gmj_copy_to_mjtnum(mjtNum* dst, const double* src, int count) {
+#ifdef mjUSESINGLE
+  int i = 0;
+  for (i = 0; i < count; ++i) {
+    dst[i] = (mjtNum)src[i];
+  }
+#else
+  memcpy(dst, src, sizeof(double) * (size_t)count);
+#endif
 }
 
-gmj_model* gmj_model_load_xml(const char* xml_path, char* error_buffer,
-                              size_t error_buffer_size) {
-  char load_error[1024] = {0};
-  gmj_model* wrapper = NULL;
-  mjModel* model = NULL;
-
-  if (xml_path == NULL) {
-    const char* message = "xml_path is null";
-    if (error_buffer != NULL && error_buffer_size > 0) {
-      strncpy(error_buffer, message, error_buffer_size);
-      error_buffer[error_buffer_size - 1] = '\0';
-    }
-    gmj_set_error(message);
-    return NULL;
+static void gmj_copy_from_mjtnum(double* dst, const mjtNum* src, int count) {
+#ifdef mjUSESINGLE
+  int i = 0;
+  for (i = 0; i < count; ++i) {
+    dst[i] = (double)src[i];
   }
+#else
+  memcpy(dst, src, sizeof(double) * (size_t)count);
+#endif
+}
 
-  model = mj_loadXML(xml_path, NULL, load_error, sizeof(load_error));
-  if (model == NULL) {
-    if (error_buffer != NULL && error_buffer_size > 0) {
-      strncpy(error_buffer, load_error, error_buffer_size);
-      error_buffer[error_buffer_size - 1] = '\0';
-    }
-    gmj_set_error(load_error);
-    return NULL;
-  }
+#if defined(_WIN32)
+typedef CRITICAL_SECTION gmj_mutex;
+typedef CONDITION_VARIABLE gmj_cond;
+typedef HANDLE gmj_thread;
+typedef DWORD(WINAPI* gmj_thread_entry)(LPVOID);
+#define GMJ_THREAD_RETURN DWORD WINAPI
+#define GMJ_THREAD_RESULT 0
 
-  wrapper = (gmj_model*)malloc(sizeof(gmj_model));
-  if (wrapper == NULL) {
-    mj_deleteModel(model);
-    gmj_set_error("failed to allocate gmj_model");
-    return NULL;
-  }
+static void gmj_mutex_init(gmj_mutex* mutex) { InitializeCriticalSection(mutex); }
+static void gmj_mutex_destroy(gmj_mutex* mutex) { DeleteCriticalSection(mutex); }
+static void gmj_mutex_lock(gmj_mutex* mutex) { EnterCriticalSection(mutex); }
+static void gmj_mutex_unlock(gmj_mutex* mutex) { LeaveCriticalSection(mutex); }
+static void gmj_cond_init(gmj_cond* cond) { InitializeConditionVariable(cond); }
+static void gmj_cond_destroy(gmj_cond* cond) { (void)cond; }
+static void gmj_cond_wait(gmj_cond* cond, gmj_mutex* mutex) {
+  SleepConditionVariableCS(cond, mutex, INFINITE);
+}
+static void gmj_cond_signal(gmj_cond* cond) { WakeConditionVariable(cond); }
+static void gmj_cond_broadcast(gmj_cond* cond) {
+  WakeAllConditionVariable(cond);
+}
 
-  wrapper->handle = model;
-  gmj_set_error(NULL);
-  return wrapper;
+static int gmj_thread_start(gmj_thread* thread, gmj_thread_entry entry,
+                            void* arg) {
+  *thread = CreateThread(NULL, 0, entry, arg, 0, NULL);
+  return *thread != NULL ? 0 : -1;
 }
 
-void gmj_model_free(gmj_model* model) {
-  if (model == NULL) {
-    return;
-  }
-  if (model->handle != NULL) {
-    mj_deleteModel(model->handle);
-    model->handle = NULL;
-  }
-  free(model);
+static void gmj_thread_join(gmj_thread thread) {
+  WaitForSingleObject(thread, INFINITE);
+  CloseHandle(thread);
 }
 
-gmj_data* gmj_data_create(const gmj_model* model) {
-  gmj_data* wrapper = NULL;
-  mjData* data = NULL;
+static double gmj_now_seconds(void) {
+  LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+  return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
 
-  if (model == NULL || model->handle == NULL) {
-    gmj_set_error("model is null");
-    return NULL;
-  }
+static void gmj_sleep_seconds(double seconds) {
+  Sleep((DWORD)(seconds * 1000.0));
+}
 
-  data = mj_makeData(model->handle);
-  if (data == NULL) {
-    gmj_set_error("failed to allocate mjData");
-    return NULL;
-  }
+static void gmj_thread_yield(void) { SwitchToThread(); }
 
-  wrapper = (gmj_data*)malloc(sizeof(gmj_data));
-  if (wrapper == NULL) {
-    mj_deleteData(data);
-    gmj_set_error("failed to allocate gmj_data");
-    return NULL;
-  }
+static int gmj_cpu_count(void) {
+  SYSTEM_INFO info;
+  GetSystemInfo(&info);
+  return (int)info.dwNumberOfProcessors;
+}
+#else
+typedef pthread_mutex_t gmj_mutex;
+typedef pthread_cond_t gmj_cond;
+typedef pthread_t gmj_thread;
+typedef void* (*gmj_thread_entry)(void*);
+#define GMJ_THREAD_RETURN void*
+#define GMJ_THREAD_RESULT NULL
 
-  wrapper->handle = data;
-  gmj_set_error(NULL);
-  return wrapper;
+static void gmj_mutex_init(gmj_mutex* mutex) { pthread_mutex_init(mutex, NULL); }
+static void gmj_mutex_destroy(gmj_mutex* mutex) { pthread_mutex_destroy(mutex); }
+static void gmj_mutex_lock(gmj_mutex* mutex) { pthread_mutex_lock(mutex); }
+static void gmj_mutex_unlock(gmj_mutex* mutex) { pthread_mutex_unlock(mutex); }
+static void gmj_cond_init(gmj_cond* cond) { pthread_cond_init(cond, NULL); }
+static void gmj_cond_destroy(gmj_cond* cond) { pthread_cond_destroy(cond); }
+static void gmj_cond_wait(gmj_cond* cond, gmj_mutex* mutex) {
+  pthread_cond_wait(cond, mutex);
 }
+static void gmj_cond_signal(gmj_cond* cond) { pthread_cond_signal(cond); }
+static void gmj_cond_broadcast(gmj_cond* cond) { pthread_cond_broadcast(cond); }
 
-void gmj_data_free(gmj_data* data) {
-  if (data == NULL) {
-    return;
-  }
-  if (data->handle != NULL) {
-    mj_deleteData(data->handle);
-    data->handle = NULL;
-  }
-  free(data);
+static int gmj_thread_start(gmj_thread* thread, gmj_thread_entry entry,
+                            void* arg) {
+  return pthread_create(thread, NULL, entry, arg);
 }
 
-gmj_error_code gmj_reset_data(const gmj_model* model, gmj_data* data) {
-  const gmj_error_code valid = gmj_validate_ptrs(model, data);
-  if (valid != GMJ_OK) {
-    return valid;
-  }
+static void gmj_thread_join(gmj_thread thread) { pthread_join(thread, NULL); }
 
-  mj_resetData(model->handle, data->handle);
-  gmj_set_error(NULL);
-  return GMJ_OK;
+static double gmj_now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
 }
 
-gmj_error_code gmj_step(const gmj_model* model, gmj_data* data, int steps) {
-  int i = 0;
-  const gmj_error_code valid = gmj_validate_ptrs(model, data);
-  if (valid != GMJ_OK) {
-    return valid;
-  }
-  if (steps < 1) {
-    gmj_set_error("steps must be >= 1");
-    return GMJ_ERR_INVALID_ARGUMENT;
-  }
+static void gmj_sleep_seconds(double seconds) {
+  struct timespec ts;
+  ts.tv_sec = (time_t)seconds;
+  ts.tv_nsec = (long)((seconds - (double)ts.tv_sec) * 1e9);
+  nanosleep(&ts, NULL);
+}
 
-  for (i = 0; i < steps; ++i) {
-    mj_step(model->handle, data->handle);
-  }
+static void gmj_thread_yield(void) { sched_yield(); }
 
-  gmj_set_error(NULL);
-  return GMJ_OK;
+static int gmj_cpu_count(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+  const long count = sysconf(_SC_NPROCESSORS_ONLN);
+  return count > 0 ? (int)count : 1;
+#else
+  return 1;
+#endif
 }
+#endif
 
-gmj_error_code gmj_forward(const gmj_model* model, gmj_data* data) {
-  const gmj_error_code valid = gmj_validate_ptrs(model, data);
-  if (valid != GMJ_OK) {
-    return valid;
-  }
+#if defined(_MSC_VER)
+static long gmj_atomic_fetch_add(volatile long* target, long value) {
+  return InterlockedExchangeAdd(target, value);
+}
+static long gmj_atomic_load(volatile long* target) {
+  return InterlockedCompareExchange(target, 0, 0);
+}
+static void gmj_atomic_store(volatile long* target, long value) {
+  InterlockedExchange(target, value);
+}
+static long gmj_atomic_exchange(volatile long* target, long value) {
+  return InterlockedExchange(target, value);
+}
+#else
+static long gmj_atomic_fetch_add(volatile long* target, long value) {
+  return __atomic_fetch_add(target, value, __ATOMIC_ACQ_REL);
+}
+static long gmj_atomic_load(volatile long* target) {
+  return __atomic_load_n(target, __ATOMIC_ACQUIRE);
+}
+static void gmj_atomic_store(volatile long* target, long value) {
+  __atomic_store_n(target, value, __ATOMIC_RELEASE);
+}
+static long gmj_atomic_exchange(volatile long* target, long value) {
+  return __atomic_exchange_n(target, value, __ATOMIC_ACQ_REL);
+}
+#endif
 
-  mj_forward(model->handle, data->handle);
-  gmj_set_error(NULL);
-  return GMJ_OK;
+#if defined(_WIN32)
+typedef SRWLOCK gmj_static_mutex;
+#define GMJ_STATIC_MUTEX_INIT SRWLOCK_INIT
+static void gmj_static_mutex_lock(gmj_static_mutex* mutex) {
+  AcquireSRWLockExclusive(mutex);
+}
+static void gmj_static_mutex_unlock(gmj_static_mutex* mutex) {
+  ReleaseSRWLockExclusive(mutex);
+}
+#else
+typedef pthread_mutex_t gmj_static_mutex;
+#define GMJ_STATIC_MUTEX_INIT PTHREAD_MUTEX_INITIALIZER
+static void gmj_static_mutex_lock(gmj_static_mutex* mutex) {
+  pthread_mutex_lock(mutex);
+}
+static void gmj_static_mutex_unlock(gmj_static_mutex* mutex) {
+  pthread_mutex_unlock(mutex);
 }
+#endif
 
-int gmj_nq(const gmj_model* model) {
-  if (model == NULL || model->handle == NULL) {
-    gmj_set_error("model is null");
-    return -1;
+/* x86 kernels are compiled per function with target attributes (or plain
+   intrinsics on MSVC) so the library itself keeps the baseline ISA; the
+   level is picked at run time from cpuid. */
+#if (defined(__GNUC__) || defined(__clang__)) && \
+    (defined(__x86_64__) || defined(__i386__))
+#define GMJ_X86_SIMD 1
+#define GMJ_TARGET(features) __attribute__((target(features)))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define GMJ_X86_SIMD 1
+#define GMJ_TARGET(features)
+#endif
+
+#ifdef GMJ_X86_SIMD
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+static gmj_simd_level gmj_simd_detect(void) {
+#if defined(GMJ_X86_SIMD) && defined(_MSC_VER)
+  int info[4];
+  unsigned long long xcr0 = 0;
+  __cpuid(info, 1);
+  if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 12)) == 0) {
+    return GMJ_SIMD_SCALAR;
   }
-  return model->handle->nq;
+  xcr0 = _xgetbv(0);
+  if ((xcr0 & 0x6) != 0x6) {
+    return GMJ_SIMD_SCALAR;
+  }
+  __cpuidex(info, 7, 0);
+  if ((info[1] & (1 << 5)) == 0) {
+    return GMJ_SIMD_SCALAR;
+  }
+  if ((info[1] & (1 << 16)) != 0 && (xcr0 & 0xe6) == 0xe6) {
+    return GMJ_SIMD_AVX512;
+  }
+  return GMJ_SIMD_AVX2;
+#elif defined(GMJ_X86_SIMD)
+  __builtin_cpu_init();
+  if (!__builtin_cpu_supports("avx2") || !__builtin_cpu_supports("fma")) {
+    return GMJ_SIMD_SCALAR;
+  }
+  if (__builtin_cpu_supports("avx512f")) {
+    return GMJ_SIMD_AVX512;
+  }
+  return GMJ_SIMD_AVX2;
+#else
+  return GMJ_SIMD_SCALAR;
+#endif
 }
 
-int gmj_nv(const gmj_model* model) {
-  if (model == NULL || model->handle == NULL) {
-    gmj_set_error("model is null");
-    return -1;
+/* -1 until first use; detection is idempotent so racing callers are fine. */
+static volatile long gmj_simd_detected = -1;
+static volatile long gmj_simd_limit = GMJ_SIMD_AVX512;
+
+static gmj_simd_level gmj_simd_active(void) {
+  long level = gmj_atomic_load(&gmj_simd_detected);
+  long limit = gmj_atomic_load(&gmj_simd_limit);
+  if (level < 0) {
+    level = (long)gmj_simd_detect();
+    gmj_atomic_store(&gmj_simd_detected, level);
   }
-  return model->handle->nv;
+  return (gmj_simd_level)(level < limit ? level : limit);
 }
 
-int gmj_nu(const gmj_model* model) {
-  if (model == NULL || model->handle == NULL) {
-    gmj_set_error("model is null");
-    return -1;
-  }
-  return model->handle->nu;
+gmj_simd_level gmj_simd_get_level(void) { return gmj_simd_active(); }
+
+void gmj_simd_set_limit(gmj_simd_level max_level) {
+  gmj_atomic_store(&gmj_simd_limit, (long)max_level);
 }
 
-int gmj_nbody(const gmj_model* model) {
-  if (model == NULL || model->handle == NULL) {
-    gmj_set_error("model is null");
-    return -1;
+/* double <-> float32 conversion for the float32 state API. On x86-64 the
+   SCALAR level still converts four values per instruction pair with SSE2,
+   which every x86-64 CPU has; AVX2 and AVX-512 widen that to 8 and 16 per
+   iteration. Tails fall back to the scalar loop. */
+#ifndef mjUSESINGLE
+static void gmj_narrow_scalar(float* dst, const double* src, int count) {
+  int i = 0;
+  for (i = 0; i < count; ++i) {
+    dst[i] = (float)src[i];
   }
-  return model->handle->nbody;
 }
 
-int gmj_body_id(const gmj_model* model, const char* body_name) {
-  int id = -1;
-  if (model == NULL || model->handle == NULL || body_name == NULL) {
-    gmj_set_error("invalid model pointer or body_name");
-    return -1;
+static void gmj_widen_scalar(double* dst, const float* src, int count) {
+  int i = 0;
+  for (i = 0; i < count; ++i) {
+    dst[i] = (double)src[i];
   }
+}
 
-  id = mj_name2id(model->handle, mjOBJ_BODY, body_name);
-  if (id < 0) {
-    gmj_set_error("body_name not found");
-    return -1;
+#ifdef GMJ_X86_SIMD
+#if defined(__x86_64__) || defined(_M_X64)
+#define GMJ_SSE2_BASELINE 1
+
+static void gmj_narrow_sse2(float* dst, const double* src, int count) {
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m128 lo = _mm_cvtpd_ps(_mm_loadu_pd(src + i));
+    const __m128 hi = _mm_cvtpd_ps(_mm_loadu_pd(src + i + 2));
+    _mm_storeu_ps(dst + i, _mm_movelh_ps(lo, hi));
   }
-  gmj_set_error(NULL);
-  return id;
+  gmj_narrow_scalar(dst + i, src + i, count - i);
 }
 
-int gmj_joint_id(const gmj_model* model, const char* joint_name) {
-  int id = -1;
-  if (model == NULL || model->handle == NULL || joint_name == NULL) {
-    gmj_set_error("invalid model pointer or joint_name");
-    return -1;
+static void gmj_widen_sse2(double* dst, const float* src, int count) {
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    const __m128 v = _mm_loadu_ps(src + i);
+    _mm_storeu_pd(dst + i, _mm_cvtps_pd(v));
+    _mm_storeu_pd(dst + i + 2, _mm_cvtps_pd(_mm_movehl_ps(v, v)));
   }
+  gmj_widen_scalar(dst + i, src + i, count - i);
+}
+#endif
 
-  id = mj_name2id(model->handle, mjOBJ_JOINT, joint_name);
-  if (id < 0) {
-    gmj_set_error("joint_name not found");
-    return -1;
+GMJ_TARGET("avx2,fma")
+static void gmj_narrow_avx2(float* dst, const double* src, int count) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    _mm_storeu_ps(dst + i, _mm256_cvtpd_ps(_mm256_loadu_pd(src + i)));
+    _mm_storeu_ps(dst + i + 4, _mm256_cvtpd_ps(_mm256_loadu_pd(src + i + 4)));
   }
-  gmj_set_error(NULL);
-  return id;
+  gmj_narrow_scalar(dst + i, src + i, count - i);
 }
 
-int gmj_actuator_id(const gmj_model* model, const char* actuator_name) {
-  int id = -1;
-  if (model == NULL || model->handle == NULL || actuator_name == NULL) {
-    gmj_set_error("invalid model pointer or actuator_name");
-    return -1;
+GMJ_TARGET("avx2,fma")
+static void gmj_widen_avx2(double* dst, const float* src, int count) {
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    _mm256_storeu_pd(dst + i, _mm256_cvtps_pd(_mm_loadu_ps(src + i)));
+    _mm256_storeu_pd(dst + i + 4, _mm256_cvtps_pd(_mm_loadu_ps(src + i + 4)));
   }
+  gmj_widen_scalar(dst + i, src + i, count - i);
+}
 
-  id = mj_name2id(model->handle, mjOBJ_ACTUATOR, actuator_name);
-  if (id < 0) {
-    gmj_set_error("actuator_name not found");
-    return -1;
+GMJ_TARGET("avx512f")
+static void gmj_narrow_avx512(float* dst, const double* src, int count) {
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    _mm256_storeu_ps(dst + i, _mm512_cvtpd_ps(_mm512_loadu_pd(src + i)));
+    _mm256_storeu_ps(dst + i + 8,
+                     _mm512_cvtpd_ps(_mm512_loadu_pd(src + i + 8)));
   }
-  gmj_set_error(NULL);
-  return id;
+  gmj_narrow_scalar(dst + i, src + i, count - i);
 }
 
-const char* gmj_body_name(const gmj_model* model, int body_id) {
-  const char* name = NULL;
-  if (model == NULL || model->handle == NULL) {
-    gmj_set_error("invalid model pointer");
-    return NULL;
-  }
-  if (body_id < 0 || body_id >= model->handle->nbody) {
-    gmj_set_error("body_id out of range");
-    return NULL;
+GMJ_TARGET("avx512f")
+static void gmj_widen_avx512(double* dst, const float* src, int count) {
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    _mm512_storeu_pd(dst + i, _mm512_cvtps_pd(_mm256_loadu_ps(src + i)));
+    _mm512_storeu_pd(dst + i + 8,
+                     _mm512_cvtps_pd(_mm256_loadu_ps(src + i + 8)));
   }
-
-  name = mj_id2name(model->handle, mjOBJ_BODY, body_id);
-  gmj_set_error(NULL);
-  return name;
+  gmj_widen_scalar(dst + i, src + i, count - i);
 }
+#endif
+#endif
 
-const char* gmj_joint_name(const gmj_model* model, int joint_id) {
-  const char* name = NULL;
-  if (model == NULL || model->handle == NULL) {
-    gmj_set_error("invalid model pointer");
-    return NULL;
-  }
-  if (joint_id < 0 || joint_id >= model->handle->njnt) {
-    gmj_set_error("joint_id out of range");
-    return NULL;
+/* dst[0, count) = (float)src[0, count). */
+static void gmj_store_f32(float* dst, const mjtNum* src, int count,
+                          gmj_simd_level level) {
+#ifdef mjUSESINGLE
+  (void)level;
+  memcpy(dst, src, sizeof(float) * (size_t)count);
+#elif defined(GMJ_X86_SIMD)
+  if (level >= GMJ_SIMD_AVX512) {
+    gmj_narrow_avx512(dst, src, count);
+  } else if (level == GMJ_SIMD_AVX2) {
+    gmj_narrow_avx2(dst, src, count);
+  } else {
+#ifdef GMJ_SSE2_BASELINE
+    gmj_narrow_sse2(dst, src, count);
+#else
+    gmj_narrow_scalar(dst, src, count);
+#endif
   }
+#else
+  (void)level;
+  gmj_narrow_scalar(dst, src, count);
+#endif
+}
 
-  name = mj_id2name(model->handle, mjOBJ_JOINT, joint_id);
-  gmj_set_error(NULL);
-  return name;
+/* dst[0, count) = (mjtNum)src[0, count). */
+static void gmj_load_f32(mjtNum* dst, const float* src, int count,
+                         gmj_simd_level level) {
+#ifdef mjUSESINGLE
+  (void)level;
+  memcpy(dst, src, sizeof(float) * (size_t)count);
+#elif defined(GMJ_X86_SIMD)
+  if (level >= GMJ_SIMD_AVX512) {
+    gmj_widen_avx512(dst, src, count);
+  } else if (level == GMJ_SIMD_AVX2) {
+    gmj_widen_avx2(dst, src, count);
+  } else {
+#ifdef GMJ_SSE2_BASELINE
+    gmj_widen_sse2(dst, src, count);
+#else
+    gmj_widen_scalar(dst, src, count);
+#endif
+  }
+#else
+  (void)level;
+  gmj_widen_scalar(dst, src, count);
+#endif
 }
 
-const char* gmj_actuator_name(const gmj_model* model, int actuator_id) {
-  const char* name = NULL;
-  if (model == NULL || model->handle == NULL) {
-    gmj_set_error("invalid model pointer");
-    return NULL;
+typedef void (*gmj_pool_task)(void* context, int item_index);
+
+/* Each worker owns a contiguous slice of the items and claims from it with
+   an atomic counter; once its slice is drained it claims from the other
+   slices, so one slow item (e.g. a contact-heavy env) only delays its own
+   worker instead of the whole dispatch. */
+typedef struct gmj_pool_worker {
+  struct gmj_thread_pool* pool;
+  int index;
+  gmj_thread thread;
+  volatile long next;
+  long end;
+  gmj_thread_stats stats;
+} gmj_pool_worker;
+
+struct gmj_thread_pool {
+  int thread_count;
+  gmj_pool_worker* workers;
+  gmj_mutex mutex;
+  gmj_mutex dispatch_mutex;
+  gmj_cond work_cond;
+  gmj_cond done_cond;
+  unsigned long generation;
+  int pending;
+  int shutdown;
+  gmj_pool_task task;
+  void* context;
+};
+
+static void gmj_pool_work(gmj_thread_pool* pool, gmj_pool_worker* self) {
+  const double start = gmj_now_seconds();
+  int offset = 0;
+
+  for (offset = 0; offset < pool->thread_count; ++offset) {
+    gmj_pool_worker* victim =
+        &pool->workers[(self->index + offset) % pool->thread_count];
+    for (;;) {
+      const long item = gmj_atomic_fetch_add(&victim->next, 1);
+      if (item >= victim->end) {
+        break;
+      }
+      pool->task(pool->context, (int)item);
+      self->stats.items_processed += 1;
+      if (victim != self) {
+        self->stats.items_stolen += 1;
+      }
+    }
   }
-  if (actuator_id < 0 || actuator_id >= model->handle->nu) {
-    gmj_set_error("actuator_id out of range");
-    return NULL;
+
+  self->stats.dispatches += 1;
+  self->stats.busy_seconds += gmj_now_seconds() - start;
+}
+
+static GMJ_THREAD_RETURN gmj_pool_worker_main(void* arg) {
+  gmj_pool_worker* self = (gmj_pool_worker*)arg;
+  gmj_thread_pool* pool = self->pool;
+  unsigned long seen = 0;
+
+  for (;;) {
+    gmj_mutex_lock(&pool->mutex);
+    while (!pool->shutdown && pool->generation == seen) {
+      gmj_cond_wait(&pool->work_cond, &pool->mutex);
+    }
+    if (pool->shutdown) {
+      gmj_mutex_unlock(&pool->mutex);
+      break;
+    }
+    seen = pool->generation;
+    gmj_mutex_unlock(&pool->mutex);
+
+    gmj_pool_work(pool, self);
+
+    gmj_mutex_lock(&pool->mutex);
+    pool->pending -= 1;
+    if (pool->pending == 0) {
+      gmj_cond_signal(&pool->done_cond);
+    }
+    gmj_mutex_unlock(&pool->mutex);
   }
 
-  name = mj_id2name(model->handle, mjOBJ_ACTUATOR, actuator_id);
-  gmj_set_error(NULL);
-  return name;
+  return GMJ_THREAD_RESULT;
 }
 
-gmj_error_code gmj_set_ctrl(const gmj_model* model, gmj_data* data,
-                            int actuator_index, double value) {
-  const gmj_error_code valid = gmj_validate_ptrs(model, data);
-  if (valid != GMJ_OK) {
-    return valid;
+/* Runs task(context, i) for every i in [0, item_count). The calling thread
+   acts as worker 0; with no pool the items run serially in order. */
+static void gmj_pool_run(gmj_thread_pool* pool, int item_count,
+                         gmj_pool_task task, void* context) {
+  int i = 0;
+  long chunk = 0;
+  long remainder = 0;
+  long begin = 0;
+
+  if (pool == NULL || pool->thread_count < 2 || item_count < 2) {
+    for (i = 0; i < item_count; ++i) {
+      task(context, i);
+    }
+    return;
   }
-  if (actuator_index < 0 || actuator_index >= model->handle->nu) {
-    gmj_set_error("actuator_index out of range");
-    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+
+  gmj_mutex_lock(&pool->dispatch_mutex);
+  gmj_mutex_lock(&pool->mutex);
+  pool->task = task;
+  pool->context = context;
+  chunk = item_count / pool->thread_count;
+  remainder = item_count % pool->thread_count;
+  for (i = 0; i < pool->thread_count; ++i) {
+    const long size = chunk + (i < remainder ? 1 : 0);
+    gmj_atomic_store(&pool->workers[i].next, begin);
+    pool->workers[i].end = begin + size;
+    begin += size;
   }
+  pool->pending = pool->thread_count - 1;
+  pool->generation += 1;
+  gmj_cond_broadcast(&pool->work_cond);
+  gmj_mutex_unlock(&pool->mutex);
 
-  data->handle->ctrl[actuator_index] = (mjtNum)value;
-  gmj_set_error(NULL);
-  return GMJ_OK;
-}
+  gmj_pool_work(pool, &pool->workers[0]);
 
-gmj_error_code gmj_get_ctrl(const gmj_model* model, const gmj_data* data,
-                            int actuator_index, double* out_value) {
-  if (out_value == NULL) {
-    gmj_set_error("out_value is null");
-    return GMJ_ERR_INVALID_ARGUMENT;
+  gmj_mutex_lock(&pool->mutex);
+  while (pool->pending > 0) {
+    gmj_cond_wait(&pool->done_cond, &pool->mutex);
   }
-  if (model == NULL || model->handle == NULL || data == NULL ||
-      data->handle == NULL) {
-    gmj_set_error("invalid model or data pointer");
-    return GMJ_ERR_INVALID_ARGUMENT;
+  pool->task = NULL;
+  pool->context = NULL;
+  gmj_mutex_unlock(&pool->mutex);
+  gmj_mutex_unlock(&pool->dispatch_mutex);
+}
+
+const char* gmj_mujoco_version(void) {
+  static _Thread_local char version[32];
+  const int ver = mj_version();
+  const int major = ver / 100;
+  const int minor = ver % 100;
+  snprintf(version, sizeof(version), "%d.%d", major, minor);
+  return version;
+}
+
+static void gmj_write_error(char* error_buffer, size_t error_buffer_size,
+                            const char* message) {
+  if (error_buffer != NULL && error_buffer_size > 0) {
+    strncpy(error_buffer, message, error_buffer_size);
+    error_buffer[error_buffer_size - 1] = '\0';
   }
-  if (actuator_index < 0 || actuator_index >= model->handle->nu) {
-    gmj_set_error("actuator_index out of range");
-    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  gmj_set_error(message);
+}
+
+static gmj_model* gmj_model_wrap(mjModel* model) {
+  gmj_model* wrapper = (gmj_model*)calloc(1, sizeof(gmj_model));
+  if (wrapper == NULL) {
+    mj_deleteModel(model);
+    gmj_set_error("failed to allocate gmj_model");
+    return NULL;
   }
+  wrapper->handle = model;
+  wrapper->refcount = 1;
+  return wrapper;
+}
 
-  *out_value = (double)data->handle->ctrl[actuator_index];
-  gmj_set_error(NULL);
-  return GMJ_OK;
+static gmj_static_mutex gmj_model_cache_mutex = GMJ_STATIC_MUTEX_INIT;
+static gmj_model* gmj_model_cache_head = NULL;
+
+static unsigned long long gmj_hash_bytes(unsigned long long hash,
+                                         const void* bytes, size_t size) {
+  const unsigned char* cursor = (const unsigned char*)bytes;
+  size_t i = 0;
+  for (i = 0; i < size; ++i) {
+    hash ^= (unsigned long long)cursor[i];
+    hash *= 1099511628211ULL;
+  }
+  return hash;
 }
 
-gmj_error_code gmj_get_qpos(const gmj_model* model, const gmj_data* data,
-                            int qpos_index, double* out_value) {
-  if (out_value == NULL) {
-    gmj_set_error("out_value is null");
-    return GMJ_ERR_INVALID_ARGUMENT;
+#define GMJ_HASH_SEED 14695981039346656037ULL
+
+static int gmj_hash_file(const char* path, unsigned long long* out_hash) {
+  unsigned char chunk[16384];
+  unsigned long long hash = GMJ_HASH_SEED;
+  size_t read = 0;
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    return -1;
   }
-  if (model == NULL || model->handle == NULL || data == NULL ||
-      data->handle == NULL) {
-    gmj_set_error("invalid model or data pointer");
-    return GMJ_ERR_INVALID_ARGUMENT;
+  while ((read = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    hash = gmj_hash_bytes(hash, chunk, read);
   }
-  if (qpos_index < 0 || qpos_index >= model->handle->nq) {
-    gmj_set_error("qpos_index out of range");
-    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  if (ferror(file)) {
+    fclose(file);
+    return -1;
   }
+  fclose(file);
+  *out_hash = hash;
+  return 0;
+}
 
-  *out_value = (double)data->handle->qpos[qpos_index];
-  gmj_set_error(NULL);
-  return GMJ_OK;
+static char* gmj_canonical_path(const char* path) {
+#if defined(_WIN32)
+  return _fullpath(NULL, path, 0);
+#else
+  return realpath(path, NULL);
+#endif
 }
 
-gmj_error_code gmj_set_qpos(const gmj_model* model, gmj_data* data,
-                            int qpos_index, double value) {
-  const gmj_error_code valid = gmj_validate_ptrs(model, data);
-  if (valid != GMJ_OK) {
-    return valid;
+typedef struct gmj_mapped_file {
+  const void* data;
+  size_t size;
+#if defined(_WIN32)
+  HANDLE file;
+  HANDLE mapping;
+#endif
+} gmj_mapped_file;
+
+static int gmj_map_file(const char* path, gmj_mapped_file* out_file) {
+#if defined(_WIN32)
+  LARGE_INTEGER size;
+  memset(out_file, 0, sizeof(gmj_mapped_file));
+  out_file->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                               OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (out_file->file == INVALID_HANDLE_VALUE) {
+    return -1;
   }
-  if (qpos_index < 0 || qpos_index >= model->handle->nq) {
-    gmj_set_error("qpos_index out of range");
-    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  if (!GetFileSizeEx(out_file->file, &size) || size.QuadPart <= 0) {
+    CloseHandle(out_file->file);
+    return -1;
+  }
+  out_file->mapping =
+      CreateFileMappingA(out_file->file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (out_file->mapping == NULL) {
+    CloseHandle(out_file->file);
+    return -1;
+  }
+  out_file->data = MapViewOfFile(out_file->mapping, FILE_MAP_READ, 0, 0, 0);
+  if (out_file->data == NULL) {
+    CloseHandle(out_file->mapping);
+    CloseHandle(out_file->file);
+    return -1;
+  }
+  out_file->size = (size_t)size.QuadPart;
+  return 0;
+#else
+  struct stat info;
+  void* data = NULL;
+  const int fd = open(path, O_RDONLY);
+  memset(out_file, 0, sizeof(gmj_mapped_file));
+  if (fd < 0) {
+    return -1;
+  }
+  if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+    close(fd);
+    return -1;
   }
+  data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return -1;
+  }
+  out_file->data = data;
+  out_file->size = (size_t)info.st_size;
+  return 0;
+#endif
+}
 
-  data->handle->qpos[qpos_index] = (mjtNum)value;
-  gmj_set_error(NULL);
-  return GMJ_OK;
+static void gmj_unmap_file(gmj_mapped_file* file) {
+  if (file->data == NULL) {
+    return;
+  }
+#if defined(_WIN32)
+  UnmapViewOfFile(file->data);
+  CloseHandle(file->mapping);
+  CloseHandle(file->file);
+#else
+  munmap((void*)file->data, file->size);
+#endif
+  file->data = NULL;
+  file->size = 0;
 }
 
-gmj_error_code gmj_get_qvel(const gmj_model* model, const gmj_data* data,
-                            int qvel_index, double* out_value) {
-  if (out_value == NULL) {
-    gmj_set_error("out_value is null");
-    return GMJ_ERR_INVALID_ARGUMENT;
+static char* gmj_read_text_file(const char* path) {
+  char* text = NULL;
+  long size = 0;
+  FILE* file = fopen(path, "rb");
+  if (file == NULL) {
+    return NULL;
   }
-  if (model == NULL || model->handle == NULL || data == NULL ||
-      data->handle == NULL) {
-    gmj_set_error("invalid model or data pointer");
-    return GMJ_ERR_INVALID_ARGUMENT;
+  if (fseek(file, 0, SEEK_END) != 0 || (size = ftell(file)) < 0 ||
+      fseek(file, 0, SEEK_SET) != 0) {
+    fclose(file);
+    return NULL;
   }
-  if (qvel_index < 0 || qvel_index >= model->handle->nv) {
-    gmj_set_error("qvel_index out of range");
-    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  text = (char*)malloc((size_t)size + 1);
+  if (text != NULL) {
+    if (fread(text, 1, (size_t)size, file) != (size_t)size) {
+      free(text);
+      text = NULL;
+    } else {
+      text[size] = '\0';
+    }
   }
+  fclose(file);
+  return text;
+}
 
-  *out_value = (double)data->handle->qvel[qvel_index];
-  gmj_set_error(NULL);
-  return GMJ_OK;
+#define GMJ_PATH_MAX 1024
+#define GMJ_INCLUDE_DEPTH_MAX 16
+
+typedef struct gmj_asset_dirs {
+  char model_dir[GMJ_PATH_MAX];
+  char mesh_dir[GMJ_PATH_MAX];
+  char texture_dir[GMJ_PATH_MAX];
+} gmj_asset_dirs;
+
+static int gmj_is_absolute_path(const char* path) {
+  if (path[0] == '/' || path[0] == '\\') {
+    return 1;
+  }
+  return path[0] != '\0' && path[1] == ':';
 }
 
-gmj_error_code gmj_set_qvel(const gmj_model* model, gmj_data* data,
-                            int qvel_index, double value) {
-  const gmj_error_code valid = gmj_validate_ptrs(model, data);
-  if (valid != GMJ_OK) {
-    return valid;
+static void gmj_parent_dir(const char* path, char* out_dir, size_t size) {
+  const char* slash = strrchr(path, '/');
+  const char* backslash = strrchr(path, '\\');
+  size_t length = 0;
+  if (backslash != NULL && (slash == NULL || backslash > slash)) {
+    slash = backslash;
   }
-  if (qvel_index < 0 || qvel_index >= model->handle->nv) {
-    gmj_set_error("qvel_index out of range");
-    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  length = slash != NULL ? (size_t)(slash - path) + 1 : 0;
+  if (length >= size) {
+    length = size - 1;
   }
+  memcpy(out_dir, path, length);
+  out_dir[length] = '\0';
+}
 
-  data->handle->qvel[qvel_index] = (mjtNum)value;
-  gmj_set_error(NULL);
-  return GMJ_OK;
+static void gmj_join_path(const char* dir, const char* name, char* out_path,
+                          size_t size) {
+  if (gmj_is_absolute_path(name) || dir[0] == '\0') {
+    snprintf(out_path, size, "%s", name);
+  } else {
+    const size_t length = strlen(dir);
+    const char last = length > 0 ? dir[length - 1] : '/';
+    snprintf(out_path, size, "%s%s%s", dir,
+             (last == '/' || last == '\\') ? "" : "/", name);
+  }
 }
 
-gmj_error_code gmj_get_qpos_slice(const gmj_model* model, const gmj_data* data,
-                                  int start_index, int count,
-                                  double* out_values) {
-  int i = 0;
-  gmj_error_code valid = GMJ_OK;
-  if (out_values == NULL) {
-    gmj_set_error("out_values is null");
-    return GMJ_ERR_INVALID_ARGUMENT;
+static int gmj_xml_is_space(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+/* Copies the value of attribute `name` from the tag text [tag, tag_end)
+   into out_value. Returns 0 when found. Walks the tag attribute by
+   attribute and never reads past tag_end, so hashing a large file stays
+   linear when most tags lack the attribute. */
+static int gmj_xml_attribute(const char* tag, const char* tag_end,
+                             const char* name, char* out_value, size_t size) {
+  const size_t name_length = strlen(name);
+  const char* cursor = tag + 1;
+
+  while (cursor < tag_end && !gmj_xml_is_space(*cursor) && *cursor != '/') {
+    ++cursor;
   }
-  if (model == NULL || model->handle == NULL || data == NULL ||
-      data->handle == NULL) {
-    gmj_set_error("invalid model or data pointer");
-    return GMJ_ERR_INVALID_ARGUMENT;
+  while (cursor < tag_end) {
+    const char* key = NULL;
+    const char* close = NULL;
+    size_t key_length = 0;
+    char quote = '\0';
+
+    while (cursor < tag_end && gmj_xml_is_space(*cursor)) {
+      ++cursor;
+    }
+    key = cursor;
+    while (cursor < tag_end && !gmj_xml_is_space(*cursor) &&
+           *cursor != '=' && *cursor != '/') {
+      ++cursor;
+    }
+    key_length = (size_t)(cursor - key);
+    while (cursor < tag_end && gmj_xml_is_space(*cursor)) {
+      ++cursor;
+    }
+    if (cursor == tag_end) {
+      break;
+    }
+    if (*cursor != '=') {
+      cursor += key_length == 0 ? 1 : 0;
+      continue;
+    }
+    ++cursor;
+    while (cursor < tag_end && gmj_xml_is_space(*cursor)) {
+      ++cursor;
+    }
+    if (cursor == tag_end) {
+      break;
+    }
+    quote = *cursor;
+    if (quote != '"' && quote != '\'') {
+      continue;
+    }
+    ++cursor;
+    close = (const char*)memchr(cursor, quote, (size_t)(tag_end - cursor));
+    if (close == NULL) {
+      break;
+    }
+    if (key_length == name_length && memcmp(key, name, name_length) == 0) {
+      if ((size_t)(close - cursor) >= size) {
+        return -1;
+      }
+      memcpy(out_value, cursor, (size_t)(close - cursor));
+      out_value[close - cursor] = '\0';
+      return 0;
+    }
+    cursor = close + 1;
   }
+  return -1;
+}
 
-  valid = gmj_validate_slice(start_index, count, model->handle->nq);
-  if (valid != GMJ_OK) {
-    return valid;
+static int gmj_tag_is(const char* tag, const char* name) {
+  const size_t length = strlen(name);
+  return strncmp(tag + 1, name, length) == 0 &&
+         (gmj_xml_is_space(tag[1 + length]) || tag[1 + length] == '/' ||
+          tag[1 + length] == '>');
+}
+
+/* Folds the contents of xml_path and every file it references (includes,
+   meshes, textures, heightfields, skins) into hash. Missing files hash as
+   their resolved path only, so creating them later changes the key. */
+static unsigned long long gmj_hash_model_inputs(const char* xml_path,
+                                                gmj_asset_dirs* dirs,
+                                                unsigned long long hash,
+                                                int depth) {
+  char value[GMJ_PATH_MAX];
+  char resolved[GMJ_PATH_MAX];
+  const char* tag = NULL;
+  char* text = gmj_read_text_file(xml_path);
+
+  hash = gmj_hash_bytes(hash, xml_path, strlen(xml_path));
+  if (text == NULL) {
+    return hash;
   }
+  hash = gmj_hash_bytes(hash, text, strlen(text));
 
-  for (i = 0; i < count; ++i) {
-    out_values[i] = (double)data->handle->qpos[start_index + i];
+  for (tag = strchr(text, '<'); tag != NULL; tag = strchr(tag + 1, '<')) {
+    const char* tag_end = strchr(tag, '>');
+    if (tag_end == NULL) {
+      break;
+    }
+    if (gmj_tag_is(tag, "compiler")) {
+      char base[GMJ_PATH_MAX];
+      if (gmj_xml_attribute(tag, tag_end, "assetdir", value, sizeof(value)) ==
+          0) {
+        gmj_join_path(dirs->model_dir, value, base, sizeof(base));
+        snprintf(dirs->mesh_dir, sizeof(dirs->mesh_dir), "%s", base);
+        snprintf(dirs->texture_dir, sizeof(dirs->texture_dir), "%s", base);
+      }
+      if (gmj_xml_attribute(tag, tag_end, "meshdir", value, sizeof(value)) ==
+          0) {
+        gmj_join_path(dirs->model_dir, value, dirs->mesh_dir,
+                      sizeof(dirs->mesh_dir));
+      }
+      if (gmj_xml_attribute(tag, tag_end, "texturedir", value,
+                            sizeof(value)) == 0) {
+        gmj_join_path(dirs->model_dir, value, dirs->texture_dir,
+                      sizeof(dirs->texture_dir));
+      }
+      continue;
+    }
+    if (gmj_xml_attribute(tag, tag_end, "file", value, sizeof(value)) != 0) {
+      continue;
+    }
+
+    if (gmj_tag_is(tag, "include")) {
+      gmj_join_path(dirs->model_dir, value, resolved, sizeof(resolved));
+      if (depth < GMJ_INCLUDE_DEPTH_MAX) {
+        hash = gmj_hash_model_inputs(resolved, dirs, hash, depth + 1);
+      }
+      continue;
+    }
+
+    gmj_join_path(gmj_tag_is(tag, "texture") ? dirs->texture_dir
+                                             : dirs->mesh_dir,
+                  value, resolved, sizeof(resolved));
+    hash = gmj_hash_bytes(hash, resolved, strlen(resolved));
+    {
+      unsigned long long file_hash = 0;
+      if (gmj_hash_file(resolved, &file_hash) == 0) {
+        hash = gmj_hash_bytes(hash, &file_hash, sizeof(file_hash));
+      }
+    }
   }
-  gmj_set_error(NULL);
-  return GMJ_OK;
+
+  free(text);
+  return hash;
 }
 
-gmj_error_code gmj_set_qpos_slice(const gmj_model* model, gmj_data* data,
-                                  int start_index, int count,
-                                  const double* values) {
-  int i = 0;
-  gmj_error_code valid = GMJ_OK;
-  valid = gmj_validate_ptrs(model, data);
-  if (valid != GMJ_OK) {
-    return valid;
-  }
-  if (values == NULL) {
-    gmj_set_error("values is null");
+static unsigned long long gmj_hash_xml_tree(const char* xml_path) {
+  gmj_asset_dirs dirs;
+  gmj_parent_dir(xml_path, dirs.model_dir, sizeof(dirs.model_dir));
+  memcpy(dirs.mesh_dir, dirs.model_dir, sizeof(dirs.mesh_dir));
+  memcpy(dirs.texture_dir, dirs.model_dir, sizeof(dirs.texture_dir));
+  return gmj_hash_model_inputs(xml_path, &dirs, GMJ_HASH_SEED, 0);
+}
+
+static gmj_static_mutex gmj_compile_cache_mutex = GMJ_STATIC_MUTEX_INIT;
+static char gmj_compile_cache_dir[GMJ_PATH_MAX] = {0};
+
+gmj_error_code gmj_compile_cache_set_dir(const char* cache_dir) {
+  if (cache_dir != NULL && strlen(cache_dir) >= GMJ_PATH_MAX - 64) {
+    gmj_set_error("cache_dir is too long");
     return GMJ_ERR_INVALID_ARGUMENT;
   }
 
-  valid = gmj_validate_slice(start_index, count, model->handle->nq);
-  if (valid != GMJ_OK) {
-    return valid;
+  if (cache_dir != NULL && cache_dir[0] != '\0') {
+#if defined(_WIN32)
+    CreateDirectoryA(cache_dir, NULL);
+#else
+    mkdir(cache_dir, 0755);
+#endif
   }
 
-  for (i = 0; i < count; ++i) {
-    data->handle->qpos[start_index + i] = (mjtNum)values[i];
-  }
+  gmj_static_mutex_lock(&gmj_compile_cache_mutex);
+  snprintf(gmj_compile_cache_dir, sizeof(gmj_compile_cache_dir), "%s",
+           cache_dir != NULL ? cache_dir : "");
+  gmj_static_mutex_unlock(&gmj_compile_cache_mutex);
   gmj_set_error(NULL);
   return GMJ_OK;
 }
 
-gmj_error_code gmj_get_qvel_slice(const gmj_model* model, const gmj_data* data,
-                                  int start_index, int count,
-                                  double* out_values) {
-  int i = 0;
-  gmj_error_code valid = GMJ_OK;
-  if (out_values == NULL) {
-    gmj_set_error("out_values is null");
-    return GMJ_ERR_INVALID_ARGUMENT;
+/* Size in bytes, or -1 when the file cannot be opened. */
+static long gmj_file_size(const char* path) {
+  FILE* file = fopen(path, "rb");
+  long size = -1;
+  if (file == NULL) {
+    return -1;
   }
-  if (model == NULL || model->handle == NULL || data == NULL ||
-      data->handle == NULL) {
-    gmj_set_error("invalid model or data pointer");
-    return GMJ_ERR_INVALID_ARGUMENT;
+  if (fseek(file, 0, SEEK_END) == 0) {
+    size = ftell(file);
   }
+  fclose(file);
+  return size;
+}
 
-  valid = gmj_validate_slice(start_index, count, model->handle->nv);
-  if (valid != GMJ_OK) {
-    return valid;
+/* MuJoCo reads the file itself; the existence check keeps a cache miss
+   from raising a MuJoCo warning. */
+static mjModel* gmj_load_binary(const char* binary_path) {
+  if (gmj_file_size(binary_path) <= 0) {
+    return NULL;
   }
+  return mj_loadModel(binary_path, NULL);
+}
 
-  for (i = 0; i < count; ++i) {
-    out_values[i] = (double)data->handle->qvel[start_index + i];
+static volatile long gmj_save_binary_counter = 0;
+
+static int gmj_save_binary(const mjModel* model, const char* binary_path) {
+  char temp_path[GMJ_PATH_MAX + 64];
+  const long serial = gmj_atomic_fetch_add(&gmj_save_binary_counter, 1);
+
+  /* Unique per process and call, so concurrent writers of the same hash
+     never share a temp file. */
+#if defined(_WIN32)
+  snprintf(temp_path, sizeof(temp_path), "%s.%lu-%ld.tmp", binary_path,
+           (unsigned long)GetCurrentProcessId(), serial);
+#else
+  snprintf(temp_path, sizeof(temp_path), "%s.%lu-%ld.tmp", binary_path,
+           (unsigned long)getpid(), serial);
+#endif
+  remove(temp_path);
+  mj_saveModel(model, temp_path, NULL, 0);
+  if (gmj_file_size(temp_path) != (long)mj_sizeModel(model)) {
+    remove(temp_path);
+    return -1;
+  }
+
+  /* Write-then-rename so a concurrent loader never reads a partial file. */
+#if defined(_WIN32)
+  if (!MoveFileExA(temp_path, binary_path, MOVEFILE_REPLACE_EXISTING)) {
+#else
+  if (rename(temp_path, binary_path) != 0) {
+#endif
+    remove(temp_path);
+    return -1;
+  }
+  return 0;
+}
+
+/* tree_hash, when the caller already has it, saves hashing the XML tree a
+   second time for the compile cache. */
+static gmj_model* gmj_model_load_xml_hashed(
+    const char* xml_path, const unsigned long long* tree_hash,
+    char* error_buffer, size_t error_buffer_size) {
+  char load_error[1024] = {0};
+  char cache_dir[GMJ_PATH_MAX];
+  char binary_path[GMJ_PATH_MAX + 96];
+  gmj_load_info info;
+  gmj_model* wrapper = NULL;
+  mjModel* model = NULL;
+  const double start = gmj_now_seconds();
+
+  if (xml_path == NULL) {
+    gmj_write_error(error_buffer, error_buffer_size, "xml_path is null");
+    return NULL;
+  }
+
+  memset(&info, 0, sizeof(info));
+  binary_path[0] = '\0';
+  gmj_static_mutex_lock(&gmj_compile_cache_mutex);
+  memcpy(cache_dir, gmj_compile_cache_dir, sizeof(cache_dir));
+  gmj_static_mutex_unlock(&gmj_compile_cache_mutex);
+
+  if (cache_dir[0] != '\0') {
+    char stem[128];
+    const char* name = xml_path + strlen(xml_path);
+    const char* dot = NULL;
+    size_t stem_length = 0;
+
+    info.content_hash =
+        tree_hash != NULL ? *tree_hash : gmj_hash_xml_tree(xml_path);
+
+    while (name > xml_path && name[-1] != '/' && name[-1] != '\\') {
+      --name;
+    }
+    dot = strrchr(name, '.');
+    stem_length = dot != NULL ? (size_t)(dot - name) : strlen(name);
+    if (stem_length >= sizeof(stem)) {
+      stem_length = sizeof(stem) - 1;
+    }
+    memcpy(stem, name, stem_length);
+    stem[stem_length] = '\0';
+
+    /* The binary format is only valid for the MuJoCo build that wrote it. */
+    snprintf(binary_path, sizeof(binary_path), "%s/%s-%016llx-mj%d.mjb",
+             cache_dir, stem, info.content_hash, mj_version());
+    model = gmj_load_binary(binary_path);
+    info.cache_hit = model != NULL ? 1 : 0;
+  }
+
+  if (model == NULL) {
+    model = mj_loadXML(xml_path, NULL, load_error, sizeof(load_error));
+    if (model == NULL) {
+      gmj_write_error(error_buffer, error_buffer_size, load_error);
+      return NULL;
+    }
+    if (binary_path[0] != '\0') {
+      info.cache_written = gmj_save_binary(model, binary_path) == 0 ? 1 : 0;
+    }
+  }
+
+  wrapper = gmj_model_wrap(model);
+  if (wrapper == NULL) {
+    return NULL;
+  }
+
+  info.load_seconds = gmj_now_seconds() - start;
+  wrapper->load_info = info;
+  gmj_set_error(NULL);
+  return wrapper;
+}
+
+gmj_model* gmj_model_load_xml(const char* xml_path, char* error_buffer,
+                              size_t error_buffer_size) {
+  return gmj_model_load_xml_hashed(xml_path, NULL, error_buffer,
+                                   error_buffer_size);
+}
+
+gmj_error_code gmj_model_load_info(const gmj_model* model,
+                                   gmj_load_info* out_info) {
+  if (model == NULL || model->handle == NULL || out_info == NULL) {
+    gmj_set_error("invalid model or out_info pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
   }
+  *out_info = model->load_info;
   gmj_set_error(NULL);
   return GMJ_OK;
 }
 
-gmj_error_code gmj_set_qvel_slice(const gmj_model* model, gmj_data* data,
-                                  int start_index, int count,
-                                  const double* values) {
-  int i = 0;
-  gmj_error_code valid = GMJ_OK;
-  valid = gmj_validate_ptrs(model, data);
-  if (valid != GMJ_OK) {
-    return valid;
+struct gmj_vfs {
+  mjVFS* handle;
+  gmj_mutex mutex;
+};
+
+gmj_vfs* gmj_vfs_create(void) {
+  gmj_vfs* vfs = (gmj_vfs*)calloc(1, sizeof(gmj_vfs));
+  if (vfs == NULL) {
+    gmj_set_error("failed to allocate gmj_vfs");
+    return NULL;
   }
-  if (values == NULL) {
-    gmj_set_error("values is null");
-    return GMJ_ERR_INVALID_ARGUMENT;
+
+  /* mjVFS is a multi-megabyte struct in older MuJoCo releases. */
+  vfs->handle = (mjVFS*)malloc(sizeof(mjVFS));
+  if (vfs->handle == NULL) {
+    free(vfs);
+    gmj_set_error("failed to allocate mjVFS");
+    return NULL;
   }
 
-  valid = gmj_validate_slice(start_index, count, model->handle->nv);
-  if (valid != GMJ_OK) {
-    return valid;
+  mj_defaultVFS(vfs->handle);
+  gmj_mutex_init(&vfs->mutex);
+  gmj_set_error(NULL);
+  return vfs;
+}
+
+void gmj_vfs_free(gmj_vfs* vfs) {
+  if (vfs == NULL) {
+    return;
+  }
+  if (vfs->handle != NULL) {
+    mj_deleteVFS(vfs->handle);
+    free(vfs->handle);
+    vfs->handle = NULL;
+  }
+  gmj_mutex_destroy(&vfs->mutex);
+  free(vfs);
+}
+
+gmj_error_code gmj_vfs_add_buffer(gmj_vfs* vfs, const char* name,
+                                  const void* buffer, size_t size) {
+  int result = 0;
+  if (vfs == NULL || vfs->handle == NULL || name == NULL || buffer == NULL) {
+    gmj_set_error("invalid vfs, name or buffer pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (size == 0 || size > (size_t)0x7fffffff) {
+    gmj_set_error("buffer size must be in [1, 2^31)");
+    return GMJ_ERR_INVALID_ARGUMENT;
   }
 
-  for (i = 0; i < count; ++i) {
-    data->handle->qvel[start_index + i] = (mjtNum)values[i];
+  gmj_mutex_lock(&vfs->mutex);
+  result = mj_addBufferVFS(vfs->handle, name, buffer, (int)size);
+  gmj_mutex_unlock(&vfs->mutex);
+  if (result == 2) {
+    gmj_set_error("a file with this name is already in the vfs");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (result != 0) {
+    gmj_set_error("failed to add buffer to vfs");
+    return GMJ_ERR_ALLOCATION;
   }
+
   gmj_set_error(NULL);
   return GMJ_OK;
 }
 
-gmj_error_code gmj_get_ctrl_slice(const gmj_model* model, const gmj_data* data,
-                                  int start_index, int count,
-                                  double* out_values) {
-  int i = 0;
-  gmj_error_code valid = GMJ_OK;
-  if (out_values == NULL) {
-    gmj_set_error("out_values is null");
+gmj_error_code gmj_vfs_remove(gmj_vfs* vfs, const char* name) {
+  int result = 0;
+  if (vfs == NULL || vfs->handle == NULL || name == NULL) {
+    gmj_set_error("invalid vfs or name pointer");
     return GMJ_ERR_INVALID_ARGUMENT;
   }
-  if (model == NULL || model->handle == NULL || data == NULL ||
-      data->handle == NULL) {
-    gmj_set_error("invalid model or data pointer");
+
+  gmj_mutex_lock(&vfs->mutex);
+  result = mj_deleteFileVFS(vfs->handle, name);
+  gmj_mutex_unlock(&vfs->mutex);
+  if (result != 0) {
+    gmj_set_error("name not found in vfs");
     return GMJ_ERR_INVALID_ARGUMENT;
   }
 
-  valid = gmj_validate_slice(start_index, count, model->handle->nu);
-  if (valid != GMJ_OK) {
-    return valid;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+static int gmj_has_suffix(const char* text, const char* suffix) {
+  const size_t text_length = strlen(text);
+  const size_t suffix_length = strlen(suffix);
+  return text_length >= suffix_length &&
+         strcmp(text + text_length - suffix_length, suffix) == 0;
+}
+
+/* Adds the buffer to vfs under name, loads it and removes it again so the
+   caller's assets stay in place for the next load. */
+static mjModel* gmj_load_vfs_entry(mjVFS* vfs, const char* name,
+                                   const void* buffer, size_t size,
+                                   char* load_error, int load_error_size) {
+  mjModel* model = NULL;
+  const int added = mj_addBufferVFS(vfs, name, buffer, (int)size);
+  if (added != 0) {
+    snprintf(load_error, (size_t)load_error_size, "%s",
+             added == 2 ? "a file with this name is already in the vfs"
+                        : "failed to add buffer to vfs");
+    return NULL;
   }
 
-  for (i = 0; i < count; ++i) {
-    out_values[i] = (double)data->handle->ctrl[start_index + i];
+  if (gmj_has_suffix(name, ".mjb")) {
+    model = mj_loadModel(name, vfs);
+    if (model == NULL) {
+      snprintf(load_error, (size_t)load_error_size, "%s",
+               "failed to load binary model from buffer");
+    }
+  } else {
+    model = mj_loadXML(name, vfs, load_error, load_error_size);
+  }
+
+  mj_deleteFileVFS(vfs, name);
+  return model;
+}
+
+gmj_model* gmj_model_load_buffer(const char* name, const void* buffer,
+                                 size_t size, gmj_vfs* vfs,
+                                 char* error_buffer,
+                                 size_t error_buffer_size) {
+  char load_error[1024] = {0};
+  gmj_load_info info;
+  gmj_model* wrapper = NULL;
+  mjModel* model = NULL;
+  const double start = gmj_now_seconds();
+
+  if (name == NULL || buffer == NULL) {
+    gmj_write_error(error_buffer, error_buffer_size,
+                    "name or buffer is null");
+    return NULL;
+  }
+  if (size == 0 || size > (size_t)0x7fffffff) {
+    gmj_write_error(error_buffer, error_buffer_size,
+                    "buffer size must be in [1, 2^31)");
+    return NULL;
+  }
+
+  if (vfs != NULL) {
+    gmj_mutex_lock(&vfs->mutex);
+    model = gmj_load_vfs_entry(vfs->handle, name, buffer, size, load_error,
+                               sizeof(load_error));
+    gmj_mutex_unlock(&vfs->mutex);
+  } else {
+    mjVFS* scratch = (mjVFS*)malloc(sizeof(mjVFS));
+    if (scratch == NULL) {
+      gmj_write_error(error_buffer, error_buffer_size,
+                      "failed to allocate mjVFS");
+      return NULL;
+    }
+    mj_defaultVFS(scratch);
+    model = gmj_load_vfs_entry(scratch, name, buffer, size, load_error,
+                               sizeof(load_error));
+    mj_deleteVFS(scratch);
+    free(scratch);
+  }
+
+  if (model == NULL) {
+    gmj_write_error(error_buffer, error_buffer_size, load_error);
+    return NULL;
+  }
+
+  wrapper = gmj_model_wrap(model);
+  if (wrapper == NULL) {
+    return NULL;
   }
+
+  memset(&info, 0, sizeof(info));
+  info.content_hash = gmj_hash_bytes(GMJ_HASH_SEED, buffer, size);
+  info.load_seconds = gmj_now_seconds() - start;
+  wrapper->load_info = info;
   gmj_set_error(NULL);
-  return GMJ_OK;
+  return wrapper;
 }
 
-gmj_error_code gmj_set_ctrl_slice(const gmj_model* model, gmj_data* data,
-                                  int start_index, int count,
-                                  const double* values) {
-  int i = 0;
-  gmj_error_code valid = GMJ_OK;
-  valid = gmj_validate_ptrs(model, data);
-  if (valid != GMJ_OK) {
-    return valid;
+gmj_model* gmj_model_load_xml_string(const char* xml, gmj_vfs* vfs,
+                                     char* error_buffer,
+                                     size_t error_buffer_size) {
+  char name[64];
+  static volatile long inline_counter = 0;
+
+  if (xml == NULL) {
+    gmj_write_error(error_buffer, error_buffer_size, "xml is null");
+    return NULL;
   }
-  if (values == NULL) {
-    gmj_set_error("values is null");
-    return GMJ_ERR_INVALID_ARGUMENT;
+
+  snprintf(name, sizeof(name), "gmj_inline_%ld.xml",
+           gmj_atomic_fetch_add(&inline_counter, 1));
+  return gmj_model_load_buffer(name, xml, strlen(xml), vfs, error_buffer,
+                               error_buffer_size);
+}
+
+/* Takes a reference on the cached model for (canonical, hash), if any.
+   Called with gmj_model_cache_mutex held. */
+static gmj_model* gmj_model_cache_find(const char* canonical,
+                                       unsigned long long hash) {
+  gmj_model* entry = NULL;
+  for (entry = gmj_model_cache_head; entry != NULL;
+       entry = entry->cache_next) {
+    if (entry->cache_hash == hash && strcmp(entry->cache_path, canonical) == 0) {
+      entry->refcount += 1;
+      return entry;
+    }
   }
+  return NULL;
+}
 
-  valid = gmj_validate_slice(start_index, count, model->handle->nu);
-  if (valid != GMJ_OK) {
-    return valid;
+gmj_model* gmj_model_acquire_xml(const char* xml_path, char* error_buffer,
+                                 size_t error_buffer_size) {
+  char* canonical = NULL;
+  unsigned long long hash = 0;
+  gmj_model* entry = NULL;
+  gmj_model* model = NULL;
+
+  if (xml_path == NULL) {
+    gmj_write_error(error_buffer, error_buffer_size, "xml_path is null");
+    return NULL;
   }
 
-  for (i = 0; i < count; ++i) {
-    data->handle->ctrl[start_index + i] = (mjtNum)values[i];
+  canonical = gmj_canonical_path(xml_path);
+  if (canonical == NULL || gmj_file_size(canonical) < 0) {
+    free(canonical);
+    gmj_write_error(error_buffer, error_buffer_size,
+                    "failed to read xml_path");
+    return NULL;
+  }
+  hash = gmj_hash_xml_tree(canonical);
+
+  gmj_static_mutex_lock(&gmj_model_cache_mutex);
+  entry = gmj_model_cache_find(canonical, hash);
+  gmj_static_mutex_unlock(&gmj_model_cache_mutex);
+  if (entry != NULL) {
+    free(canonical);
+    gmj_set_error(NULL);
+    return entry;
+  }
+
+  /* The compile runs outside the lock, so frees and lookups of other
+     models never wait for it. Acquires that miss on the same file at the
+     same time each compile; the first to finish is cached and the others
+     take it and drop their own. */
+  model = gmj_model_load_xml_hashed(canonical, &hash, error_buffer,
+                                    error_buffer_size);
+  if (model == NULL) {
+    free(canonical);
+    return NULL;
+  }
+
+  gmj_static_mutex_lock(&gmj_model_cache_mutex);
+  entry = gmj_model_cache_find(canonical, hash);
+  if (entry == NULL) {
+    model->cached = 1;
+    model->cache_path = canonical;
+    model->cache_hash = hash;
+    model->cache_next = gmj_model_cache_head;
+    gmj_model_cache_head = model;
+    entry = model;
+    model = NULL;
+    canonical = NULL;
   }
+  gmj_static_mutex_unlock(&gmj_model_cache_mutex);
+  free(canonical);
+  gmj_model_free(model);
+
   gmj_set_error(NULL);
-  return GMJ_OK;
+  return entry;
 }
 
-gmj_error_code gmj_body_world_position(const gmj_model* model,
-                                       const gmj_data* data, int body_index,
-                                       double* out_xyz_3) {
-  const mjtNum* body_xpos = NULL;
-  if (out_xyz_3 == NULL) {
-    gmj_set_error("out_xyz_3 is null");
-    return GMJ_ERR_INVALID_ARGUMENT;
+int gmj_model_cache_count(void) {
+  int count = 0;
+  const gmj_model* entry = NULL;
+  gmj_static_mutex_lock(&gmj_model_cache_mutex);
+  for (entry = gmj_model_cache_head; entry != NULL;
+       entry = entry->cache_next) {
+    count += 1;
   }
-  if (model == NULL || model->handle == NULL || data == NULL ||
-      data->handle == NULL) {
-    gmj_set_error("invalid model or data pointer");
-    return GMJ_ERR_INVALID_ARGUMENT;
+  gmj_static_mutex_unlock(&gmj_model_cache_mutex);
+  return count;
+}
+
+int gmj_model_refcount(const gmj_model* model) {
+  int refcount = 0;
+  if (model == NULL) {
+    gmj_set_error("model is null");
+    return -1;
   }
-  if (body_index < 0 || body_index >= model->handle->nbody) {
-    gmj_set_error("body_index out of range");
-    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  gmj_static_mutex_lock(&gmj_model_cache_mutex);
+  refcount = model->refcount;
+  gmj_static_mutex_unlock(&gmj_model_cache_mutex);
+  return refcount;
+}
+
+/* Internal holders (idle pool data) keep a model alive through the same
+   count as gmj_model_acquire_xml, so its mjModel address cannot be reused
+   while they still point at it. */
+static void gmj_model_retain(const gmj_model* model) {
+  gmj_static_mutex_lock(&gmj_model_cache_mutex);
+  ((gmj_model*)model)->refcount += 1;
+  gmj_static_mutex_unlock(&gmj_model_cache_mutex);
+}
+
+void gmj_model_free(gmj_model* model) {
+  if (model == NULL) {
+    return;
+  }
+  gmj_static_mutex_lock(&gmj_model_cache_mutex);
+  model->refcount -= 1;
+  if (model->refcount > 0) {
+    gmj_static_mutex_unlock(&gmj_model_cache_mutex);
+    return;
+  }
+  if (model->cached) {
+    gmj_model** link = &gmj_model_cache_head;
+    while (*link != NULL && *link != model) {
+      link = &(*link)->cache_next;
+    }
+    if (*link != NULL) {
+      *link = model->cache_next;
+    }
+  }
+  gmj_static_mutex_unlock(&gmj_model_cache_mutex);
+  free(model->cache_path);
+  model->cache_path = NULL;
+  if (model->handle != NULL) {
+    mj_deleteModel(model->handle);
+    model->handle = NULL;
+  }
+  free(model);
+}
+
+/* Hot reload. The watcher thread hashes the XML tree every poll and only
+   compiles a hash that two polls in a row agree on, so an editor that
+   writes a file in several steps is not compiled half-saved. Compiled
+   models are not listed in the path cache; their refcount alone lets every
+   consumer of one reloader share a single compile. */
+struct gmj_reloader {
+  char* xml_path;
+  double poll_seconds;
+  gmj_thread thread;
+  volatile long stop;
+  gmj_mutex mutex;
+  gmj_model* latest;
+  gmj_reload_info info;
+  char error[1024];
+};
+
+static GMJ_THREAD_RETURN gmj_reloader_main(void* arg) {
+  gmj_reloader* reloader = (gmj_reloader*)arg;
+  unsigned long long live = reloader->info.content_hash;
+  unsigned long long seen = live;
+
+  while (!gmj_atomic_load(&reloader->stop)) {
+    char error[1024] = {0};
+    unsigned long long hash = 0;
+    double waited = 0.0;
+    double start = 0.0;
+    gmj_model* model = NULL;
+    gmj_model* replaced = NULL;
+
+    while (waited < reloader->poll_seconds &&
+           !gmj_atomic_load(&reloader->stop)) {
+      gmj_sleep_seconds(0.02);
+      waited += 0.02;
+    }
+    if (gmj_atomic_load(&reloader->stop)) {
+      break;
+    }
+
+    hash = gmj_hash_xml_tree(reloader->xml_path);
+    gmj_mutex_lock(&reloader->mutex);
+    reloader->info.polls += 1;
+    gmj_mutex_unlock(&reloader->mutex);
+    if (hash == live || hash != seen) {
+      seen = hash;
+      continue;
+    }
+
+    live = hash;
+    start = gmj_now_seconds();
+    model = gmj_model_load_xml(reloader->xml_path, error, sizeof(error));
+    gmj_mutex_lock(&reloader->mutex);
+    reloader->info.last_compile_seconds = gmj_now_seconds() - start;
+    if (model != NULL) {
+      replaced = reloader->latest;
+      reloader->latest = model;
+      reloader->info.generation += 1;
+      reloader->info.content_hash = hash;
+      reloader->error[0] = '\0';
+    } else {
+      reloader->info.failures += 1;
+      snprintf(reloader->error, sizeof(reloader->error), "%s", error);
+    }
+    gmj_mutex_unlock(&reloader->mutex);
+    gmj_model_free(replaced);
   }
 
-  body_xpos = data->handle->xpos + (3 * body_index);
-  out_xyz_3[0] = (double)body_xpos[0];
-  out_xyz_3[1] = (double)body_xpos[1];
-  out_xyz_3[2] = (double)body_xpos[2];
-  gmj_set_error(NULL);
-  return GMJ_OK;
+  return GMJ_THREAD_RESULT;
+}
+
+gmj_reloader* gmj_reloader_create(const char* xml_path, double poll_seconds) {
+  gmj_reloader* reloader = NULL;
+  if (xml_path == NULL) {
+    gmj_set_error("xml_path is null");
+    return NULL;
+  }
+  if (!(poll_seconds > 0.0)) {
+    gmj_set_error("poll_seconds must be > 0");
+    return NULL;
+  }
+
+  reloader = (gmj_reloader*)calloc(1, sizeof(gmj_reloader));
+  if (reloader == NULL) {
+    gmj_set_error("failed to allocate gmj_reloader");
+    return NULL;
+  }
+  reloader->xml_path = gmj_canonical_path(xml_path);
+  if (reloader->xml_path == NULL) {
+    free(reloader);
+    gmj_set_error("failed to read xml_path");
+    return NULL;
+  }
+
+  reloader->poll_seconds = poll_seconds;
+  reloader->info.content_hash = gmj_hash_xml_tree(reloader->xml_path);
+  gmj_mutex_init(&reloader->mutex);
+  if (gmj_thread_start(&reloader->thread, gmj_reloader_main, reloader) != 0) {
+    gmj_mutex_destroy(&reloader->mutex);
+    free(reloader->xml_path);
+    free(reloader);
+    gmj_set_error("failed to start reload thread");
+    return NULL;
+  }
+
+  gmj_set_error(NULL);
+  return reloader;
+}
+
+void gmj_reloader_free(gmj_reloader* reloader) {
+  if (reloader == NULL) {
+    return;
+  }
+  gmj_atomic_store(&reloader->stop, 1);
+  gmj_thread_join(reloader->thread);
+  gmj_model_free(reloader->latest);
+  gmj_mutex_destroy(&reloader->mutex);
+  free(reloader->xml_path);
+  free(reloader);
+}
+
+gmj_model* gmj_reloader_latest(gmj_reloader* reloader,
+                               unsigned long long* inout_generation) {
+  gmj_model* model = NULL;
+  if (reloader == NULL || inout_generation == NULL) {
+    gmj_set_error("invalid reloader or generation pointer");
+    return NULL;
+  }
+
+  gmj_mutex_lock(&reloader->mutex);
+  if (reloader->latest != NULL &&
+      reloader->info.generation > *inout_generation) {
+    model = reloader->latest;
+    *inout_generation = reloader->info.generation;
+    gmj_static_mutex_lock(&gmj_model_cache_mutex);
+    model->refcount += 1;
+    gmj_static_mutex_unlock(&gmj_model_cache_mutex);
+  }
+  gmj_mutex_unlock(&reloader->mutex);
+  gmj_set_error(NULL);
+  return model;
+}
+
+gmj_error_code gmj_reloader_info(gmj_reloader* reloader,
+                                 gmj_reload_info* out_info) {
+  if (reloader == NULL || out_info == NULL) {
+    gmj_set_error("invalid reloader or out_info pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  gmj_mutex_lock(&reloader->mutex);
+  *out_info = reloader->info;
+  gmj_mutex_unlock(&reloader->mutex);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_reloader_last_error(gmj_reloader* reloader, char* buffer,
+                                       size_t buffer_size) {
+  if (reloader == NULL || buffer == NULL || buffer_size == 0) {
+    gmj_set_error("invalid reloader or buffer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  gmj_mutex_lock(&reloader->mutex);
+  snprintf(buffer, buffer_size, "%s", reloader->error);
+  gmj_mutex_unlock(&reloader->mutex);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+/* Trajectory files: a gmj_traj_header, then frames of
+   [u32 payload bytes][u8 type][payload], then a keyframe offset index
+   written on close. A frame holds ctrl followed by the mj_getState vector.
+   Keyframes store raw doubles; delta frames store zigzag varints of the
+   change in round(value / quantum), so the error stays within quantum / 2
+   and does not drift. Frame k * keyframe_interval is always a keyframe.
+   Files use the native byte order. */
+#define GMJ_TRAJ_MAGIC "GMJTRJ01"
+#define GMJ_TRAJ_VERSION 1
+#define GMJ_TRAJ_KEYFRAME 0
+#define GMJ_TRAJ_DELTA 1
+#define GMJ_TRAJ_CHUNK_BYTES (256 * 1024)
+#define GMJ_TRAJ_CHUNK_COUNT 4
+
+typedef struct gmj_traj_header {
+  char magic[8];
+  int version;
+  int signature;
+  int nq;
+  int nv;
+  int nu;
+  int state_size;
+  int keyframe_interval;
+  int reserved;
+  double quantum;
+  unsigned long long frame_count;
+  unsigned long long keyframe_count;
+  unsigned long long index_offset;
+} gmj_traj_header;
+
+/* Frames are encoded on the stepping thread into fixed chunks; a writer
+   thread drains full chunks in order. The producer only blocks when all
+   chunks are waiting on the disk. */
+struct gmj_recorder {
+  const gmj_model* model;
+  gmj_data* attached;
+  FILE* file;
+  gmj_traj_header header;
+  int value_count;
+  mjtNum* values;
+  long long* quantized;
+  unsigned long long* keyframe_offsets;
+  unsigned long long keyframe_capacity;
+  unsigned long long bytes_written;
+  size_t chunk_bytes;
+  unsigned char* chunks[GMJ_TRAJ_CHUNK_COUNT];
+  size_t chunk_used[GMJ_TRAJ_CHUNK_COUNT];
+  int fill_index;
+  int write_index;
+  int ready_count;
+  int stop;
+  int write_failed;
+  int writer_started;
+  gmj_mutex mutex;
+  gmj_cond ready_cond;
+  gmj_cond free_cond;
+  gmj_thread writer;
+};
+
+static long long gmj_quantize(double value, double quantum) {
+  const double scaled = value / quantum;
+  if (scaled != scaled) {
+    return 0;
+  }
+  if (scaled > 9.0e18) {
+    return 9000000000000000000LL;
+  }
+  if (scaled < -9.0e18) {
+    return -9000000000000000000LL;
+  }
+  return llround(scaled);
+}
+
+static GMJ_THREAD_RETURN gmj_recorder_writer_main(void* arg) {
+  gmj_recorder* recorder = (gmj_recorder*)arg;
+  gmj_mutex_lock(&recorder->mutex);
+  for (;;) {
+    int index = 0;
+    while (recorder->ready_count == 0 && !recorder->stop) {
+      gmj_cond_wait(&recorder->ready_cond, &recorder->mutex);
+    }
+    if (recorder->ready_count == 0) {
+      break;
+    }
+
+    index = recorder->write_index;
+    gmj_mutex_unlock(&recorder->mutex);
+    if (fwrite(recorder->chunks[index], 1, recorder->chunk_used[index],
+               recorder->file) != recorder->chunk_used[index]) {
+      recorder->write_failed = 1;
+    }
+    gmj_mutex_lock(&recorder->mutex);
+
+    recorder->chunk_used[index] = 0;
+    recorder->write_index = (index + 1) % GMJ_TRAJ_CHUNK_COUNT;
+    recorder->ready_count -= 1;
+    gmj_cond_signal(&recorder->free_cond);
+  }
+  gmj_mutex_unlock(&recorder->mutex);
+  return GMJ_THREAD_RESULT;
+}
+
+static void gmj_recorder_submit(gmj_recorder* recorder) {
+  gmj_mutex_lock(&recorder->mutex);
+  recorder->ready_count += 1;
+  gmj_cond_signal(&recorder->ready_cond);
+  while (recorder->ready_count == GMJ_TRAJ_CHUNK_COUNT) {
+    gmj_cond_wait(&recorder->free_cond, &recorder->mutex);
+  }
+  recorder->fill_index = (recorder->fill_index + 1) % GMJ_TRAJ_CHUNK_COUNT;
+  gmj_mutex_unlock(&recorder->mutex);
+}
+
+static void gmj_put_varint(unsigned char** cursor, unsigned long long value) {
+  unsigned char* out = *cursor;
+  while (value >= 0x80) {
+    *out++ = (unsigned char)(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = (unsigned char)value;
+  *cursor = out;
+}
+
+static void gmj_recorder_record(gmj_recorder* recorder, const mjData* d) {
+  const mjModel* m = recorder->model->handle;
+  const int count = recorder->value_count;
+  const double quantum = recorder->header.quantum;
+  const int is_key = recorder->header.frame_count %
+                         (unsigned long long)recorder->header.keyframe_interval ==
+                     0;
+  const size_t max_bytes = 5 + (size_t)count * (is_key ? 8 : 10);
+  unsigned char* frame = NULL;
+  unsigned char* cursor = NULL;
+  unsigned int payload = 0;
+  int i = 0;
+
+  if (recorder->chunk_used[recorder->fill_index] + max_bytes >
+      recorder->chunk_bytes) {
+    gmj_recorder_submit(recorder);
+  }
+
+  if (m->nu > 0) {
+    memcpy(recorder->values, d->ctrl, (size_t)m->nu * sizeof(mjtNum));
+  }
+  mj_getState(m, d, recorder->values + m->nu, recorder->header.signature);
+
+  frame = recorder->chunks[recorder->fill_index] +
+          recorder->chunk_used[recorder->fill_index];
+  cursor = frame + 5;
+  frame[4] = (unsigned char)(is_key ? GMJ_TRAJ_KEYFRAME : GMJ_TRAJ_DELTA);
+
+  if (is_key) {
+    if (recorder->header.keyframe_count == recorder->keyframe_capacity) {
+      const unsigned long long capacity =
+          recorder->keyframe_capacity > 0 ? 2 * recorder->keyframe_capacity
+                                          : 64;
+      unsigned long long* offsets = (unsigned long long*)realloc(
+          recorder->keyframe_offsets,
+          (size_t)capacity * sizeof(unsigned long long));
+      if (offsets == NULL) {
+        recorder->write_failed = 1;
+        return;
+      }
+      recorder->keyframe_offsets = offsets;
+      recorder->keyframe_capacity = capacity;
+    }
+    recorder->keyframe_offsets[recorder->header.keyframe_count++] =
+        recorder->bytes_written;
+
+    for (i = 0; i < count; ++i) {
+      const double value = (double)recorder->values[i];
+      memcpy(cursor, &value, sizeof(double));
+      cursor += sizeof(double);
+      recorder->quantized[i] = gmj_quantize(value, quantum);
+    }
+  } else {
+    for (i = 0; i < count; ++i) {
+      const long long q = gmj_quantize((double)recorder->values[i], quantum);
+      const long long delta = q - recorder->quantized[i];
+      gmj_put_varint(&cursor, ((unsigned long long)delta << 1) ^
+                                  (unsigned long long)(delta >> 63));
+      recorder->quantized[i] = q;
+    }
+  }
+
+  payload = (unsigned int)(cursor - frame - 5);
+  memcpy(frame, &payload, sizeof(payload));
+  recorder->chunk_used[recorder->fill_index] += (size_t)(cursor - frame);
+  recorder->bytes_written += (unsigned long long)(cursor - frame);
+  recorder->header.frame_count += 1;
+}
+
+static void gmj_recorder_destroy(gmj_recorder* recorder) {
+  int i = 0;
+  if (recorder->file != NULL) {
+    fclose(recorder->file);
+  }
+  for (i = 0; i < GMJ_TRAJ_CHUNK_COUNT; ++i) {
+    free(recorder->chunks[i]);
+  }
+  free(recorder->values);
+  free(recorder->quantized);
+  free(recorder->keyframe_offsets);
+  free(recorder);
+}
+
+gmj_recorder* gmj_recorder_open(const gmj_model* model, const char* path,
+                                int signature, int keyframe_interval,
+                                double quantum, char* error_buffer,
+                                size_t error_buffer_size) {
+  gmj_recorder* recorder = NULL;
+  const char* message = NULL;
+  size_t max_frame = 0;
+  int i = 0;
+
+  if (model == NULL || model->handle == NULL || path == NULL) {
+    gmj_write_error(error_buffer, error_buffer_size,
+                    "invalid model or path pointer");
+    return NULL;
+  }
+  if (gmj_validate_signature(signature) != GMJ_OK) {
+    gmj_write_error(error_buffer, error_buffer_size,
+                    "invalid state signature");
+    return NULL;
+  }
+
+  recorder = (gmj_recorder*)calloc(1, sizeof(gmj_recorder));
+  if (recorder == NULL) {
+    gmj_write_error(error_buffer, error_buffer_size,
+                    "failed to allocate gmj_recorder");
+    return NULL;
+  }
+
+  recorder->model = model;
+  memcpy(recorder->header.magic, GMJ_TRAJ_MAGIC, 8);
+  recorder->header.version = GMJ_TRAJ_VERSION;
+  recorder->header.signature = signature;
+  recorder->header.nq = model->handle->nq;
+  recorder->header.nv = model->handle->nv;
+  recorder->header.nu = model->handle->nu;
+  recorder->header.state_size = mj_stateSize(model->handle, signature);
+  recorder->header.keyframe_interval =
+      keyframe_interval > 0 ? keyframe_interval : 256;
+  recorder->header.quantum = quantum > 0.0 ? quantum : 1e-6;
+  recorder->value_count = model->handle->nu + recorder->header.state_size;
+
+  max_frame = 5 + (size_t)recorder->value_count * 10;
+  recorder->chunk_bytes = GMJ_TRAJ_CHUNK_BYTES > 2 * max_frame
+                              ? GMJ_TRAJ_CHUNK_BYTES
+                              : 2 * max_frame;
+  recorder->values = (mjtNum*)malloc(
+      (size_t)(recorder->value_count + 1) * sizeof(mjtNum));
+  recorder->quantized = (long long*)calloc(
+      (size_t)recorder->value_count + 1, sizeof(long long));
+  for (i = 0; i < GMJ_TRAJ_CHUNK_COUNT; ++i) {
+    recorder->chunks[i] = (unsigned char*)malloc(recorder->chunk_bytes);
+    if (recorder->chunks[i] == NULL) {
+      message = "failed to allocate recorder chunks";
+    }
+  }
+  if (recorder->values == NULL || recorder->quantized == NULL) {
+    message = "failed to allocate recorder buffers";
+  }
+
+  if (message == NULL) {
+    recorder->file = fopen(path, "wb");
+    if (recorder->file == NULL) {
+      message = "failed to open trajectory file";
+    } else if (fwrite(&recorder->header, sizeof(gmj_traj_header), 1,
+                      recorder->file) != 1) {
+      message = "failed to write trajectory header";
+    }
+  }
+
+  if (message == NULL) {
+    gmj_mutex_init(&recorder->mutex);
+    gmj_cond_init(&recorder->ready_cond);
+    gmj_cond_init(&recorder->free_cond);
+    if (gmj_thread_start(&recorder->writer, gmj_recorder_writer_main,
+                         recorder) != 0) {
+      gmj_cond_destroy(&recorder->free_cond);
+      gmj_cond_destroy(&recorder->ready_cond);
+      gmj_mutex_destroy(&recorder->mutex);
+      message = "failed to start recorder writer thread";
+    } else {
+      recorder->writer_started = 1;
+    }
+  }
+
+  if (message != NULL) {
+    gmj_write_error(error_buffer, error_buffer_size, message);
+    gmj_recorder_destroy(recorder);
+    return NULL;
+  }
+
+  gmj_set_error(NULL);
+  return recorder;
+}
+
+gmj_error_code gmj_recorder_attach(gmj_recorder* recorder, gmj_data* data) {
+  if (recorder == NULL) {
+    gmj_set_error("recorder is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (data != NULL && data->recorder != NULL && data->recorder != recorder) {
+    gmj_set_error("data already has a recorder attached");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  if (recorder->attached != NULL) {
+    recorder->attached->recorder = NULL;
+  }
+  recorder->attached = data;
+  if (data != NULL) {
+    data->recorder = recorder;
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_recorder_append(gmj_recorder* recorder,
+                                   const gmj_data* data) {
+  if (recorder == NULL || data == NULL || data->handle == NULL) {
+    gmj_set_error("invalid recorder or data pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  gmj_recorder_record(recorder, data->handle);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+long long gmj_recorder_frame_count(const gmj_recorder* recorder) {
+  if (recorder == NULL) {
+    gmj_set_error("recorder is null");
+    return -1;
+  }
+  return (long long)recorder->header.frame_count;
+}
+
+gmj_error_code gmj_recorder_close(gmj_recorder* recorder) {
+  int failed = 0;
+  if (recorder == NULL) {
+    gmj_set_error("recorder is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  gmj_recorder_attach(recorder, NULL);
+
+  gmj_mutex_lock(&recorder->mutex);
+  if (recorder->chunk_used[recorder->fill_index] > 0) {
+    recorder->ready_count += 1;
+  }
+  recorder->stop = 1;
+  gmj_cond_signal(&recorder->ready_cond);
+  gmj_mutex_unlock(&recorder->mutex);
+  gmj_thread_join(recorder->writer);
+  gmj_cond_destroy(&recorder->free_cond);
+  gmj_cond_destroy(&recorder->ready_cond);
+  gmj_mutex_destroy(&recorder->mutex);
+
+  recorder->header.index_offset =
+      sizeof(gmj_traj_header) + recorder->bytes_written;
+  if (recorder->header.keyframe_count > 0 &&
+      fwrite(recorder->keyframe_offsets, sizeof(unsigned long long),
+             (size_t)recorder->header.keyframe_count,
+             recorder->file) != (size_t)recorder->header.keyframe_count) {
+    failed = 1;
+  }
+  if (fseek(recorder->file, 0, SEEK_SET) != 0 ||
+      fwrite(&recorder->header, sizeof(gmj_traj_header), 1, recorder->file) !=
+          1) {
+    failed = 1;
+  }
+  if (fclose(recorder->file) != 0) {
+    failed = 1;
+  }
+  recorder->file = NULL;
+
+  failed = failed || recorder->write_failed;
+  gmj_recorder_destroy(recorder);
+  if (failed) {
+    gmj_set_error("failed to write trajectory file");
+    return GMJ_ERR_MUJOCO;
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+struct gmj_replay {
+  gmj_mapped_file file;
+  gmj_traj_header header;
+  const unsigned char* frames;
+  size_t frames_size;
+  unsigned long long* keyframe_offsets;
+  int value_count;
+  double* values;
+  long long* quantized;
+  mjtNum* state;
+  long long cursor;
+  size_t cursor_next;
+};
+
+static int gmj_get_varint(const unsigned char** cursor,
+                          const unsigned char* end,
+                          unsigned long long* out_value) {
+  const unsigned char* in = *cursor;
+  unsigned long long value = 0;
+  int shift = 0;
+  while (in < end && shift < 64) {
+    const unsigned char byte = *in++;
+    value |= (unsigned long long)(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) {
+      *cursor = in;
+      *out_value = value;
+      return 1;
+    }
+    shift += 7;
+  }
+  return 0;
+}
+
+/* Decodes the frame at offset into replay->values and returns the offset
+   of the next frame, or 0 if the frame is malformed. */
+static size_t gmj_replay_decode(gmj_replay* replay, size_t offset) {
+  const double quantum = replay->header.quantum;
+  const unsigned char* frame = replay->frames + offset;
+  const unsigned char* cursor = frame + 5;
+  const unsigned char* end = NULL;
+  unsigned int payload = 0;
+  int i = 0;
+
+  if (offset + 5 > replay->frames_size) {
+    return 0;
+  }
+  memcpy(&payload, frame, sizeof(payload));
+  if ((size_t)payload > replay->frames_size - offset - 5) {
+    return 0;
+  }
+  end = cursor + payload;
+
+  if (frame[4] == GMJ_TRAJ_KEYFRAME) {
+    if ((size_t)payload != (size_t)replay->value_count * sizeof(double)) {
+      return 0;
+    }
+    for (i = 0; i < replay->value_count; ++i) {
+      memcpy(&replay->values[i], cursor, sizeof(double));
+      cursor += sizeof(double);
+      replay->quantized[i] = gmj_quantize(replay->values[i], quantum);
+    }
+  } else {
+    for (i = 0; i < replay->value_count; ++i) {
+      unsigned long long zigzag = 0;
+      if (!gmj_get_varint(&cursor, end, &zigzag)) {
+        return 0;
+      }
+      replay->quantized[i] +=
+          (long long)(zigzag >> 1) ^ -(long long)(zigzag & 1);
+      replay->values[i] = (double)replay->quantized[i] * quantum;
+    }
+  }
+  return (size_t)(end - replay->frames);
+}
+
+void gmj_replay_close(gmj_replay* replay) {
+  if (replay == NULL) {
+    return;
+  }
+  gmj_unmap_file(&replay->file);
+  free(replay->keyframe_offsets);
+  free(replay->values);
+  free(replay->quantized);
+  free(replay->state);
+  free(replay);
+}
+
+gmj_replay* gmj_replay_open(const char* path, char* error_buffer,
+                            size_t error_buffer_size) {
+  gmj_replay* replay = NULL;
+  const unsigned char* bytes = NULL;
+  const char* message = NULL;
+  unsigned long long count = 0;
+
+  if (path == NULL) {
+    gmj_write_error(error_buffer, error_buffer_size, "path is null");
+    return NULL;
+  }
+
+  replay = (gmj_replay*)calloc(1, sizeof(gmj_replay));
+  if (replay == NULL) {
+    gmj_write_error(error_buffer, error_buffer_size,
+                    "failed to allocate gmj_replay");
+    return NULL;
+  }
+  if (gmj_map_file(path, &replay->file) != 0) {
+    free(replay);
+    gmj_write_error(error_buffer, error_buffer_size,
+                    "failed to map trajectory file");
+    return NULL;
+  }
+
+  bytes = (const unsigned char*)replay->file.data;
+  if (replay->file.size < sizeof(gmj_traj_header)) {
+    message = "trajectory file is truncated";
+  } else {
+    memcpy(&replay->header, bytes, sizeof(gmj_traj_header));
+    if (memcmp(replay->header.magic, GMJ_TRAJ_MAGIC, 8) != 0 ||
+        replay->header.version != GMJ_TRAJ_VERSION ||
+        replay->header.keyframe_interval <= 0 ||
+        replay->header.quantum <= 0.0 || replay->header.nu < 0 ||
+        replay->header.state_size < 0) {
+      message = "not a gmj trajectory file";
+    }
+  }
+
+  if (message == NULL) {
+    replay->frames = bytes + sizeof(gmj_traj_header);
+    replay->frames_size = replay->file.size - sizeof(gmj_traj_header);
+    replay->value_count = replay->header.nu + replay->header.state_size;
+    replay->values = (double*)malloc((size_t)(replay->value_count + 1) *
+                                     sizeof(double));
+    replay->quantized = (long long*)calloc((size_t)replay->value_count + 1,
+                                           sizeof(long long));
+    replay->state = (mjtNum*)malloc(
+        (size_t)(replay->header.state_size + 1) * sizeof(mjtNum));
+    if (replay->values == NULL || replay->quantized == NULL ||
+        replay->state == NULL) {
+      message = "failed to allocate replay buffers";
+    }
+  }
+
+  if (message == NULL && replay->header.index_offset != 0) {
+    const unsigned long long index_bytes =
+        replay->header.keyframe_count * sizeof(unsigned long long);
+    if (replay->header.index_offset + index_bytes > replay->file.size) {
+      message = "trajectory index is truncated";
+    } else {
+      replay->frames_size =
+          (size_t)replay->header.index_offset - sizeof(gmj_traj_header);
+      replay->keyframe_offsets =
+          (unsigned long long*)malloc((size_t)index_bytes + 1);
+      if (replay->keyframe_offsets == NULL) {
+        message = "failed to allocate trajectory index";
+      } else {
+        memcpy(replay->keyframe_offsets, bytes + replay->header.index_offset,
+               (size_t)index_bytes);
+      }
+    }
+  } else if (message == NULL) {
+    /* The recorder did not close: rebuild the index by walking frames. */
+    size_t offset = 0;
+    unsigned long long capacity = 0;
+    replay->header.frame_count = 0;
+    replay->header.keyframe_count = 0;
+    while (offset + 5 <= replay->frames_size) {
+      unsigned int payload = 0;
+      memcpy(&payload, replay->frames + offset, sizeof(payload));
+      if ((size_t)payload > replay->frames_size - offset - 5) {
+        break;
+      }
+      if (replay->header.frame_count %
+              (unsigned long long)replay->header.keyframe_interval ==
+          0) {
+        if (replay->frames[offset + 4] != GMJ_TRAJ_KEYFRAME) {
+          break;
+        }
+        if (count == capacity) {
+          unsigned long long* offsets = NULL;
+          capacity = capacity > 0 ? 2 * capacity : 64;
+          offsets = (unsigned long long*)realloc(
+              replay->keyframe_offsets,
+              (size_t)capacity * sizeof(unsigned long long));
+          if (offsets == NULL) {
+            message = "failed to allocate trajectory index";
+            break;
+          }
+          replay->keyframe_offsets = offsets;
+        }
+        replay->keyframe_offsets[count++] = offset;
+      }
+      replay->header.frame_count += 1;
+      offset += 5 + (size_t)payload;
+    }
+    replay->header.keyframe_count = count;
+  }
+
+  if (message != NULL) {
+    gmj_write_error(error_buffer, error_buffer_size, message);
+    gmj_replay_close(replay);
+    return NULL;
+  }
+
+  replay->cursor = -1;
+  gmj_set_error(NULL);
+  return replay;
+}
+
+gmj_error_code gmj_replay_get_info(const gmj_replay* replay,
+                                   gmj_replay_info* out_info) {
+  if (replay == NULL || out_info == NULL) {
+    gmj_set_error("invalid replay or out_info pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  out_info->frame_count = (long long)replay->header.frame_count;
+  out_info->signature = replay->header.signature;
+  out_info->nu = replay->header.nu;
+  out_info->state_size = replay->header.state_size;
+  out_info->keyframe_interval = replay->header.keyframe_interval;
+  out_info->quantum = replay->header.quantum;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+/* Sequential reads continue from the cursor; anything else decodes from
+   the keyframe at or before the step, at most keyframe_interval frames. */
+static gmj_error_code gmj_replay_seek(gmj_replay* replay, long long step) {
+  const long long interval = replay->header.keyframe_interval;
+  size_t offset = 0;
+  long long frame = 0;
+
+  if (step < 0 || step >= (long long)replay->header.frame_count) {
+    gmj_set_error("step out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+  if (replay->cursor == step) {
+    return GMJ_OK;
+  }
+
+  if (replay->cursor >= 0 && step > replay->cursor &&
+      step / interval == replay->cursor / interval) {
+    frame = replay->cursor + 1;
+    offset = replay->cursor_next;
+  } else {
+    const unsigned long long key = (unsigned long long)(step / interval);
+    if (key >= replay->header.keyframe_count) {
+      gmj_set_error("trajectory index is inconsistent");
+      return GMJ_ERR_MUJOCO;
+    }
+    frame = (long long)key * interval;
+    offset = (size_t)replay->keyframe_offsets[key];
+  }
+
+  for (; frame <= step; ++frame) {
+    offset = gmj_replay_decode(replay, offset);
+    if (offset == 0) {
+      replay->cursor = -1;
+      gmj_set_error("trajectory frame is malformed");
+      return GMJ_ERR_MUJOCO;
+    }
+  }
+  replay->cursor = step;
+  replay->cursor_next = offset;
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_replay_read(gmj_replay* replay, long long step,
+                               double* out_ctrl, double* out_state) {
+  gmj_error_code rc = GMJ_OK;
+  if (replay == NULL) {
+    gmj_set_error("replay is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  rc = gmj_replay_seek(replay, step);
+  if (rc != GMJ_OK) {
+    return rc;
+  }
+  if (out_ctrl != NULL && replay->header.nu > 0) {
+    memcpy(out_ctrl, replay->values,
+           (size_t)replay->header.nu * sizeof(double));
+  }
+  if (out_state != NULL && replay->header.state_size > 0) {
+    memcpy(out_state, replay->values + replay->header.nu,
+           (size_t)replay->header.state_size * sizeof(double));
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_replay_apply(gmj_replay* replay, const gmj_model* model,
+                                gmj_data* data, long long step) {
+  gmj_error_code rc = gmj_validate_ptrs(model, data);
+  int i = 0;
+  if (rc != GMJ_OK) {
+    return rc;
+  }
+  if (replay == NULL) {
+    gmj_set_error("replay is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (model->handle->nu != replay->header.nu ||
+      mj_stateSize(model->handle, replay->header.signature) !=
+          replay->header.state_size) {
+    gmj_set_error("trajectory does not match model");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  rc = gmj_replay_seek(replay, step);
+  if (rc != GMJ_OK) {
+    return rc;
+  }
+  gmj_copy_to_mjtnum(data->handle->ctrl, replay->values, replay->header.nu);
+  for (i = 0; i < replay->header.state_size; ++i) {
+    replay->state[i] = (mjtNum)replay->values[replay->header.nu + i];
+  }
+  mj_setState(model->handle, data->handle, replay->state,
+              replay->header.signature);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+static int gmj_solver_iterations(const mjData* d) {
+  const int islands = d->solver_nisland > 0 ? d->solver_nisland : 1;
+  int total = 0;
+  int i = 0;
+  for (i = 0; i < islands && i < mjNISLAND; ++i) {
+    total += d->solver_niter[i];
+  }
+  return total;
+}
+
+/* mjData warning counts restart at every reset, so the bridge keeps
+   running totals from the last value it saw. Besides the bridge's own
+   resets (which clear what it saw), mj_step resets the data itself when
+   qpos, qvel or qacc go bad and then counts that one warning; such a step
+   leaves time at one timestep instead of advancing it, and reset tells
+   this fold to count from zero. */
+static void gmj_data_note_warnings(gmj_data* data, int reset) {
+  const mjData* d = data->handle;
+  int i = 0;
+  for (i = 0; i < GMJ_STATS_WARNINGS && i < mjNWARNING; ++i) {
+    const int number = d->warning[i].number;
+    if (reset || number < data->stat_warning_seen[i]) {
+      data->stat_warning_seen[i] = 0;
+    }
+    data->stat_warnings[i] += number - data->stat_warning_seen[i];
+    data->stat_warning_seen[i] = number;
+  }
+}
+
+/* Folds what the last stepping call left in mjData into the counters read
+   by gmj_data_stats; warnings are folded per step by gmj_data_advance. */
+static void gmj_data_note_steps(gmj_data* data, int steps, double seconds) {
+  const mjData* d = data->handle;
+  const int iterations = gmj_solver_iterations(d);
+  const int ncon = d->ncon > d->maxuse_con ? d->ncon : d->maxuse_con;
+  const int nefc = d->nefc > d->maxuse_efc ? d->nefc : d->maxuse_efc;
+
+  data->stat_steps += steps;
+  data->stat_step_seconds += seconds;
+  if (ncon > data->stat_ncon_max) {
+    data->stat_ncon_max = ncon;
+  }
+  if (nefc > data->stat_nefc_max) {
+    data->stat_nefc_max = nefc;
+  }
+  if (iterations > data->stat_solver_iterations_max) {
+    data->stat_solver_iterations_max = iterations;
+  }
+  if ((long long)d->maxuse_arena > data->stat_arena_peak_max) {
+    data->stat_arena_peak_max = (long long)d->maxuse_arena;
+  }
+  if ((long long)d->maxuse_stack > data->stat_stack_peak_max) {
+    data->stat_stack_peak_max = (long long)d->maxuse_stack;
+  }
+}
+
+/* Domain randomization. A randomized data steps against its own copy of
+   the mjModel header: the arrays the terms touch point into a private block,
+   every other pointer still refers to the shared base model. Values are
+   redrawn from the base on every reset, into the same block. */
+typedef struct gmj_rand_term {
+  gmj_param param;
+  int first;
+  int count;
+  gmj_rand_op op;
+  gmj_dist dist;
+  double a;
+  double b;
+} gmj_rand_term;
+
+struct gmj_randomizer {
+  const gmj_model* model;
+  gmj_rand_term* terms;
+  int count;
+  int capacity;
+};
+
+struct gmj_env_params {
+  mjModel model;
+  const mjModel* base;
+  gmj_rand_term* terms;
+  int term_count;
+  int term_capacity;
+  mjtNum* values;
+  size_t value_capacity;
+  unsigned long long rng;
+};
+
+static unsigned long long gmj_rng_next(unsigned long long* state) {
+  unsigned long long z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+static double gmj_rng_uniform(unsigned long long* state) {
+  return (double)(gmj_rng_next(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+static double gmj_rand_sample(const gmj_rand_term* term,
+                              unsigned long long* state) {
+  const double u = gmj_rng_uniform(state);
+  switch (term->dist) {
+    case GMJ_DIST_LOG_UNIFORM:
+      return exp(log(term->a) + u * (log(term->b) - log(term->a)));
+    case GMJ_DIST_NORMAL:
+      return term->a + term->b * sqrt(-2.0 * log(1.0 - u)) *
+                           cos(6.283185307179586 * gmj_rng_uniform(state));
+    default:
+      return term->a + u * (term->b - term->a);
+  }
+}
+
+/* The randomized coefficient of element i: friction is the sliding term and
+   gear the first gear entry. */
+static mjtNum* gmj_param_slot(const mjModel* m, gmj_param param, int i) {
+  switch (param) {
+    case GMJ_PARAM_BODY_MASS:
+      return m->body_mass + i;
+    case GMJ_PARAM_GEOM_FRICTION:
+      return m->geom_friction + 3 * i;
+    case GMJ_PARAM_DOF_DAMPING:
+      return m->dof_damping + i;
+    default:
+      return m->actuator_gear + 6 * i;
+  }
+}
+
+static void gmj_env_params_draw(gmj_env_params* params) {
+  const mjModel* base = params->base;
+  mjModel* m = &params->model;
+  int t = 0;
+  int i = 0;
+
+  if (m->body_mass != base->body_mass) {
+    memcpy(m->body_mass, base->body_mass, sizeof(mjtNum) * (size_t)m->nbody);
+  }
+  if (m->geom_friction != base->geom_friction) {
+    memcpy(m->geom_friction, base->geom_friction,
+           sizeof(mjtNum) * 3 * (size_t)m->ngeom);
+  }
+  if (m->dof_damping != base->dof_damping) {
+    memcpy(m->dof_damping, base->dof_damping, sizeof(mjtNum) * (size_t)m->nv);
+  }
+  if (m->actuator_gear != base->actuator_gear) {
+    memcpy(m->actuator_gear, base->actuator_gear,
+           sizeof(mjtNum) * 6 * (size_t)m->nu);
+  }
+
+  for (t = 0; t < params->term_count; ++t) {
+    const gmj_rand_term* term = &params->terms[t];
+    for (i = term->first; i < term->first + term->count; ++i) {
+      const double sample = gmj_rand_sample(term, &params->rng);
+      double value = term->op == GMJ_RAND_SCALE
+                         ? (double)*gmj_param_slot(base, term->param, i) * sample
+                         : sample;
+      if (term->param != GMJ_PARAM_ACTUATOR_GEAR && value < 0.0) {
+        value = 0.0;
+      }
+      *gmj_param_slot(m, term->param, i) = (mjtNum)value;
+    }
+  }
+
+  /* Inertia follows mass at fixed density, and subtree masses are rebuilt
+     leaf to root (children always come after their parent). */
+  if (m->body_mass != base->body_mass) {
+    for (i = 0; i < m->nbody; ++i) {
+      const mjtNum ratio = base->body_mass[i] > 0
+                               ? m->body_mass[i] / base->body_mass[i]
+                               : 1;
+      m->body_inertia[3 * i] = base->body_inertia[3 * i] * ratio;
+      m->body_inertia[3 * i + 1] = base->body_inertia[3 * i + 1] * ratio;
+      m->body_inertia[3 * i + 2] = base->body_inertia[3 * i + 2] * ratio;
+      m->body_subtreemass[i] = m->body_mass[i];
+    }
+    for (i = m->nbody - 1; i > 0; --i) {
+      m->body_subtreemass[m->body_parentid[i]] += m->body_subtreemass[i];
+    }
+  }
+}
+
+static const mjModel* gmj_data_physics_model(const mjModel* m,
+                                             const gmj_data* data) {
+  return data->params != NULL ? &data->params->model : m;
+}
+
+/* Every reset path: new parameter draw first, then the state reset against
+   the model the env will step with, which is returned. */
+static const mjModel* gmj_data_reset(const mjModel* m, gmj_data* data,
+                                     int key) {
+  if (data->params != NULL) {
+    gmj_env_params_draw(data->params);
+    m = &data->params->model;
+  }
+  if (key >= 0) {
+    mj_resetDataKeyframe(m, data->handle, key);
+  } else {
+    mj_resetData(m, data->handle);
+  }
+  memset(data->stat_warning_seen, 0, sizeof(data->stat_warning_seen));
+  return m;
+}
+
+static void gmj_env_params_free(gmj_env_params* params) {
+  if (params == NULL) {
+    return;
+  }
+  free(params->terms);
+  free(params->values);
+  free(params);
+}
+
+gmj_randomizer* gmj_randomizer_create(const gmj_model* model) {
+  gmj_randomizer* randomizer = NULL;
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("model is null");
+    return NULL;
+  }
+  randomizer = (gmj_randomizer*)calloc(1, sizeof(gmj_randomizer));
+  if (randomizer == NULL) {
+    gmj_set_error("failed to allocate gmj_randomizer");
+    return NULL;
+  }
+  randomizer->model = model;
+  gmj_set_error(NULL);
+  return randomizer;
+}
+
+void gmj_randomizer_free(gmj_randomizer* randomizer) {
+  if (randomizer == NULL) {
+    return;
+  }
+  free(randomizer->terms);
+  free(randomizer);
+}
+
+gmj_error_code gmj_randomizer_add(gmj_randomizer* randomizer, gmj_param param,
+                                  const char* name, gmj_rand_op op,
+                                  gmj_dist dist, double a, double b) {
+  static const int object_types[4] = {mjOBJ_BODY, mjOBJ_GEOM, mjOBJ_JOINT,
+                                      mjOBJ_ACTUATOR};
+  const mjModel* m = NULL;
+  gmj_rand_term term;
+  int id = -1;
+
+  if (randomizer == NULL) {
+    gmj_set_error("randomizer is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (param < GMJ_PARAM_BODY_MASS || param > GMJ_PARAM_ACTUATOR_GEAR ||
+      (op != GMJ_RAND_SCALE && op != GMJ_RAND_SET)) {
+    gmj_set_error("unknown param or op");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if ((dist == GMJ_DIST_UNIFORM && !(a <= b)) ||
+      (dist == GMJ_DIST_LOG_UNIFORM && !(a > 0.0 && a <= b)) ||
+      (dist == GMJ_DIST_NORMAL && !(b >= 0.0)) ||
+      dist < GMJ_DIST_UNIFORM || dist > GMJ_DIST_NORMAL) {
+    gmj_set_error("invalid distribution bounds");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  m = randomizer->model->handle;
+  term.param = param;
+  term.op = op;
+  term.dist = dist;
+  term.a = a;
+  term.b = b;
+  term.first = 0;
+  if (param == GMJ_PARAM_BODY_MASS) {
+    term.count = m->nbody;
+  } else if (param == GMJ_PARAM_GEOM_FRICTION) {
+    term.count = m->ngeom;
+  } else if (param == GMJ_PARAM_DOF_DAMPING) {
+    term.count = m->nv;
+  } else {
+    term.count = m->nu;
+  }
+  if (name != NULL) {
+    id = mj_name2id(m, object_types[param], name);
+    if (id < 0) {
+      gmj_set_error("name not found for param");
+      return GMJ_ERR_INVALID_ARGUMENT;
+    }
+    term.first = id;
+    term.count = 1;
+    if (param == GMJ_PARAM_DOF_DAMPING) {
+      term.first = m->jnt_dofadr[id];
+      term.count = (id + 1 < m->njnt ? m->jnt_dofadr[id + 1] : m->nv) -
+                   term.first;
+    }
+  }
+
+  if (randomizer->count == randomizer->capacity) {
+    const int capacity = randomizer->capacity > 0 ? 2 * randomizer->capacity : 8;
+    gmj_rand_term* grown = (gmj_rand_term*)realloc(
+        randomizer->terms, sizeof(gmj_rand_term) * (size_t)capacity);
+    if (grown == NULL) {
+      gmj_set_error("failed to grow randomizer");
+      return GMJ_ERR_ALLOCATION;
+    }
+    randomizer->terms = grown;
+    randomizer->capacity = capacity;
+  }
+  randomizer->terms[randomizer->count++] = term;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+static size_t gmj_env_params_size(const gmj_randomizer* randomizer,
+                                  int used[4]) {
+  const mjModel* base = randomizer->model->handle;
+  int t = 0;
+  used[0] = used[1] = used[2] = used[3] = 0;
+  for (t = 0; t < randomizer->count; ++t) {
+    used[randomizer->terms[t].param] = 1;
+  }
+  return (used[GMJ_PARAM_BODY_MASS] ? 5 * (size_t)base->nbody : 0) +
+         (used[GMJ_PARAM_GEOM_FRICTION] ? 3 * (size_t)base->ngeom : 0) +
+         (used[GMJ_PARAM_DOF_DAMPING] ? (size_t)base->nv : 0) +
+         (used[GMJ_PARAM_ACTUATOR_GEAR] ? 6 * (size_t)base->nu : 0);
+}
+
+/* Drops a parameter block that was created but never bound. */
+static void gmj_env_params_drop_unbound(gmj_data* data) {
+  if (data->params != NULL && data->params->base == NULL) {
+    gmj_env_params_free(data->params);
+    data->params = NULL;
+  }
+}
+
+/* Moves a live binding's array pointers from the current block to values,
+   which holds a copy of it. Arrays still shared with the base are left. */
+static void gmj_env_params_rebase(gmj_env_params* params, mjtNum* values) {
+  const mjModel* base = params->base;
+  mjModel* m = &params->model;
+  if (base == NULL) {
+    return;
+  }
+  if (m->body_mass != base->body_mass) {
+    m->body_mass = values + (m->body_mass - params->values);
+    m->body_subtreemass = values + (m->body_subtreemass - params->values);
+    m->body_inertia = values + (m->body_inertia - params->values);
+  }
+  if (m->geom_friction != base->geom_friction) {
+    m->geom_friction = values + (m->geom_friction - params->values);
+  }
+  if (m->dof_damping != base->dof_damping) {
+    m->dof_damping = values + (m->dof_damping - params->values);
+  }
+  if (m->actuator_gear != base->actuator_gear) {
+    m->actuator_gear = values + (m->actuator_gear - params->values);
+  }
+}
+
+/* Grows data's private block only when the randomizer's terms need more
+   room. On failure a previous binding is left intact and a new block is
+   dropped, so the data steps exactly as before. */
+static gmj_error_code gmj_env_params_reserve(gmj_data* data,
+                                             const gmj_randomizer* randomizer) {
+  gmj_env_params* params = data->params;
+  int used[4];
+  const size_t needed = gmj_env_params_size(randomizer, used);
+
+  if (params == NULL) {
+    params = (gmj_env_params*)calloc(1, sizeof(gmj_env_params));
+    if (params == NULL) {
+      gmj_set_error("failed to allocate randomized parameters");
+      return GMJ_ERR_ALLOCATION;
+    }
+    data->params = params;
+  }
+  if (randomizer->count > params->term_capacity) {
+    gmj_rand_term* terms = (gmj_rand_term*)realloc(
+        params->terms, sizeof(gmj_rand_term) * (size_t)randomizer->count);
+    if (terms != NULL) {
+      params->terms = terms;
+      params->term_capacity = randomizer->count;
+    }
+  }
+  if (needed > params->value_capacity) {
+    mjtNum* values = (mjtNum*)malloc(sizeof(mjtNum) * needed);
+    if (values != NULL) {
+      if (params->value_capacity > 0) {
+        memcpy(values, params->values,
+               sizeof(mjtNum) * params->value_capacity);
+      }
+      gmj_env_params_rebase(params, values);
+      free(params->values);
+      params->values = values;
+      params->value_capacity = needed;
+    }
+  }
+  if (randomizer->count > params->term_capacity ||
+      needed > params->value_capacity) {
+    gmj_env_params_drop_unbound(data);
+    gmj_set_error("failed to allocate randomized parameters");
+    return GMJ_ERR_ALLOCATION;
+  }
+  return GMJ_OK;
+}
+
+/* Binds data to the randomizer's terms and makes the first draw. The block
+   must already be reserved, so this cannot fail. The terms are copied, so
+   the randomizer may be freed or extended afterwards. */
+static void gmj_env_params_apply(gmj_data* data,
+                                 const gmj_randomizer* randomizer,
+                                 unsigned long long seed) {
+  const mjModel* base = randomizer->model->handle;
+  gmj_env_params* params = data->params;
+  mjtNum* cursor = params->values;
+  int used[4];
+
+  gmj_env_params_size(randomizer, used);
+  memcpy(&params->model, base, sizeof(mjModel));
+  params->base = base;
+  if (randomizer->count > 0) {
+    memcpy(params->terms, randomizer->terms,
+           sizeof(gmj_rand_term) * (size_t)randomizer->count);
+  }
+  params->term_count = randomizer->count;
+  params->rng = seed;
+  if (used[GMJ_PARAM_BODY_MASS]) {
+    params->model.body_mass = cursor;
+    params->model.body_subtreemass = cursor + base->nbody;
+    params->model.body_inertia = cursor + 2 * (size_t)base->nbody;
+    cursor += 5 * (size_t)base->nbody;
+  }
+  if (used[GMJ_PARAM_GEOM_FRICTION]) {
+    params->model.geom_friction = cursor;
+    cursor += 3 * (size_t)base->ngeom;
+  }
+  if (used[GMJ_PARAM_DOF_DAMPING]) {
+    params->model.dof_damping = cursor;
+    cursor += base->nv;
+  }
+  if (used[GMJ_PARAM_ACTUATOR_GEAR]) {
+    params->model.actuator_gear = cursor;
+  }
+  gmj_env_params_draw(params);
+}
+
+static gmj_error_code gmj_env_params_bind(gmj_data* data,
+                                          const gmj_randomizer* randomizer,
+                                          unsigned long long seed) {
+  const gmj_error_code valid = gmj_env_params_reserve(data, randomizer);
+  if (valid == GMJ_OK) {
+    gmj_env_params_apply(data, randomizer, seed);
+  }
+  return valid;
+}
+
+/* Per-env seeds are decorrelated through one splitmix step of the index. */
+static unsigned long long gmj_env_seed(unsigned long long seed, int env_index) {
+  unsigned long long state = seed + (unsigned long long)env_index;
+  return gmj_rng_next(&state);
+}
+
+/* Every stepping path of the bridge runs through here: mj_step, the
+   attached recorder and the per-data counters. */
+static void gmj_data_advance(const mjModel* m, gmj_data* data, int steps) {
+  const double start = gmj_now_seconds();
+  int k = 0;
+  m = gmj_data_physics_model(m, data);
+  for (k = 0; k < steps; ++k) {
+    const mjtNum time = data->handle->time;
+    mj_step(m, data->handle);
+    gmj_data_note_warnings(data,
+                           data->handle->time < time + 0.5 * m->opt.timestep);
+    if (data->recorder != NULL) {
+      gmj_recorder_record(data->recorder, data->handle);
+    }
+  }
+  gmj_data_note_steps(data, steps, gmj_now_seconds() - start);
+}
+
+#define GMJ_ARENA_MIN_BYTES (64 * 1024)
+
+/* Smallest custom arena accepted: a fixed 64 KiB plus two dense nv x nv
+   matrices, which the Newton solver takes from the stack. Below this the
+   first mj_forward would overflow the stack, which MuJoCo treats as fatal.
+   A model whose own <size memory> is smaller keeps that as the floor. This
+   is a floor, not a guarantee; size from the stats peaks. */
+static size_t gmj_arena_floor(const mjModel* m) {
+  const size_t floor_bytes =
+      GMJ_ARENA_MIN_BYTES + 2 * (size_t)m->nv * (size_t)m->nv * sizeof(mjtNum);
+  return floor_bytes < (size_t)m->narena ? floor_bytes : (size_t)m->narena;
+}
+
+static gmj_error_code gmj_validate_arena(const mjModel* m,
+                                         size_t arena_bytes) {
+  if (arena_bytes != 0 && arena_bytes < gmj_arena_floor(m)) {
+    char message[128];
+    snprintf(message, sizeof(message),
+             "arena_bytes must be 0 or at least %lu for this model",
+             (unsigned long)gmj_arena_floor(m));
+    gmj_set_error(message);
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  return GMJ_OK;
+}
+
+/* mj_makeData takes the arena size (stack included) from model->narena, so
+   a header copy with another narena yields a differently sized arena. The
+   size then lives in mjData, which is all resets and stepping look at. A
+   size carried over from another model is raised to this model's floor. */
+static mjData* gmj_make_data_sized(const mjModel* m, size_t arena_bytes) {
+  mjModel sized;
+  if (arena_bytes != 0 && arena_bytes < gmj_arena_floor(m)) {
+    arena_bytes = gmj_arena_floor(m);
+  }
+  if (arena_bytes == 0 || arena_bytes == (size_t)m->narena) {
+    return mj_makeData(m);
+  }
+  memcpy(&sized, m, sizeof(mjModel));
+  sized.narena = arena_bytes;
+  return mj_makeData(&sized);
+}
+
+/* A data keeps a non-default arena size across model swaps. */
+static size_t gmj_data_arena_size(const mjModel* m, const mjData* d) {
+  return (size_t)d->narena == (size_t)m->narena ? 0 : (size_t)d->narena;
+}
+
+gmj_data* gmj_data_create(const gmj_model* model) {
+  return gmj_data_create_sized(model, 0);
+}
+
+gmj_data* gmj_data_create_sized(const gmj_model* model, size_t arena_bytes) {
+  gmj_data* wrapper = NULL;
+  mjData* data = NULL;
+
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("model is null");
+    return NULL;
+  }
+
+  if (gmj_validate_arena(model->handle, arena_bytes) != GMJ_OK) {
+    return NULL;
+  }
+
+  data = gmj_make_data_sized(model->handle, arena_bytes);
+  if (data == NULL) {
+    gmj_set_error("failed to allocate mjData");
+    return NULL;
+  }
+
+  wrapper = (gmj_data*)calloc(1, sizeof(gmj_data));
+  if (wrapper == NULL) {
+    mj_deleteData(data);
+    gmj_set_error("failed to allocate gmj_data");
+    return NULL;
+  }
+
+  wrapper->handle = data;
+  wrapper->generation = 1;
+  gmj_set_error(NULL);
+  return wrapper;
+}
+
+void gmj_data_free(gmj_data* data) {
+  if (data == NULL) {
+    return;
+  }
+  if (data->handle != NULL) {
+    mj_deleteData(data->handle);
+    data->handle = NULL;
+  }
+  if (data->recorder != NULL) {
+    data->recorder->attached = NULL;
+  }
+  gmj_env_params_free(data->params);
+  free(data->snapshots);
+  free(data);
+}
+
+/* Idle data are kept per (model, arena size) and handed out most recently
+   released first, while their arena is still warm in cache. Each idle data
+   holds a reference on its model, dropped when the data leaves the pool. */
+typedef struct gmj_pool_slot {
+  const gmj_model* model;
+  gmj_data* data;
+} gmj_pool_slot;
+
+struct gmj_data_pool {
+  gmj_mutex mutex;
+  gmj_pool_slot* idle;
+  int count;
+  int capacity;
+  int max_idle;
+  long long created;
+  long long reused;
+};
+
+gmj_data_pool* gmj_data_pool_create(int max_idle) {
+  gmj_data_pool* pool = NULL;
+  if (max_idle < 0) {
+    gmj_set_error("max_idle must be >= 0");
+    return NULL;
+  }
+  pool = (gmj_data_pool*)calloc(1, sizeof(gmj_data_pool));
+  if (pool == NULL) {
+    gmj_set_error("failed to allocate gmj_data_pool");
+    return NULL;
+  }
+  pool->max_idle = max_idle;
+  gmj_mutex_init(&pool->mutex);
+  gmj_set_error(NULL);
+  return pool;
+}
+
+void gmj_data_pool_free(gmj_data_pool* pool) {
+  int i = 0;
+  if (pool == NULL) {
+    return;
+  }
+  for (i = 0; i < pool->count; ++i) {
+    gmj_data_free(pool->idle[i].data);
+    gmj_model_free((gmj_model*)pool->idle[i].model);
+  }
+  gmj_mutex_destroy(&pool->mutex);
+  free(pool->idle);
+  free(pool);
+}
+
+gmj_data* gmj_data_pool_acquire(gmj_data_pool* pool, const gmj_model* model,
+                                size_t arena_bytes) {
+  gmj_data* data = NULL;
+  size_t narena = 0;
+  int i = 0;
+  if (pool == NULL || model == NULL || model->handle == NULL) {
+    gmj_set_error("invalid pool or model pointer");
+    return NULL;
+  }
+
+  if (gmj_validate_arena(model->handle, arena_bytes) != GMJ_OK) {
+    return NULL;
+  }
+
+  narena = arena_bytes != 0 ? arena_bytes : (size_t)model->handle->narena;
+  gmj_mutex_lock(&pool->mutex);
+  for (i = pool->count - 1; i >= 0; --i) {
+    if (pool->idle[i].model == model &&
+        (size_t)pool->idle[i].data->handle->narena == narena) {
+      data = pool->idle[i].data;
+      memmove(pool->idle + i, pool->idle + i + 1,
+              sizeof(gmj_pool_slot) * (size_t)(pool->count - i - 1));
+      pool->count -= 1;
+      pool->reused += 1;
+      break;
+    }
+  }
+  gmj_mutex_unlock(&pool->mutex);
+
+  if (data == NULL) {
+    data = gmj_data_create_sized(model, arena_bytes);
+    if (data != NULL) {
+      gmj_mutex_lock(&pool->mutex);
+      pool->created += 1;
+      gmj_mutex_unlock(&pool->mutex);
+    }
+    return data;
+  }
+  /* The caller's own reference keeps the model alive. */
+  gmj_model_free((gmj_model*)model);
+  mj_resetData(model->handle, data->handle);
+  gmj_data_reset_stats(data);
+  memset(data->stat_warning_seen, 0, sizeof(data->stat_warning_seen));
+  data->generation += 1;
+  gmj_set_error(NULL);
+  return data;
+}
+
+/* Everything beyond the mjData itself is dropped on release, so an acquired
+   data looks freshly created apart from its generation. */
+void gmj_data_pool_release(gmj_data_pool* pool, const gmj_model* model,
+                           gmj_data* data) {
+  int kept = 0;
+  if (data == NULL) {
+    return;
+  }
+  if (pool == NULL || model == NULL || model->handle == NULL ||
+      data->handle == NULL) {
+    gmj_data_free(data);
+    return;
+  }
+
+  if (data->recorder != NULL) {
+    data->recorder->attached = NULL;
+    data->recorder = NULL;
+  }
+  gmj_env_params_free(data->params);
+  data->params = NULL;
+  free(data->snapshots);
+  data->snapshots = NULL;
+  data->snapshot_capacity = 0;
+  data->snapshot_stride = 0;
+  data->snapshot_signature = 0;
+  data->snapshot_head = 0;
+  data->snapshot_count = 0;
+
+  gmj_mutex_lock(&pool->mutex);
+  if (pool->max_idle == 0 || pool->count < pool->max_idle) {
+    if (pool->count == pool->capacity) {
+      const int capacity = pool->capacity > 0 ? 2 * pool->capacity : 8;
+      gmj_pool_slot* grown = (gmj_pool_slot*)realloc(
+          pool->idle, sizeof(gmj_pool_slot) * (size_t)capacity);
+      if (grown != NULL) {
+        pool->idle = grown;
+        pool->capacity = capacity;
+      }
+    }
+    if (pool->count < pool->capacity) {
+      gmj_model_retain(model);
+      pool->idle[pool->count].model = model;
+      pool->idle[pool->count].data = data;
+      pool->count += 1;
+      kept = 1;
+    }
+  }
+  gmj_mutex_unlock(&pool->mutex);
+
+  if (!kept) {
+    gmj_data_free(data);
+  }
+}
+
+/* Matching entries are unlinked under the lock and freed after it, so
+   acquires and releases on other threads never wait for mj_deleteData or
+   for the model teardown a last reference triggers. */
+int gmj_data_pool_trim(gmj_data_pool* pool, const gmj_model* model) {
+  gmj_pool_slot* dropped = NULL;
+  int freed = 0;
+  int kept = 0;
+  int i = 0;
+  if (pool == NULL) {
+    gmj_set_error("pool is null");
+    return -1;
+  }
+
+  gmj_mutex_lock(&pool->mutex);
+  if (pool->count > 0) {
+    dropped = (gmj_pool_slot*)malloc(sizeof(gmj_pool_slot) *
+                                     (size_t)pool->count);
+    if (dropped == NULL) {
+      gmj_mutex_unlock(&pool->mutex);
+      gmj_set_error("failed to allocate trim buffer");
+      return -1;
+    }
+  }
+  for (i = 0; i < pool->count; ++i) {
+    if (model == NULL || pool->idle[i].model == model) {
+      dropped[freed++] = pool->idle[i];
+    } else {
+      pool->idle[kept++] = pool->idle[i];
+    }
+  }
+  pool->count = kept;
+  gmj_mutex_unlock(&pool->mutex);
+
+  for (i = 0; i < freed; ++i) {
+    gmj_data_free(dropped[i].data);
+    gmj_model_free((gmj_model*)dropped[i].model);
+  }
+  free(dropped);
+  gmj_set_error(NULL);
+  return freed;
+}
+
+gmj_error_code gmj_data_pool_stats(gmj_data_pool* pool,
+                                   gmj_data_pool_info* out_info) {
+  int i = 0;
+  if (pool == NULL || out_info == NULL) {
+    gmj_set_error("invalid pool or out_info pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  memset(out_info, 0, sizeof(*out_info));
+  gmj_mutex_lock(&pool->mutex);
+  out_info->idle = pool->count;
+  out_info->created = pool->created;
+  out_info->reused = pool->reused;
+  for (i = 0; i < pool->count; ++i) {
+    const mjData* d = pool->idle[i].data->handle;
+    out_info->idle_bytes += (long long)d->nbuffer + (long long)d->narena;
+  }
+  gmj_mutex_unlock(&pool->mutex);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+static int gmj_joint_width(int type, int velocity) {
+  switch (type) {
+    case mjJNT_FREE:
+      return velocity ? 6 : 7;
+    case mjJNT_BALL:
+      return velocity ? 3 : 4;
+    default:
+      return 1;
+  }
+}
+
+/* Same name, or for unnamed joints (a bare <freejoint/>, say) the same
+   position among the joints of a body with the same name. */
+static int gmj_match_joint(const mjModel* from, const mjModel* to, int joint) {
+  const char* name = mj_id2name(from, mjOBJ_JOINT, joint);
+  const char* body_name = NULL;
+  int from_body = 0;
+  int to_body = 0;
+  int ordinal = 0;
+
+  if (name != NULL && name[0] != '\0') {
+    return mj_name2id(to, mjOBJ_JOINT, name);
+  }
+  from_body = from->jnt_bodyid[joint];
+  body_name = mj_id2name(from, mjOBJ_BODY, from_body);
+  if (body_name == NULL || body_name[0] == '\0') {
+    return -1;
+  }
+  to_body = mj_name2id(to, mjOBJ_BODY, body_name);
+  ordinal = joint - from->body_jntadr[from_body];
+  if (to_body < 0 || ordinal >= to->body_jntnum[to_body]) {
+    return -1;
+  }
+  return to->body_jntadr[to_body] + ordinal;
+}
+
+/* Unnamed actuators match by index when the other side is unnamed too. */
+static int gmj_match_actuator(const mjModel* from, const mjModel* to,
+                              int actuator) {
+  const char* name = mj_id2name(from, mjOBJ_ACTUATOR, actuator);
+  const char* other = NULL;
+  if (name != NULL && name[0] != '\0') {
+    return mj_name2id(to, mjOBJ_ACTUATOR, name);
+  }
+  if (actuator >= to->nu) {
+    return -1;
+  }
+  other = mj_id2name(to, mjOBJ_ACTUATOR, actuator);
+  return other == NULL || other[0] == '\0' ? actuator : -1;
+}
+
+static void gmj_migrate_state(const mjModel* from, const mjData* src,
+                              const mjModel* to, mjData* dst) {
+  int j = 0;
+  int u = 0;
+
+  dst->time = src->time;
+  for (j = 0; j < from->njnt; ++j) {
+    const int type = from->jnt_type[j];
+    const int target = gmj_match_joint(from, to, j);
+    if (target < 0 || to->jnt_type[target] != type) {
+      continue;
+    }
+    memcpy(dst->qpos + to->jnt_qposadr[target],
+           src->qpos + from->jnt_qposadr[j],
+           sizeof(mjtNum) * (size_t)gmj_joint_width(type, 0));
+    memcpy(dst->qvel + to->jnt_dofadr[target],
+           src->qvel + from->jnt_dofadr[j],
+           sizeof(mjtNum) * (size_t)gmj_joint_width(type, 1));
+  }
+  for (u = 0; u < from->nu; ++u) {
+    const int target = gmj_match_actuator(from, to, u);
+    if (target >= 0) {
+      dst->ctrl[target] = src->ctrl[u];
+    }
+  }
+  mj_forward(to, dst);
+}
+
+/* Swaps in the migrated mjData. Anything sized by the old model goes: the
+   snapshot ring and randomized parameters are dropped and a recorder is
+   detached. */
+static void gmj_data_swap_handle(gmj_data* data, mjData* handle) {
+  mj_deleteData(data->handle);
+  data->handle = handle;
+  data->generation += 1;
+  memset(data->stat_warning_seen, 0, sizeof(data->stat_warning_seen));
+  gmj_env_params_free(data->params);
+  data->params = NULL;
+  free(data->snapshots);
+  data->snapshots = NULL;
+  data->snapshot_capacity = 0;
+  data->snapshot_stride = 0;
+  data->snapshot_signature = 0;
+  data->snapshot_head = 0;
+  data->snapshot_count = 0;
+  if (data->recorder != NULL) {
+    data->recorder->attached = NULL;
+    data->recorder = NULL;
+  }
+}
+
+gmj_error_code gmj_data_migrate(const gmj_model* old_model, gmj_data* data,
+                                const gmj_model* new_model) {
+  mjData* handle = NULL;
+  const gmj_error_code valid = gmj_validate_ptrs(old_model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (new_model == NULL || new_model->handle == NULL) {
+    gmj_set_error("new_model is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  handle = gmj_make_data_sized(
+      new_model->handle, gmj_data_arena_size(old_model->handle, data->handle));
+  if (handle == NULL) {
+    gmj_set_error("failed to allocate mjData");
+    return GMJ_ERR_ALLOCATION;
+  }
+  gmj_migrate_state(old_model->handle, data->handle, new_model->handle,
+                    handle);
+  gmj_data_swap_handle(data, handle);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_data_randomize(const gmj_model* model, gmj_data* data,
+                                  const gmj_randomizer* randomizer,
+                                  unsigned long long seed) {
+  gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (randomizer == NULL) {
+    gmj_env_params_free(data->params);
+    data->params = NULL;
+    gmj_set_error(NULL);
+    return GMJ_OK;
+  }
+  if (randomizer->model->handle != model->handle) {
+    gmj_set_error("randomizer was built for a different model");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  valid = gmj_env_params_bind(data, randomizer, seed);
+  if (valid == GMJ_OK) {
+    gmj_set_error(NULL);
+  }
+  return valid;
+}
+
+gmj_error_code gmj_data_param(const gmj_model* model, const gmj_data* data,
+                              gmj_param param, int index, double* out_value) {
+  const mjModel* m = NULL;
+  int count = 0;
+  const gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (out_value == NULL ||
+      param < GMJ_PARAM_BODY_MASS || param > GMJ_PARAM_ACTUATOR_GEAR) {
+    gmj_set_error("invalid param or out_value pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  m = gmj_data_physics_model(model->handle, data);
+  if (param == GMJ_PARAM_BODY_MASS) {
+    count = m->nbody;
+  } else if (param == GMJ_PARAM_GEOM_FRICTION) {
+    count = m->ngeom;
+  } else if (param == GMJ_PARAM_DOF_DAMPING) {
+    count = m->nv;
+  } else {
+    count = m->nu;
+  }
+  if (index < 0 || index >= count) {
+    gmj_set_error("index out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+
+  *out_value = (double)*gmj_param_slot(m, param, index);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_reset_data(const gmj_model* model, gmj_data* data) {
+  const gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  gmj_data_reset(model->handle, data, -1);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_step(const gmj_model* model, gmj_data* data, int steps) {
+  const gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (steps < 1) {
+    gmj_set_error("steps must be >= 1");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  gmj_data_advance(model->handle, data, steps);
+
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_forward(const gmj_model* model, gmj_data* data) {
+  const gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  mj_forward(gmj_data_physics_model(model->handle, data), data->handle);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+int gmj_nq(const gmj_model* model) {
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("model is null");
+    return -1;
+  }
+  return model->handle->nq;
+}
+
+int gmj_nv(const gmj_model* model) {
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("model is null");
+    return -1;
+  }
+  return model->handle->nv;
+}
+
+int gmj_nu(const gmj_model* model) {
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("model is null");
+    return -1;
+  }
+  return model->handle->nu;
+}
+
+int gmj_nbody(const gmj_model* model) {
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("model is null");
+    return -1;
+  }
+  return model->handle->nbody;
+}
+
+int gmj_nsensor(const gmj_model* model) {
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("model is null");
+    return -1;
+  }
+  return model->handle->nsensor;
+}
+
+int gmj_nsensordata(const gmj_model* model) {
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("model is null");
+    return -1;
+  }
+  return model->handle->nsensordata;
+}
+
+int gmj_body_id(const gmj_model* model, const char* body_name) {
+  int id = -1;
+  if (model == NULL || model->handle == NULL || body_name == NULL) {
+    gmj_set_error("invalid model pointer or body_name");
+    return -1;
+  }
+
+  id = mj_name2id(model->handle, mjOBJ_BODY, body_name);
+  if (id < 0) {
+    gmj_set_error("body_name not found");
+    return -1;
+  }
+  gmj_set_error(NULL);
+  return id;
+}
+
+int gmj_joint_id(const gmj_model* model, const char* joint_name) {
+  int id = -1;
+  if (model == NULL || model->handle == NULL || joint_name == NULL) {
+    gmj_set_error("invalid model pointer or joint_name");
+    return -1;
+  }
+
+  id = mj_name2id(model->handle, mjOBJ_JOINT, joint_name);
+  if (id < 0) {
+    gmj_set_error("joint_name not found");
+    return -1;
+  }
+  gmj_set_error(NULL);
+  return id;
+}
+
+int gmj_actuator_id(const gmj_model* model, const char* actuator_name) {
+  int id = -1;
+  if (model == NULL || model->handle == NULL || actuator_name == NULL) {
+    gmj_set_error("invalid model pointer or actuator_name");
+    return -1;
+  }
+
+  id = mj_name2id(model->handle, mjOBJ_ACTUATOR, actuator_name);
+  if (id < 0) {
+    gmj_set_error("actuator_name not found");
+    return -1;
+  }
+  gmj_set_error(NULL);
+  return id;
+}
+
+int gmj_sensor_id(const gmj_model* model, const char* sensor_name) {
+  int id = -1;
+  if (model == NULL || model->handle == NULL || sensor_name == NULL) {
+    gmj_set_error("invalid model pointer or sensor_name");
+    return -1;
+  }
+
+  id = mj_name2id(model->handle, mjOBJ_SENSOR, sensor_name);
+  if (id < 0) {
+    gmj_set_error("sensor_name not found");
+    return -1;
+  }
+  gmj_set_error(NULL);
+  return id;
+}
+
+const char* gmj_body_name(const gmj_model* model, int body_id) {
+  const char* name = NULL;
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("invalid model pointer");
+    return NULL;
+  }
+  if (body_id < 0 || body_id >= model->handle->nbody) {
+    gmj_set_error("body_id out of range");
+    return NULL;
+  }
+
+  name = mj_id2name(model->handle, mjOBJ_BODY, body_id);
+  gmj_set_error(NULL);
+  return name;
+}
+
+const char* gmj_joint_name(const gmj_model* model, int joint_id) {
+  const char* name = NULL;
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("invalid model pointer");
+    return NULL;
+  }
+  if (joint_id < 0 || joint_id >= model->handle->njnt) {
+    gmj_set_error("joint_id out of range");
+    return NULL;
+  }
+
+  name = mj_id2name(model->handle, mjOBJ_JOINT, joint_id);
+  gmj_set_error(NULL);
+  return name;
+}
+
+const char* gmj_actuator_name(const gmj_model* model, int actuator_id) {
+  const char* name = NULL;
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("invalid model pointer");
+    return NULL;
+  }
+  if (actuator_id < 0 || actuator_id >= model->handle->nu) {
+    gmj_set_error("actuator_id out of range");
+    return NULL;
+  }
+
+  name = mj_id2name(model->handle, mjOBJ_ACTUATOR, actuator_id);
+  gmj_set_error(NULL);
+  return name;
+}
+
+const char* gmj_sensor_name(const gmj_model* model, int sensor_id) {
+  const char* name = NULL;
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("invalid model pointer");
+    return NULL;
+  }
+  if (sensor_id < 0 || sensor_id >= model->handle->nsensor) {
+    gmj_set_error("sensor_id out of range");
+    return NULL;
+  }
+
+  name = mj_id2name(model->handle, mjOBJ_SENSOR, sensor_id);
+  gmj_set_error(NULL);
+  return name;
+}
+
+int gmj_sensor_adr(const gmj_model* model, int sensor_id) {
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("invalid model pointer");
+    return -1;
+  }
+  if (sensor_id < 0 || sensor_id >= model->handle->nsensor) {
+    gmj_set_error("sensor_id out of range");
+    return -1;
+  }
+  gmj_set_error(NULL);
+  return model->handle->sensor_adr[sensor_id];
+}
+
+int gmj_sensor_dim(const gmj_model* model, int sensor_id) {
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("invalid model pointer");
+    return -1;
+  }
+  if (sensor_id < 0 || sensor_id >= model->handle->nsensor) {
+    gmj_set_error("sensor_id out of range");
+    return -1;
+  }
+  gmj_set_error(NULL);
+  return model->handle->sensor_dim[sensor_id];
+}
+
+gmj_error_code gmj_set_ctrl(const gmj_model* model, gmj_data* data,
+                            int actuator_index, double value) {
+  const gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (actuator_index < 0 || actuator_index >= model->handle->nu) {
+    gmj_set_error("actuator_index out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+
+  data->handle->ctrl[actuator_index] = (mjtNum)value;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_get_ctrl(const gmj_model* model, const gmj_data* data,
+                            int actuator_index, double* out_value) {
+  if (out_value == NULL) {
+    gmj_set_error("out_value is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (model == NULL || model->handle == NULL || data == NULL ||
+      data->handle == NULL) {
+    gmj_set_error("invalid model or data pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (actuator_index < 0 || actuator_index >= model->handle->nu) {
+    gmj_set_error("actuator_index out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+
+  *out_value = (double)data->handle->ctrl[actuator_index];
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_get_qpos(const gmj_model* model, const gmj_data* data,
+                            int qpos_index, double* out_value) {
+  if (out_value == NULL) {
+    gmj_set_error("out_value is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (model == NULL || model->handle == NULL || data == NULL ||
+      data->handle == NULL) {
+    gmj_set_error("invalid model or data pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (qpos_index < 0 || qpos_index >= model->handle->nq) {
+    gmj_set_error("qpos_index out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+
+  *out_value = (double)data->handle->qpos[qpos_index];
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_set_qpos(const gmj_model* model, gmj_data* data,
+                            int qpos_index, double value) {
+  const gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (qpos_index < 0 || qpos_index >= model->handle->nq) {
+    gmj_set_error("qpos_index out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+
+  data->handle->qpos[qpos_index] = (mjtNum)value;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_get_qvel(const gmj_model* model, const gmj_data* data,
+                            int qvel_index, double* out_value) {
+  if (out_value == NULL) {
+    gmj_set_error("out_value is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (model == NULL || model->handle == NULL || data == NULL ||
+      data->handle == NULL) {
+    gmj_set_error("invalid model or data pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (qvel_index < 0 || qvel_index >= model->handle->nv) {
+    gmj_set_error("qvel_index out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+
+  *out_value = (double)data->handle->qvel[qvel_index];
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_set_qvel(const gmj_model* model, gmj_data* data,
+                            int qvel_index, double value) {
+  const gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (qvel_index < 0 || qvel_index >= model->handle->nv) {
+    gmj_set_error("qvel_index out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+
+  data->handle->qvel[qvel_index] = (mjtNum)value;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_get_qpos_slice(const gmj_model* model, const gmj_data* data,
+                                  int start_index, int count,
+                                  double* out_values) {
+  gmj_error_code valid = GMJ_OK;
+  if (out_values == NULL) {
+    gmj_set_error("out_values is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (model == NULL || model->handle == NULL || data == NULL ||
+      data->handle == NULL) {
+    gmj_set_error("invalid model or data pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  valid = gmj_validate_slice(start_index, count, model->handle->nq);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  gmj_copy_from_mjtnum(out_values, data->handle->qpos + start_index, count);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_set_qpos_slice(const gmj_model* model, gmj_data* data,
+                                  int start_index, int count,
+                                  const double* values) {
+  gmj_error_code valid = GMJ_OK;
+  valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (values == NULL) {
+    gmj_set_error("values is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  valid = gmj_validate_slice(start_index, count, model->handle->nq);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  gmj_copy_to_mjtnum(data->handle->qpos + start_index, values, count);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_get_qvel_slice(const gmj_model* model, const gmj_data* data,
+                                  int start_index, int count,
+                                  double* out_values) {
+  gmj_error_code valid = GMJ_OK;
+  if (out_values == NULL) {
+    gmj_set_error("out_values is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (model == NULL || model->handle == NULL || data == NULL ||
+      data->handle == NULL) {
+    gmj_set_error("invalid model or data pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  valid = gmj_validate_slice(start_index, count, model->handle->nv);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  gmj_copy_from_mjtnum(out_values, data->handle->qvel + start_index, count);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_set_qvel_slice(const gmj_model* model, gmj_data* data,
+                                  int start_index, int count,
+                                  const double* values) {
+  gmj_error_code valid = GMJ_OK;
+  valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (values == NULL) {
+    gmj_set_error("values is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  valid = gmj_validate_slice(start_index, count, model->handle->nv);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  gmj_copy_to_mjtnum(data->handle->qvel + start_index, values, count);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_get_ctrl_slice(const gmj_model* model, const gmj_data* data,
+                                  int start_index, int count,
+                                  double* out_values) {
+  gmj_error_code valid = GMJ_OK;
+  if (out_values == NULL) {
+    gmj_set_error("out_values is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (model == NULL || model->handle == NULL || data == NULL ||
+      data->handle == NULL) {
+    gmj_set_error("invalid model or data pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  valid = gmj_validate_slice(start_index, count, model->handle->nu);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  gmj_copy_from_mjtnum(out_values, data->handle->ctrl + start_index, count);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_set_ctrl_slice(const gmj_model* model, gmj_data* data,
+                                  int start_index, int count,
+                                  const double* values) {
+  gmj_error_code valid = GMJ_OK;
+  valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (values == NULL) {
+    gmj_set_error("values is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  valid = gmj_validate_slice(start_index, count, model->handle->nu);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  gmj_copy_to_mjtnum(data->handle->ctrl + start_index, values, count);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_body_world_position(const gmj_model* model,
+                                       const gmj_data* data, int body_index,
+                                       double* out_xyz_3) {
+  const mjtNum* body_xpos = NULL;
+  if (out_xyz_3 == NULL) {
+    gmj_set_error("out_xyz_3 is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (model == NULL || model->handle == NULL || data == NULL ||
+      data->handle == NULL) {
+    gmj_set_error("invalid model or data pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (body_index < 0 || body_index >= model->handle->nbody) {
+    gmj_set_error("body_index out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+
+  body_xpos = data->handle->xpos + (3 * body_index);
+  out_xyz_3[0] = (double)body_xpos[0];
+  out_xyz_3[1] = (double)body_xpos[1];
+  out_xyz_3[2] = (double)body_xpos[2];
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+/* Array, length and row width of a state field. d may be NULL when only
+   the extent is needed. Returns 0 for an unknown field. */
+static int gmj_field_lookup(const mjModel* m, mjData* d, gmj_state_field field,
+                            mjtNum** out_values, int* out_count,
+                            int* out_width) {
+  mjtNum* values = NULL;
+  int count = 0;
+  int width = 1;
+  switch (field) {
+    case GMJ_FIELD_QPOS:
+      values = d != NULL ? d->qpos : NULL;
+      count = m->nq;
+      break;
+    case GMJ_FIELD_QVEL:
+      values = d != NULL ? d->qvel : NULL;
+      count = m->nv;
+      break;
+    case GMJ_FIELD_CTRL:
+      values = d != NULL ? d->ctrl : NULL;
+      count = m->nu;
+      break;
+    case GMJ_FIELD_ACT:
+      values = d != NULL ? d->act : NULL;
+      count = m->na;
+      break;
+    case GMJ_FIELD_XPOS:
+      values = d != NULL ? d->xpos : NULL;
+      width = 3;
+      break;
+    case GMJ_FIELD_XQUAT:
+      values = d != NULL ? d->xquat : NULL;
+      width = 4;
+      break;
+    case GMJ_FIELD_XMAT:
+      values = d != NULL ? d->xmat : NULL;
+      width = 9;
+      break;
+    case GMJ_FIELD_SENSORDATA:
+      values = d != NULL ? d->sensordata : NULL;
+      count = m->nsensordata;
+      break;
+    default:
+      return 0;
+  }
+  if (width > 1) {
+    count = width * m->nbody;
+  }
+  if (out_values != NULL) {
+    *out_values = values;
+  }
+  *out_count = count;
+  *out_width = width;
+  return 1;
+}
+
+gmj_error_code gmj_data_view(const gmj_model* model, gmj_data* data,
+                             gmj_state_field field, gmj_view* out_view) {
+  const gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (out_view == NULL) {
+    gmj_set_error("out_view is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+#ifdef mjUSESINGLE
+  (void)field;
+  gmj_set_error("views require a double-precision MuJoCo build");
+  return GMJ_ERR_MUJOCO;
+#else
+  if (!gmj_field_lookup(model->handle, data->handle, field, &out_view->values,
+                        &out_view->count, &out_view->width)) {
+    gmj_set_error("unknown state field");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  out_view->generation = data->generation;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+#endif
+}
+
+unsigned long long gmj_data_generation(const gmj_data* data) {
+  if (data == NULL) {
+    gmj_set_error("data is null");
+    return 0;
+  }
+  return data->generation;
+}
+
+static int gmj_field_writable(gmj_state_field field) {
+  return field == GMJ_FIELD_QPOS || field == GMJ_FIELD_QVEL ||
+         field == GMJ_FIELD_CTRL || field == GMJ_FIELD_ACT;
+}
+
+/* Resolves field[start, start + count) for the float32 accessors. */
+static gmj_error_code gmj_resolve_slice_f32(const mjModel* m, mjData* d,
+                                            gmj_state_field field,
+                                            int start_index, int count,
+                                            int writing, mjtNum** out_base) {
+  mjtNum* values = NULL;
+  int length = 0;
+  int width = 0;
+  gmj_error_code valid = GMJ_OK;
+  if (!gmj_field_lookup(m, d, field, &values, &length, &width)) {
+    gmj_set_error("unknown state field");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (writing && !gmj_field_writable(field)) {
+    gmj_set_error("field is read-only");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  valid = gmj_validate_slice(start_index, count, length);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  *out_base = values != NULL && count > 0 ? values + start_index : NULL;
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_get_slice_f32(const gmj_model* model, const gmj_data* data,
+                                 gmj_state_field field, int start_index,
+                                 int count, float* out_values) {
+  mjtNum* base = NULL;
+  gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (out_values == NULL) {
+    gmj_set_error("out_values is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  valid = gmj_resolve_slice_f32(model->handle, data->handle, field,
+                                start_index, count, 0, &base);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  if (count > 0) {
+    gmj_store_f32(out_values, base, count, gmj_simd_active());
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_set_slice_f32(const gmj_model* model, gmj_data* data,
+                                 gmj_state_field field, int start_index,
+                                 int count, const float* values) {
+  mjtNum* base = NULL;
+  gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (values == NULL) {
+    gmj_set_error("values is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  valid = gmj_resolve_slice_f32(model->handle, data->handle, field,
+                                start_index, count, 1, &base);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  if (count > 0) {
+    gmj_load_f32(base, values, count, gmj_simd_active());
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_get_qpos_slice_f32(const gmj_model* model,
+                                      const gmj_data* data, int start_index,
+                                      int count, float* out_values) {
+  return gmj_get_slice_f32(model, data, GMJ_FIELD_QPOS, start_index, count,
+                           out_values);
+}
+
+gmj_error_code gmj_set_qpos_slice_f32(const gmj_model* model, gmj_data* data,
+                                      int start_index, int count,
+                                      const float* values) {
+  return gmj_set_slice_f32(model, data, GMJ_FIELD_QPOS, start_index, count,
+                           values);
+}
+
+gmj_error_code gmj_get_qvel_slice_f32(const gmj_model* model,
+                                      const gmj_data* data, int start_index,
+                                      int count, float* out_values) {
+  return gmj_get_slice_f32(model, data, GMJ_FIELD_QVEL, start_index, count,
+                           out_values);
+}
+
+gmj_error_code gmj_set_qvel_slice_f32(const gmj_model* model, gmj_data* data,
+                                      int start_index, int count,
+                                      const float* values) {
+  return gmj_set_slice_f32(model, data, GMJ_FIELD_QVEL, start_index, count,
+                           values);
+}
+
+gmj_error_code gmj_get_ctrl_slice_f32(const gmj_model* model,
+                                      const gmj_data* data, int start_index,
+                                      int count, float* out_values) {
+  return gmj_get_slice_f32(model, data, GMJ_FIELD_CTRL, start_index, count,
+                           out_values);
+}
+
+gmj_error_code gmj_set_ctrl_slice_f32(const gmj_model* model, gmj_data* data,
+                                      int start_index, int count,
+                                      const float* values) {
+  return gmj_set_slice_f32(model, data, GMJ_FIELD_CTRL, start_index, count,
+                           values);
+}
+
+/* Adds one data to out: counts, times and current sizes add up, high-water
+   marks and peaks take the maximum. */
+static void gmj_stats_accumulate(const gmj_data* data, gmj_stats* out) {
+  const mjData* d = data->handle;
+  const int iterations = gmj_solver_iterations(d);
+  const long long arena_peak = (long long)d->maxuse_arena;
+  const long long stack_peak = (long long)d->maxuse_stack;
+  int i = 0;
+
+  out->steps += data->stat_steps;
+  out->step_seconds += data->stat_step_seconds;
+  for (i = 0; i < GMJ_STATS_TIMERS && i < mjNTIMER; ++i) {
+    out->timer_seconds[i] += (double)d->timer[i].duration;
+    out->timer_calls[i] += d->timer[i].number;
+  }
+  for (i = 0; i < GMJ_STATS_WARNINGS; ++i) {
+    out->warnings[i] += data->stat_warnings[i];
+  }
+  out->solver_iterations += iterations;
+  out->ncon += d->ncon;
+  out->nefc += d->nefc;
+  out->buffer_bytes += (long long)d->nbuffer;
+  out->arena_bytes += (long long)d->narena;
+  if (data->stat_solver_iterations_max > out->solver_iterations_max) {
+    out->solver_iterations_max = data->stat_solver_iterations_max;
+  }
+  if (data->stat_ncon_max > out->ncon_max) {
+    out->ncon_max = data->stat_ncon_max;
+  }
+  if (data->stat_nefc_max > out->nefc_max) {
+    out->nefc_max = data->stat_nefc_max;
+  }
+  if (arena_peak > out->arena_peak_bytes) {
+    out->arena_peak_bytes = arena_peak;
+  }
+  if (stack_peak > out->stack_peak_bytes) {
+    out->stack_peak_bytes = stack_peak;
+  }
+  if (data->stat_arena_peak_max > out->arena_peak_max_bytes) {
+    out->arena_peak_max_bytes = data->stat_arena_peak_max;
+  }
+  if (data->stat_stack_peak_max > out->stack_peak_max_bytes) {
+    out->stack_peak_max_bytes = data->stat_stack_peak_max;
+  }
+}
+
+gmj_error_code gmj_data_stats(const gmj_model* model, const gmj_data* data,
+                              gmj_stats* out_stats) {
+  const gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (out_stats == NULL) {
+    gmj_set_error("out_stats is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  memset(out_stats, 0, sizeof(*out_stats));
+  gmj_stats_accumulate(data, out_stats);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+void gmj_data_reset_stats(gmj_data* data) {
+  if (data == NULL) {
+    return;
+  }
+  data->stat_steps = 0;
+  data->stat_step_seconds = 0.0;
+  data->stat_ncon_max = 0;
+  data->stat_nefc_max = 0;
+  data->stat_solver_iterations_max = 0;
+  data->stat_arena_peak_max = 0;
+  data->stat_stack_peak_max = 0;
+  memset(data->stat_warnings, 0, sizeof(data->stat_warnings));
+}
+
+static mjtNum gmj_timer_now(void) { return (mjtNum)gmj_now_seconds(); }
+
+void gmj_stats_enable_timers(int enabled) {
+  mjcb_time = enabled ? gmj_timer_now : NULL;
+}
+
+_Static_assert(GMJ_STATE_INTEGRATION == mjSTATE_INTEGRATION &&
+                   GMJ_STATE_PLUGIN == mjSTATE_PLUGIN,
+               "gmj state signature bits must match mjtState");
+
+int gmj_state_size(const gmj_model* model, int signature) {
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("model is null");
+    return -1;
+  }
+  if (gmj_validate_signature(signature) != GMJ_OK) {
+    return -1;
+  }
+  return mj_stateSize(model->handle, signature);
+}
+
+gmj_error_code gmj_state_save(const gmj_model* model, const gmj_data* data,
+                              int signature, double* out_state) {
+  gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  valid = gmj_validate_signature(signature);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (out_state == NULL) {
+    gmj_set_error("out_state is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+#ifdef mjUSESINGLE
+  {
+    const int size = mj_stateSize(model->handle, signature);
+    int i = 0;
+    mjtNum* state = (mjtNum*)malloc((size_t)size * sizeof(mjtNum));
+    if (state == NULL) {
+      gmj_set_error("failed to allocate state buffer");
+      return GMJ_ERR_ALLOCATION;
+    }
+    mj_getState(model->handle, data->handle, state, signature);
+    for (i = 0; i < size; ++i) {
+      out_state[i] = (double)state[i];
+    }
+    free(state);
+  }
+#else
+  mj_getState(model->handle, data->handle, out_state, signature);
+#endif
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_state_restore(const gmj_model* model, gmj_data* data,
+                                 int signature, const double* state) {
+  gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  valid = gmj_validate_signature(signature);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (state == NULL) {
+    gmj_set_error("state is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+#ifdef mjUSESINGLE
+  {
+    const int size = mj_stateSize(model->handle, signature);
+    int i = 0;
+    mjtNum* converted = (mjtNum*)malloc((size_t)size * sizeof(mjtNum));
+    if (converted == NULL) {
+      gmj_set_error("failed to allocate state buffer");
+      return GMJ_ERR_ALLOCATION;
+    }
+    for (i = 0; i < size; ++i) {
+      converted[i] = (mjtNum)state[i];
+    }
+    mj_setState(model->handle, data->handle, converted, signature);
+    free(converted);
+  }
+#else
+  mj_setState(model->handle, data->handle, state, signature);
+#endif
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+/* The snapshot ring is one block of capacity * mj_stateSize mjtNum owned by
+   the gmj_data; push, restore and rollback only copy within it. */
+gmj_error_code gmj_snapshot_ring_configure(const gmj_model* model,
+                                           gmj_data* data, int capacity,
+                                           int signature) {
+  mjtNum* arena = NULL;
+  int stride = 0;
+  gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (capacity < 0) {
+    gmj_set_error("capacity must be >= 0");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  if (capacity > 0) {
+    valid = gmj_validate_signature(signature);
+    if (valid != GMJ_OK) {
+      return valid;
+    }
+    stride = mj_stateSize(model->handle, signature);
+    arena = (mjtNum*)malloc((size_t)capacity * (size_t)stride *
+                            sizeof(mjtNum));
+    if (arena == NULL && stride > 0) {
+      gmj_set_error("failed to allocate snapshot ring");
+      return GMJ_ERR_ALLOCATION;
+    }
+  }
+
+  free(data->snapshots);
+  data->snapshots = arena;
+  data->snapshot_capacity = capacity;
+  data->snapshot_stride = stride;
+  data->snapshot_signature = signature;
+  data->snapshot_head = 0;
+  data->snapshot_count = 0;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_snapshot_push(const gmj_model* model, gmj_data* data) {
+  const gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (data->snapshot_capacity == 0) {
+    gmj_set_error("snapshot ring is not configured");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  mj_getState(model->handle, data->handle,
+              data->snapshots +
+                  (size_t)data->snapshot_head * (size_t)data->snapshot_stride,
+              data->snapshot_signature);
+  data->snapshot_head = (data->snapshot_head + 1) % data->snapshot_capacity;
+  if (data->snapshot_count < data->snapshot_capacity) {
+    data->snapshot_count += 1;
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+int gmj_snapshot_count(const gmj_data* data) {
+  if (data == NULL) {
+    gmj_set_error("data is null");
+    return -1;
+  }
+  return data->snapshot_count;
+}
+
+static gmj_error_code gmj_snapshot_load(const gmj_model* model,
+                                        gmj_data* data, int age,
+                                        int drop_newer) {
+  int slot = 0;
+  const gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (age < 0 || age >= data->snapshot_count) {
+    gmj_set_error("snapshot age out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+
+  slot = (data->snapshot_head - 1 - age + data->snapshot_capacity) %
+         data->snapshot_capacity;
+  mj_setState(model->handle, data->handle,
+              data->snapshots + (size_t)slot * (size_t)data->snapshot_stride,
+              data->snapshot_signature);
+  if (drop_newer) {
+    data->snapshot_head = (slot + 1) % data->snapshot_capacity;
+    data->snapshot_count -= age;
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_snapshot_restore(const gmj_model* model, gmj_data* data,
+                                    int age) {
+  return gmj_snapshot_load(model, data, age, 0);
+}
+
+gmj_error_code gmj_snapshot_rollback(const gmj_model* model, gmj_data* data,
+                                     int age) {
+  return gmj_snapshot_load(model, data, age, 1);
+}
+
+static int gmj_transform_stride(gmj_transform_layout layout) {
+  switch (layout) {
+    case GMJ_TRANSFORM_MULTIMESH:
+      return 12;
+    case GMJ_TRANSFORM_POS_QUAT:
+      return 7;
+    default:
+      return 0;
+  }
+}
+
+static gmj_error_code gmj_validate_transform_args(const mjModel* m,
+                                                  const int* body_ids,
+                                                  int body_count,
+                                                  gmj_transform_layout layout,
+                                                  const float* out) {
+  int i = 0;
+  if (out == NULL) {
+    gmj_set_error("out_transforms is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (gmj_transform_stride(layout) == 0) {
+    gmj_set_error("unknown transform layout");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (body_count < 0 || (body_ids == NULL && body_count > m->nbody)) {
+    gmj_set_error("body_count out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+  if (body_ids != NULL) {
+    for (i = 0; i < body_count; ++i) {
+      if (body_ids[i] < 0 || body_ids[i] >= m->nbody) {
+        gmj_set_error("body id out of range");
+        return GMJ_ERR_INDEX_OUT_OF_RANGE;
+      }
+    }
+  }
+  return GMJ_OK;
+}
+
+/* MuJoCo is Z-up; GMJ_TRANSFORM_Y_UP rotates -90 degrees about X so that
+   (x, y, z) maps to (x, z, -y). */
+static const int gmj_y_up_axis[3] = {0, 2, 1};
+static const double gmj_y_up_sign[3] = {1.0, 1.0, -1.0};
+
+static void gmj_write_transforms(const mjData* d, const int* body_ids,
+                                 int body_count, const float* world_offset,
+                                 gmj_transform_layout layout, int flags,
+                                 float* out) {
+  const int* axis = gmj_y_up_axis;
+  const double* sign = gmj_y_up_sign;
+  const int y_up = (flags & GMJ_TRANSFORM_Y_UP) != 0;
+  const int stride = gmj_transform_stride(layout);
+  double offset[3] = {0.0, 0.0, 0.0};
+  int i = 0;
+  int r = 0;
+  int c = 0;
+
+  if (world_offset != NULL) {
+    offset[0] = world_offset[0];
+    offset[1] = world_offset[1];
+    offset[2] = world_offset[2];
+  }
+
+  for (i = 0; i < body_count; ++i) {
+    const int body = body_ids != NULL ? body_ids[i] : i;
+    const mjtNum* pos = d->xpos + 3 * body;
+    float* dst = out + (size_t)i * (size_t)stride;
+    double p[3];
+
+    for (r = 0; r < 3; ++r) {
+      p[r] = y_up ? sign[r] * (double)pos[axis[r]] : (double)pos[r];
+      p[r] += offset[r];
+    }
+
+    if (layout == GMJ_TRANSFORM_MULTIMESH) {
+      /* Godot MultiMesh/Transform3D rows: basis row r then origin r. */
+      const mjtNum* mat = d->xmat + 9 * body;
+      for (r = 0; r < 3; ++r) {
+        for (c = 0; c < 3; ++c) {
+          const double value =
+              y_up ? sign[r] * sign[c] * (double)mat[3 * axis[r] + axis[c]]
+                   : (double)mat[3 * r + c];
+          dst[4 * r + c] = (float)value;
+        }
+        dst[4 * r + 3] = (float)p[r];
+      }
+    } else {
+      /* Godot Quaternion order is (x, y, z, w); MuJoCo stores (w, x, y, z). */
+      const mjtNum* quat = d->xquat + 4 * body;
+      dst[0] = (float)p[0];
+      dst[1] = (float)p[1];
+      dst[2] = (float)p[2];
+      for (r = 0; r < 3; ++r) {
+        dst[3 + r] = y_up ? (float)(sign[r] * (double)quat[1 + axis[r]])
+                          : (float)quat[1 + r];
+      }
+      dst[6] = (float)quat[0];
+    }
+  }
+}
+
+gmj_error_code gmj_export_body_transforms(const gmj_model* model,
+                                          const gmj_data* data,
+                                          const int* body_ids, int body_count,
+                                          const float* world_offset_xyz,
+                                          gmj_transform_layout layout,
+                                          int flags, float* out_transforms) {
+  gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  valid = gmj_validate_transform_args(model->handle, body_ids, body_count,
+                                      layout, out_transforms);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  gmj_write_transforms(data->handle, body_ids, body_count, world_offset_xyz,
+                       layout, flags, out_transforms);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+/* Render interpolation. A pose set is float32 structure-of-arrays (px py pz
+   qw qx qy qz, each padded to a multiple of 16 bodies) so a blend runs over
+   whole registers. Quaternions are slerped with Eberly's trig-free form:
+   sin(t * theta) / sin(theta) as a degree-8 polynomial in cos(theta) - 1
+   whose coefficients depend only on t, so they are computed once per call
+   (max error below 3e-5 per quaternion component, largest near 165-degree
+   rotations). */
+#define GMJ_POSE_LANES 16
+#define GMJ_SLERP_TERMS 8
+#define GMJ_SLERP_CORRECTION 1.85298109240830
+
+static int gmj_pose_stride(int nbody) {
+  return (nbody + GMJ_POSE_LANES - 1) / GMJ_POSE_LANES * GMJ_POSE_LANES;
+}
+
+static void gmj_pose_capture(const mjModel* m, const mjData* d, int stride,
+                             float* set) {
+  int i = 0;
+  int k = 0;
+  for (i = 0; i < m->nbody; ++i) {
+    for (k = 0; k < 3; ++k) {
+      set[k * stride + i] = (float)d->xpos[3 * i + k];
+    }
+    for (k = 0; k < 4; ++k) {
+      set[(3 + k) * stride + i] = (float)d->xquat[4 * i + k];
+    }
+  }
+}
+
+static void gmj_slerp_coefficients(double t, float* out) {
+  double a = t;
+  int i = 0;
+  out[0] = (float)a;
+  for (i = 1; i <= GMJ_SLERP_TERMS; ++i) {
+    a *= t * t / (double)(i * (2 * i + 1)) - (double)i / (double)(2 * i + 1);
+    out[i] = (float)a;
+  }
+  out[GMJ_SLERP_TERMS] = (float)(a * GMJ_SLERP_CORRECTION);
+}
+
+/* c0 weighs from (1 - t), c1 weighs to (t). */
+static void gmj_pose_blend_scalar(const float* from, const float* to,
+                                  int stride, float t, const float* c0,
+                                  const float* c1, float* out) {
+  int i = 0;
+  int k = 0;
+  int j = 0;
+  for (i = 0; i < stride; ++i) {
+    float dot = 0.0f;
+    float sign = 1.0f;
+    float d = 0.0f;
+    float w0 = c0[GMJ_SLERP_TERMS];
+    float w1 = c1[GMJ_SLERP_TERMS];
+
+    for (k = 0; k < 3; ++k) {
+      const float a = from[k * stride + i];
+      out[k * stride + i] = a + t * (to[k * stride + i] - a);
+    }
+    for (k = 3; k < 7; ++k) {
+      dot += from[k * stride + i] * to[k * stride + i];
+    }
+    sign = dot < 0.0f ? -1.0f : 1.0f;
+    d = dot * sign - 1.0f;
+    for (j = GMJ_SLERP_TERMS - 1; j >= 0; --j) {
+      w0 = w0 * d + c0[j];
+      w1 = w1 * d + c1[j];
+    }
+    w1 *= sign;
+    for (k = 3; k < 7; ++k) {
+      out[k * stride + i] = w0 * from[k * stride + i] + w1 * to[k * stride + i];
+    }
+  }
+}
+
+#ifdef GMJ_X86_SIMD
+GMJ_TARGET("avx2,fma")
+static void gmj_pose_blend_avx2(const float* from, const float* to,
+                                int stride, float t, const float* c0,
+                                const float* c1, float* out) {
+  const __m256 tv = _mm256_set1_ps(t);
+  const __m256 one = _mm256_set1_ps(1.0f);
+  const __m256 sign_bit = _mm256_set1_ps(-0.0f);
+  int i = 0;
+  int k = 0;
+  int j = 0;
+  for (i = 0; i < stride; i += 8) {
+    __m256 qa[4];
+    __m256 qb[4];
+    __m256 dot = _mm256_setzero_ps();
+    __m256 neg;
+    __m256 d;
+    __m256 w0 = _mm256_set1_ps(c0[GMJ_SLERP_TERMS]);
+    __m256 w1 = _mm256_set1_ps(c1[GMJ_SLERP_TERMS]);
+
+    for (k = 0; k < 3; ++k) {
+      const __m256 a = _mm256_loadu_ps(from + k * stride + i);
+      const __m256 b = _mm256_loadu_ps(to + k * stride + i);
+      _mm256_storeu_ps(out + k * stride + i,
+                       _mm256_fmadd_ps(tv, _mm256_sub_ps(b, a), a));
+    }
+    for (k = 0; k < 4; ++k) {
+      qa[k] = _mm256_loadu_ps(from + (3 + k) * stride + i);
+      qb[k] = _mm256_loadu_ps(to + (3 + k) * stride + i);
+      dot = _mm256_fmadd_ps(qa[k], qb[k], dot);
+    }
+    neg = _mm256_and_ps(dot, sign_bit);
+    d = _mm256_sub_ps(_mm256_xor_ps(dot, neg), one);
+    for (j = GMJ_SLERP_TERMS - 1; j >= 0; --j) {
+      w0 = _mm256_fmadd_ps(w0, d, _mm256_set1_ps(c0[j]));
+      w1 = _mm256_fmadd_ps(w1, d, _mm256_set1_ps(c1[j]));
+    }
+    w1 = _mm256_xor_ps(w1, neg);
+    for (k = 0; k < 4; ++k) {
+      _mm256_storeu_ps(out + (3 + k) * stride + i,
+                       _mm256_fmadd_ps(w0, qa[k], _mm256_mul_ps(w1, qb[k])));
+    }
+  }
+}
+
+GMJ_TARGET("avx512f")
+static void gmj_pose_blend_avx512(const float* from, const float* to,
+                                  int stride, float t, const float* c0,
+                                  const float* c1, float* out) {
+  const __m512 tv = _mm512_set1_ps(t);
+  const __m512 one = _mm512_set1_ps(1.0f);
+  const __m512i sign_bit = _mm512_set1_epi32((int)0x80000000u);
+  int i = 0;
+  int k = 0;
+  int j = 0;
+  for (i = 0; i < stride; i += 16) {
+    __m512 qa[4];
+    __m512 qb[4];
+    __m512 dot = _mm512_setzero_ps();
+    __m512i neg;
+    __m512 d;
+    __m512 w0 = _mm512_set1_ps(c0[GMJ_SLERP_TERMS]);
+    __m512 w1 = _mm512_set1_ps(c1[GMJ_SLERP_TERMS]);
+
+    for (k = 0; k < 3; ++k) {
+      const __m512 a = _mm512_loadu_ps(from + k * stride + i);
+      const __m512 b = _mm512_loadu_ps(to + k * stride + i);
+      _mm512_storeu_ps(out + k * stride + i,
+                       _mm512_fmadd_ps(tv, _mm512_sub_ps(b, a), a));
+    }
+    for (k = 0; k < 4; ++k) {
+      qa[k] = _mm512_loadu_ps(from + (3 + k) * stride + i);
+      qb[k] = _mm512_loadu_ps(to + (3 + k) * stride + i);
+      dot = _mm512_fmadd_ps(qa[k], qb[k], dot);
+    }
+    neg = _mm512_and_si512(_mm512_castps_si512(dot), sign_bit);
+    d = _mm512_sub_ps(
+        _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(dot), neg)),
+        one);
+    for (j = GMJ_SLERP_TERMS - 1; j >= 0; --j) {
+      w0 = _mm512_fmadd_ps(w0, d, _mm512_set1_ps(c0[j]));
+      w1 = _mm512_fmadd_ps(w1, d, _mm512_set1_ps(c1[j]));
+    }
+    w1 = _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(w1), neg));
+    for (k = 0; k < 4; ++k) {
+      _mm512_storeu_ps(out + (3 + k) * stride + i,
+                       _mm512_fmadd_ps(w0, qa[k], _mm512_mul_ps(w1, qb[k])));
+    }
+  }
+}
+#endif
+
+static void gmj_pose_blend(const float* from, const float* to, int stride,
+                           float alpha, float* out) {
+  float c0[GMJ_SLERP_TERMS + 1];
+  float c1[GMJ_SLERP_TERMS + 1];
+  const float t = alpha < 0.0f ? 0.0f : (alpha > 1.0f ? 1.0f : alpha);
+#ifdef GMJ_X86_SIMD
+  const gmj_simd_level level = gmj_simd_active();
+#endif
+
+  gmj_slerp_coefficients(1.0 - (double)t, c0);
+  gmj_slerp_coefficients((double)t, c1);
+#ifdef GMJ_X86_SIMD
+  if (level >= GMJ_SIMD_AVX512) {
+    gmj_pose_blend_avx512(from, to, stride, t, c0, c1, out);
+  } else if (level == GMJ_SIMD_AVX2) {
+    gmj_pose_blend_avx2(from, to, stride, t, c0, c1, out);
+  } else {
+    gmj_pose_blend_scalar(from, to, stride, t, c0, c1, out);
+  }
+#else
+  gmj_pose_blend_scalar(from, to, stride, t, c0, c1, out);
+#endif
+}
+
+/* Same records as gmj_write_transforms, with the basis rebuilt from the
+   blended quaternion. */
+static void gmj_pose_pack(const float* set, int stride, const int* body_ids,
+                          int body_count, const float* world_offset,
+                          gmj_transform_layout layout, int flags,
+                          float* out) {
+  const int* axis = gmj_y_up_axis;
+  const double* sign = gmj_y_up_sign;
+  const int y_up = (flags & GMJ_TRANSFORM_Y_UP) != 0;
+  const int record = gmj_transform_stride(layout);
+  int i = 0;
+  int r = 0;
+  int c = 0;
+
+  for (i = 0; i < body_count; ++i) {
+    const int body = body_ids != NULL ? body_ids[i] : i;
+    const double w = set[3 * stride + body];
+    const double x = set[4 * stride + body];
+    const double y = set[5 * stride + body];
+    const double z = set[6 * stride + body];
+    const double q[4] = {w, x, y, z};
+    float* dst = out + (size_t)i * (size_t)record;
+    double p[3];
+
+    for (r = 0; r < 3; ++r) {
+      p[r] = y_up ? sign[r] * (double)set[axis[r] * stride + body]
+                  : (double)set[r * stride + body];
+      p[r] += world_offset != NULL ? (double)world_offset[r] : 0.0;
+    }
+
+    if (layout == GMJ_TRANSFORM_MULTIMESH) {
+      const double mat[9] = {
+          1.0 - 2.0 * (y * y + z * z), 2.0 * (x * y - w * z),
+          2.0 * (x * z + w * y),       2.0 * (x * y + w * z),
+          1.0 - 2.0 * (x * x + z * z), 2.0 * (y * z - w * x),
+          2.0 * (x * z - w * y),       2.0 * (y * z + w * x),
+          1.0 - 2.0 * (x * x + y * y)};
+      for (r = 0; r < 3; ++r) {
+        for (c = 0; c < 3; ++c) {
+          dst[4 * r + c] =
+              (float)(y_up ? sign[r] * sign[c] * mat[3 * axis[r] + axis[c]]
+                           : mat[3 * r + c]);
+        }
+        dst[4 * r + 3] = (float)p[r];
+      }
+    } else {
+      dst[0] = (float)p[0];
+      dst[1] = (float)p[1];
+      dst[2] = (float)p[2];
+      for (r = 0; r < 3; ++r) {
+        dst[3 + r] = (float)(y_up ? sign[r] * q[1 + axis[r]] : q[1 + r]);
+      }
+      dst[6] = (float)w;
+    }
+  }
+}
+
+struct gmj_pose_buffer {
+  const gmj_model* model;
+  int stride;
+  int count;
+  float* sets;
+  float* previous;
+  float* current;
+  float* blended;
+};
+
+gmj_pose_buffer* gmj_pose_buffer_create(const gmj_model* model) {
+  gmj_pose_buffer* buffer = NULL;
+  size_t set_size = 0;
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("model is null");
+    return NULL;
+  }
+
+  buffer = (gmj_pose_buffer*)calloc(1, sizeof(gmj_pose_buffer));
+  if (buffer == NULL) {
+    gmj_set_error("failed to allocate gmj_pose_buffer");
+    return NULL;
+  }
+  buffer->model = model;
+  buffer->stride = gmj_pose_stride(model->handle->nbody);
+  set_size = 7 * (size_t)buffer->stride;
+  /* One block for the three sets; the padding lanes stay zero. */
+  buffer->sets = (float*)calloc(3 * set_size, sizeof(float));
+  if (buffer->sets == NULL) {
+    free(buffer);
+    gmj_set_error("failed to allocate pose sets");
+    return NULL;
+  }
+  buffer->previous = buffer->sets;
+  buffer->current = buffer->sets + set_size;
+  buffer->blended = buffer->current + set_size;
+  gmj_set_error(NULL);
+  return buffer;
+}
+
+void gmj_pose_buffer_free(gmj_pose_buffer* buffer) {
+  if (buffer == NULL) {
+    return;
+  }
+  free(buffer->sets);
+  free(buffer);
+}
+
+gmj_error_code gmj_pose_buffer_push(gmj_pose_buffer* buffer,
+                                    const gmj_data* data) {
+  float* oldest = NULL;
+  gmj_error_code valid = GMJ_OK;
+  if (buffer == NULL) {
+    gmj_set_error("pose buffer is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  valid = gmj_validate_ptrs(buffer->model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  oldest = buffer->previous;
+  buffer->previous = buffer->current;
+  buffer->current = oldest;
+  gmj_pose_capture(buffer->model->handle, data->handle, buffer->stride,
+                   buffer->current);
+  if (buffer->count == 0) {
+    memcpy(buffer->previous, buffer->current,
+           7 * (size_t)buffer->stride * sizeof(float));
+  }
+  buffer->count += buffer->count < 2 ? 1 : 0;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_pose_buffer_interpolate(gmj_pose_buffer* buffer,
+                                           float alpha, const int* body_ids,
+                                           int body_count,
+                                           const float* world_offset_xyz,
+                                           gmj_transform_layout layout,
+                                           int flags, float* out_transforms) {
+  gmj_error_code valid = GMJ_OK;
+  if (buffer == NULL) {
+    gmj_set_error("pose buffer is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (buffer->count == 0) {
+    gmj_set_error("no poses pushed yet");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  valid = gmj_validate_transform_args(buffer->model->handle, body_ids,
+                                      body_count, layout, out_transforms);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  gmj_pose_blend(buffer->previous, buffer->current, buffer->stride, alpha,
+                 buffer->blended);
+  gmj_pose_pack(buffer->blended, buffer->stride, body_ids, body_count,
+                world_offset_xyz, layout, flags, out_transforms);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+/* Contact export. The body set is a per-body byte mask so the per-contact
+   test is two loads regardless of how many bodies were added. */
+struct gmj_contact_filter {
+  const gmj_model* model;
+  unsigned char* body_mask;
+  int body_count;
+  double min_normal_force;
+};
+
+gmj_contact_filter* gmj_contact_filter_create(const gmj_model* model) {
+  gmj_contact_filter* filter = NULL;
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("model is null");
+    return NULL;
+  }
+
+  filter = (gmj_contact_filter*)calloc(1, sizeof(gmj_contact_filter));
+  if (filter == NULL) {
+    gmj_set_error("failed to allocate gmj_contact_filter");
+    return NULL;
+  }
+  filter->body_mask = (unsigned char*)calloc(
+      (size_t)(model->handle->nbody > 0 ? model->handle->nbody : 1), 1);
+  if (filter->body_mask == NULL) {
+    free(filter);
+    gmj_set_error("failed to allocate contact body mask");
+    return NULL;
+  }
+
+  filter->model = model;
+  gmj_set_error(NULL);
+  return filter;
+}
+
+void gmj_contact_filter_free(gmj_contact_filter* filter) {
+  if (filter == NULL) {
+    return;
+  }
+  free(filter->body_mask);
+  free(filter);
+}
+
+gmj_error_code gmj_contact_filter_add_body(gmj_contact_filter* filter,
+                                           int body_id) {
+  if (filter == NULL) {
+    gmj_set_error("filter is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (body_id < 0 || body_id >= filter->model->handle->nbody) {
+    gmj_set_error("body id out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+
+  if (!filter->body_mask[body_id]) {
+    filter->body_mask[body_id] = 1;
+    filter->body_count++;
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_contact_filter_set_min_force(gmj_contact_filter* filter,
+                                                double min_normal_force) {
+  if (filter == NULL) {
+    gmj_set_error("filter is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  filter->min_normal_force = min_normal_force;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+static gmj_error_code gmj_validate_contact_args(
+    const mjModel* m, const gmj_contact_filter* filter,
+    const gmj_contact* out, int capacity) {
+  if (filter != NULL && filter->model->handle != m) {
+    gmj_set_error("filter was built for a different model");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (capacity < 0 || (capacity > 0 && out == NULL)) {
+    gmj_set_error("contact buffer is null or capacity is negative");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  return GMJ_OK;
+}
+
+/* Returns the number of matching contacts; only the first capacity are
+   written. Forces are only computed for contacts that pass the body test
+   and, without a force threshold, only for the ones that fit. */
+static int gmj_write_contacts(const mjModel* m, const mjData* d,
+                              const gmj_contact_filter* filter, int flags,
+                              gmj_contact* out, int capacity) {
+  const int* axis = gmj_y_up_axis;
+  const double* sign = gmj_y_up_sign;
+  const int y_up = (flags & GMJ_TRANSFORM_Y_UP) != 0;
+  const unsigned char* mask =
+      filter != NULL && filter->body_count > 0 ? filter->body_mask : NULL;
+  const double min_force = filter != NULL ? filter->min_normal_force : 0.0;
+  const int thresholded = filter != NULL && filter->min_normal_force > 0.0;
+  int matched = 0;
+  int i = 0;
+  int k = 0;
+
+  for (i = 0; i < d->ncon; ++i) {
+    const mjContact* con = d->contact + i;
+    const int geom1 = con->geom[0];
+    const int geom2 = con->geom[1];
+    const int body1 = geom1 >= 0 ? m->geom_bodyid[geom1] : -1;
+    const int body2 = geom2 >= 0 ? m->geom_bodyid[geom2] : -1;
+    mjtNum force[6] = {0, 0, 0, 0, 0, 0};
+    gmj_contact* dst = NULL;
+
+    if (mask != NULL && !(body1 >= 0 && mask[body1]) &&
+        !(body2 >= 0 && mask[body2])) {
+      continue;
+    }
+    if (!thresholded && matched >= capacity) {
+      matched++;
+      continue;
+    }
+    mj_contactForce(m, d, i, force);
+    if (thresholded && (double)force[0] < min_force) {
+      continue;
+    }
+    if (matched >= capacity) {
+      matched++;
+      continue;
+    }
+
+    dst = out + matched++;
+    dst->geom1 = geom1;
+    dst->geom2 = geom2;
+    dst->body1 = body1;
+    dst->body2 = body2;
+    for (k = 0; k < 3; ++k) {
+      const int a = y_up ? axis[k] : k;
+      const double s = y_up ? sign[k] : 1.0;
+      dst->pos[k] = (float)(s * (double)con->pos[a]);
+      dst->normal[k] = (float)(s * (double)con->frame[a]);
+      dst->force[k] = (float)force[k];
+    }
+    dst->penetration = con->dist < 0 ? (float)-con->dist : 0.0f;
+  }
+  return matched;
+}
+
+gmj_error_code gmj_export_contacts(const gmj_model* model,
+                                   const gmj_data* data,
+                                   const gmj_contact_filter* filter, int flags,
+                                   gmj_contact* out_contacts, int capacity,
+                                   int* out_count) {
+  gmj_error_code valid = gmj_validate_ptrs(model, data);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (out_count == NULL) {
+    gmj_set_error("out_count is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  valid = gmj_validate_contact_args(model->handle, filter, out_contacts,
+                                    capacity);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  *out_count = gmj_write_contacts(model->handle, data->handle, filter, flags,
+                                  out_contacts, capacity);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+/* Ray sets. Fans keep their origin and unit directions in the frame body's
+   coordinates; a cast rotates them into world axes on the data's stack and
+   hands each fan to mj_multiRay, which culls geoms by bounding sphere once
+   per origin instead of once per ray. */
+typedef struct gmj_ray_fan {
+  int body_id;
+  int exclude_body_id;
+  int start;
+  int count;
+  mjtNum origin[3];
+} gmj_ray_fan;
+
+struct gmj_ray_set {
+  const gmj_model* model;
+  gmj_ray_fan* fans;
+  int fan_count;
+  int fan_capacity;
+  mjtNum* directions;
+  int size;
+  int direction_capacity;
+  int max_fan;
+  mjtByte geomgroup[mjNGROUP];
+  int all_groups;
+  mjtByte include_static;
+  mjtNum max_distance;
+};
+
+gmj_ray_set* gmj_ray_set_create(const gmj_model* model) {
+  gmj_ray_set* set = NULL;
+  int g = 0;
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("model is null");
+    return NULL;
+  }
+
+  set = (gmj_ray_set*)calloc(1, sizeof(gmj_ray_set));
+  if (set == NULL) {
+    gmj_set_error("failed to allocate gmj_ray_set");
+    return NULL;
+  }
+
+  set->model = model;
+  for (g = 0; g < mjNGROUP; ++g) {
+    set->geomgroup[g] = 1;
+  }
+  set->all_groups = 1;
+  set->include_static = 1;
+  set->max_distance = mjMAXVAL;
+  gmj_set_error(NULL);
+  return set;
+}
+
+void gmj_ray_set_free(gmj_ray_set* set) {
+  if (set == NULL) {
+    return;
+  }
+  free(set->fans);
+  free(set->directions);
+  free(set);
+}
+
+int gmj_ray_set_size(const gmj_ray_set* set) {
+  if (set == NULL) {
+    gmj_set_error("ray set is null");
+    return -1;
+  }
+  return set->size;
+}
+
+gmj_error_code gmj_ray_set_add(gmj_ray_set* set, int frame_body_id,
+                               int exclude_body_id, const double* origin_xyz,
+                               const double* directions_xyz, int count) {
+  const mjModel* m = NULL;
+  gmj_ray_fan* fan = NULL;
+  int i = 0;
+  int k = 0;
+  if (set == NULL || origin_xyz == NULL || directions_xyz == NULL) {
+    gmj_set_error("invalid ray set, origin or directions pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  m = set->model->handle;
+  if (frame_body_id < 0 || frame_body_id >= m->nbody ||
+      exclude_body_id < -1 || exclude_body_id >= m->nbody) {
+    gmj_set_error("body id out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+  if (count < 1) {
+    gmj_set_error("count must be >= 1");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  for (i = 0; i < count; ++i) {
+    const double* v = directions_xyz + 3 * i;
+    if (v[0] * v[0] + v[1] * v[1] + v[2] * v[2] < 1e-12) {
+      gmj_set_error("ray direction has zero length");
+      return GMJ_ERR_INVALID_ARGUMENT;
+    }
+  }
+
+  if (set->fan_count == set->fan_capacity) {
+    const int capacity = set->fan_capacity > 0 ? 2 * set->fan_capacity : 8;
+    gmj_ray_fan* fans = (gmj_ray_fan*)realloc(
+        set->fans, (size_t)capacity * sizeof(gmj_ray_fan));
+    if (fans == NULL) {
+      gmj_set_error("failed to grow ray set");
+      return GMJ_ERR_ALLOCATION;
+    }
+    set->fans = fans;
+    set->fan_capacity = capacity;
+  }
+  if (set->size + count > set->direction_capacity) {
+    int capacity = set->direction_capacity > 0 ? set->direction_capacity : 64;
+    mjtNum* directions = NULL;
+    while (capacity < set->size + count) {
+      capacity *= 2;
+    }
+    directions = (mjtNum*)realloc(set->directions,
+                                  3 * (size_t)capacity * sizeof(mjtNum));
+    if (directions == NULL) {
+      gmj_set_error("failed to grow ray set");
+      return GMJ_ERR_ALLOCATION;
+    }
+    set->directions = directions;
+    set->direction_capacity = capacity;
+  }
+
+  fan = &set->fans[set->fan_count++];
+  fan->body_id = frame_body_id;
+  fan->exclude_body_id = exclude_body_id;
+  fan->start = set->size;
+  fan->count = count;
+  for (k = 0; k < 3; ++k) {
+    fan->origin[k] = (mjtNum)origin_xyz[k];
+  }
+  for (i = 0; i < count; ++i) {
+    const double* v = directions_xyz + 3 * i;
+    const double length = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    for (k = 0; k < 3; ++k) {
+      set->directions[3 * (set->size + i) + k] = (mjtNum)(v[k] / length);
+    }
+  }
+  set->size += count;
+  if (count > set->max_fan) {
+    set->max_fan = count;
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_ray_set_filter(gmj_ray_set* set, int group_mask,
+                                  int include_static) {
+  const int all = (1 << mjNGROUP) - 1;
+  int g = 0;
+  if (set == NULL) {
+    gmj_set_error("ray set is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  for (g = 0; g < mjNGROUP; ++g) {
+    set->geomgroup[g] = (mjtByte)((group_mask >> g) & 1);
+  }
+  set->all_groups = (group_mask & all) == all;
+  set->include_static = (mjtByte)(include_static != 0);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_ray_set_max_distance(gmj_ray_set* set,
+                                        double max_distance) {
+  if (set == NULL) {
+    gmj_set_error("ray set is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (!(max_distance > 0.0)) {
+    gmj_set_error("max_distance must be > 0");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  set->max_distance =
+      max_distance < mjMAXVAL ? (mjtNum)max_distance : (mjtNum)mjMAXVAL;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+/* One of out_f64 and out_f32 is set. */
+static void gmj_cast_rays(const gmj_ray_set* set, mjData* d, double* out_f64,
+                          float* out_f32, int* out_ids,
+                          gmj_simd_level level) {
+  const mjModel* m = set->model->handle;
+  const mjtByte* groups = set->all_groups ? NULL : set->geomgroup;
+  mjtNum* world = NULL;
+  mjtNum* dist = NULL;
+  int* ids = NULL;
+  int f = 0;
+  int i = 0;
+  int r = 0;
+
+  if (set->size == 0) {
+    return;
+  }
+  mj_markStack(d);
+  world = mj_stackAllocNum(d, 3 * (size_t)set->max_fan);
+  if (out_f32 != NULL) {
+    dist = mj_stackAllocNum(d, (size_t)set->max_fan);
+  }
+  if (out_ids == NULL) {
+    ids = mj_stackAllocInt(d, (size_t)set->max_fan);
+  }
+
+  for (f = 0; f < set->fan_count; ++f) {
+    const gmj_ray_fan* fan = &set->fans[f];
+    const mjtNum* dirs = set->directions + 3 * fan->start;
+    mjtNum pnt[3];
+    mjtNum* fan_dist = out_f32 != NULL ? dist : out_f64 + fan->start;
+    int* fan_ids = out_ids != NULL ? out_ids + fan->start : ids;
+
+    if (fan->body_id == 0) {
+      pnt[0] = fan->origin[0];
+      pnt[1] = fan->origin[1];
+      pnt[2] = fan->origin[2];
+    } else {
+      const mjtNum* pos = d->xpos + 3 * fan->body_id;
+      const mjtNum* mat = d->xmat + 9 * fan->body_id;
+      for (r = 0; r < 3; ++r) {
+        pnt[r] = pos[r] + mat[3 * r] * fan->origin[0] +
+                 mat[3 * r + 1] * fan->origin[1] +
+                 mat[3 * r + 2] * fan->origin[2];
+      }
+      for (i = 0; i < fan->count; ++i) {
+        const mjtNum* v = dirs + 3 * i;
+        for (r = 0; r < 3; ++r) {
+          world[3 * i + r] = mat[3 * r] * v[0] + mat[3 * r + 1] * v[1] +
+                             mat[3 * r + 2] * v[2];
+        }
+      }
+      dirs = world;
+    }
+
+    mj_multiRay(m, d, pnt, dirs, groups, set->include_static,
+                fan->exclude_body_id, fan_ids, fan_dist, fan->count,
+                set->max_distance);
+    if (out_f32 != NULL) {
+      gmj_store_f32(out_f32 + fan->start, dist, fan->count, level);
+    }
+  }
+  mj_freeStack(d);
+}
+
+static gmj_error_code gmj_raycast_run(const gmj_ray_set* set, gmj_data* data,
+                                      double* out_f64, float* out_f32,
+                                      int* out_ids) {
+  if (set == NULL || data == NULL || data->handle == NULL ||
+      (out_f64 == NULL && out_f32 == NULL)) {
+    gmj_set_error("invalid ray set, data or out_distances pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  gmj_cast_rays(set, data->handle, out_f64, out_f32, out_ids,
+                gmj_simd_active());
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_raycast(const gmj_ray_set* set, gmj_data* data,
+                           double* out_distances, int* out_geom_ids) {
+  return gmj_raycast_run(set, data, out_distances, NULL, out_geom_ids);
+}
+
+gmj_error_code gmj_raycast_f32(const gmj_ray_set* set, gmj_data* data,
+                               float* out_distances, int* out_geom_ids) {
+  return gmj_raycast_run(set, data, NULL, out_distances, out_geom_ids);
+}
+
+/* Observation specs are compiled into a flat gather plan as terms are
+   added: adjacent ranges of the same array collapse into one copy op, so a
+   fill is a short loop of memcpy-sized copies plus the body-relative ops. */
+typedef struct gmj_obs_op {
+  gmj_obs_source source;
+  int start;
+  int count;
+  int body_id;
+  int root_body_id;
+} gmj_obs_op;
+
+struct gmj_obs_spec {
+  const gmj_model* model;
+  gmj_obs_op* ops;
+  int op_count;
+  int op_capacity;
+  int size;
+};
+
+gmj_obs_spec* gmj_obs_spec_create(const gmj_model* model) {
+  gmj_obs_spec* spec = NULL;
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("model is null");
+    return NULL;
+  }
+
+  spec = (gmj_obs_spec*)calloc(1, sizeof(gmj_obs_spec));
+  if (spec == NULL) {
+    gmj_set_error("failed to allocate gmj_obs_spec");
+    return NULL;
+  }
+
+  spec->model = model;
+  gmj_set_error(NULL);
+  return spec;
+}
+
+void gmj_obs_spec_free(gmj_obs_spec* spec) {
+  if (spec == NULL) {
+    return;
+  }
+  free(spec->ops);
+  free(spec);
+}
+
+int gmj_obs_spec_size(const gmj_obs_spec* spec) {
+  if (spec == NULL) {
+    gmj_set_error("spec is null");
+    return -1;
+  }
+  return spec->size;
+}
+
+static gmj_error_code gmj_obs_spec_push(gmj_obs_spec* spec,
+                                        const gmj_obs_op* op, int width) {
+  if (spec->op_count > 0) {
+    gmj_obs_op* last = &spec->ops[spec->op_count - 1];
+    if (width == 0 && last->source == op->source &&
+        last->start + last->count == op->start) {
+      last->count += op->count;
+      spec->size += op->count;
+      gmj_set_error(NULL);
+      return GMJ_OK;
+    }
+  }
+
+  if (spec->op_count == spec->op_capacity) {
+    const int capacity = spec->op_capacity > 0 ? 2 * spec->op_capacity : 8;
+    gmj_obs_op* ops =
+        (gmj_obs_op*)realloc(spec->ops, (size_t)capacity * sizeof(gmj_obs_op));
+    if (ops == NULL) {
+      gmj_set_error("failed to grow observation plan");
+      return GMJ_ERR_ALLOCATION;
+    }
+    spec->ops = ops;
+    spec->op_capacity = capacity;
+  }
+
+  spec->ops[spec->op_count] = *op;
+  spec->op_count += 1;
+  spec->size += width > 0 ? width : op->count;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_obs_spec_add_range(gmj_obs_spec* spec,
+                                      gmj_obs_source source, int start_index,
+                                      int count) {
+  gmj_obs_op op;
+  const mjModel* m = NULL;
+  int length = 0;
+  gmj_error_code valid = GMJ_OK;
+  if (spec == NULL || spec->model == NULL || spec->model->handle == NULL) {
+    gmj_set_error("invalid spec pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  m = spec->model->handle;
+  switch (source) {
+    case GMJ_OBS_QPOS:
+      length = m->nq;
+      break;
+    case GMJ_OBS_QVEL:
+      length = m->nv;
+      break;
+    case GMJ_OBS_SENSORDATA:
+      length = m->nsensordata;
+      break;
+    case GMJ_OBS_PREV_ACTION:
+      length = m->nu;
+      break;
+    default:
+      gmj_set_error("source is not a range source");
+      return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  valid = gmj_validate_slice(start_index, count, length);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (count == 0) {
+    gmj_set_error(NULL);
+    return GMJ_OK;
+  }
+
+  memset(&op, 0, sizeof(op));
+  op.source = source;
+  op.start = start_index;
+  op.count = count;
+  return gmj_obs_spec_push(spec, &op, 0);
+}
+
+gmj_error_code gmj_obs_spec_add_body(gmj_obs_spec* spec,
+                                     gmj_obs_source source, int body_id,
+                                     int root_body_id) {
+  gmj_obs_op op;
+  const mjModel* m = NULL;
+  if (spec == NULL || spec->model == NULL || spec->model->handle == NULL) {
+    gmj_set_error("invalid spec pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (source != GMJ_OBS_BODY_POS_REL && source != GMJ_OBS_BODY_POS_LOCAL) {
+    gmj_set_error("source is not a body source");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  m = spec->model->handle;
+  if (body_id < 0 || body_id >= m->nbody || root_body_id < 0 ||
+      root_body_id >= m->nbody) {
+    gmj_set_error("body id out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+
+  memset(&op, 0, sizeof(op));
+  op.source = source;
+  op.count = 3;
+  op.body_id = body_id;
+  op.root_body_id = root_body_id;
+  return gmj_obs_spec_push(spec, &op, 3);
+}
+
+static const mjtNum* gmj_obs_range_base(const mjData* d,
+                                        gmj_obs_source source) {
+  switch (source) {
+    case GMJ_OBS_QPOS:
+      return d->qpos;
+    case GMJ_OBS_QVEL:
+      return d->qvel;
+    case GMJ_OBS_SENSORDATA:
+      return d->sensordata;
+    case GMJ_OBS_PREV_ACTION:
+      return d->ctrl;
+    default:
+      return NULL;
+  }
+}
+
+static void gmj_obs_body_delta(const mjData* d, const gmj_obs_op* op,
+                               double out_xyz[3]) {
+  const mjtNum* pos = d->xpos + 3 * op->body_id;
+  const mjtNum* root = d->xpos + 3 * op->root_body_id;
+  const double delta[3] = {(double)(pos[0] - root[0]),
+                           (double)(pos[1] - root[1]),
+                           (double)(pos[2] - root[2])};
+  if (op->source == GMJ_OBS_BODY_POS_LOCAL) {
+    /* xmat is row-major body-to-world; its transpose maps into the root
+       frame. */
+    const mjtNum* mat = d->xmat + 9 * op->root_body_id;
+    int r = 0;
+    for (r = 0; r < 3; ++r) {
+      out_xyz[r] = (double)mat[r] * delta[0] + (double)mat[3 + r] * delta[1] +
+                   (double)mat[6 + r] * delta[2];
+    }
+  } else {
+    out_xyz[0] = delta[0];
+    out_xyz[1] = delta[1];
+    out_xyz[2] = delta[2];
+  }
+}
+
+static void gmj_obs_gather_f64(const gmj_obs_spec* spec, const mjData* d,
+                               double* out) {
+  int i = 0;
+  for (i = 0; i < spec->op_count; ++i) {
+    const gmj_obs_op* op = &spec->ops[i];
+    if (op->source == GMJ_OBS_BODY_POS_REL ||
+        op->source == GMJ_OBS_BODY_POS_LOCAL) {
+      gmj_obs_body_delta(d, op, out);
+    } else {
+      gmj_copy_from_mjtnum(out, gmj_obs_range_base(d, op->source) + op->start,
+                           op->count);
+    }
+    out += op->count;
+  }
+}
+
+static void gmj_obs_gather_f32(const gmj_obs_spec* spec, const mjData* d,
+                               gmj_simd_level level, float* out) {
+  int i = 0;
+  for (i = 0; i < spec->op_count; ++i) {
+    const gmj_obs_op* op = &spec->ops[i];
+    if (op->source == GMJ_OBS_BODY_POS_REL ||
+        op->source == GMJ_OBS_BODY_POS_LOCAL) {
+      double delta[3];
+      gmj_obs_body_delta(d, op, delta);
+      out[0] = (float)delta[0];
+      out[1] = (float)delta[1];
+      out[2] = (float)delta[2];
+    } else {
+      gmj_store_f32(out, gmj_obs_range_base(d, op->source) + op->start,
+                    op->count, level);
+    }
+    out += op->count;
+  }
+}
+
+gmj_error_code gmj_obs_fill(const gmj_obs_spec* spec, const gmj_data* data,
+                            double* out_values) {
+  if (spec == NULL || data == NULL || data->handle == NULL ||
+      out_values == NULL) {
+    gmj_set_error("invalid spec, data or out_values pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  gmj_obs_gather_f64(spec, data->handle, out_values);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_obs_fill_f32(const gmj_obs_spec* spec, const gmj_data* data,
+                                float* out_values) {
+  if (spec == NULL || data == NULL || data->handle == NULL ||
+      out_values == NULL) {
+    gmj_set_error("invalid spec, data or out_values pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  gmj_obs_gather_f32(spec, data->handle, gmj_simd_active(), out_values);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+/* Sensor maps are observation specs made only of sensordata ranges, plus
+   the (sensor id, offset) pairs needed to find a sensor in the output. */
+typedef struct gmj_sensor_binding {
+  int sensor_id;
+  int offset;
+} gmj_sensor_binding;
+
+struct gmj_sensor_map {
+  gmj_obs_spec* spec;
+  gmj_sensor_binding* bindings;
+  int count;
+  int capacity;
+};
+
+gmj_sensor_map* gmj_sensor_map_create(const gmj_model* model) {
+  gmj_sensor_map* map = NULL;
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("model is null");
+    return NULL;
+  }
+
+  map = (gmj_sensor_map*)calloc(1, sizeof(gmj_sensor_map));
+  if (map == NULL) {
+    gmj_set_error("failed to allocate gmj_sensor_map");
+    return NULL;
+  }
+  map->spec = gmj_obs_spec_create(model);
+  if (map->spec == NULL) {
+    free(map);
+    return NULL;
+  }
+
+  gmj_set_error(NULL);
+  return map;
+}
+
+void gmj_sensor_map_free(gmj_sensor_map* map) {
+  if (map == NULL) {
+    return;
+  }
+  gmj_obs_spec_free(map->spec);
+  free(map->bindings);
+  free(map);
+}
+
+int gmj_sensor_map_size(const gmj_sensor_map* map) {
+  if (map == NULL) {
+    gmj_set_error("map is null");
+    return -1;
+  }
+  return map->spec->size;
+}
+
+gmj_error_code gmj_sensor_map_add_id(gmj_sensor_map* map, int sensor_id,
+                                     int* out_offset) {
+  const mjModel* m = NULL;
+  int offset = 0;
+  gmj_error_code valid = GMJ_OK;
+  if (map == NULL) {
+    gmj_set_error("map is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  m = map->spec->model->handle;
+  offset = map->spec->size;
+  if (sensor_id < 0 || sensor_id >= m->nsensor) {
+    gmj_set_error("sensor_id out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+
+  if (map->count == map->capacity) {
+    const int capacity = map->capacity > 0 ? 2 * map->capacity : 8;
+    gmj_sensor_binding* bindings = (gmj_sensor_binding*)realloc(
+        map->bindings, (size_t)capacity * sizeof(gmj_sensor_binding));
+    if (bindings == NULL) {
+      gmj_set_error("failed to grow sensor map");
+      return GMJ_ERR_ALLOCATION;
+    }
+    map->bindings = bindings;
+    map->capacity = capacity;
+  }
+
+  valid = gmj_obs_spec_add_range(map->spec, GMJ_OBS_SENSORDATA,
+                                 m->sensor_adr[sensor_id],
+                                 m->sensor_dim[sensor_id]);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  map->bindings[map->count].sensor_id = sensor_id;
+  map->bindings[map->count].offset = offset;
+  map->count++;
+  if (out_offset != NULL) {
+    *out_offset = offset;
+  }
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_sensor_map_add(gmj_sensor_map* map,
+                                  const char* sensor_name, int* out_offset) {
+  int id = -1;
+  if (map == NULL) {
+    gmj_set_error("map is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  id = gmj_sensor_id(map->spec->model, sensor_name);
+  if (id < 0) {
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  return gmj_sensor_map_add_id(map, id, out_offset);
+}
+
+gmj_error_code gmj_sensor_map_add_all(gmj_sensor_map* map) {
+  gmj_error_code valid = GMJ_OK;
+  int i = 0;
+  if (map == NULL) {
+    gmj_set_error("map is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  for (i = 0; i < map->spec->model->handle->nsensor; ++i) {
+    valid = gmj_sensor_map_add_id(map, i, NULL);
+    if (valid != GMJ_OK) {
+      return valid;
+    }
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+int gmj_sensor_map_offset(const gmj_sensor_map* map, int sensor_id) {
+  int i = 0;
+  if (map == NULL) {
+    gmj_set_error("map is null");
+    return -1;
+  }
+  for (i = 0; i < map->count; ++i) {
+    if (map->bindings[i].sensor_id == sensor_id) {
+      return map->bindings[i].offset;
+    }
+  }
+  return -1;
+}
+
+gmj_error_code gmj_sensor_read(const gmj_sensor_map* map, const gmj_data* data,
+                               double* out_values) {
+  if (map == NULL) {
+    gmj_set_error("map is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  return gmj_obs_fill(map->spec, data, out_values);
+}
+
+gmj_error_code gmj_sensor_read_f32(const gmj_sensor_map* map,
+                                   const gmj_data* data, float* out_values) {
+  if (map == NULL) {
+    gmj_set_error("map is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  return gmj_obs_fill_f32(map->spec, data, out_values);
+}
+
+/* Command lists. Each command carries everything it needs, resolved while
+   recording, so gmj_execute is a switch over a flat array. */
+typedef enum gmj_cmd_kind {
+  GMJ_CMD_SET_CTRL = 0,
+  GMJ_CMD_STEP = 1,
+  GMJ_CMD_COPY = 2,
+  GMJ_CMD_EXPORT = 3
+} gmj_cmd_kind;
+
+typedef struct gmj_cmd {
+  gmj_cmd_kind kind;
+  gmj_state_field field;
+  int start;
+  int count;
+  const double* values;
+  double* out_values;
+  int* body_ids;
+  float world_offset[3];
+  int has_offset;
+  gmj_transform_layout layout;
+  int flags;
+  float* out_transforms;
+} gmj_cmd;
+
+struct gmj_cmd_list {
+  const gmj_model* model;
+  gmj_cmd* cmds;
+  int count;
+  int capacity;
+};
+
+gmj_cmd_list* gmj_cmd_list_create(const gmj_model* model) {
+  gmj_cmd_list* list = NULL;
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("model is null");
+    return NULL;
+  }
+
+  list = (gmj_cmd_list*)calloc(1, sizeof(gmj_cmd_list));
+  if (list == NULL) {
+    gmj_set_error("failed to allocate gmj_cmd_list");
+    return NULL;
+  }
+
+  list->model = model;
+  gmj_set_error(NULL);
+  return list;
+}
+
+void gmj_cmd_list_clear(gmj_cmd_list* list) {
+  int i = 0;
+  if (list == NULL) {
+    return;
+  }
+  for (i = 0; i < list->count; ++i) {
+    free(list->cmds[i].body_ids);
+  }
+  list->count = 0;
+}
+
+void gmj_cmd_list_free(gmj_cmd_list* list) {
+  if (list == NULL) {
+    return;
+  }
+  gmj_cmd_list_clear(list);
+  free(list->cmds);
+  free(list);
+}
+
+int gmj_cmd_list_size(const gmj_cmd_list* list) {
+  if (list == NULL) {
+    gmj_set_error("list is null");
+    return -1;
+  }
+  return list->count;
+}
+
+/* Returns the zeroed slot for the next command; it only counts once the
+   caller bumps list->count. */
+static gmj_cmd* gmj_cmd_reserve(gmj_cmd_list* list) {
+  gmj_cmd* cmd = NULL;
+  if (list->count == list->capacity) {
+    const int capacity = list->capacity > 0 ? 2 * list->capacity : 8;
+    gmj_cmd* cmds =
+        (gmj_cmd*)realloc(list->cmds, (size_t)capacity * sizeof(gmj_cmd));
+    if (cmds == NULL) {
+      gmj_set_error("failed to grow command list");
+      return NULL;
+    }
+    list->cmds = cmds;
+    list->capacity = capacity;
+  }
+  cmd = &list->cmds[list->count];
+  memset(cmd, 0, sizeof(*cmd));
+  return cmd;
+}
+
+gmj_error_code gmj_cmd_set_ctrl(gmj_cmd_list* list, int start_index,
+                                int count, const double* values) {
+  gmj_cmd* cmd = NULL;
+  gmj_error_code valid = GMJ_OK;
+  if (list == NULL || values == NULL) {
+    gmj_set_error("invalid list or values pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  valid = gmj_validate_slice(start_index, count, list->model->handle->nu);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  if (count == 0) {
+    gmj_set_error(NULL);
+    return GMJ_OK;
+  }
+
+  cmd = gmj_cmd_reserve(list);
+  if (cmd == NULL) {
+    return GMJ_ERR_ALLOCATION;
+  }
+  cmd->kind = GMJ_CMD_SET_CTRL;
+  cmd->start = start_index;
+  cmd->count = count;
+  cmd->values = values;
+  list->count += 1;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_cmd_step(gmj_cmd_list* list, int steps) {
+  gmj_cmd* cmd = NULL;
+  if (list == NULL) {
+    gmj_set_error("list is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (steps < 1) {
+    gmj_set_error("steps must be >= 1");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  cmd = gmj_cmd_reserve(list);
+  if (cmd == NULL) {
+    return GMJ_ERR_ALLOCATION;
+  }
+  cmd->kind = GMJ_CMD_STEP;
+  cmd->count = steps;
+  list->count += 1;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_cmd_copy(gmj_cmd_list* list, gmj_state_field field,
+                            int start_index, int count, double* out_values) {
+  gmj_cmd* cmd = NULL;
+  gmj_error_code valid = GMJ_OK;
+  int length = 0;
+  int width = 0;
+  if (list == NULL || out_values == NULL) {
+    gmj_set_error("invalid list or out_values pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (!gmj_field_lookup(list->model->handle, NULL, field, NULL, &length,
+                        &width)) {
+    gmj_set_error("unknown state field");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  valid = gmj_validate_slice(start_index, count, length);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  if (count == 0) {
+    gmj_set_error(NULL);
+    return GMJ_OK;
+  }
+
+  cmd = gmj_cmd_reserve(list);
+  if (cmd == NULL) {
+    return GMJ_ERR_ALLOCATION;
+  }
+  cmd->kind = GMJ_CMD_COPY;
+  cmd->field = field;
+  cmd->start = start_index;
+  cmd->count = count;
+  cmd->out_values = out_values;
+  list->count += 1;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_cmd_export_transforms(gmj_cmd_list* list,
+                                         const int* body_ids, int body_count,
+                                         const float* world_offset_xyz,
+                                         gmj_transform_layout layout,
+                                         int flags, float* out_transforms) {
+  gmj_cmd* cmd = NULL;
+  int* ids = NULL;
+  gmj_error_code valid = GMJ_OK;
+  if (list == NULL) {
+    gmj_set_error("list is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  valid = gmj_validate_transform_args(list->model->handle, body_ids,
+                                      body_count, layout, out_transforms);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  if (body_ids != NULL && body_count > 0) {
+    ids = (int*)malloc((size_t)body_count * sizeof(int));
+    if (ids == NULL) {
+      gmj_set_error("failed to copy body ids");
+      return GMJ_ERR_ALLOCATION;
+    }
+    memcpy(ids, body_ids, (size_t)body_count * sizeof(int));
+  }
+  cmd = gmj_cmd_reserve(list);
+  if (cmd == NULL) {
+    free(ids);
+    return GMJ_ERR_ALLOCATION;
+  }
+  cmd->kind = GMJ_CMD_EXPORT;
+  cmd->count = body_count;
+  cmd->body_ids = ids;
+  if (world_offset_xyz != NULL) {
+    memcpy(cmd->world_offset, world_offset_xyz, sizeof(cmd->world_offset));
+    cmd->has_offset = 1;
+  }
+  cmd->layout = layout;
+  cmd->flags = flags;
+  cmd->out_transforms = out_transforms;
+  list->count += 1;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_execute(const gmj_cmd_list* list, gmj_data* data) {
+  const mjModel* m = NULL;
+  mjData* d = NULL;
+  int i = 0;
+  if (list == NULL || data == NULL || data->handle == NULL) {
+    gmj_set_error("invalid list or data pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  m = list->model->handle;
+  d = data->handle;
+  for (i = 0; i < list->count; ++i) {
+    const gmj_cmd* cmd = &list->cmds[i];
+    switch (cmd->kind) {
+      case GMJ_CMD_SET_CTRL:
+        gmj_copy_to_mjtnum(d->ctrl + cmd->start, cmd->values, cmd->count);
+        break;
+      case GMJ_CMD_STEP:
+        gmj_data_advance(m, data, cmd->count);
+        break;
+      case GMJ_CMD_COPY: {
+        mjtNum* values = NULL;
+        int length = 0;
+        int width = 0;
+        gmj_field_lookup(m, d, cmd->field, &values, &length, &width);
+        gmj_copy_from_mjtnum(cmd->out_values, values + cmd->start,
+                             cmd->count);
+        break;
+      }
+      case GMJ_CMD_EXPORT:
+        gmj_write_transforms(d, cmd->body_ids, cmd->count,
+                             cmd->has_offset ? cmd->world_offset : NULL,
+                             cmd->layout, cmd->flags, cmd->out_transforms);
+        break;
+    }
+  }
+  return GMJ_OK;
+}
+
+/* Minimal JSON reader for the policy export files. A document is validated
+   once with gmj_json_skip; the lookups below assume a well-formed tree. */
+#define GMJ_JSON_DEPTH_MAX 64
+
+static const char* gmj_json_ws(const char* p) {
+  while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r') {
+    ++p;
+  }
+  return p;
+}
+
+static const char* gmj_json_skip(const char* p, int depth) {
+  p = gmj_json_ws(p);
+  if (depth > GMJ_JSON_DEPTH_MAX) {
+    return NULL;
+  }
+
+  if (*p == '{' || *p == '[') {
+    const int is_object = *p == '{';
+    const char close = is_object ? '}' : ']';
+    p = gmj_json_ws(p + 1);
+    if (*p == close) {
+      return p + 1;
+    }
+    for (;;) {
+      if (is_object) {
+        if (*p != '"' || (p = gmj_json_skip(p, depth + 1)) == NULL) {
+          return NULL;
+        }
+        p = gmj_json_ws(p);
+        if (*p != ':') {
+          return NULL;
+        }
+        ++p;
+      }
+      if ((p = gmj_json_skip(p, depth + 1)) == NULL) {
+        return NULL;
+      }
+      p = gmj_json_ws(p);
+      if (*p == close) {
+        return p + 1;
+      }
+      if (*p != ',') {
+        return NULL;
+      }
+      p = gmj_json_ws(p + 1);
+    }
+  }
+
+  if (*p == '"') {
+    for (++p; *p != '"'; ++p) {
+      if (*p == '\0') {
+        return NULL;
+      }
+      if (*p == '\\' && p[1] != '\0') {
+        ++p;
+      }
+    }
+    return p + 1;
+  }
+
+  if (strncmp(p, "true", 4) == 0 || strncmp(p, "null", 4) == 0) {
+    return p + 4;
+  }
+  if (strncmp(p, "false", 5) == 0) {
+    return p + 5;
+  }
+
+  {
+    char* end = NULL;
+    (void)strtod(p, &end);
+    return end == p ? NULL : end;
+  }
+}
+
+static const char* gmj_json_find(const char* object, const char* key) {
+  const size_t key_length = strlen(key);
+  const char* p = gmj_json_ws(object);
+  if (*p != '{') {
+    return NULL;
+  }
+
+  p = gmj_json_ws(p + 1);
+  while (*p == '"') {
+    const char* name_end = gmj_json_skip(p, 0) - 1;
+    const char* value = gmj_json_ws(gmj_json_ws(name_end + 1) + 1);
+    if ((size_t)(name_end - (p + 1)) == key_length &&
+        memcmp(p + 1, key, key_length) == 0) {
+      return value;
+    }
+    p = gmj_json_ws(gmj_json_skip(value, 0));
+    if (*p != ',') {
+      break;
+    }
+    p = gmj_json_ws(p + 1);
+  }
+  return NULL;
+}
+
+static const char* gmj_json_first(const char* array) {
+  const char* p = array != NULL ? gmj_json_ws(array) : NULL;
+  if (p == NULL || *p != '[') {
+    return NULL;
+  }
+  p = gmj_json_ws(p + 1);
+  return *p == ']' ? NULL : p;
+}
+
+static const char* gmj_json_next(const char* element) {
+  const char* p = gmj_json_ws(gmj_json_skip(element, 0));
+  return *p == ',' ? gmj_json_ws(p + 1) : NULL;
+}
+
+static int gmj_json_count(const char* array) {
+  int count = 0;
+  const char* p = NULL;
+  for (p = gmj_json_first(array); p != NULL; p = gmj_json_next(p)) {
+    ++count;
+  }
+  return count;
+}
+
+static int gmj_json_number(const char* p, double* out_value) {
+  char* end = NULL;
+  if (p == NULL || *p == '"' || *p == '[' || *p == '{') {
+    return 0;
+  }
+  *out_value = strtod(p, &end);
+  return end != p;
+}
+
+static int gmj_json_string_is(const char* p, const char* text) {
+  const size_t length = strlen(text);
+  return p != NULL && *p == '"' && strncmp(p + 1, text, length) == 0 &&
+         p[length + 1] == '"';
+}
+
+/* Policy kernels work in float32 with every row padded to a multiple of
+   GMJ_POLICY_LANES, so the AVX2 and AVX-512 paths need no tail handling.
+   Layer weights are stored transposed ([in x out_stride]) so one input
+   broadcast feeds a full vector of outputs. */
+#define GMJ_POLICY_LANES 16
+#define GMJ_POLICY_MAX_WIDTH 1024
+
+typedef enum gmj_policy_activation {
+  GMJ_ACTIVATION_LINEAR = 0,
+  GMJ_ACTIVATION_TANH = 1,
+  GMJ_ACTIVATION_RELU = 2
+} gmj_policy_activation;
+
+typedef struct gmj_policy_layer {
+  int in_dim;
+  int out_dim;
+  int out_stride;
+  float* weights;
+  float* bias;
+  gmj_policy_activation activation;
+} gmj_policy_layer;
+
+struct gmj_policy {
+  int obs_size;
+  int obs_stride;
+  int action_size;
+  float* obs_mean;
+  float* obs_scale;
+  float* obs_clip;
+  gmj_policy_layer* layers;
+  int layer_count;
+  float clip_action;
+};
+
+static int gmj_policy_pad(int count) {
+  return (count + GMJ_POLICY_LANES - 1) / GMJ_POLICY_LANES * GMJ_POLICY_LANES;
+}
+
+void gmj_policy_free(gmj_policy* policy) {
+  int i = 0;
+  if (policy == NULL) {
+    return;
+  }
+  for (i = 0; i < policy->layer_count; ++i) {
+    free(policy->layers[i].weights);
+    free(policy->layers[i].bias);
+  }
+  free(policy->layers);
+  free(policy->obs_mean);
+  free(policy->obs_scale);
+  free(policy->obs_clip);
+  free(policy);
+}
+
+static const char* gmj_policy_read_layer(const char* object,
+                                         gmj_policy_activation activation,
+                                         gmj_policy_layer* out_layer) {
+  const char* weights = gmj_json_find(object, "weights");
+  const char* bias = gmj_json_find(object, "bias");
+  const char* name = gmj_json_find(object, "activation");
+  const char* row = NULL;
+  const char* cell = NULL;
+  int r = 0;
+  int c = 0;
+
+  if (gmj_json_first(weights) == NULL || gmj_json_first(bias) == NULL) {
+    return "weights/bias must be non-empty arrays";
+  }
+  if (name != NULL) {
+    if (gmj_json_string_is(name, "tanh")) {
+      activation = GMJ_ACTIVATION_TANH;
+    } else if (gmj_json_string_is(name, "relu")) {
+      activation = GMJ_ACTIVATION_RELU;
+    } else if (gmj_json_string_is(name, "linear") ||
+               gmj_json_string_is(name, "identity")) {
+      activation = GMJ_ACTIVATION_LINEAR;
+    } else {
+      return "unknown activation";
+    }
+  }
+
+  out_layer->activation = activation;
+  out_layer->out_dim = gmj_json_count(weights);
+  if (gmj_json_count(bias) != out_layer->out_dim) {
+    return "bias length must match weights action rows";
+  }
+
+  /* Ragged rows are zero-padded, matching the managed fallback. */
+  for (row = gmj_json_first(weights); row != NULL; row = gmj_json_next(row)) {
+    const int length = gmj_json_count(row);
+    if (*row != '[') {
+      return "each weights row must be an array";
+    }
+    if (length > out_layer->in_dim) {
+      out_layer->in_dim = length;
+    }
+  }
+
+  out_layer->out_stride = gmj_policy_pad(out_layer->out_dim);
+  if (out_layer->in_dim == 0 || out_layer->in_dim > GMJ_POLICY_MAX_WIDTH ||
+      out_layer->out_stride > GMJ_POLICY_MAX_WIDTH) {
+    return "layer width must be between 1 and 1024";
+  }
+
+  out_layer->weights = (float*)calloc(
+      (size_t)out_layer->in_dim * (size_t)out_layer->out_stride, sizeof(float));
+  out_layer->bias = (float*)calloc((size_t)out_layer->out_stride, sizeof(float));
+  if (out_layer->weights == NULL || out_layer->bias == NULL) {
+    return "failed to allocate policy layer";
+  }
+
+  for (r = 0, row = gmj_json_first(weights); row != NULL;
+       ++r, row = gmj_json_next(row)) {
+    for (c = 0, cell = gmj_json_first(row); cell != NULL;
+         ++c, cell = gmj_json_next(cell)) {
+      double value = 0.0;
+      if (!gmj_json_number(cell, &value)) {
+        return "weights must be numbers";
+      }
+      out_layer->weights[(size_t)c * (size_t)out_layer->out_stride + r] =
+          (float)value;
+    }
+  }
+
+  for (r = 0, cell = gmj_json_first(bias); cell != NULL;
+       ++r, cell = gmj_json_next(cell)) {
+    double value = 0.0;
+    if (!gmj_json_number(cell, &value)) {
+      return "bias must be numbers";
+    }
+    out_layer->bias[r] = (float)value;
+  }
+  return NULL;
+}
+
+static const char* gmj_policy_read_vecnorm(gmj_policy* policy,
+                                           const char* root) {
+  const char* mean = gmj_json_find(root, "obs_mean");
+  const char* var = gmj_json_find(root, "obs_var");
+  const char* clip = gmj_json_find(root, "clip_obs");
+  const char* epsilon = gmj_json_find(root, "epsilon");
+  double clip_obs = 10.0;
+  double eps = 1e-8;
+  int i = 0;
+
+  if (gmj_json_first(mean) == NULL || gmj_json_first(var) == NULL) {
+    const char* rms = gmj_json_find(root, "obs_rms");
+    if (rms != NULL && *rms == '{') {
+      mean = gmj_json_find(rms, "mean");
+      var = gmj_json_find(rms, "var");
+    }
+  }
+  if (gmj_json_first(mean) == NULL || gmj_json_first(var) == NULL) {
+    return "VecNorm stats missing obs_mean or obs_var";
+  }
+  if (gmj_json_count(mean) != gmj_json_count(var)) {
+    return "VecNorm length mismatch between obs_mean and obs_var";
+  }
+  if (clip != NULL && !gmj_json_number(clip, &clip_obs)) {
+    return "clip_obs must be a number";
+  }
+  if (epsilon != NULL && !gmj_json_number(epsilon, &eps)) {
+    return "epsilon must be a number";
+  }
+
+  /* Entries past the stats (or past the policy input) pass through. */
+  mean = gmj_json_first(mean);
+  var = gmj_json_first(var);
+  for (i = 0; i < policy->obs_size && mean != NULL && var != NULL; ++i) {
+    double m = 0.0;
+    double v = 0.0;
+    if (!gmj_json_number(mean, &m) || !gmj_json_number(var, &v)) {
+      return "VecNorm stats must be numbers";
+    }
+    policy->obs_mean[i] = (float)m;
+    policy->obs_scale[i] = (float)(1.0 / sqrt((v > 0.0 ? v : 0.0) + eps));
+    policy->obs_clip[i] = (float)clip_obs;
+    mean = gmj_json_next(mean);
+    var = gmj_json_next(var);
+  }
+  return NULL;
+}
+
+gmj_policy* gmj_policy_load_json(const char* policy_json,
+                                 const char* vecnorm_json, char* error_buffer,
+                                 size_t error_buffer_size) {
+  gmj_policy* policy = NULL;
+  const char* layers = NULL;
+  const char* clip = NULL;
+  const char* message = NULL;
+  double clip_action = 1.0;
+  int i = 0;
+
+  if (policy_json == NULL) {
+    gmj_write_error(error_buffer, error_buffer_size, "policy_json is null");
+    return NULL;
+  }
+  if (gmj_json_skip(policy_json, 0) == NULL ||
+      *gmj_json_ws(policy_json) != '{' ||
+      (vecnorm_json != NULL && (gmj_json_skip(vecnorm_json, 0) == NULL ||
+                                *gmj_json_ws(vecnorm_json) != '{'))) {
+    gmj_write_error(error_buffer, error_buffer_size, "malformed JSON");
+    return NULL;
+  }
+
+  policy = (gmj_policy*)calloc(1, sizeof(gmj_policy));
+  if (policy == NULL) {
+    gmj_write_error(error_buffer, error_buffer_size,
+                    "failed to allocate gmj_policy");
+    return NULL;
+  }
+
+  /* policy_linear.json is one tanh layer clipped to 1 by default; the MLP
+     format lists layers, which are linear unless they name an activation,
+     and only clips when clip_action is given. */
+  layers = gmj_json_find(policy_json, "layers");
+  policy->layer_count = layers != NULL ? gmj_json_count(layers) : 1;
+  policy->clip_action = layers != NULL ? FLT_MAX : 1.0f;
+  policy->layers = (gmj_policy_layer*)calloc((size_t)policy->layer_count,
+                                             sizeof(gmj_policy_layer));
+  if (policy->layer_count == 0 || policy->layers == NULL) {
+    message = policy->layer_count == 0 ? "layers must not be empty"
+                                       : "failed to allocate policy layers";
+  } else if (layers == NULL) {
+    message = gmj_policy_read_layer(policy_json, GMJ_ACTIVATION_TANH,
+                                    &policy->layers[0]);
+  } else {
+    const char* layer = gmj_json_first(layers);
+    for (i = 0; message == NULL && layer != NULL;
+         ++i, layer = gmj_json_next(layer)) {
+      message = gmj_policy_read_layer(layer, GMJ_ACTIVATION_LINEAR,
+                                      &policy->layers[i]);
+      if (message == NULL && i > 0 &&
+          policy->layers[i].in_dim != policy->layers[i - 1].out_dim) {
+        message = "layer input size must match previous layer output size";
+      }
+    }
+  }
+
+  clip = gmj_json_find(policy_json, "clip_action");
+  if (message == NULL && clip != NULL) {
+    if (!gmj_json_number(clip, &clip_action)) {
+      message = "clip_action must be a number";
+    } else {
+      policy->clip_action = clip_action > 0.0 ? (float)clip_action : 0.0f;
+    }
+  }
+
+  if (message == NULL) {
+    policy->obs_size = policy->layers[0].in_dim;
+    policy->obs_stride = gmj_policy_pad(policy->obs_size);
+    policy->action_size = policy->layers[policy->layer_count - 1].out_dim;
+    policy->obs_mean = (float*)calloc((size_t)policy->obs_stride, sizeof(float));
+    policy->obs_scale = (float*)malloc((size_t)policy->obs_stride * sizeof(float));
+    policy->obs_clip = (float*)malloc((size_t)policy->obs_stride * sizeof(float));
+    if (policy->obs_mean == NULL || policy->obs_scale == NULL ||
+        policy->obs_clip == NULL) {
+      message = "failed to allocate normalization stats";
+    } else {
+      for (i = 0; i < policy->obs_stride; ++i) {
+        policy->obs_scale[i] = 1.0f;
+        policy->obs_clip[i] = FLT_MAX;
+      }
+      if (vecnorm_json != NULL) {
+        message = gmj_policy_read_vecnorm(policy, vecnorm_json);
+      }
+    }
+  }
+
+  if (message != NULL) {
+    gmj_write_error(error_buffer, error_buffer_size, message);
+    gmj_policy_free(policy);
+    return NULL;
+  }
+
+  gmj_set_error(NULL);
+  return policy;
+}
+
+gmj_policy* gmj_policy_load(const char* policy_path, const char* vecnorm_path,
+                            char* error_buffer, size_t error_buffer_size) {
+  gmj_policy* policy = NULL;
+  char* policy_json = NULL;
+  char* vecnorm_json = NULL;
+
+  if (policy_path == NULL) {
+    gmj_write_error(error_buffer, error_buffer_size, "policy_path is null");
+    return NULL;
+  }
+
+  policy_json = gmj_read_text_file(policy_path);
+  if (policy_json == NULL) {
+    gmj_write_error(error_buffer, error_buffer_size,
+                    "failed to read policy file");
+    return NULL;
+  }
+  if (vecnorm_path != NULL) {
+    vecnorm_json = gmj_read_text_file(vecnorm_path);
+    if (vecnorm_json == NULL) {
+      free(policy_json);
+      gmj_write_error(error_buffer, error_buffer_size,
+                      "failed to read VecNorm file");
+      return NULL;
+    }
+  }
+
+  policy = gmj_policy_load_json(policy_json, vecnorm_json, error_buffer,
+                                error_buffer_size);
+  free(policy_json);
+  free(vecnorm_json);
+  return policy;
+}
+
+int gmj_policy_obs_size(const gmj_policy* policy) {
+  if (policy == NULL) {
+    gmj_set_error("policy is null");
+    return -1;
+  }
+  return policy->obs_size;
+}
+
+int gmj_policy_action_size(const gmj_policy* policy) {
+  if (policy == NULL) {
+    gmj_set_error("policy is null");
+    return -1;
+  }
+  return policy->action_size;
+}
+
+static void gmj_policy_normalize_scalar(const gmj_policy* policy, float* x) {
+  int i = 0;
+  for (i = 0; i < policy->obs_stride; ++i) {
+    float v = (x[i] - policy->obs_mean[i]) * policy->obs_scale[i];
+    v = v > policy->obs_clip[i] ? policy->obs_clip[i] : v;
+    x[i] = v < -policy->obs_clip[i] ? -policy->obs_clip[i] : v;
+  }
+}
+
+static void gmj_policy_dense_scalar(const gmj_policy_layer* layer,
+                                    const float* in, float* out) {
+  int i = 0;
+  int j = 0;
+  memcpy(out, layer->bias, (size_t)layer->out_stride * sizeof(float));
+  for (i = 0; i < layer->in_dim; ++i) {
+    const float x = in[i];
+    const float* w = layer->weights + (size_t)i * (size_t)layer->out_stride;
+    for (j = 0; j < layer->out_stride; ++j) {
+      out[j] += x * w[j];
+    }
+  }
+}
+
+#ifdef GMJ_X86_SIMD
+GMJ_TARGET("avx2,fma")
+static void gmj_policy_normalize_avx2(const gmj_policy* policy, float* x) {
+  int i = 0;
+  for (i = 0; i < policy->obs_stride; i += 8) {
+    const __m256 clip = _mm256_loadu_ps(policy->obs_clip + i);
+    __m256 v = _mm256_sub_ps(_mm256_loadu_ps(x + i),
+                             _mm256_loadu_ps(policy->obs_mean + i));
+    v = _mm256_mul_ps(v, _mm256_loadu_ps(policy->obs_scale + i));
+    v = _mm256_max_ps(_mm256_min_ps(v, clip),
+                      _mm256_sub_ps(_mm256_setzero_ps(), clip));
+    _mm256_storeu_ps(x + i, v);
+  }
+}
+
+GMJ_TARGET("avx2,fma")
+static void gmj_policy_dense_avx2(const gmj_policy_layer* layer,
+                                  const float* in, float* out) {
+  int i = 0;
+  int j = 0;
+  for (j = 0; j < layer->out_stride; j += 16) {
+    const float* w = layer->weights + j;
+    __m256 acc0 = _mm256_loadu_ps(layer->bias + j);
+    __m256 acc1 = _mm256_loadu_ps(layer->bias + j + 8);
+    for (i = 0; i < layer->in_dim; ++i, w += layer->out_stride) {
+      const __m256 x = _mm256_set1_ps(in[i]);
+      acc0 = _mm256_fmadd_ps(x, _mm256_loadu_ps(w), acc0);
+      acc1 = _mm256_fmadd_ps(x, _mm256_loadu_ps(w + 8), acc1);
+    }
+    _mm256_storeu_ps(out + j, acc0);
+    _mm256_storeu_ps(out + j + 8, acc1);
+  }
+}
+
+GMJ_TARGET("avx512f")
+static void gmj_policy_normalize_avx512(const gmj_policy* policy, float* x) {
+  int i = 0;
+  for (i = 0; i < policy->obs_stride; i += 16) {
+    const __m512 clip = _mm512_loadu_ps(policy->obs_clip + i);
+    __m512 v = _mm512_sub_ps(_mm512_loadu_ps(x + i),
+                             _mm512_loadu_ps(policy->obs_mean + i));
+    v = _mm512_mul_ps(v, _mm512_loadu_ps(policy->obs_scale + i));
+    v = _mm512_max_ps(_mm512_min_ps(v, clip),
+                      _mm512_sub_ps(_mm512_setzero_ps(), clip));
+    _mm512_storeu_ps(x + i, v);
+  }
+}
+
+GMJ_TARGET("avx512f")
+static void gmj_policy_dense_avx512(const gmj_policy_layer* layer,
+                                    const float* in, float* out) {
+  int i = 0;
+  int j = 0;
+  for (j = 0; j < layer->out_stride; j += 16) {
+    const float* w = layer->weights + j;
+    __m512 acc = _mm512_loadu_ps(layer->bias + j);
+    for (i = 0; i < layer->in_dim; ++i, w += layer->out_stride) {
+      acc = _mm512_fmadd_ps(_mm512_set1_ps(in[i]), _mm512_loadu_ps(w), acc);
+    }
+    _mm512_storeu_ps(out + j, acc);
+  }
+}
+#endif
+
+/* Runs normalize -> (dense -> activation)* on input (obs_stride floats,
+   modified in place) and returns the buffer holding the clipped actions. */
+static const float* gmj_policy_forward(const gmj_policy* policy,
+                                       gmj_simd_level level, float* input,
+                                       float* scratch_a, float* scratch_b) {
+  const float* in = input;
+  float* out = scratch_a;
+  int layer_index = 0;
+  int j = 0;
+
+#ifdef GMJ_X86_SIMD
+  if (level >= GMJ_SIMD_AVX512) {
+    gmj_policy_normalize_avx512(policy, input);
+  } else if (level == GMJ_SIMD_AVX2) {
+    gmj_policy_normalize_avx2(policy, input);
+  } else {
+    gmj_policy_normalize_scalar(policy, input);
+  }
+#else
+  (void)level;
+  gmj_policy_normalize_scalar(policy, input);
+#endif
+
+  for (layer_index = 0; layer_index < policy->layer_count; ++layer_index) {
+    const gmj_policy_layer* layer = &policy->layers[layer_index];
+#ifdef GMJ_X86_SIMD
+    if (level >= GMJ_SIMD_AVX512) {
+      gmj_policy_dense_avx512(layer, in, out);
+    } else if (level == GMJ_SIMD_AVX2) {
+      gmj_policy_dense_avx2(layer, in, out);
+    } else {
+      gmj_policy_dense_scalar(layer, in, out);
+    }
+#else
+    gmj_policy_dense_scalar(layer, in, out);
+#endif
+
+    if (layer->activation == GMJ_ACTIVATION_TANH) {
+      for (j = 0; j < layer->out_dim; ++j) {
+        out[j] = tanhf(out[j]);
+      }
+    } else if (layer->activation == GMJ_ACTIVATION_RELU) {
+      for (j = 0; j < layer->out_dim; ++j) {
+        out[j] = out[j] > 0.0f ? out[j] : 0.0f;
+      }
+    }
+
+    in = out;
+    out = out == scratch_a ? scratch_b : scratch_a;
+  }
+
+  out = (float*)in;
+  for (j = 0; j < policy->action_size; ++j) {
+    out[j] = out[j] > policy->clip_action ? policy->clip_action : out[j];
+    out[j] = out[j] < -policy->clip_action ? -policy->clip_action : out[j];
+  }
+  return out;
+}
+
+gmj_error_code gmj_policy_infer(const gmj_policy* policy,
+                                const double* observation, int obs_count,
+                                double* out_actions, int action_count) {
+  float input[GMJ_POLICY_MAX_WIDTH];
+  float scratch_a[GMJ_POLICY_MAX_WIDTH];
+  float scratch_b[GMJ_POLICY_MAX_WIDTH];
+  const float* actions = NULL;
+  int i = 0;
+
+  if (policy == NULL || observation == NULL || out_actions == NULL ||
+      obs_count < 0 || action_count < 0) {
+    gmj_set_error("invalid policy, observation or out_actions");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  /* Like the managed fallback: extra observations are ignored, missing ones
+     read as zero, and only min(action_count, action_size) are written. */
+  for (i = 0; i < policy->obs_stride; ++i) {
+    input[i] = i < obs_count && i < policy->obs_size ? (float)observation[i]
+                                                     : 0.0f;
+  }
+  actions = gmj_policy_forward(policy, gmj_simd_active(), input, scratch_a,
+                               scratch_b);
+  for (i = 0; i < action_count && i < policy->action_size; ++i) {
+    out_actions[i] = (double)actions[i];
+  }
+
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+static gmj_error_code gmj_policy_validate_apply(const gmj_policy* policy,
+                                                const gmj_obs_spec* spec,
+                                                int ctrl_start) {
+  if (policy == NULL || spec == NULL) {
+    gmj_set_error("invalid policy or spec pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (spec->size != policy->obs_size) {
+    gmj_set_error("observation spec size does not match policy input size");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  return gmj_validate_slice(ctrl_start, policy->action_size,
+                            spec->model->handle->nu);
+}
+
+static void gmj_policy_apply_data(const gmj_policy* policy,
+                                  const gmj_obs_spec* spec,
+                                  gmj_simd_level level, mjData* d,
+                                  int ctrl_start, double* out_actions) {
+  float input[GMJ_POLICY_MAX_WIDTH];
+  float scratch_a[GMJ_POLICY_MAX_WIDTH];
+  float scratch_b[GMJ_POLICY_MAX_WIDTH];
+  const float* actions = NULL;
+  int i = 0;
+
+  gmj_obs_gather_f32(spec, d, level, input);
+  for (i = policy->obs_size; i < policy->obs_stride; ++i) {
+    input[i] = 0.0f;
+  }
+  actions = gmj_policy_forward(policy, level, input, scratch_a, scratch_b);
+  gmj_load_f32(d->ctrl + ctrl_start, actions, policy->action_size, level);
+  if (out_actions != NULL) {
+    for (i = 0; i < policy->action_size; ++i) {
+      out_actions[i] = (double)actions[i];
+    }
+  }
+}
+
+gmj_error_code gmj_policy_apply(const gmj_policy* policy,
+                                const gmj_obs_spec* spec, gmj_data* data,
+                                int ctrl_start, double* out_actions) {
+  gmj_error_code valid = GMJ_OK;
+  if (data == NULL || data->handle == NULL) {
+    gmj_set_error("data is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  valid = gmj_policy_validate_apply(policy, spec, ctrl_start);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  gmj_policy_apply_data(policy, spec, gmj_simd_active(), data->handle,
+                        ctrl_start, out_actions);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+/* Reward/termination terms evaluated right after stepping. Terms are kept
+   in fixed arrays so a task is a single allocation. */
+#define GMJ_TASK_TERMS_MAX 16
+
+typedef struct gmj_task_term {
+  int kind;
+  int body_id;
+  int axis;
+  double threshold;
+  double weight;
+} gmj_task_term;
+
+struct gmj_task {
+  const gmj_model* model;
+  gmj_task_term rewards[GMJ_TASK_TERMS_MAX];
+  int reward_count;
+  gmj_task_term terminations[GMJ_TASK_TERMS_MAX];
+  int termination_count;
+  double time_limit;
+  int reset_key;
+};
+
+gmj_task* gmj_task_create(const gmj_model* model) {
+  gmj_task* task = NULL;
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("model is null");
+    return NULL;
+  }
+
+  task = (gmj_task*)calloc(1, sizeof(gmj_task));
+  if (task == NULL) {
+    gmj_set_error("failed to allocate gmj_task");
+    return NULL;
+  }
+
+  task->model = model;
+  task->reset_key = -1;
+  gmj_set_error(NULL);
+  return task;
+}
+
+void gmj_task_free(gmj_task* task) { free(task); }
+
+static gmj_error_code gmj_task_validate_body(const gmj_task* task,
+                                             int body_id, int axis) {
+  if (body_id < 0 || body_id >= task->model->handle->nbody) {
+    gmj_set_error("body id out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+  if (axis < 0 || axis > 2) {
+    gmj_set_error("axis must be 0, 1 or 2");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_task_add_reward(gmj_task* task, gmj_reward_term term,
+                                   int body_id, int axis, double threshold,
+                                   double weight) {
+  gmj_task_term* slot = NULL;
+  if (task == NULL) {
+    gmj_set_error("task is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (task->reward_count == GMJ_TASK_TERMS_MAX) {
+    gmj_set_error("too many reward terms");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (term == GMJ_REWARD_FORWARD || term == GMJ_REWARD_HEIGHT) {
+    const gmj_error_code valid = gmj_task_validate_body(task, body_id, axis);
+    if (valid != GMJ_OK) {
+      return valid;
+    }
+  } else if (term != GMJ_REWARD_CTRL_COST) {
+    gmj_set_error("unknown reward term");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  slot = &task->rewards[task->reward_count++];
+  slot->kind = (int)term;
+  slot->body_id = body_id;
+  slot->axis = axis;
+  slot->threshold = threshold;
+  slot->weight = weight;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_task_add_termination(gmj_task* task,
+                                        gmj_termination condition,
+                                        int body_id, int axis,
+                                        double threshold) {
+  gmj_task_term* slot = NULL;
+  gmj_error_code valid = GMJ_OK;
+  if (task == NULL) {
+    gmj_set_error("task is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (task->termination_count == GMJ_TASK_TERMS_MAX) {
+    gmj_set_error("too many termination conditions");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (condition != GMJ_TERMINATE_BELOW && condition != GMJ_TERMINATE_ABOVE) {
+    gmj_set_error("unknown termination condition");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  valid = gmj_task_validate_body(task, body_id, axis);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  slot = &task->terminations[task->termination_count++];
+  slot->kind = (int)condition;
+  slot->body_id = body_id;
+  slot->axis = axis;
+  slot->threshold = threshold;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_task_set_time_limit(gmj_task* task, double seconds) {
+  if (task == NULL) {
+    gmj_set_error("task is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  task->time_limit = seconds > 0.0 ? seconds : 0.0;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_task_set_reset_keyframe(gmj_task* task, int key_index) {
+  if (task == NULL) {
+    gmj_set_error("task is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (key_index < -1 || key_index >= task->model->handle->nkey) {
+    gmj_set_error("key_index out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+  task->reset_key = key_index;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+/* Steps one env and scores the interval. Positions come from xpos, which
+   mj_step leaves at the start of its last step, so forward displacement is
+   measured consistently between consecutive calls. Done envs are reset and
+   run through mj_forward, so the next observation is the new episode. */
+static void gmj_task_step_data(const gmj_task* task, gmj_data* data,
+                               int steps, double* out_reward,
+                               unsigned char* out_done) {
+  const mjModel* m = task->model->handle;
+  mjData* d = data->handle;
+  double before[GMJ_TASK_TERMS_MAX];
+  double reward = 0.0;
+  unsigned char done = GMJ_DONE_NONE;
+  int i = 0;
+  int k = 0;
+
+  for (i = 0; i < task->reward_count; ++i) {
+    const gmj_task_term* term = &task->rewards[i];
+    if (term->kind == GMJ_REWARD_FORWARD) {
+      before[i] = (double)d->xpos[3 * term->body_id + term->axis];
+    }
+  }
+
+  gmj_data_advance(m, data, steps);
+
+  for (i = 0; i < task->reward_count; ++i) {
+    const gmj_task_term* term = &task->rewards[i];
+    if (term->kind == GMJ_REWARD_FORWARD) {
+      reward += term->weight *
+                ((double)d->xpos[3 * term->body_id + term->axis] - before[i]);
+    } else if (term->kind == GMJ_REWARD_HEIGHT) {
+      if ((double)d->xpos[3 * term->body_id + term->axis] >= term->threshold) {
+        reward += term->weight;
+      }
+    } else {
+      double cost = 0.0;
+      for (k = 0; k < m->nu; ++k) {
+        cost += (double)d->ctrl[k] * (double)d->ctrl[k];
+      }
+      reward -= term->weight * cost;
+    }
+  }
+
+  for (i = 0; i < task->termination_count && done == GMJ_DONE_NONE; ++i) {
+    const gmj_task_term* term = &task->terminations[i];
+    const double value = (double)d->xpos[3 * term->body_id + term->axis];
+    if ((term->kind == GMJ_TERMINATE_BELOW && value < term->threshold) ||
+        (term->kind == GMJ_TERMINATE_ABOVE && value > term->threshold)) {
+      done = GMJ_DONE_TERMINATED;
+    }
+  }
+  if (done == GMJ_DONE_NONE && task->time_limit > 0.0 &&
+      (double)d->time >= task->time_limit) {
+    done = GMJ_DONE_TRUNCATED;
+  }
+
+  if (done != GMJ_DONE_NONE) {
+    mj_forward(gmj_data_reset(m, data, task->reset_key), d);
+  }
+
+  *out_reward = reward;
+  *out_done = done;
+}
+
+gmj_error_code gmj_task_step(const gmj_task* task, gmj_data* data, int steps,
+                             double* out_reward, unsigned char* out_done) {
+  double reward = 0.0;
+  unsigned char done = GMJ_DONE_NONE;
+  if (task == NULL || data == NULL || data->handle == NULL) {
+    gmj_set_error("invalid task or data pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (steps < 1) {
+    gmj_set_error("steps must be >= 1");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  gmj_task_step_data(task, data, steps, &reward, &done);
+  if (out_reward != NULL) {
+    *out_reward = reward;
+  }
+  if (out_done != NULL) {
+    *out_done = done;
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+/* Fixed-rate simulation thread. Commands travel through a single-producer
+   single-consumer ring (tail advanced by the poster, head by the sim
+   thread) and ticks are published through a triple buffer: the sim thread
+   fills its back frame and swaps it into the middle slot, and the reader
+   swaps the middle slot into its front frame when it is marked fresh.
+   Neither side ever waits for the other. */
+#define GMJ_SIM_QUEUE_DEFAULT 64
+#define GMJ_SIM_QUEUE_MAX 65536
+#define GMJ_SIM_FRESH 4
+/* OS sleeps overshoot by up to a scheduler quantum, so the last stretch
+   before a deadline is spent yielding instead. */
+#define GMJ_SIM_SPIN_SECONDS 0.001
+#define GMJ_SIM_SLEEP_MAX_SECONDS 0.01
+
+typedef enum gmj_sim_command_kind {
+  GMJ_SIM_COMMAND_CTRL = 0,
+  GMJ_SIM_COMMAND_RESET = 1
+} gmj_sim_command_kind;
+
+typedef struct gmj_sim_command {
+  gmj_sim_command_kind kind;
+  int start;
+  int count;
+} gmj_sim_command;
+
+/* values holds qpos | qvel | ctrl | xpos | xquat; poses holds the pose
+   sets of the previous and of this tick for interpolation. */
+typedef struct gmj_sim_frame {
+  gmj_sim_stats stats;
+  unsigned long long tick;
+  double time;
+  double reward;
+  int done;
+  double published_seconds;
+  double* values;
+  float* poses;
+} gmj_sim_frame;
+
+struct gmj_sim_thread {
+  const gmj_model* model;
+  gmj_data* data;
+  const gmj_task* task;
+  double period;
+  int steps_per_tick;
+  gmj_thread thread;
+  volatile long stop;
+
+  gmj_sim_command* commands;
+  double* command_values;
+  long capacity;
+  volatile long head;
+  volatile long tail;
+  volatile long rejected;
+
+  gmj_sim_frame frames[3];
+  double* frame_values;
+  float* pose_values;
+  float* last_pose;
+  float* blended;
+  int pose_stride;
+  volatile long middle;
+  int back;
+  int front;
+  gmj_sim_stats stats;
+};
+
+static void gmj_sim_publish(gmj_sim_thread* sim, double reward, int done) {
+  const mjModel* m = sim->model->handle;
+  const mjData* d = sim->data->handle;
+  gmj_sim_frame* frame = &sim->frames[sim->back];
+  const size_t pose_size = 7 * (size_t)sim->pose_stride * sizeof(float);
+  double* dst = frame->values;
+
+  frame->stats = sim->stats;
+  frame->tick = (unsigned long long)sim->stats.ticks;
+  frame->time = (double)d->time;
+  frame->reward = reward;
+  frame->done = done;
+  gmj_copy_from_mjtnum(dst, d->qpos, m->nq);
+  dst += m->nq;
+  gmj_copy_from_mjtnum(dst, d->qvel, m->nv);
+  dst += m->nv;
+  gmj_copy_from_mjtnum(dst, d->ctrl, m->nu);
+  dst += m->nu;
+  gmj_copy_from_mjtnum(dst, d->xpos, 3 * m->nbody);
+  dst += 3 * m->nbody;
+  gmj_copy_from_mjtnum(dst, d->xquat, 4 * m->nbody);
+  memcpy(frame->poses, sim->last_pose, pose_size);
+  gmj_pose_capture(m, d, sim->pose_stride, sim->last_pose);
+  memcpy(frame->poses + 7 * (size_t)sim->pose_stride, sim->last_pose,
+         pose_size);
+  frame->published_seconds = gmj_now_seconds();
+
+  sim->back =
+      (int)(gmj_atomic_exchange(&sim->middle, sim->back | GMJ_SIM_FRESH) & 3);
+}
+
+static void gmj_sim_reset(gmj_sim_thread* sim) {
+  const int key = sim->task != NULL ? sim->task->reset_key : -1;
+  mj_forward(gmj_data_reset(sim->model->handle, sim->data, key),
+             sim->data->handle);
+  sim->stats.resets += 1;
+}
+
+static void gmj_sim_drain(gmj_sim_thread* sim) {
+  const int nu = sim->model->handle->nu;
+  const unsigned long mask = (unsigned long)sim->capacity - 1UL;
+  const unsigned long tail = (unsigned long)gmj_atomic_load(&sim->tail);
+  unsigned long head = (unsigned long)sim->head;
+  const int depth = (int)(tail - head);
+
+  if (depth > sim->stats.queue_high_water) {
+    sim->stats.queue_high_water = depth;
+  }
+  for (; head != tail; ++head) {
+    const unsigned long slot = head & mask;
+    const gmj_sim_command* command = &sim->commands[slot];
+    if (command->kind == GMJ_SIM_COMMAND_RESET) {
+      gmj_sim_reset(sim);
+    } else {
+      gmj_copy_to_mjtnum(sim->data->handle->ctrl + command->start,
+                         sim->command_values + slot * (unsigned long)nu,
+                         command->count);
+    }
+    sim->stats.commands_applied += 1;
+  }
+  gmj_atomic_store(&sim->head, (long)head);
+}
+
+static void gmj_sim_wait_until(gmj_sim_thread* sim, double deadline) {
+  for (;;) {
+    const double remaining = deadline - gmj_now_seconds();
+    if (remaining <= 0.0 || gmj_atomic_load(&sim->stop)) {
+      return;
+    }
+    if (remaining > GMJ_SIM_SPIN_SECONDS) {
+      const double nap = remaining - GMJ_SIM_SPIN_SECONDS;
+      gmj_sleep_seconds(nap < GMJ_SIM_SLEEP_MAX_SECONDS
+                            ? nap
+                            : GMJ_SIM_SLEEP_MAX_SECONDS);
+    } else {
+      gmj_thread_yield();
+    }
+  }
+}
+
+/* A tick that finishes after its deadline counts as missed and restarts
+   the schedule from now, so a stall is not followed by a burst of
+   catch-up ticks. */
+static GMJ_THREAD_RETURN gmj_sim_thread_main(void* arg) {
+  gmj_sim_thread* sim = (gmj_sim_thread*)arg;
+  const mjModel* m = sim->model->handle;
+  double deadline = gmj_now_seconds() + sim->period;
+
+  while (!gmj_atomic_load(&sim->stop)) {
+    const double start = gmj_now_seconds();
+    double reward = 0.0;
+    unsigned char done = GMJ_DONE_NONE;
+
+    gmj_sim_drain(sim);
+    if (sim->task != NULL) {
+      gmj_task_step_data(sim->task, sim->data, sim->steps_per_tick, &reward,
+                         &done);
+      if (done != GMJ_DONE_NONE) {
+        sim->stats.resets += 1;
+      }
+    } else {
+      gmj_data_advance(m, sim->data, sim->steps_per_tick);
+    }
+    sim->stats.ticks += 1;
+    sim->stats.steps += sim->steps_per_tick;
+    sim->stats.last_tick_seconds = gmj_now_seconds() - start;
+    gmj_sim_publish(sim, reward, done);
+
+    if (sim->period > 0.0) {
+      const double now = gmj_now_seconds();
+      if (now > deadline) {
+        const double lateness = now - deadline;
+        sim->stats.missed_deadlines += 1;
+        if (lateness > sim->stats.max_lateness_seconds) {
+          sim->stats.max_lateness_seconds = lateness;
+        }
+        deadline = now + sim->period;
+      } else {
+        gmj_sim_wait_until(sim, deadline);
+        deadline += sim->period;
+      }
+    }
+  }
+
+  return GMJ_THREAD_RESULT;
+}
+
+static void gmj_sim_release(gmj_sim_thread* sim) {
+  free(sim->commands);
+  free(sim->command_values);
+  free(sim->frame_values);
+  free(sim->pose_values);
+  free(sim);
+}
+
+gmj_sim_thread* gmj_sim_thread_start(const gmj_model* model, gmj_data* data,
+                                     const gmj_task* task,
+                                     double tick_rate_hz, int steps_per_tick,
+                                     int queue_capacity) {
+  gmj_sim_thread* sim = NULL;
+  const mjModel* m = NULL;
+  size_t stride = 0;
+  long capacity = 1;
+  int i = 0;
+
+  if (gmj_validate_ptrs(model, data) != GMJ_OK) {
+    return NULL;
+  }
+  if (task != NULL && task->model != model) {
+    gmj_set_error("task was created for a different model");
+    return NULL;
+  }
+  if (isnan(tick_rate_hz) || steps_per_tick < 1) {
+    gmj_set_error("tick_rate_hz must be a number and steps_per_tick >= 1");
+    return NULL;
+  }
+  if (queue_capacity > GMJ_SIM_QUEUE_MAX) {
+    gmj_set_error("queue_capacity is too large");
+    return NULL;
+  }
+  if (queue_capacity <= 0) {
+    queue_capacity = GMJ_SIM_QUEUE_DEFAULT;
+  }
+  while (capacity < queue_capacity) {
+    capacity <<= 1;
+  }
+
+  m = model->handle;
+  stride = (size_t)m->nq + (size_t)m->nv + (size_t)m->nu +
+           7 * (size_t)m->nbody;
+  sim = (gmj_sim_thread*)calloc(1, sizeof(gmj_sim_thread));
+  if (sim == NULL) {
+    gmj_set_error("failed to allocate gmj_sim_thread");
+    return NULL;
+  }
+  sim->commands =
+      (gmj_sim_command*)calloc((size_t)capacity, sizeof(gmj_sim_command));
+  sim->command_values = (double*)malloc(
+      sizeof(double) * (size_t)capacity * (size_t)(m->nu > 0 ? m->nu : 1));
+  sim->frame_values = (double*)malloc(sizeof(double) * 3 * stride);
+  sim->pose_stride = gmj_pose_stride(m->nbody);
+  /* Three frames of two sets, the thread's last set and the reader's blend
+     target; the padding lanes stay zero. */
+  sim->pose_values =
+      (float*)calloc(8 * 7 * (size_t)sim->pose_stride, sizeof(float));
+  if (sim->commands == NULL || sim->command_values == NULL ||
+      sim->frame_values == NULL || sim->pose_values == NULL) {
+    gmj_sim_release(sim);
+    gmj_set_error("failed to allocate sim thread buffers");
+    return NULL;
+  }
+
+  sim->model = model;
+  sim->data = data;
+  sim->task = task;
+  sim->period = tick_rate_hz > 0.0 ? 1.0 / tick_rate_hz : 0.0;
+  sim->steps_per_tick = steps_per_tick;
+  sim->capacity = capacity;
+  sim->stats.queue_capacity = (int)capacity;
+  for (i = 0; i < 3; ++i) {
+    sim->frames[i].values = sim->frame_values + (size_t)i * stride;
+    sim->frames[i].poses =
+        sim->pose_values + (size_t)i * 14 * (size_t)sim->pose_stride;
+  }
+  sim->last_pose = sim->pose_values + 42 * (size_t)sim->pose_stride;
+  sim->blended = sim->last_pose + 7 * (size_t)sim->pose_stride;
+  sim->back = 0;
+  sim->middle = 1;
+  sim->front = 2;
+
+  /* Tick 0 is the state as handed over, with derived quantities current.
+     It goes straight to the reader's front slot so that every read, even
+     before the first tick, sees a complete frame. */
+  mj_forward(gmj_data_physics_model(m, data), data->handle);
+  gmj_pose_capture(m, data->handle, sim->pose_stride, sim->last_pose);
+  gmj_sim_publish(sim, 0.0, GMJ_DONE_NONE);
+  sim->front = (int)(sim->middle & 3);
+  sim->middle = 2;
+
+  if (gmj_thread_start(&sim->thread, gmj_sim_thread_main, sim) != 0) {
+    gmj_sim_release(sim);
+    gmj_set_error("failed to start sim thread");
+    return NULL;
+  }
+
+  gmj_set_error(NULL);
+  return sim;
+}
+
+void gmj_sim_thread_stop(gmj_sim_thread* sim) {
+  if (sim == NULL) {
+    return;
+  }
+  gmj_atomic_store(&sim->stop, 1);
+  gmj_thread_join(sim->thread);
+  gmj_sim_release(sim);
+}
+
+static gmj_error_code gmj_sim_post(gmj_sim_thread* sim,
+                                   gmj_sim_command_kind kind, int start_index,
+                                   int count, const double* values) {
+  const int nu = sim->model->handle->nu;
+  const unsigned long tail = (unsigned long)sim->tail;
+  const unsigned long head = (unsigned long)gmj_atomic_load(&sim->head);
+  unsigned long slot = 0;
+
+  if (tail - head >= (unsigned long)sim->capacity) {
+    gmj_atomic_fetch_add(&sim->rejected, 1);
+    gmj_set_error("sim command queue is full");
+    return GMJ_ERR_QUEUE_FULL;
+  }
+
+  slot = tail & ((unsigned long)sim->capacity - 1UL);
+  sim->commands[slot].kind = kind;
+  sim->commands[slot].start = start_index;
+  sim->commands[slot].count = count;
+  if (count > 0) {
+    memcpy(sim->command_values + slot * (unsigned long)nu, values,
+           sizeof(double) * (size_t)count);
+  }
+  gmj_atomic_store(&sim->tail, (long)(tail + 1UL));
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_sim_post_ctrl(gmj_sim_thread* sim, int start_index,
+                                 int count, const double* values) {
+  gmj_error_code valid = GMJ_OK;
+  if (sim == NULL || (values == NULL && count > 0)) {
+    gmj_set_error("invalid sim thread or values pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  valid = gmj_validate_slice(start_index, count, sim->model->handle->nu);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  return gmj_sim_post(sim, GMJ_SIM_COMMAND_CTRL, start_index, count, values);
+}
+
+gmj_error_code gmj_sim_post_reset(gmj_sim_thread* sim) {
+  if (sim == NULL) {
+    gmj_set_error("sim thread is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  return gmj_sim_post(sim, GMJ_SIM_COMMAND_RESET, 0, 0, NULL);
+}
+
+gmj_error_code gmj_sim_latest_state(gmj_sim_thread* sim,
+                                    gmj_sim_state* out_state,
+                                    gmj_sim_stats* out_stats) {
+  const mjModel* m = NULL;
+  const gmj_sim_frame* frame = NULL;
+
+  if (sim == NULL || out_state == NULL) {
+    gmj_set_error("invalid sim thread or output pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  if ((gmj_atomic_load(&sim->middle) & GMJ_SIM_FRESH) != 0) {
+    sim->front = (int)(gmj_atomic_exchange(&sim->middle, sim->front) & 3);
+  }
+
+  m = sim->model->handle;
+  frame = &sim->frames[sim->front];
+  out_state->tick = frame->tick;
+  out_state->time = frame->time;
+  out_state->reward = frame->reward;
+  out_state->done = frame->done;
+  out_state->nq = m->nq;
+  out_state->nv = m->nv;
+  out_state->nu = m->nu;
+  out_state->nbody = m->nbody;
+  out_state->qpos = frame->values;
+  out_state->qvel = out_state->qpos + m->nq;
+  out_state->ctrl = out_state->qvel + m->nv;
+  out_state->xpos = out_state->ctrl + m->nu;
+  out_state->xquat = out_state->xpos + 3 * m->nbody;
+
+  if (out_stats != NULL) {
+    *out_stats = frame->stats;
+    out_stats->commands_rejected = gmj_atomic_load(&sim->rejected);
+    out_stats->queue_depth =
+        (int)((unsigned long)gmj_atomic_load(&sim->tail) -
+              (unsigned long)gmj_atomic_load(&sim->head));
+  }
+
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_sim_interpolate_transforms(
+    gmj_sim_thread* sim, float alpha, const int* body_ids, int body_count,
+    const float* world_offset_xyz, gmj_transform_layout layout, int flags,
+    float* out_transforms) {
+  const gmj_sim_frame* frame = NULL;
+  gmj_error_code valid = GMJ_OK;
+  if (sim == NULL) {
+    gmj_set_error("sim thread is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  valid = gmj_validate_transform_args(sim->model->handle, body_ids,
+                                      body_count, layout, out_transforms);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  frame = &sim->frames[sim->front];
+  if (alpha < 0.0f) {
+    alpha = sim->period > 0.0
+                ? (float)((gmj_now_seconds() - frame->published_seconds) /
+                          sim->period)
+                : 1.0f;
+  }
+  gmj_pose_blend(frame->poses, frame->poses + 7 * (size_t)sim->pose_stride,
+                 sim->pose_stride, alpha, sim->blended);
+  gmj_pose_pack(sim->blended, sim->pose_stride, body_ids, body_count,
+                world_offset_xyz, layout, flags, out_transforms);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_thread_pool* gmj_thread_pool_create(int thread_count) {
+  gmj_thread_pool* pool = NULL;
+  int i = 0;
+
+  if (thread_count <= 0) {
+    thread_count = gmj_cpu_count();
+  }
+
+  pool = (gmj_thread_pool*)calloc(1, sizeof(gmj_thread_pool));
+  if (pool == NULL) {
+    gmj_set_error("failed to allocate gmj_thread_pool");
+    return NULL;
+  }
+
+  pool->workers =
+      (gmj_pool_worker*)calloc((size_t)thread_count, sizeof(gmj_pool_worker));
+  if (pool->workers == NULL) {
+    free(pool);
+    gmj_set_error("failed to allocate gmj_thread_pool workers");
+    return NULL;
+  }
+
+  gmj_mutex_init(&pool->mutex);
+  gmj_mutex_init(&pool->dispatch_mutex);
+  gmj_cond_init(&pool->work_cond);
+  gmj_cond_init(&pool->done_cond);
+  for (i = 0; i < thread_count; ++i) {
+    pool->workers[i].pool = pool;
+    pool->workers[i].index = i;
+  }
+
+  /* Worker 0 is whichever thread dispatches; only spawn the rest. */
+  pool->thread_count = 1;
+  for (i = 1; i < thread_count; ++i) {
+    if (gmj_thread_start(&pool->workers[i].thread, gmj_pool_worker_main,
+                         &pool->workers[i]) != 0) {
+      gmj_thread_pool_free(pool);
+      gmj_set_error("failed to start worker thread");
+      return NULL;
+    }
+    pool->thread_count = i + 1;
+  }
+
+  gmj_set_error(NULL);
+  return pool;
+}
+
+void gmj_thread_pool_free(gmj_thread_pool* pool) {
+  int i = 0;
+  if (pool == NULL) {
+    return;
+  }
+
+  gmj_mutex_lock(&pool->mutex);
+  pool->shutdown = 1;
+  gmj_cond_broadcast(&pool->work_cond);
+  gmj_mutex_unlock(&pool->mutex);
+
+  for (i = 1; i < pool->thread_count; ++i) {
+    gmj_thread_join(pool->workers[i].thread);
+  }
+
+  gmj_cond_destroy(&pool->done_cond);
+  gmj_cond_destroy(&pool->work_cond);
+  gmj_mutex_destroy(&pool->dispatch_mutex);
+  gmj_mutex_destroy(&pool->mutex);
+  free(pool->workers);
+  free(pool);
+}
+
+int gmj_thread_pool_size(const gmj_thread_pool* pool) {
+  if (pool == NULL) {
+    gmj_set_error("pool is null");
+    return -1;
+  }
+  return pool->thread_count;
+}
+
+gmj_error_code gmj_thread_pool_stats(const gmj_thread_pool* pool,
+                                     int thread_index,
+                                     gmj_thread_stats* out_stats) {
+  if (pool == NULL || out_stats == NULL) {
+    gmj_set_error("invalid pool or out_stats pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (thread_index < 0 || thread_index >= pool->thread_count) {
+    gmj_set_error("thread_index out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+
+  *out_stats = pool->workers[thread_index].stats;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+void gmj_thread_pool_reset_stats(gmj_thread_pool* pool) {
+  int i = 0;
+  if (pool == NULL) {
+    return;
+  }
+  for (i = 0; i < pool->thread_count; ++i) {
+    memset(&pool->workers[i].stats, 0, sizeof(gmj_thread_stats));
+  }
+}
+
+gmj_batch* gmj_batch_create(const gmj_model* model, int env_count) {
+  return gmj_batch_create_sized(model, env_count, 0);
+}
+
+gmj_batch* gmj_batch_create_sized(const gmj_model* model, int env_count,
+                                  size_t arena_bytes) {
+  gmj_batch* batch = NULL;
+  int i = 0;
+
+  if (model == NULL || model->handle == NULL) {
+    gmj_set_error("model is null");
+    return NULL;
+  }
+  if (env_count < 1) {
+    gmj_set_error("env_count must be >= 1");
+    return NULL;
+  }
+  if (gmj_validate_arena(model->handle, arena_bytes) != GMJ_OK) {
+    return NULL;
+  }
+
+  batch = (gmj_batch*)calloc(1, sizeof(gmj_batch));
+  if (batch == NULL) {
+    gmj_set_error("failed to allocate gmj_batch");
+    return NULL;
+  }
+
+  batch->envs = (gmj_data*)calloc((size_t)env_count, sizeof(gmj_data));
+  if (batch->envs == NULL) {
+    free(batch);
+    gmj_set_error("failed to allocate gmj_batch envs");
+    return NULL;
+  }
+
+  batch->model = model;
+  batch->env_count = env_count;
+  for (i = 0; i < env_count; ++i) {
+    batch->envs[i].handle = gmj_make_data_sized(model->handle, arena_bytes);
+    batch->envs[i].generation = 1;
+    if (batch->envs[i].handle == NULL) {
+      gmj_batch_free(batch);
+      gmj_set_error("failed to allocate mjData");
+      return NULL;
+    }
+  }
+
+  gmj_set_error(NULL);
+  return batch;
+}
+
+void gmj_batch_free(gmj_batch* batch) {
+  int i = 0;
+  if (batch == NULL) {
+    return;
+  }
+  if (batch->envs != NULL) {
+    for (i = 0; i < batch->env_count; ++i) {
+      if (batch->envs[i].handle != NULL) {
+        mj_deleteData(batch->envs[i].handle);
+        batch->envs[i].handle = NULL;
+      }
+      if (batch->envs[i].recorder != NULL) {
+        batch->envs[i].recorder->attached = NULL;
+      }
+      gmj_env_params_free(batch->envs[i].params);
+      free(batch->envs[i].snapshots);
+    }
+    free(batch->envs);
+    batch->envs = NULL;
+  }
+  free(batch);
+}
+
+int gmj_batch_size(const gmj_batch* batch) {
+  if (batch == NULL) {
+    gmj_set_error("batch is null");
+    return -1;
+  }
+  return batch->env_count;
+}
+
+gmj_data* gmj_batch_env(gmj_batch* batch, int env_index) {
+  if (batch == NULL) {
+    gmj_set_error("batch is null");
+    return NULL;
+  }
+  if (env_index < 0 || env_index >= batch->env_count) {
+    gmj_set_error("env_index out of range");
+    return NULL;
+  }
+  gmj_set_error(NULL);
+  return &batch->envs[env_index];
+}
+
+gmj_error_code gmj_batch_reset(gmj_batch* batch) {
+  int i = 0;
+  if (batch == NULL || batch->model == NULL || batch->model->handle == NULL) {
+    gmj_set_error("invalid batch pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  for (i = 0; i < batch->env_count; ++i) {
+    gmj_data_reset(batch->model->handle, &batch->envs[i], -1);
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_batch_reset_env(gmj_batch* batch, int env_index) {
+  if (batch == NULL || batch->model == NULL || batch->model->handle == NULL) {
+    gmj_set_error("invalid batch pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (env_index < 0 || env_index >= batch->env_count) {
+    gmj_set_error("env_index out of range");
+    return GMJ_ERR_INDEX_OUT_OF_RANGE;
+  }
+
+  gmj_data_reset(batch->model->handle, &batch->envs[env_index], -1);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_batch_reload(gmj_batch* batch, const gmj_model* new_model) {
+  mjData** handles = NULL;
+  int i = 0;
+  if (batch == NULL || batch->model == NULL || batch->model->handle == NULL) {
+    gmj_set_error("invalid batch pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (new_model == NULL || new_model->handle == NULL) {
+    gmj_set_error("new_model is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  /* Every env is migrated before any is swapped, so a failed allocation
+     leaves the batch on the old model. */
+  handles = (mjData**)calloc((size_t)batch->env_count, sizeof(mjData*));
+  if (handles == NULL) {
+    gmj_set_error("failed to allocate reload buffers");
+    return GMJ_ERR_ALLOCATION;
+  }
+  for (i = 0; i < batch->env_count; ++i) {
+    handles[i] = gmj_make_data_sized(
+        new_model->handle,
+        gmj_data_arena_size(batch->model->handle, batch->envs[i].handle));
+    if (handles[i] == NULL) {
+      while (i-- > 0) {
+        mj_deleteData(handles[i]);
+      }
+      free(handles);
+      gmj_set_error("failed to allocate mjData");
+      return GMJ_ERR_ALLOCATION;
+    }
+    gmj_migrate_state(batch->model->handle, batch->envs[i].handle,
+                      new_model->handle, handles[i]);
+  }
+
+  for (i = 0; i < batch->env_count; ++i) {
+    gmj_data_swap_handle(&batch->envs[i], handles[i]);
+  }
+  batch->model = new_model;
+  free(handles);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_batch_randomize(gmj_batch* batch,
+                                   const gmj_randomizer* randomizer,
+                                   unsigned long long seed) {
+  gmj_error_code valid = GMJ_OK;
+  int i = 0;
+  if (batch == NULL || batch->model == NULL || batch->model->handle == NULL) {
+    gmj_set_error("invalid batch pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (randomizer != NULL &&
+      randomizer->model->handle != batch->model->handle) {
+    gmj_set_error("randomizer was built for a different model");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  if (randomizer == NULL) {
+    for (i = 0; i < batch->env_count; ++i) {
+      gmj_env_params_free(batch->envs[i].params);
+      batch->envs[i].params = NULL;
+    }
+    gmj_set_error(NULL);
+    return GMJ_OK;
+  }
+
+  /* All-or-nothing: every block is grown before any env is rebound, so a
+     failed allocation leaves the whole batch on its previous parameters. */
+  for (i = 0; i < batch->env_count; ++i) {
+    valid = gmj_env_params_reserve(&batch->envs[i], randomizer);
+    if (valid != GMJ_OK) {
+      while (--i >= 0) {
+        gmj_env_params_drop_unbound(&batch->envs[i]);
+      }
+      return valid;
+    }
+  }
+  for (i = 0; i < batch->env_count; ++i) {
+    gmj_env_params_apply(&batch->envs[i], randomizer, gmj_env_seed(seed, i));
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_batch_stats(const gmj_batch* batch, gmj_stats* out_stats) {
+  int i = 0;
+  if (batch == NULL || out_stats == NULL) {
+    gmj_set_error("invalid batch or output pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  memset(out_stats, 0, sizeof(*out_stats));
+  for (i = 0; i < batch->env_count; ++i) {
+    gmj_stats_accumulate(&batch->envs[i], out_stats);
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_batch_get_state(const gmj_batch* batch, double* out_qpos,
+                                   double* out_qvel) {
+  int i = 0;
+  int nq = 0;
+  int nv = 0;
+  if (batch == NULL || batch->model == NULL || batch->model->handle == NULL) {
+    gmj_set_error("invalid batch pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  nq = batch->model->handle->nq;
+  nv = batch->model->handle->nv;
+  for (i = 0; i < batch->env_count; ++i) {
+    const mjData* d = batch->envs[i].handle;
+    if (out_qpos != NULL) {
+      gmj_copy_from_mjtnum(out_qpos + (size_t)i * (size_t)nq, d->qpos, nq);
+    }
+    if (out_qvel != NULL) {
+      gmj_copy_from_mjtnum(out_qvel + (size_t)i * (size_t)nv, d->qvel, nv);
+    }
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_batch_get_state_f32(const gmj_batch* batch, float* out_qpos,
+                                       float* out_qvel) {
+  const gmj_simd_level level = gmj_simd_active();
+  int i = 0;
+  int nq = 0;
+  int nv = 0;
+  if (batch == NULL || batch->model == NULL || batch->model->handle == NULL) {
+    gmj_set_error("invalid batch pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  nq = batch->model->handle->nq;
+  nv = batch->model->handle->nv;
+  for (i = 0; i < batch->env_count; ++i) {
+    const mjData* d = batch->envs[i].handle;
+    if (out_qpos != NULL) {
+      gmj_store_f32(out_qpos + (size_t)i * (size_t)nq, d->qpos, nq, level);
+    }
+    if (out_qvel != NULL) {
+      gmj_store_f32(out_qvel + (size_t)i * (size_t)nv, d->qvel, nv, level);
+    }
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+/* Checks field[start, start + count) against the model once; every env has
+   the same layout. */
+static gmj_error_code gmj_batch_validate_slice_f32(const gmj_batch* batch,
+                                                   gmj_state_field field,
+                                                   int start_index, int count,
+                                                   int writing,
+                                                   const void* buffer) {
+  mjtNum* base = NULL;
+  if (batch == NULL || batch->model == NULL || batch->model->handle == NULL ||
+      buffer == NULL) {
+    gmj_set_error("invalid batch or buffer pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  return gmj_resolve_slice_f32(batch->model->handle, NULL, field, start_index,
+                               count, writing, &base);
+}
+
+gmj_error_code gmj_batch_get_slice_f32(const gmj_batch* batch,
+                                       gmj_state_field field, int start_index,
+                                       int count, float* out_values) {
+  const gmj_simd_level level = gmj_simd_active();
+  int i = 0;
+  const gmj_error_code valid = gmj_batch_validate_slice_f32(
+      batch, field, start_index, count, 0, out_values);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  for (i = 0; i < batch->env_count && count > 0; ++i) {
+    mjtNum* values = NULL;
+    int length = 0;
+    int width = 0;
+    gmj_field_lookup(batch->model->handle, batch->envs[i].handle, field,
+                     &values, &length, &width);
+    gmj_store_f32(out_values + (size_t)i * (size_t)count, values + start_index,
+                  count, level);
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_batch_set_slice_f32(gmj_batch* batch,
+                                       gmj_state_field field, int start_index,
+                                       int count, const float* values) {
+  const gmj_simd_level level = gmj_simd_active();
+  int i = 0;
+  const gmj_error_code valid = gmj_batch_validate_slice_f32(
+      batch, field, start_index, count, 1, values);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  for (i = 0; i < batch->env_count && count > 0; ++i) {
+    mjtNum* base = NULL;
+    int length = 0;
+    int width = 0;
+    gmj_field_lookup(batch->model->handle, batch->envs[i].handle, field, &base,
+                     &length, &width);
+    gmj_load_f32(base + start_index, values + (size_t)i * (size_t)count, count,
+                 level);
+  }
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+typedef struct gmj_batch_step_job {
+  const mjModel* model;
+  gmj_data* envs;
+  int steps;
+  /* Either the double or the float32 set of pointers is used; the other
+     stays NULL. */
+  const double* ctrl;
+  double* out_qpos;
+  double* out_qvel;
+  const float* ctrl_f32;
+  float* out_qpos_f32;
+  float* out_qvel_f32;
+  gmj_simd_level level;
+} gmj_batch_step_job;
+
+static void gmj_batch_step_env(void* context, int env_index) {
+  const gmj_batch_step_job* job = (const gmj_batch_step_job*)context;
+  const mjModel* m = job->model;
+  mjData* d = job->envs[env_index].handle;
+  const size_t env = (size_t)env_index;
+
+  if (job->ctrl != NULL && m->nu > 0) {
+    gmj_copy_to_mjtnum(d->ctrl, job->ctrl + env * (size_t)m->nu, m->nu);
+  } else if (job->ctrl_f32 != NULL && m->nu > 0) {
+    gmj_load_f32(d->ctrl, job->ctrl_f32 + env * (size_t)m->nu, m->nu,
+                 job->level);
+  }
+  gmj_data_advance(m, &job->envs[env_index], job->steps);
+  if (job->out_qpos != NULL) {
+    gmj_copy_from_mjtnum(job->out_qpos + env * (size_t)m->nq, d->qpos, m->nq);
+  }
+  if (job->out_qvel != NULL) {
+    gmj_copy_from_mjtnum(job->out_qvel + env * (size_t)m->nv, d->qvel, m->nv);
+  }
+  if (job->out_qpos_f32 != NULL) {
+    gmj_store_f32(job->out_qpos_f32 + env * (size_t)m->nq, d->qpos, m->nq,
+                  job->level);
+  }
+  if (job->out_qvel_f32 != NULL) {
+    gmj_store_f32(job->out_qvel_f32 + env * (size_t)m->nv, d->qvel, m->nv,
+                  job->level);
+  }
+}
+
+gmj_error_code gmj_batch_set_thread_pool(gmj_batch* batch,
+                                         gmj_thread_pool* pool) {
+  if (batch == NULL) {
+    gmj_set_error("batch is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  batch->pool = pool;
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_batch_step(gmj_batch* batch, const double* ctrl, int steps,
+                              double* out_qpos, double* out_qvel) {
+  gmj_batch_step_job job;
+  if (batch == NULL || batch->model == NULL || batch->model->handle == NULL) {
+    gmj_set_error("invalid batch pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (steps < 1) {
+    gmj_set_error("steps must be >= 1");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  memset(&job, 0, sizeof(job));
+  job.model = batch->model->handle;
+  job.envs = batch->envs;
+  job.ctrl = ctrl;
+  job.steps = steps;
+  job.out_qpos = out_qpos;
+  job.out_qvel = out_qvel;
+  gmj_pool_run(batch->pool, batch->env_count, gmj_batch_step_env, &job);
+
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_batch_step_f32(gmj_batch* batch, const float* ctrl,
+                                  int steps, float* out_qpos,
+                                  float* out_qvel) {
+  gmj_batch_step_job job;
+  if (batch == NULL || batch->model == NULL || batch->model->handle == NULL) {
+    gmj_set_error("invalid batch pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (steps < 1) {
+    gmj_set_error("steps must be >= 1");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  memset(&job, 0, sizeof(job));
+  job.model = batch->model->handle;
+  job.envs = batch->envs;
+  job.steps = steps;
+  job.ctrl_f32 = ctrl;
+  job.out_qpos_f32 = out_qpos;
+  job.out_qvel_f32 = out_qvel;
+  job.level = gmj_simd_active();
+  gmj_pool_run(batch->pool, batch->env_count, gmj_batch_step_env, &job);
+
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+typedef struct gmj_batch_transform_job {
+  const gmj_data* envs;
+  const int* body_ids;
+  int body_count;
+  const float* env_offsets;
+  gmj_transform_layout layout;
+  int flags;
+  float* out;
+} gmj_batch_transform_job;
+
+static void gmj_batch_transform_env(void* context, int env_index) {
+  const gmj_batch_transform_job* job =
+      (const gmj_batch_transform_job*)context;
+  const size_t env_stride = (size_t)job->body_count *
+                            (size_t)gmj_transform_stride(job->layout);
+  gmj_write_transforms(
+      job->envs[env_index].handle, job->body_ids, job->body_count,
+      job->env_offsets != NULL ? job->env_offsets + 3 * env_index : NULL,
+      job->layout, job->flags, job->out + (size_t)env_index * env_stride);
+}
+
+gmj_error_code gmj_batch_export_body_transforms(
+    const gmj_batch* batch, const int* body_ids, int body_count,
+    const float* env_offsets_xyz, gmj_transform_layout layout, int flags,
+    float* out_transforms) {
+  gmj_batch_transform_job job;
+  gmj_error_code valid = GMJ_OK;
+  if (batch == NULL || batch->model == NULL || batch->model->handle == NULL) {
+    gmj_set_error("invalid batch pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  valid = gmj_validate_transform_args(batch->model->handle, body_ids,
+                                      body_count, layout, out_transforms);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  job.envs = batch->envs;
+  job.body_ids = body_ids;
+  job.body_count = body_count;
+  job.env_offsets = env_offsets_xyz;
+  job.layout = layout;
+  job.flags = flags;
+  job.out = out_transforms;
+  gmj_pool_run(batch->pool, batch->env_count, gmj_batch_transform_env, &job);
+
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+typedef struct gmj_batch_contact_job {
+  const mjModel* model;
+  const gmj_data* envs;
+  const gmj_contact_filter* filter;
+  int flags;
+  gmj_contact* out;
+  int capacity;
+  int* counts;
+} gmj_batch_contact_job;
+
+static void gmj_batch_contact_env(void* context, int env_index) {
+  const gmj_batch_contact_job* job = (const gmj_batch_contact_job*)context;
+  job->counts[env_index] = gmj_write_contacts(
+      job->model, job->envs[env_index].handle, job->filter, job->flags,
+      job->out + (size_t)env_index * (size_t)job->capacity, job->capacity);
+}
+
+gmj_error_code gmj_batch_export_contacts(const gmj_batch* batch,
+                                         const gmj_contact_filter* filter,
+                                         int flags, gmj_contact* out_contacts,
+                                         int capacity_per_env,
+                                         int* out_counts) {
+  gmj_batch_contact_job job;
+  gmj_error_code valid = GMJ_OK;
+  if (batch == NULL || batch->model == NULL || batch->model->handle == NULL) {
+    gmj_set_error("invalid batch pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (out_counts == NULL) {
+    gmj_set_error("out_counts is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  valid = gmj_validate_contact_args(batch->model->handle, filter,
+                                    out_contacts, capacity_per_env);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+
+  job.model = batch->model->handle;
+  job.envs = batch->envs;
+  job.filter = filter;
+  job.flags = flags;
+  job.out = out_contacts;
+  job.capacity = capacity_per_env;
+  job.counts = out_counts;
+  gmj_pool_run(batch->pool, batch->env_count, gmj_batch_contact_env, &job);
+
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+typedef struct gmj_batch_ray_job {
+  const gmj_ray_set* set;
+  gmj_data* envs;
+  double* out_f64;
+  float* out_f32;
+  int* out_ids;
+  gmj_simd_level level;
+} gmj_batch_ray_job;
+
+static void gmj_batch_ray_env(void* context, int env_index) {
+  const gmj_batch_ray_job* job = (const gmj_batch_ray_job*)context;
+  const size_t offset = (size_t)env_index * (size_t)job->set->size;
+  gmj_cast_rays(job->set, job->envs[env_index].handle,
+                job->out_f64 != NULL ? job->out_f64 + offset : NULL,
+                job->out_f32 != NULL ? job->out_f32 + offset : NULL,
+                job->out_ids != NULL ? job->out_ids + offset : NULL,
+                job->level);
+}
+
+static gmj_error_code gmj_batch_raycast_run(const gmj_ray_set* set,
+                                            gmj_batch* batch, double* out_f64,
+                                            float* out_f32, int* out_ids) {
+  gmj_batch_ray_job job;
+  if (set == NULL || batch == NULL || batch->model == NULL ||
+      batch->model->handle == NULL) {
+    gmj_set_error("invalid ray set or batch pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (out_f64 == NULL && out_f32 == NULL) {
+    gmj_set_error("out_distances is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (set->model->handle != batch->model->handle) {
+    gmj_set_error("ray set was built for a different model");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  job.set = set;
+  job.envs = batch->envs;
+  job.out_f64 = out_f64;
+  job.out_f32 = out_f32;
+  job.out_ids = out_ids;
+  job.level = gmj_simd_active();
+  gmj_pool_run(batch->pool, batch->env_count, gmj_batch_ray_env, &job);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_batch_raycast(const gmj_ray_set* set, gmj_batch* batch,
+                                 double* out_distances, int* out_geom_ids) {
+  return gmj_batch_raycast_run(set, batch, out_distances, NULL, out_geom_ids);
+}
+
+gmj_error_code gmj_batch_raycast_f32(const gmj_ray_set* set, gmj_batch* batch,
+                                     float* out_distances, int* out_geom_ids) {
+  return gmj_batch_raycast_run(set, batch, NULL, out_distances, out_geom_ids);
+}
+
+typedef struct gmj_batch_obs_job {
+  const gmj_obs_spec* spec;
+  const gmj_data* envs;
+  double* out_f64;
+  float* out_f32;
+  gmj_simd_level level;
+} gmj_batch_obs_job;
+
+static void gmj_batch_obs_env(void* context, int env_index) {
+  const gmj_batch_obs_job* job = (const gmj_batch_obs_job*)context;
+  const size_t offset = (size_t)env_index * (size_t)job->spec->size;
+  if (job->out_f64 != NULL) {
+    gmj_obs_gather_f64(job->spec, job->envs[env_index].handle,
+                       job->out_f64 + offset);
+  } else {
+    gmj_obs_gather_f32(job->spec, job->envs[env_index].handle, job->level,
+                       job->out_f32 + offset);
+  }
+}
+
+static gmj_error_code gmj_batch_obs_run(const gmj_obs_spec* spec,
+                                        const gmj_batch* batch,
+                                        double* out_f64, float* out_f32) {
+  gmj_batch_obs_job job;
+  if (spec == NULL || batch == NULL || batch->model == NULL ||
+      batch->model->handle == NULL) {
+    gmj_set_error("invalid spec or batch pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (out_f64 == NULL && out_f32 == NULL) {
+    gmj_set_error("out_values is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (spec->model->handle != batch->model->handle) {
+    gmj_set_error("spec was built for a different model");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  job.spec = spec;
+  job.envs = batch->envs;
+  job.out_f64 = out_f64;
+  job.out_f32 = out_f32;
+  job.level = gmj_simd_active();
+  gmj_pool_run(batch->pool, batch->env_count, gmj_batch_obs_env, &job);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+gmj_error_code gmj_batch_obs_fill(const gmj_obs_spec* spec,
+                                  const gmj_batch* batch, double* out_values) {
+  return gmj_batch_obs_run(spec, batch, out_values, NULL);
+}
+
+gmj_error_code gmj_batch_obs_fill_f32(const gmj_obs_spec* spec,
+                                      const gmj_batch* batch,
+                                      float* out_values) {
+  return gmj_batch_obs_run(spec, batch, NULL, out_values);
+}
+
+gmj_error_code gmj_batch_sensor_read(const gmj_sensor_map* map,
+                                     const gmj_batch* batch,
+                                     double* out_values) {
+  if (map == NULL) {
+    gmj_set_error("map is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  return gmj_batch_obs_run(map->spec, batch, out_values, NULL);
+}
+
+gmj_error_code gmj_batch_sensor_read_f32(const gmj_sensor_map* map,
+                                         const gmj_batch* batch,
+                                         float* out_values) {
+  if (map == NULL) {
+    gmj_set_error("map is null");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  return gmj_batch_obs_run(map->spec, batch, NULL, out_values);
+}
+
+typedef struct gmj_batch_policy_job {
+  const gmj_policy* policy;
+  const gmj_obs_spec* spec;
+  gmj_data* envs;
+  gmj_simd_level level;
+  int ctrl_start;
+  double* out_actions;
+} gmj_batch_policy_job;
+
+static void gmj_batch_policy_env(void* context, int env_index) {
+  const gmj_batch_policy_job* job = (const gmj_batch_policy_job*)context;
+  double* out_actions =
+      job->out_actions != NULL
+          ? job->out_actions +
+                (size_t)env_index * (size_t)job->policy->action_size
+          : NULL;
+  gmj_policy_apply_data(job->policy, job->spec, job->level,
+                        job->envs[env_index].handle, job->ctrl_start,
+                        out_actions);
+}
+
+gmj_error_code gmj_batch_apply_policy(gmj_batch* batch,
+                                      const gmj_policy* policy,
+                                      const gmj_obs_spec* spec, int ctrl_start,
+                                      double* out_actions) {
+  gmj_batch_policy_job job;
+  gmj_error_code valid = GMJ_OK;
+  if (batch == NULL || batch->model == NULL || batch->model->handle == NULL) {
+    gmj_set_error("invalid batch pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  valid = gmj_policy_validate_apply(policy, spec, ctrl_start);
+  if (valid != GMJ_OK) {
+    return valid;
+  }
+  if (spec->model->handle != batch->model->handle) {
+    gmj_set_error("spec was built for a different model");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  job.policy = policy;
+  job.spec = spec;
+  job.envs = batch->envs;
+  job.level = gmj_simd_active();
+  job.ctrl_start = ctrl_start;
+  job.out_actions = out_actions;
+  gmj_pool_run(batch->pool, batch->env_count, gmj_batch_policy_env, &job);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+typedef struct gmj_batch_task_job {
+  const gmj_task* task;
+  gmj_data* envs;
+  const double* ctrl;
+  int steps;
+  double* out_rewards;
+  unsigned char* out_done;
+} gmj_batch_task_job;
+
+static void gmj_batch_task_env(void* context, int env_index) {
+  const gmj_batch_task_job* job = (const gmj_batch_task_job*)context;
+  const int nu = job->task->model->handle->nu;
+  gmj_data* env = &job->envs[env_index];
+  double reward = 0.0;
+  unsigned char done = GMJ_DONE_NONE;
+
+  if (job->ctrl != NULL && nu > 0) {
+    gmj_copy_to_mjtnum(env->handle->ctrl,
+                       job->ctrl + (size_t)env_index * (size_t)nu, nu);
+  }
+  gmj_task_step_data(job->task, env, job->steps, &reward, &done);
+  if (job->out_rewards != NULL) {
+    job->out_rewards[env_index] = reward;
+  }
+  if (job->out_done != NULL) {
+    job->out_done[env_index] = done;
+  }
+}
+
+gmj_error_code gmj_batch_step_task(gmj_batch* batch, const gmj_task* task,
+                                   const double* ctrl, int steps,
+                                   double* out_rewards,
+                                   unsigned char* out_done) {
+  gmj_batch_task_job job;
+  if (batch == NULL || batch->model == NULL || batch->model->handle == NULL ||
+      task == NULL) {
+    gmj_set_error("invalid batch or task pointer");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (task->model->handle != batch->model->handle) {
+    gmj_set_error("task was built for a different model");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+  if (steps < 1) {
+    gmj_set_error("steps must be >= 1");
+    return GMJ_ERR_INVALID_ARGUMENT;
+  }
+
+  job.task = task;
+  job.envs = batch->envs;
+  job.ctrl = ctrl;
+  job.steps = steps;
+  job.out_rewards = out_rewards;
+  job.out_done = out_done;
+  gmj_pool_run(batch->pool, batch->env_count, gmj_batch_task_env, &job);
+  gmj_set_error(NULL);
+  return GMJ_OK;
+}
+
+const char* gmj_last_mujoco_error(void) {
+  return gmj_error_storage;
+}
+
+#else
+
+static gmj_error_code gmj_unavailable(void) {
+  gmj_set_error("MuJoCo headers unavailable at build time");
+  return GMJ_ERR_MUJOCO;
+}
+
+const char* gmj_mujoco_version(void) { return "unavailable"; }
+
+gmj_model* gmj_model_load_xml(const char* xml_path, char* error_buffer,
+                              size_t error_buffer_size) {
+  (void)xml_path;
+  if (error_buffer != NULL && error_buffer_size > 0) {
+    const char* message = "MuJoCo headers unavailable at build time";
+    strncpy(error_buffer, message, error_buffer_size);
+    error_buffer[error_buffer_size - 1] = '\0';
+  }
+  gmj_unavailable();
+  return NULL;
+}
+
+gmj_model* gmj_model_acquire_xml(const char* xml_path, char* error_buffer,
+                                 size_t error_buffer_size) {
+  (void)xml_path;
+  if (error_buffer != NULL && error_buffer_size > 0) {
+    const char* message = "MuJoCo headers unavailable at build time";
+    strncpy(error_buffer, message, error_buffer_size);
+    error_buffer[error_buffer_size - 1] = '\0';
+  }
+  gmj_unavailable();
+  return NULL;
+}
+
+int gmj_model_cache_count(void) { return 0; }
+
+int gmj_model_refcount(const gmj_model* model) {
+  (void)model;
+  gmj_unavailable();
+  return -1;
+}
+
+void gmj_model_free(gmj_model* model) { (void)model; }
+
+gmj_reloader* gmj_reloader_create(const char* xml_path, double poll_seconds) {
+  (void)xml_path;
+  (void)poll_seconds;
+  gmj_unavailable();
+  return NULL;
+}
+
+void gmj_reloader_free(gmj_reloader* reloader) { (void)reloader; }
+
+gmj_model* gmj_reloader_latest(gmj_reloader* reloader,
+                               unsigned long long* inout_generation) {
+  (void)reloader;
+  (void)inout_generation;
+  gmj_unavailable();
+  return NULL;
+}
+
+gmj_error_code gmj_reloader_info(gmj_reloader* reloader,
+                                 gmj_reload_info* out_info) {
+  (void)reloader;
+  (void)out_info;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_reloader_last_error(gmj_reloader* reloader, char* buffer,
+                                       size_t buffer_size) {
+  (void)reloader;
+  (void)buffer;
+  (void)buffer_size;
+  return gmj_unavailable();
+}
+
+gmj_vfs* gmj_vfs_create(void) {
+  gmj_unavailable();
+  return NULL;
+}
+
+void gmj_vfs_free(gmj_vfs* vfs) { (void)vfs; }
+
+gmj_error_code gmj_vfs_add_buffer(gmj_vfs* vfs, const char* name,
+                                  const void* buffer, size_t size) {
+  (void)vfs;
+  (void)name;
+  (void)buffer;
+  (void)size;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_vfs_remove(gmj_vfs* vfs, const char* name) {
+  (void)vfs;
+  (void)name;
+  return gmj_unavailable();
+}
+
+gmj_model* gmj_model_load_buffer(const char* name, const void* buffer,
+                                 size_t size, gmj_vfs* vfs,
+                                 char* error_buffer,
+                                 size_t error_buffer_size) {
+  (void)name;
+  (void)buffer;
+  (void)size;
+  (void)vfs;
+  if (error_buffer != NULL && error_buffer_size > 0) {
+    const char* message = "MuJoCo headers unavailable at build time";
+    strncpy(error_buffer, message, error_buffer_size);
+    error_buffer[error_buffer_size - 1] = '\0';
+  }
+  gmj_unavailable();
+  return NULL;
+}
+
+gmj_model* gmj_model_load_xml_string(const char* xml, gmj_vfs* vfs,
+                                     char* error_buffer,
+                                     size_t error_buffer_size) {
+  (void)xml;
+  return gmj_model_load_buffer("inline.xml", NULL, 0, vfs, error_buffer,
+                               error_buffer_size);
+}
+
+gmj_error_code gmj_compile_cache_set_dir(const char* cache_dir) {
+  (void)cache_dir;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_model_load_info(const gmj_model* model,
+                                   gmj_load_info* out_info) {
+  (void)model;
+  (void)out_info;
+  return gmj_unavailable();
+}
+
+gmj_recorder* gmj_recorder_open(const gmj_model* model, const char* path,
+                                int signature, int keyframe_interval,
+                                double quantum, char* error_buffer,
+                                size_t error_buffer_size) {
+  (void)model;
+  (void)path;
+  (void)signature;
+  (void)keyframe_interval;
+  (void)quantum;
+  if (error_buffer != NULL && error_buffer_size > 0) {
+    const char* message = "MuJoCo headers unavailable at build time";
+    strncpy(error_buffer, message, error_buffer_size);
+    error_buffer[error_buffer_size - 1] = '\0';
+  }
+  gmj_unavailable();
+  return NULL;
+}
+
+gmj_error_code gmj_recorder_attach(gmj_recorder* recorder, gmj_data* data) {
+  (void)recorder;
+  (void)data;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_recorder_append(gmj_recorder* recorder,
+                                   const gmj_data* data) {
+  (void)recorder;
+  (void)data;
+  return gmj_unavailable();
+}
+
+long long gmj_recorder_frame_count(const gmj_recorder* recorder) {
+  (void)recorder;
+  gmj_unavailable();
+  return -1;
+}
+
+gmj_error_code gmj_recorder_close(gmj_recorder* recorder) {
+  (void)recorder;
+  return gmj_unavailable();
+}
+
+gmj_replay* gmj_replay_open(const char* path, char* error_buffer,
+                            size_t error_buffer_size) {
+  (void)path;
+  if (error_buffer != NULL && error_buffer_size > 0) {
+    const char* message = "MuJoCo headers unavailable at build time";
+    strncpy(error_buffer, message, error_buffer_size);
+    error_buffer[error_buffer_size - 1] = '\0';
+  }
+  gmj_unavailable();
+  return NULL;
+}
+
+void gmj_replay_close(gmj_replay* replay) { (void)replay; }
+
+gmj_error_code gmj_replay_get_info(const gmj_replay* replay,
+                                   gmj_replay_info* out_info) {
+  (void)replay;
+  (void)out_info;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_replay_read(gmj_replay* replay, long long step,
+                               double* out_ctrl, double* out_state) {
+  (void)replay;
+  (void)step;
+  (void)out_ctrl;
+  (void)out_state;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_replay_apply(gmj_replay* replay, const gmj_model* model,
+                                gmj_data* data, long long step) {
+  (void)replay;
+  (void)model;
+  (void)data;
+  (void)step;
+  return gmj_unavailable();
+}
+
+gmj_data* gmj_data_create(const gmj_model* model) {
+  (void)model;
+  gmj_unavailable();
+  return NULL;
+}
+
+gmj_data* gmj_data_create_sized(const gmj_model* model, size_t arena_bytes) {
+  (void)model;
+  (void)arena_bytes;
+  gmj_unavailable();
+  return NULL;
+}
+
+void gmj_data_free(gmj_data* data) { (void)data; }
+
+gmj_data_pool* gmj_data_pool_create(int max_idle) {
+  (void)max_idle;
+  gmj_unavailable();
+  return NULL;
+}
+
+void gmj_data_pool_free(gmj_data_pool* pool) { (void)pool; }
+
+gmj_data* gmj_data_pool_acquire(gmj_data_pool* pool, const gmj_model* model,
+                                size_t arena_bytes) {
+  (void)pool;
+  (void)model;
+  (void)arena_bytes;
+  gmj_unavailable();
+  return NULL;
+}
+
+void gmj_data_pool_release(gmj_data_pool* pool, const gmj_model* model,
+                           gmj_data* data) {
+  (void)pool;
+  (void)model;
+  (void)data;
+}
+
+int gmj_data_pool_trim(gmj_data_pool* pool, const gmj_model* model) {
+  (void)pool;
+  (void)model;
+  gmj_unavailable();
+  return -1;
+}
+
+gmj_error_code gmj_data_pool_stats(gmj_data_pool* pool,
+                                   gmj_data_pool_info* out_info) {
+  (void)pool;
+  (void)out_info;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_data_migrate(const gmj_model* old_model, gmj_data* data,
+                                const gmj_model* new_model) {
+  (void)old_model;
+  (void)data;
+  (void)new_model;
+  return gmj_unavailable();
+}
+
+gmj_randomizer* gmj_randomizer_create(const gmj_model* model) {
+  (void)model;
+  gmj_unavailable();
+  return NULL;
+}
+
+void gmj_randomizer_free(gmj_randomizer* randomizer) { (void)randomizer; }
+
+gmj_error_code gmj_randomizer_add(gmj_randomizer* randomizer, gmj_param param,
+                                  const char* name, gmj_rand_op op,
+                                  gmj_dist dist, double a, double b) {
+  (void)randomizer;
+  (void)param;
+  (void)name;
+  (void)op;
+  (void)dist;
+  (void)a;
+  (void)b;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_data_randomize(const gmj_model* model, gmj_data* data,
+                                  const gmj_randomizer* randomizer,
+                                  unsigned long long seed) {
+  (void)model;
+  (void)data;
+  (void)randomizer;
+  (void)seed;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_data_param(const gmj_model* model, const gmj_data* data,
+                              gmj_param param, int index, double* out_value) {
+  (void)model;
+  (void)data;
+  (void)param;
+  (void)index;
+  (void)out_value;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_reset_data(const gmj_model* model, gmj_data* data) {
+  (void)model;
+  (void)data;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_step(const gmj_model* model, gmj_data* data, int steps) {
+  (void)model;
+  (void)data;
+  (void)steps;
+  return gmj_unavailable();
+}
+
+int gmj_nq(const gmj_model* model) {
+  (void)model;
+  gmj_unavailable();
+  return -1;
+}
+
+int gmj_nv(const gmj_model* model) {
+  (void)model;
+  gmj_unavailable();
+  return -1;
+}
+
+int gmj_nu(const gmj_model* model) {
+  (void)model;
+  gmj_unavailable();
+  return -1;
+}
+
+int gmj_nbody(const gmj_model* model) {
+  (void)model;
+  gmj_unavailable();
+  return -1;
+}
+
+int gmj_body_id(const gmj_model* model, const char* body_name) {
+  (void)model;
+  (void)body_name;
+  gmj_unavailable();
+  return -1;
+}
+
+int gmj_joint_id(const gmj_model* model, const char* joint_name) {
+  (void)model;
+  (void)joint_name;
+  gmj_unavailable();
+  return -1;
+}
+
+int gmj_actuator_id(const gmj_model* model, const char* actuator_name) {
+  (void)model;
+  (void)actuator_name;
+  gmj_unavailable();
+  return -1;
+}
+
+const char* gmj_body_name(const gmj_model* model, int body_id) {
+  (void)model;
+  (void)body_id;
+  gmj_unavailable();
+  return NULL;
+}
+
+const char* gmj_joint_name(const gmj_model* model, int joint_id) {
+  (void)model;
+  (void)joint_id;
+  gmj_unavailable();
+  return NULL;
+}
+
+const char* gmj_actuator_name(const gmj_model* model, int actuator_id) {
+  (void)model;
+  (void)actuator_id;
+  gmj_unavailable();
+  return NULL;
+}
+
+gmj_error_code gmj_set_ctrl(const gmj_model* model, gmj_data* data,
+                            int actuator_index, double value) {
+  (void)model;
+  (void)data;
+  (void)actuator_index;
+  (void)value;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_get_ctrl(const gmj_model* model, const gmj_data* data,
+                            int actuator_index, double* out_value) {
+  (void)model;
+  (void)data;
+  (void)actuator_index;
+  (void)out_value;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_get_qpos(const gmj_model* model, const gmj_data* data,
+                            int qpos_index, double* out_value) {
+  (void)model;
+  (void)data;
+  (void)qpos_index;
+  (void)out_value;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_set_qpos(const gmj_model* model, gmj_data* data,
+                            int qpos_index, double value) {
+  (void)model;
+  (void)data;
+  (void)qpos_index;
+  (void)value;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_get_qvel(const gmj_model* model, const gmj_data* data,
+                            int qvel_index, double* out_value) {
+  (void)model;
+  (void)data;
+  (void)qvel_index;
+  (void)out_value;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_set_qvel(const gmj_model* model, gmj_data* data,
+                            int qvel_index, double value) {
+  (void)model;
+  (void)data;
+  (void)qvel_index;
+  (void)value;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_get_qpos_slice(const gmj_model* model, const gmj_data* data,
+                                  int start_index, int count,
+                                  double* out_values) {
+  (void)model;
+  (void)data;
+  (void)start_index;
+  (void)count;
+  (void)out_values;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_set_qpos_slice(const gmj_model* model, gmj_data* data,
+                                  int start_index, int count,
+                                  const double* values) {
+  (void)model;
+  (void)data;
+  (void)start_index;
+  (void)count;
+  (void)values;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_get_qvel_slice(const gmj_model* model, const gmj_data* data,
+                                  int start_index, int count,
+                                  double* out_values) {
+  (void)model;
+  (void)data;
+  (void)start_index;
+  (void)count;
+  (void)out_values;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_set_qvel_slice(const gmj_model* model, gmj_data* data,
+                                  int start_index, int count,
+                                  const double* values) {
+  (void)model;
+  (void)data;
+  (void)start_index;
+  (void)count;
+  (void)values;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_get_ctrl_slice(const gmj_model* model, const gmj_data* data,
+                                  int start_index, int count,
+                                  double* out_values) {
+  (void)model;
+  (void)data;
+  (void)start_index;
+  (void)count;
+  (void)out_values;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_set_ctrl_slice(const gmj_model* model, gmj_data* data,
+                                  int start_index, int count,
+                                  const double* values) {
+  (void)model;
+  (void)data;
+  (void)start_index;
+  (void)count;
+  (void)values;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_body_world_position(const gmj_model* model,
+                                       const gmj_data* data, int body_index,
+                                       double* out_xyz_3) {
+  (void)model;
+  (void)data;
+  (void)body_index;
+  (void)out_xyz_3;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_forward(const gmj_model* model, gmj_data* data) {
+  (void)model;
+  (void)data;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_data_view(const gmj_model* model, gmj_data* data,
+                             gmj_state_field field, gmj_view* out_view) {
+  (void)model;
+  (void)data;
+  (void)field;
+  (void)out_view;
+  return gmj_unavailable();
+}
+
+unsigned long long gmj_data_generation(const gmj_data* data) {
+  (void)data;
+  gmj_unavailable();
+  return 0;
+}
+
+int gmj_state_size(const gmj_model* model, int signature) {
+  (void)model;
+  (void)signature;
+  gmj_unavailable();
+  return -1;
+}
+
+gmj_error_code gmj_state_save(const gmj_model* model, const gmj_data* data,
+                              int signature, double* out_state) {
+  (void)model;
+  (void)data;
+  (void)signature;
+  (void)out_state;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_state_restore(const gmj_model* model, gmj_data* data,
+                                 int signature, const double* state) {
+  (void)model;
+  (void)data;
+  (void)signature;
+  (void)state;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_snapshot_ring_configure(const gmj_model* model,
+                                           gmj_data* data, int capacity,
+                                           int signature) {
+  (void)model;
+  (void)data;
+  (void)capacity;
+  (void)signature;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_snapshot_push(const gmj_model* model, gmj_data* data) {
+  (void)model;
+  (void)data;
+  return gmj_unavailable();
+}
+
+int gmj_snapshot_count(const gmj_data* data) {
+  (void)data;
+  gmj_unavailable();
+  return -1;
+}
+
+gmj_error_code gmj_snapshot_restore(const gmj_model* model, gmj_data* data,
+                                    int age) {
+  (void)model;
+  (void)data;
+  (void)age;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_snapshot_rollback(const gmj_model* model, gmj_data* data,
+                                     int age) {
+  (void)model;
+  (void)data;
+  (void)age;
+  return gmj_unavailable();
+}
+
+gmj_thread_pool* gmj_thread_pool_create(int thread_count) {
+  (void)thread_count;
+  gmj_unavailable();
+  return NULL;
+}
+
+void gmj_thread_pool_free(gmj_thread_pool* pool) { (void)pool; }
+
+int gmj_thread_pool_size(const gmj_thread_pool* pool) {
+  (void)pool;
+  gmj_unavailable();
+  return -1;
+}
+
+gmj_error_code gmj_thread_pool_stats(const gmj_thread_pool* pool,
+                                     int thread_index,
+                                     gmj_thread_stats* out_stats) {
+  (void)pool;
+  (void)thread_index;
+  (void)out_stats;
+  return gmj_unavailable();
+}
+
+void gmj_thread_pool_reset_stats(gmj_thread_pool* pool) { (void)pool; }
+
+gmj_error_code gmj_batch_set_thread_pool(gmj_batch* batch,
+                                         gmj_thread_pool* pool) {
+  (void)batch;
+  (void)pool;
+  return gmj_unavailable();
+}
+
+gmj_batch* gmj_batch_create(const gmj_model* model, int env_count) {
+  (void)model;
+  (void)env_count;
+  gmj_unavailable();
+  return NULL;
+}
+
+gmj_batch* gmj_batch_create_sized(const gmj_model* model, int env_count,
+                                  size_t arena_bytes) {
+  (void)model;
+  (void)env_count;
+  (void)arena_bytes;
+  gmj_unavailable();
+  return NULL;
+}
+
+void gmj_batch_free(gmj_batch* batch) { (void)batch; }
+
+int gmj_batch_size(const gmj_batch* batch) {
+  (void)batch;
+  gmj_unavailable();
+  return -1;
+}
+
+gmj_data* gmj_batch_env(gmj_batch* batch, int env_index) {
+  (void)batch;
+  (void)env_index;
+  gmj_unavailable();
+  return NULL;
+}
+
+gmj_error_code gmj_batch_reset(gmj_batch* batch) {
+  (void)batch;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_batch_reset_env(gmj_batch* batch, int env_index) {
+  (void)batch;
+  (void)env_index;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_batch_reload(gmj_batch* batch, const gmj_model* new_model) {
+  (void)batch;
+  (void)new_model;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_batch_randomize(gmj_batch* batch,
+                                   const gmj_randomizer* randomizer,
+                                   unsigned long long seed) {
+  (void)batch;
+  (void)randomizer;
+  (void)seed;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_batch_step(gmj_batch* batch, const double* ctrl, int steps,
+                              double* out_qpos, double* out_qvel) {
+  (void)batch;
+  (void)ctrl;
+  (void)steps;
+  (void)out_qpos;
+  (void)out_qvel;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_batch_get_state(const gmj_batch* batch, double* out_qpos,
+                                   double* out_qvel) {
+  (void)batch;
+  (void)out_qpos;
+  (void)out_qvel;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_export_body_transforms(const gmj_model* model,
+                                          const gmj_data* data,
+                                          const int* body_ids, int body_count,
+                                          const float* world_offset_xyz,
+                                          gmj_transform_layout layout,
+                                          int flags, float* out_transforms) {
+  (void)model;
+  (void)data;
+  (void)body_ids;
+  (void)body_count;
+  (void)world_offset_xyz;
+  (void)layout;
+  (void)flags;
+  (void)out_transforms;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_batch_export_body_transforms(
+    const gmj_batch* batch, const int* body_ids, int body_count,
+    const float* env_offsets_xyz, gmj_transform_layout layout, int flags,
+    float* out_transforms) {
+  (void)batch;
+  (void)body_ids;
+  (void)body_count;
+  (void)env_offsets_xyz;
+  (void)layout;
+  (void)flags;
+  (void)out_transforms;
+  return gmj_unavailable();
+}
+
+gmj_obs_spec* gmj_obs_spec_create(const gmj_model* model) {
+  (void)model;
+  gmj_unavailable();
+  return NULL;
+}
+
+void gmj_obs_spec_free(gmj_obs_spec* spec) { (void)spec; }
+
+int gmj_obs_spec_size(const gmj_obs_spec* spec) {
+  (void)spec;
+  gmj_unavailable();
+  return -1;
+}
+
+gmj_error_code gmj_obs_spec_add_range(gmj_obs_spec* spec,
+                                      gmj_obs_source source, int start_index,
+                                      int count) {
+  (void)spec;
+  (void)source;
+  (void)start_index;
+  (void)count;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_obs_spec_add_body(gmj_obs_spec* spec,
+                                     gmj_obs_source source, int body_id,
+                                     int root_body_id) {
+  (void)spec;
+  (void)source;
+  (void)body_id;
+  (void)root_body_id;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_obs_fill(const gmj_obs_spec* spec, const gmj_data* data,
+                            double* out_values) {
+  (void)spec;
+  (void)data;
+  (void)out_values;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_obs_fill_f32(const gmj_obs_spec* spec, const gmj_data* data,
+                                float* out_values) {
+  (void)spec;
+  (void)data;
+  (void)out_values;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_batch_obs_fill(const gmj_obs_spec* spec,
+                                  const gmj_batch* batch, double* out_values) {
+  (void)spec;
+  (void)batch;
+  (void)out_values;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_batch_obs_fill_f32(const gmj_obs_spec* spec,
+                                      const gmj_batch* batch,
+                                      float* out_values) {
+  (void)spec;
+  (void)batch;
+  (void)out_values;
+  return gmj_unavailable();
+}
+
+gmj_simd_level gmj_simd_get_level(void) { return GMJ_SIMD_SCALAR; }
+
+void gmj_simd_set_limit(gmj_simd_level max_level) { (void)max_level; }
+
+gmj_policy* gmj_policy_load(const char* policy_path, const char* vecnorm_path,
+                            char* error_buffer, size_t error_buffer_size) {
+  (void)policy_path;
+  (void)vecnorm_path;
+  if (error_buffer != NULL && error_buffer_size > 0) {
+    const char* message = "MuJoCo headers unavailable at build time";
+    strncpy(error_buffer, message, error_buffer_size);
+    error_buffer[error_buffer_size - 1] = '\0';
+  }
+  gmj_unavailable();
+  return NULL;
+}
+
+gmj_policy* gmj_policy_load_json(const char* policy_json,
+                                 const char* vecnorm_json, char* error_buffer,
+                                 size_t error_buffer_size) {
+  (void)policy_json;
+  (void)vecnorm_json;
+  return gmj_policy_load(NULL, NULL, error_buffer, error_buffer_size);
+}
+
+void gmj_policy_free(gmj_policy* policy) { (void)policy; }
+
+int gmj_policy_obs_size(const gmj_policy* policy) {
+  (void)policy;
+  gmj_unavailable();
+  return -1;
+}
+
+int gmj_policy_action_size(const gmj_policy* policy) {
+  (void)policy;
+  gmj_unavailable();
+  return -1;
+}
+
+gmj_error_code gmj_policy_infer(const gmj_policy* policy,
+                                const double* observation, int obs_count,
+                                double* out_actions, int action_count) {
+  (void)policy;
+  (void)observation;
+  (void)obs_count;
+  (void)out_actions;
+  (void)action_count;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_policy_apply(const gmj_policy* policy,
+                                const gmj_obs_spec* spec, gmj_data* data,
+                                int ctrl_start, double* out_actions) {
+  (void)policy;
+  (void)spec;
+  (void)data;
+  (void)ctrl_start;
+  (void)out_actions;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_batch_apply_policy(gmj_batch* batch,
+                                      const gmj_policy* policy,
+                                      const gmj_obs_spec* spec, int ctrl_start,
+                                      double* out_actions) {
+  (void)batch;
+  (void)policy;
+  (void)spec;
+  (void)ctrl_start;
+  (void)out_actions;
+  return gmj_unavailable();
+}
+
+gmj_task* gmj_task_create(const gmj_model* model) {
+  (void)model;
+  gmj_unavailable();
+  return NULL;
+}
+
+void gmj_task_free(gmj_task* task) { (void)task; }
+
+gmj_error_code gmj_task_add_reward(gmj_task* task, gmj_reward_term term,
+                                   int body_id, int axis, double threshold,
+                                   double weight) {
+  (void)task;
+  (void)term;
+  (void)body_id;
+  (void)axis;
+  (void)threshold;
+  (void)weight;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_task_add_termination(gmj_task* task,
+                                        gmj_termination condition,
+                                        int body_id, int axis,
+                                        double threshold) {
+  (void)task;
+  (void)condition;
+  (void)body_id;
+  (void)axis;
+  (void)threshold;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_task_set_time_limit(gmj_task* task, double seconds) {
+  (void)task;
+  (void)seconds;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_task_set_reset_keyframe(gmj_task* task, int key_index) {
+  (void)task;
+  (void)key_index;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_task_step(const gmj_task* task, gmj_data* data, int steps,
+                             double* out_reward, unsigned char* out_done) {
+  (void)task;
+  (void)data;
+  (void)steps;
+  (void)out_reward;
+  (void)out_done;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_batch_step_task(gmj_batch* batch, const gmj_task* task,
+                                   const double* ctrl, int steps,
+                                   double* out_rewards,
+                                   unsigned char* out_done) {
+  (void)batch;
+  (void)task;
+  (void)ctrl;
+  (void)steps;
+  (void)out_rewards;
+  (void)out_done;
+  return gmj_unavailable();
+}
+
+gmj_sim_thread* gmj_sim_thread_start(const gmj_model* model, gmj_data* data,
+                                     const gmj_task* task,
+                                     double tick_rate_hz, int steps_per_tick,
+                                     int queue_capacity) {
+  (void)model;
+  (void)data;
+  (void)task;
+  (void)tick_rate_hz;
+  (void)steps_per_tick;
+  (void)queue_capacity;
+  gmj_unavailable();
+  return NULL;
+}
+
+void gmj_sim_thread_stop(gmj_sim_thread* sim) { (void)sim; }
+
+gmj_error_code gmj_sim_post_ctrl(gmj_sim_thread* sim, int start_index,
+                                 int count, const double* values) {
+  (void)sim;
+  (void)start_index;
+  (void)count;
+  (void)values;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_sim_post_reset(gmj_sim_thread* sim) {
+  (void)sim;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_sim_latest_state(gmj_sim_thread* sim,
+                                    gmj_sim_state* out_state,
+                                    gmj_sim_stats* out_stats) {
+  (void)sim;
+  (void)out_state;
+  (void)out_stats;
+  return gmj_unavailable();
+}
+
+gmj_pose_buffer* gmj_pose_buffer_create(const gmj_model* model) {
+  (void)model;
+  gmj_unavailable();
+  return NULL;
+}
+
+void gmj_pose_buffer_free(gmj_pose_buffer* buffer) { (void)buffer; }
+
+gmj_error_code gmj_pose_buffer_push(gmj_pose_buffer* buffer,
+                                    const gmj_data* data) {
+  (void)buffer;
+  (void)data;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_pose_buffer_interpolate(gmj_pose_buffer* buffer,
+                                           float alpha, const int* body_ids,
+                                           int body_count,
+                                           const float* world_offset_xyz,
+                                           gmj_transform_layout layout,
+                                           int flags, float* out_transforms) {
+  (void)buffer;
+  (void)alpha;
+  (void)body_ids;
+  (void)body_count;
+  (void)world_offset_xyz;
+  (void)layout;
+  (void)flags;
+  (void)out_transforms;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_sim_interpolate_transforms(
+    gmj_sim_thread* sim, float alpha, const int* body_ids, int body_count,
+    const float* world_offset_xyz, gmj_transform_layout layout, int flags,
+    float* out_transforms) {
+  (void)sim;
+  (void)alpha;
+  (void)body_ids;
+  (void)body_count;
+  (void)world_offset_xyz;
+  (void)layout;
+  (void)flags;
+  (void)out_transforms;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_data_stats(const gmj_model* model, const gmj_data* data,
+                              gmj_stats* out_stats) {
+  (void)model;
+  (void)data;
+  (void)out_stats;
+  return gmj_unavailable();
+}
+
+void gmj_data_reset_stats(gmj_data* data) { (void)data; }
+
+void gmj_stats_enable_timers(int enabled) { (void)enabled; }
+
+gmj_error_code gmj_batch_stats(const gmj_batch* batch, gmj_stats* out_stats) {
+  (void)batch;
+  (void)out_stats;
+  return gmj_unavailable();
+}
+
+gmj_cmd_list* gmj_cmd_list_create(const gmj_model* model) {
+  (void)model;
+  gmj_unavailable();
+  return NULL;
+}
+
+void gmj_cmd_list_free(gmj_cmd_list* list) { (void)list; }
+
+int gmj_cmd_list_size(const gmj_cmd_list* list) {
+  (void)list;
+  gmj_unavailable();
+  return -1;
+}
+
+void gmj_cmd_list_clear(gmj_cmd_list* list) { (void)list; }
+
+gmj_error_code gmj_cmd_set_ctrl(gmj_cmd_list* list, int start_index,
+                                int count, const double* values) {
+  (void)list;
+  (void)start_index;
+  (void)count;
+  (void)values;
+  return gmj_unavailable();
 }
 
-const char* gmj_last_mujoco_error(void) {
-  return gmj_error_storage;
+gmj_error_code gmj_cmd_step(gmj_cmd_list* list, int steps) {
+  (void)list;
+  (void)steps;
+  return gmj_unavailable();
 }
 
-#else
+gmj_error_code gmj_cmd_copy(gmj_cmd_list* list, gmj_state_field field,
+                            int start_index, int count, double* out_values) {
+  (void)list;
+  (void)field;
+  (void)start_index;
+  (void)count;
+  (void)out_values;
+  return gmj_unavailable();
+}
 
-static gmj_error_code gmj_unavailable(void) {
-  gmj_set_error("MuJoCo headers unavailable at build time");
-  return GMJ_ERR_MUJOCO;
+gmj_error_code gmj_cmd_export_transforms(gmj_cmd_list* list,
+                                         const int* body_ids, int body_count,
+                                         const float* world_offset_xyz,
+                                         gmj_transform_layout layout,
+                                         int flags, float* out_transforms) {
+  (void)list;
+  (void)body_ids;
+  (void)body_count;
+  (void)world_offset_xyz;
+  (void)layout;
+  (void)flags;
+  (void)out_transforms;
+  return gmj_unavailable();
 }
 
-const char* gmj_mujoco_version(void) { return "unavailable"; }
+gmj_error_code gmj_execute(const gmj_cmd_list* list, gmj_data* data) {
+  (void)list;
+  (void)data;
+  return gmj_unavailable();
+}
 
-gmj_model* gmj_model_load_xml(const char* xml_path, char* error_buffer,
-                              size_t error_buffer_size) {
-  (void)xml_path;
-  if (error_buffer != NULL && error_buffer_size > 0) {
-    const char* message = "MuJoCo headers unavailable at build time";
-    strncpy(error_buffer, message, error_buffer_size);
-    error_buffer[error_buffer_size - 1] = '\0';
-  }
-  gmj_unavailable();
-  return NULL;
+gmj_error_code gmj_get_qpos_slice_f32(const gmj_model* model,
+                                      const gmj_data* data, int start_index,
+                                      int count, float* out_values) {
+  (void)model;
+  (void)data;
+  (void)start_index;
+  (void)count;
+  (void)out_values;
+  return gmj_unavailable();
 }
 
-void gmj_model_free(gmj_model* model) { (void)model; }
+gmj_error_code gmj_set_qpos_slice_f32(const gmj_model* model, gmj_data* data,
+                                      int start_index, int count,
+                                      const float* values) {
+  (void)model;
+  (void)data;
+  (void)start_index;
+  (void)count;
+  (void)values;
+  return gmj_unavailable();
+}
 
-gmj_data* gmj_data_create(const gmj_model* model) {
+gmj_error_code gmj_get_qvel_slice_f32(const gmj_model* model,
+                                      const gmj_data* data, int start_index,
+                                      int count, float* out_values) {
   (void)model;
-  gmj_unavailable();
-  return NULL;
+  (void)data;
+  (void)start_index;
+  (void)count;
+  (void)out_values;
+  return gmj_unavailable();
 }
 
-void gmj_data_free(gmj_data* data) { (void)data; }
+gmj_error_code gmj_set_qvel_slice_f32(const gmj_model* model, gmj_data* data,
+                                      int start_index, int count,
+                                      const float* values) {
+  (void)model;
+  (void)data;
+  (void)start_index;
+  (void)count;
+  (void)values;
+  return gmj_unavailable();
+}
 
-gmj_error_code gmj_reset_data(const gmj_model* model, gmj_data* data) {
+gmj_error_code gmj_get_ctrl_slice_f32(const gmj_model* model,
+                                      const gmj_data* data, int start_index,
+                                      int count, float* out_values) {
   (void)model;
   (void)data;
+  (void)start_index;
+  (void)count;
+  (void)out_values;
   return gmj_unavailable();
 }
 
-gmj_error_code gmj_step(const gmj_model* model, gmj_data* data, int steps) {
+gmj_error_code gmj_set_ctrl_slice_f32(const gmj_model* model, gmj_data* data,
+                                      int start_index, int count,
+                                      const float* values) {
+  (void)model;
+  (void)data;
+  (void)start_index;
+  (void)count;
+  (void)values;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_get_slice_f32(const gmj_model* model, const gmj_data* data,
+                                 gmj_state_field field, int start_index,
+                                 int count, float* out_values) {
+  (void)model;
+  (void)data;
+  (void)field;
+  (void)start_index;
+  (void)count;
+  (void)out_values;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_set_slice_f32(const gmj_model* model, gmj_data* data,
+                                 gmj_state_field field, int start_index,
+                                 int count, const float* values) {
   (void)model;
   (void)data;
+  (void)field;
+  (void)start_index;
+  (void)count;
+  (void)values;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_batch_step_f32(gmj_batch* batch, const float* ctrl,
+                                  int steps, float* out_qpos,
+                                  float* out_qvel) {
+  (void)batch;
+  (void)ctrl;
   (void)steps;
+  (void)out_qpos;
+  (void)out_qvel;
   return gmj_unavailable();
 }
 
-int gmj_nq(const gmj_model* model) {
+gmj_error_code gmj_batch_get_state_f32(const gmj_batch* batch, float* out_qpos,
+                                       float* out_qvel) {
+  (void)batch;
+  (void)out_qpos;
+  (void)out_qvel;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_batch_get_slice_f32(const gmj_batch* batch,
+                                       gmj_state_field field, int start_index,
+                                       int count, float* out_values) {
+  (void)batch;
+  (void)field;
+  (void)start_index;
+  (void)count;
+  (void)out_values;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_batch_set_slice_f32(gmj_batch* batch,
+                                       gmj_state_field field, int start_index,
+                                       int count, const float* values) {
+  (void)batch;
+  (void)field;
+  (void)start_index;
+  (void)count;
+  (void)values;
+  return gmj_unavailable();
+}
+
+gmj_contact_filter* gmj_contact_filter_create(const gmj_model* model) {
   (void)model;
   gmj_unavailable();
-  return -1;
+  return NULL;
 }
 
-int gmj_nv(const gmj_model* model) {
+void gmj_contact_filter_free(gmj_contact_filter* filter) { (void)filter; }
+
+gmj_error_code gmj_contact_filter_add_body(gmj_contact_filter* filter,
+                                           int body_id) {
+  (void)filter;
+  (void)body_id;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_contact_filter_set_min_force(gmj_contact_filter* filter,
+                                                double min_normal_force) {
+  (void)filter;
+  (void)min_normal_force;
+  return gmj_unavailable();
+}
+
+gmj_error_code gmj_export_contacts(const gmj_model* model,
+                                   const gmj_data* data,
+                                   const gmj_contact_filter* filter, int flags,
+                                   gmj_contact* out_contacts, int capacity,
+                                   int* out_count) {
   (void)model;
-  gmj_unavailable();
-  return -1;
+  (void)data;
+  (void)filter;
+  (void)flags;
+  (void)out_contacts;
+  (void)capacity;
+  (void)out_count;
+  return gmj_unavailable();
 }
 
-int gmj_nu(const gmj_model* model) {
+gmj_error_code gmj_batch_export_contacts(const gmj_batch* batch,
+                                         const gmj_contact_filter* filter,
+                                         int flags, gmj_contact* out_contacts,
+                                         int capacity_per_env,
+                                         int* out_counts) {
+  (void)batch;
+  (void)filter;
+  (void)flags;
+  (void)out_contacts;
+  (void)capacity_per_env;
+  (void)out_counts;
+  return gmj_unavailable();
+}
+
+int gmj_nsensor(const gmj_model* model) {
   (void)model;
   gmj_unavailable();
   return -1;
 }
 
-int gmj_nbody(const gmj_model* model) {
+int gmj_nsensordata(const gmj_model* model) {
   (void)model;
   gmj_unavailable();
   return -1;
 }
 
-int gmj_body_id(const gmj_model* model, const char* body_name) {
+int gmj_sensor_id(const gmj_model* model, const char* sensor_name) {
   (void)model;
-  (void)body_name;
+  (void)sensor_name;
   gmj_unavailable();
   return -1;
 }
 
-int gmj_joint_id(const gmj_model* model, const char* joint_name) {
+const char* gmj_sensor_name(const gmj_model* model, int sensor_id) {
   (void)model;
-  (void)joint_name;
+  (void)sensor_id;
   gmj_unavailable();
-  return -1;
+  return NULL;
 }
 
-int gmj_actuator_id(const gmj_model* model, const char* actuator_name) {
+int gmj_sensor_adr(const gmj_model* model, int sensor_id) {
   (void)model;
-  (void)actuator_name;
+  (void)sensor_id;
   gmj_unavailable();
   return -1;
 }
 
-const char* gmj_body_name(const gmj_model* model, int body_id) {
+int gmj_sensor_dim(const gmj_model* model, int sensor_id) {
   (void)model;
-  (void)body_id;
+  (void)sensor_id;
   gmj_unavailable();
-  return NULL;
+  return -1;
 }
 
-const char* gmj_joint_name(const gmj_model* model, int joint_id) {
+gmj_sensor_map* gmj_sensor_map_create(const gmj_model* model) {
   (void)model;
-  (void)joint_id;
   gmj_unavailable();
   return NULL;
 }
 
-const char* gmj_actuator_name(const gmj_model* model, int actuator_id) {
-  (void)model;
-  (void)actuator_id;
+void gmj_sensor_map_free(gmj_sensor_map* map) { (void)map; }
+
+int gmj_sensor_map_size(const gmj_sensor_map* map) {
+  (void)map;
   gmj_unavailable();
-  return NULL;
+  return -1;
 }
 
-gmj_error_code gmj_set_ctrl(const gmj_model* model, gmj_data* data,
-                            int actuator_index, double value) {
-  (void)model;
-  (void)data;
-  (void)actuator_index;
-  (void)value;
+gmj_error_code gmj_sensor_map_add(gmj_sensor_map* map,
+                                  const char* sensor_name, int* out_offset) {
+  (void)map;
+  (void)sensor_name;
+  (void)out_offset;
   return gmj_unavailable();
 }
 
-gmj_error_code gmj_get_ctrl(const gmj_model* model, const gmj_data* data,
-                            int actuator_index, double* out_value) {
-  (void)model;
-  (void)data;
-  (void)actuator_index;
-  (void)out_value;
+gmj_error_code gmj_sensor_map_add_id(gmj_sensor_map* map, int sensor_id,
+                                     int* out_offset) {
+  (void)map;
+  (void)sensor_id;
+  (void)out_offset;
   return gmj_unavailable();
 }
 
-gmj_error_code gmj_get_qpos(const gmj_model* model, const gmj_data* data,
-                            int qpos_index, double* out_value) {
-  (void)model;
-  (void)data;
-  (void)qpos_index;
-  (void)out_value;
+gmj_error_code gmj_sensor_map_add_all(gmj_sensor_map* map) {
+  (void)map;
   return gmj_unavailable();
 }
 
-gmj_error_code gmj_set_qpos(const gmj_model* model, gmj_data* data,
-                            int qpos_index, double value) {
-  (void)model;
+int gmj_sensor_map_offset(const gmj_sensor_map* map, int sensor_id) {
+  (void)map;
+  (void)sensor_id;
+  gmj_unavailable();
+  return -1;
+}
+
+gmj_error_code gmj_sensor_read(const gmj_sensor_map* map, const gmj_data* data,
+                               double* out_values) {
+  (void)map;
   (void)data;
-  (void)qpos_index;
-  (void)value;
+  (void)out_values;
   return gmj_unavailable();
 }
 
-gmj_error_code gmj_get_qvel(const gmj_model* model, const gmj_data* data,
-                            int qvel_index, double* out_value) {
-  (void)model;
+gmj_error_code gmj_sensor_read_f32(const gmj_sensor_map* map,
+                                   const gmj_data* data, float* out_values) {
+  (void)map;
   (void)data;
-  (void)qvel_index;
-  (void)out_value;
+  (void)out_values;
   return gmj_unavailable();
 }
 
-gmj_error_code gmj_set_qvel(const gmj_model* model, gmj_data* data,
-                            int qvel_index, double value) {
-  (void)model;
-  (void)data;
-  (void)qvel_index;
-  (void)value;
+gmj_error_code gmj_batch_sensor_read(const gmj_sensor_map* map,
+                                     const gmj_batch* batch,
+                                     double* out_values) {
+  (void)map;
+  (void)batch;
+  (void)out_values;
   return gmj_unavailable();
 }
 
-gmj_error_code gmj_get_qpos_slice(const gmj_model* model, const gmj_data* data,
-                                  int start_index, int count,
-                                  double* out_values) {
-  (void)model;
-  (void)data;
-  (void)start_index;
-  (void)count;
+gmj_error_code gmj_batch_sensor_read_f32(const gmj_sensor_map* map,
+                                         const gmj_batch* batch,
+                                         float* out_values) {
+  (void)map;
+  (void)batch;
   (void)out_values;
   return gmj_unavailable();
 }
 
-gmj_error_code gmj_set_qpos_slice(const gmj_model* model, gmj_data* data,
-                                  int start_index, int count,
-                                  const double* values) {
+gmj_ray_set* gmj_ray_set_create(const gmj_model* model) {
   (void)model;
-  (void)data;
-  (void)start_index;
+  gmj_unavailable();
+  return NULL;
+}
+
+void gmj_ray_set_free(gmj_ray_set* set) { (void)set; }
+
+int gmj_ray_set_size(const gmj_ray_set* set) {
+  (void)set;
+  gmj_unavailable();
+  return -1;
+}
+
+gmj_error_code gmj_ray_set_add(gmj_ray_set* set, int frame_body_id,
+                               int exclude_body_id, const double* origin_xyz,
+                               const double* directions_xyz, int count) {
+  (void)set;
+  (void)frame_body_id;
+  (void)exclude_body_id;
+  (void)origin_xyz;
+  (void)directions_xyz;
   (void)count;
-  (void)values;
   return gmj_unavailable();
 }
 
-gmj_error_code gmj_get_qvel_slice(const gmj_model* model, const gmj_data* data,
-                                  int start_index, int count,
-                                  double* out_values) {
-  (void)model;
-  (void)data;
-  (void)start_index;
-  (void)count;
-  (void)out_values;
+gmj_error_code gmj_ray_set_filter(gmj_ray_set* set, int group_mask,
+                                  int include_static) {
+  (void)set;
+  (void)group_mask;
+  (void)include_static;
   return gmj_unavailable();
 }
 
-gmj_error_code gmj_set_qvel_slice(const gmj_model* model, gmj_data* data,
-                                  int start_index, int count,
-                                  const double* values) {
-  (void)model;
-  (void)data;
-  (void)start_index;
-  (void)count;
-  (void)values;
+gmj_error_code gmj_ray_set_max_distance(gmj_ray_set* set,
+                                        double max_distance) {
+  (void)set;
+  (void)max_distance;
   return gmj_unavailable();
 }
 
-gmj_error_code gmj_get_ctrl_slice(const gmj_model* model, const gmj_data* data,
-                                  int start_index, int count,
-                                  double* out_values) {
-  (void)model;
+gmj_error_code gmj_raycast(const gmj_ray_set* set, gmj_data* data,
+                           double* out_distances, int* out_geom_ids) {
+  (void)set;
   (void)data;
-  (void)start_index;
-  (void)count;
-  (void)out_values;
+  (void)out_distances;
+  (void)out_geom_ids;
   return gmj_unavailable();
 }
 
-gmj_error_code gmj_set_ctrl_slice(const gmj_model* model, gmj_data* data,
-                                  int start_index, int count,
-                                  const double* values) {
-  (void)model;
+gmj_error_code gmj_raycast_f32(const gmj_ray_set* set, gmj_data* data,
+                               float* out_distances, int* out_geom_ids) {
+  (void)set;
   (void)data;
-  (void)start_index;
-  (void)count;
-  (void)values;
+  (void)out_distances;
+  (void)out_geom_ids;
   return gmj_unavailable();
 }
 
-gmj_error_code gmj_body_world_position(const gmj_model* model,
-                                       const gmj_data* data, int body_index,
-                                       double* out_xyz_3) {
-  (void)model;
-  (void)data;
-  (void)body_index;
-  (void)out_xyz_3;
+gmj_error_code gmj_batch_raycast(const gmj_ray_set* set, gmj_batch* batch,
+                                 double* out_distances, int* out_geom_ids) {
+  (void)set;
+  (void)batch;
+  (void)out_distances;
+  (void)out_geom_ids;
   return gmj_unavailable();
 }
 
-gmj_error_code gmj_forward(const gmj_model* model, gmj_data* data) {
-  (void)model;
-  (void)data;
+gmj_error_code gmj_batch_raycast_f32(const gmj_ray_set* set, gmj_batch* batch,
+                                     float* out_distances, int* out_geom_ids) {
+  (void)set;
+  (void)batch;
+  (void)out_distances;
+  (void)out_geom_ids;
   return gmj_unavailable();
 }
 
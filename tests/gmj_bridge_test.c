@@ -0,0 +1,726 @@
+#if !defined(_WIN32) && !defined(_XOPEN_SOURCE)
+#define _XOPEN_SOURCE 700
+#endif
+
+#include "godot_mujoco/gmj_bridge.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(_WIN32)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/* Behavioural tests for the bridge against a real MuJoCo, through the
+   public API only. Each test builds what it needs from TEST_XML (a free
+   torso with a welded leg, pushed along x/y by two site actuators) and
+   reports every failed CHECK; the process exits non-zero if any failed. */
+
+#define TEST_MAX_NQ 16
+#define TEST_WARN_BADQACC 6 /* mjWARN_BADQACC */
+
+#define CHECK(condition)                                                \
+  do {                                                                  \
+    test_checks += 1;                                                   \
+    if (!(condition)) {                                                 \
+      test_failures += 1;                                               \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed (%s)\n", __FILE__,       \
+              __LINE__, #condition, gmj_last_mujoco_error());           \
+    }                                                                   \
+  } while (0)
+
+static int test_checks = 0;
+static int test_failures = 0;
+
+static const char TEST_XML[] =
+    "<mujoco model=\"gmj_test\">"
+    "  <option timestep=\"0.005\"/>"
+    "  <worldbody>"
+    "    <geom name=\"floor\" type=\"plane\" size=\"5 5 0.1\"/>"
+    "    <body name=\"torso\" pos=\"0 0 1\">"
+    "      <freejoint/>"
+    "      <geom type=\"sphere\" size=\"0.1\" mass=\"1\"/>"
+    "      <site name=\"thrust\"/>"
+    "      <body name=\"leg\" pos=\"0.1 0 0\">"
+    "        <geom type=\"capsule\" fromto=\"0 0 0 0 0 -0.2\" size=\"0.03\""
+    "              mass=\"0.2\"/>"
+    "      </body>"
+    "    </body>"
+    "  </worldbody>"
+    "  <actuator>"
+    "    <general name=\"push_x\" site=\"thrust\" gear=\"1 0 0 0 0 0\"/>"
+    "    <general name=\"push_y\" site=\"thrust\" gear=\"0 1 0 0 0 0\"/>"
+    "  </actuator>"
+    "  <sensor>"
+    "    <framepos objtype=\"body\" objname=\"torso\"/>"
+    "  </sensor>"
+    "  <keyframe>"
+    "    <key qpos=\"0 0 2 1 0 0 0\"/>"
+    "  </keyframe>"
+    "</mujoco>";
+
+/* A motor strong enough that ctrl = 1e9 (still a valid control) gives an
+   acceleration MuJoCo rejects, resetting the data inside mj_step. */
+static const char BADQACC_XML[] =
+    "<mujoco model=\"gmj_badqacc\">"
+    "  <worldbody>"
+    "    <body name=\"arm\">"
+    "      <joint name=\"hinge\" type=\"hinge\" axis=\"0 1 0\"/>"
+    "      <geom type=\"capsule\" fromto=\"0 0 0 0.3 0 0\" size=\"0.02\""
+    "            mass=\"1\"/>"
+    "    </body>"
+    "  </worldbody>"
+    "  <actuator>"
+    "    <motor joint=\"hinge\" gear=\"1e10\" ctrllimited=\"false\"/>"
+    "  </actuator>"
+    "</mujoco>";
+
+static gmj_model* test_load_xml(const char* xml) {
+  char error[1024] = {0};
+  gmj_model* model = gmj_model_load_xml_string(xml, NULL, error, sizeof(error));
+  if (model == NULL) {
+    fprintf(stderr, "load test model: %s\n", error);
+    exit(1);
+  }
+  return model;
+}
+
+static gmj_model* test_load(void) {
+  return test_load_xml(TEST_XML);
+}
+
+/* Files are written to the working directory (the build directory under
+   ctest) and removed by the test that wrote them. */
+#define TEST_MAIN_XML "gmj_test_main.xml"
+#define TEST_PART_XML "gmj_test_part.xml"
+
+static const char TEST_MAIN_TEXT[] =
+    "<mujoco model=\"gmj_include\">\n"
+    "  <compiler angle=\"radian\" autolimits=\"true\"/>\n"
+    "  <option timestep=\"0.005\" gravity=\"0 0 -9.81\"/>\n"
+    "  <include\n"
+    "      file = 'gmj_test_part.xml' />\n"
+    "</mujoco>\n";
+
+static void test_write_file(const char* path, const char* text) {
+  FILE* file = fopen(path, "wb");
+  if (file == NULL || fputs(text, file) < 0 || fclose(file) != 0) {
+    fprintf(stderr, "write %s failed\n", path);
+    exit(1);
+  }
+}
+
+static void test_write_part(double mass) {
+  char text[512];
+  snprintf(text, sizeof(text),
+           "<mujoco>\n"
+           "  <worldbody>\n"
+           "    <body name=\"torso\" pos=\"0 0 1\">\n"
+           "      <freejoint/>\n"
+           "      <geom type=\"sphere\" size=\"0.1\" mass=\"%g\"/>\n"
+           "    </body>\n"
+           "  </worldbody>\n"
+           "</mujoco>\n",
+           mass);
+  test_write_file(TEST_PART_XML, text);
+}
+
+static unsigned long long test_tree_hash(void) {
+  gmj_reload_info info;
+  gmj_reloader* reloader = gmj_reloader_create(TEST_MAIN_XML, 60.0);
+  memset(&info, 0, sizeof(info));
+  CHECK(reloader != NULL);
+  CHECK(gmj_reloader_info(reloader, &info) == GMJ_OK);
+  gmj_reloader_free(reloader);
+  return info.content_hash;
+}
+
+static double test_time(const gmj_model* model, const gmj_data* data) {
+  double time = -1.0;
+  gmj_state_save(model, data, GMJ_STATE_TIME, &time);
+  return time;
+}
+
+static void test_sleep_ms(int milliseconds) {
+#if defined(_WIN32)
+  Sleep((DWORD)milliseconds);
+#else
+  struct timespec ts;
+  ts.tv_sec = milliseconds / 1000;
+  ts.tv_nsec = (long)(milliseconds % 1000) * 1000000L;
+  nanosleep(&ts, NULL);
+#endif
+}
+
+static void test_step_and_reset(void) {
+  gmj_model* model = test_load();
+  gmj_data* data = gmj_data_create(model);
+  const int nq = gmj_nq(model);
+  const double push[2] = {5.0, 0.0};
+  double qpos0[TEST_MAX_NQ];
+  double qpos[TEST_MAX_NQ];
+  gmj_stats stats;
+
+  CHECK(data != NULL);
+  CHECK(nq == 7 && gmj_nv(model) == 6 && gmj_nu(model) == 2);
+  CHECK(gmj_body_id(model, "leg") == 2);
+  CHECK(gmj_get_qpos_slice(model, data, 0, nq, qpos0) == GMJ_OK);
+
+  CHECK(gmj_set_ctrl_slice(model, data, 0, 2, push) == GMJ_OK);
+  CHECK(gmj_step(model, data, 10) == GMJ_OK);
+  CHECK(fabs(test_time(model, data) - 0.05) < 1e-9);
+  CHECK(gmj_get_qpos_slice(model, data, 0, nq, qpos) == GMJ_OK);
+  CHECK(qpos[0] > qpos0[0]);
+  CHECK(qpos[2] < qpos0[2]);
+
+  CHECK(gmj_data_stats(model, data, &stats) == GMJ_OK);
+  CHECK(stats.steps == 10);
+
+  CHECK(gmj_reset_data(model, data) == GMJ_OK);
+  CHECK(test_time(model, data) == 0.0);
+  CHECK(gmj_get_qpos_slice(model, data, 0, nq, qpos) == GMJ_OK);
+  CHECK(memcmp(qpos, qpos0, sizeof(double) * (size_t)nq) == 0);
+  CHECK(gmj_data_stats(model, data, &stats) == GMJ_OK);
+  CHECK(stats.steps == 10);
+  gmj_data_reset_stats(data);
+  CHECK(gmj_data_stats(model, data, &stats) == GMJ_OK);
+  CHECK(stats.steps == 0);
+
+  CHECK(gmj_step(model, data, -1) == GMJ_ERR_INVALID_ARGUMENT);
+
+  gmj_data_free(data);
+  gmj_model_free(model);
+}
+
+/* Each bad-acceleration reset mj_step makes counts once, whether it comes
+   right after another one or after an explicit reset. */
+static void test_warning_counts(void) {
+  gmj_model* model = test_load_xml(BADQACC_XML);
+  gmj_data* data = gmj_data_create(model);
+  gmj_stats stats;
+  int i = 0;
+
+  CHECK(data != NULL);
+  for (i = 0; i < 2; ++i) {
+    CHECK(gmj_set_ctrl(model, data, 0, 1e9) == GMJ_OK);
+    CHECK(gmj_step(model, data, 1) == GMJ_OK);
+  }
+  CHECK(gmj_data_stats(model, data, &stats) == GMJ_OK);
+  CHECK(stats.warnings[TEST_WARN_BADQACC] == 2);
+
+  /* The reset zeroes ctrl, so only the first of these steps resets. */
+  CHECK(gmj_set_ctrl(model, data, 0, 1e9) == GMJ_OK);
+  CHECK(gmj_step(model, data, 3) == GMJ_OK);
+  CHECK(gmj_data_stats(model, data, &stats) == GMJ_OK);
+  CHECK(stats.warnings[TEST_WARN_BADQACC] == 3);
+
+  CHECK(gmj_reset_data(model, data) == GMJ_OK);
+  CHECK(gmj_set_ctrl(model, data, 0, 1e9) == GMJ_OK);
+  CHECK(gmj_step(model, data, 1) == GMJ_OK);
+  CHECK(gmj_data_stats(model, data, &stats) == GMJ_OK);
+  CHECK(stats.warnings[TEST_WARN_BADQACC] == 4);
+  CHECK(stats.steps == 6);
+
+  gmj_data_reset_stats(data);
+  CHECK(gmj_data_stats(model, data, &stats) == GMJ_OK);
+  CHECK(stats.warnings[TEST_WARN_BADQACC] == 0);
+
+  gmj_data_free(data);
+  gmj_model_free(model);
+}
+
+/* The XML tree hash follows includes (here with spaced, single-quoted
+   attribute syntax) and changes when only the included file does. */
+static void test_content_hash(void) {
+  unsigned long long first = 0;
+
+  test_write_file(TEST_MAIN_XML, TEST_MAIN_TEXT);
+  test_write_part(1.0);
+  first = test_tree_hash();
+  CHECK(first != 0);
+  CHECK(test_tree_hash() == first);
+  test_write_part(2.0);
+  CHECK(test_tree_hash() != first);
+  test_write_part(1.0);
+  CHECK(test_tree_hash() == first);
+
+  remove(TEST_MAIN_XML);
+  remove(TEST_PART_XML);
+}
+
+/* Acquires share one compile until the XML tree changes; editing only the
+   included file gives a new model while holders keep the old one. */
+static void test_acquire_cache(void) {
+  char error[1024] = {0};
+  gmj_model* first = NULL;
+  gmj_model* second = NULL;
+  gmj_model* edited = NULL;
+  const int cached = gmj_model_cache_count();
+
+  test_write_file(TEST_MAIN_XML, TEST_MAIN_TEXT);
+  test_write_part(1.0);
+  first = gmj_model_acquire_xml(TEST_MAIN_XML, error, sizeof(error));
+  second = gmj_model_acquire_xml(TEST_MAIN_XML, error, sizeof(error));
+  CHECK(first != NULL && first == second);
+  CHECK(gmj_model_refcount(first) == 2);
+  CHECK(gmj_model_cache_count() == cached + 1);
+
+  test_write_part(2.0);
+  edited = gmj_model_acquire_xml(TEST_MAIN_XML, error, sizeof(error));
+  CHECK(edited != NULL && edited != first);
+  CHECK(gmj_model_cache_count() == cached + 2);
+  CHECK(gmj_model_refcount(first) == 2 && gmj_model_refcount(edited) == 1);
+
+  gmj_model_free(first);
+  gmj_model_free(second);
+  CHECK(gmj_model_cache_count() == cached + 1);
+  gmj_model_free(edited);
+  CHECK(gmj_model_cache_count() == cached);
+  CHECK(gmj_model_acquire_xml("gmj_test_missing.xml", error,
+                              sizeof(error)) == NULL);
+  CHECK(error[0] != '\0');
+
+  remove(TEST_MAIN_XML);
+  remove(TEST_PART_XML);
+}
+
+/* The reloader compiles an edit of an included file once the hash is
+   stable and hands out references to that compile, outside the path
+   cache. */
+static void test_reloader(void) {
+  gmj_reloader* reloader = NULL;
+  gmj_model* latest = NULL;
+  gmj_reload_info info;
+  unsigned long long generation = 0;
+  const int cached = gmj_model_cache_count();
+  int waited = 0;
+
+  test_write_file(TEST_MAIN_XML, TEST_MAIN_TEXT);
+  test_write_part(1.0);
+  reloader = gmj_reloader_create(TEST_MAIN_XML, 0.05);
+  CHECK(reloader != NULL);
+  if (reloader == NULL) {
+    return;
+  }
+  CHECK(gmj_reloader_latest(reloader, &generation) == NULL);
+  test_write_part(3.0);
+  for (waited = 0; waited < 1000 && latest == NULL; ++waited) {
+    latest = gmj_reloader_latest(reloader, &generation);
+    test_sleep_ms(5);
+  }
+  CHECK(latest != NULL);
+  CHECK(generation == 1);
+  CHECK(gmj_reloader_latest(reloader, &generation) == NULL);
+  CHECK(gmj_reloader_info(reloader, &info) == GMJ_OK);
+  CHECK(info.generation == 1 && info.failures == 0 && info.polls >= 2);
+  if (latest != NULL) {
+    CHECK(gmj_model_refcount(latest) == 2);
+    CHECK(gmj_model_cache_count() == cached);
+    gmj_reloader_free(reloader);
+    CHECK(gmj_model_refcount(latest) == 1);
+    CHECK(gmj_nq(latest) == 7);
+    gmj_model_free(latest);
+  } else {
+    gmj_reloader_free(reloader);
+  }
+
+  remove(TEST_MAIN_XML);
+  remove(TEST_PART_XML);
+}
+
+/* MLP layers without an activation are linear, so the output layer here is
+   not squashed; the single-layer format keeps its tanh. */
+static void test_policy_activation(void) {
+  static const char mlp_json[] =
+      "{\"layers\": ["
+      "  {\"weights\": [[1, 0], [0, 1]], \"bias\": [0, 0],"
+      "   \"activation\": \"relu\"},"
+      "  {\"weights\": [[2, 1]], \"bias\": [0.5]}"
+      "]}";
+  static const char linear_json[] =
+      "{\"weights\": [[2, 1]], \"bias\": [0.5]}";
+  char error[1024] = {0};
+  gmj_policy* mlp = gmj_policy_load_json(mlp_json, NULL, error, sizeof(error));
+  gmj_policy* linear =
+      gmj_policy_load_json(linear_json, NULL, error, sizeof(error));
+  const double observation[2] = {1.0, -2.0};
+  double action = 0.0;
+
+  CHECK(mlp != NULL && linear != NULL);
+  if (mlp == NULL || linear == NULL) {
+    gmj_policy_free(mlp);
+    gmj_policy_free(linear);
+    return;
+  }
+  CHECK(gmj_policy_obs_size(mlp) == 2 && gmj_policy_action_size(mlp) == 1);
+  CHECK(gmj_policy_infer(mlp, observation, 2, &action, 1) == GMJ_OK);
+  CHECK(fabs(action - 2.5) < 1e-5);
+  CHECK(gmj_policy_infer(linear, observation, 2, &action, 1) == GMJ_OK);
+  CHECK(fabs(action - tanh(0.5)) < 1e-5);
+  CHECK(gmj_policy_load_json("{\"layers\": [{\"weights\": [[1]], "
+                             "\"bias\": [0], \"activation\": \"gelu\"}]}",
+                             NULL, error, sizeof(error)) == NULL);
+
+  gmj_policy_free(linear);
+  gmj_policy_free(mlp);
+}
+
+/* A batch env and a lone data fed the same ctrl stay bit-identical, with
+   or without a thread pool. */
+static void test_batch_matches_single(void) {
+  gmj_model* model = test_load();
+  gmj_batch* batch = gmj_batch_create(model, 3);
+  gmj_thread_pool* pool = gmj_thread_pool_create(2);
+  gmj_data* single = gmj_data_create(model);
+  const int nq = gmj_nq(model);
+  double ctrl[3 * 2] = {1.0, 0.0, 2.0, -1.0, 0.5, 0.5};
+  double batch_qpos[3 * TEST_MAX_NQ];
+  double qpos[TEST_MAX_NQ];
+  int pass = 0;
+
+  CHECK(batch != NULL && pool != NULL && single != NULL);
+  CHECK(gmj_batch_size(batch) == 3);
+  for (pass = 0; pass < 2; ++pass) {
+    CHECK(gmj_batch_set_thread_pool(batch, pass == 0 ? NULL : pool) ==
+          GMJ_OK);
+    CHECK(gmj_batch_reset(batch) == GMJ_OK);
+    CHECK(gmj_reset_data(model, single) == GMJ_OK);
+    CHECK(gmj_batch_step(batch, ctrl, 20, batch_qpos, NULL) == GMJ_OK);
+    CHECK(gmj_set_ctrl_slice(model, single, 0, 2, ctrl + 2) == GMJ_OK);
+    CHECK(gmj_step(model, single, 20) == GMJ_OK);
+    CHECK(gmj_get_qpos_slice(model, single, 0, nq, qpos) == GMJ_OK);
+    CHECK(memcmp(batch_qpos + nq, qpos, sizeof(double) * (size_t)nq) == 0);
+    CHECK(batch_qpos[0] != batch_qpos[nq]);
+  }
+
+  /* Resetting one env leaves the others alone. */
+  CHECK(gmj_batch_reset_env(batch, 1) == GMJ_OK);
+  CHECK(gmj_batch_get_state(batch, batch_qpos, NULL) == GMJ_OK);
+  CHECK(memcmp(batch_qpos + nq, qpos, sizeof(double) * (size_t)nq) != 0);
+  CHECK(batch_qpos[2 * nq] != 0.0);
+  CHECK(gmj_batch_reset_env(batch, 3) == GMJ_ERR_INDEX_OUT_OF_RANGE);
+
+  gmj_data_free(single);
+  gmj_batch_free(batch);
+  gmj_thread_pool_free(pool);
+  gmj_model_free(model);
+}
+
+/* A rejected reload or randomize changes no env; an accepted reload
+   carries the state over. */
+static void test_batch_all_or_nothing(void) {
+  gmj_model* model = test_load();
+  gmj_model* other = test_load();
+  gmj_batch* batch = gmj_batch_create(model, 4);
+  gmj_randomizer* randomizer = gmj_randomizer_create(model);
+  gmj_randomizer* foreign = gmj_randomizer_create(other);
+  const int nq = gmj_nq(model);
+  double ctrl[4 * 2] = {1.0, 0.0, 1.0, 0.0, 1.0, 0.0, 1.0, 0.0};
+  double before[4 * TEST_MAX_NQ];
+  double after[4 * TEST_MAX_NQ];
+  double masses[4];
+  double mass = 0.0;
+  double base_mass = 0.0;
+  int i = 0;
+
+  CHECK(batch != NULL && randomizer != NULL && foreign != NULL);
+  CHECK(gmj_randomizer_add(randomizer, GMJ_PARAM_BODY_MASS, "torso",
+                           GMJ_RAND_SCALE, GMJ_DIST_UNIFORM, 0.5,
+                           1.5) == GMJ_OK);
+  CHECK(gmj_randomizer_add(foreign, GMJ_PARAM_BODY_MASS, NULL, GMJ_RAND_SET,
+                           GMJ_DIST_UNIFORM, 7.0, 7.0) == GMJ_OK);
+  CHECK(gmj_data_param(model, gmj_batch_env(batch, 0), GMJ_PARAM_BODY_MASS,
+                       1, &base_mass) == GMJ_OK);
+
+  CHECK(gmj_batch_randomize(batch, randomizer, 42) == GMJ_OK);
+  for (i = 0; i < 4; ++i) {
+    CHECK(gmj_data_param(model, gmj_batch_env(batch, i), GMJ_PARAM_BODY_MASS,
+                         1, &masses[i]) == GMJ_OK);
+    CHECK(masses[i] >= 0.5 * base_mass && masses[i] <= 1.5 * base_mass);
+  }
+  CHECK(masses[0] != masses[1]);
+
+  CHECK(gmj_batch_randomize(batch, foreign, 7) == GMJ_ERR_INVALID_ARGUMENT);
+  for (i = 0; i < 4; ++i) {
+    CHECK(gmj_data_param(model, gmj_batch_env(batch, i), GMJ_PARAM_BODY_MASS,
+                         1, &mass) == GMJ_OK);
+    CHECK(mass == masses[i]);
+  }
+
+  /* Same seed, same draws. */
+  CHECK(gmj_batch_randomize(batch, randomizer, 42) == GMJ_OK);
+  CHECK(gmj_data_param(model, gmj_batch_env(batch, 3), GMJ_PARAM_BODY_MASS,
+                       1, &mass) == GMJ_OK);
+  CHECK(mass == masses[3]);
+
+  CHECK(gmj_batch_randomize(batch, NULL, 0) == GMJ_OK);
+  CHECK(gmj_data_param(model, gmj_batch_env(batch, 2), GMJ_PARAM_BODY_MASS,
+                       1, &mass) == GMJ_OK);
+  CHECK(mass == base_mass);
+
+  CHECK(gmj_batch_step(batch, ctrl, 5, before, NULL) == GMJ_OK);
+  CHECK(gmj_batch_reload(batch, NULL) == GMJ_ERR_INVALID_ARGUMENT);
+  CHECK(gmj_batch_get_state(batch, after, NULL) == GMJ_OK);
+  CHECK(memcmp(before, after, sizeof(double) * 4 * (size_t)nq) == 0);
+
+  CHECK(gmj_batch_reload(batch, other) == GMJ_OK);
+  CHECK(gmj_batch_get_state(batch, after, NULL) == GMJ_OK);
+  CHECK(memcmp(before, after, sizeof(double) * 4 * (size_t)nq) == 0);
+  CHECK(gmj_batch_randomize(batch, randomizer, 1) ==
+        GMJ_ERR_INVALID_ARGUMENT);
+  CHECK(gmj_batch_randomize(batch, foreign, 1) == GMJ_OK);
+  CHECK(gmj_batch_step(batch, ctrl, 5, NULL, NULL) == GMJ_OK);
+
+  gmj_batch_free(batch);
+  gmj_randomizer_free(foreign);
+  gmj_randomizer_free(randomizer);
+  gmj_model_free(other);
+  gmj_model_free(model);
+}
+
+/* A recorded list does what the same calls made directly do. */
+static void test_cmd_list(void) {
+  gmj_model* model = test_load();
+  gmj_cmd_list* list = gmj_cmd_list_create(model);
+  gmj_data* listed = gmj_data_create(model);
+  gmj_data* direct = gmj_data_create(model);
+  const int nq = gmj_nq(model);
+  double ctrl[2] = {0.0, 3.0};
+  double copied[TEST_MAX_NQ];
+  double qpos[TEST_MAX_NQ];
+
+  CHECK(list != NULL && listed != NULL && direct != NULL);
+  CHECK(gmj_cmd_set_ctrl(list, 0, 2, ctrl) == GMJ_OK);
+  CHECK(gmj_cmd_step(list, 4) == GMJ_OK);
+  CHECK(gmj_cmd_copy(list, GMJ_FIELD_QPOS, 0, nq, copied) == GMJ_OK);
+  CHECK(gmj_cmd_list_size(list) == 3);
+  CHECK(gmj_cmd_set_ctrl(list, 1, 2, ctrl) == GMJ_ERR_INDEX_OUT_OF_RANGE);
+  CHECK(gmj_cmd_list_size(list) == 3);
+
+  CHECK(gmj_execute(list, listed) == GMJ_OK);
+  ctrl[1] = -3.0; /* borrowed: the next execute reads the new value */
+  CHECK(gmj_execute(list, listed) == GMJ_OK);
+
+  CHECK(gmj_set_ctrl(model, direct, 1, 3.0) == GMJ_OK);
+  CHECK(gmj_step(model, direct, 4) == GMJ_OK);
+  CHECK(gmj_set_ctrl_slice(model, direct, 0, 2, ctrl) == GMJ_OK);
+  CHECK(gmj_step(model, direct, 4) == GMJ_OK);
+  CHECK(gmj_get_qpos_slice(model, direct, 0, nq, qpos) == GMJ_OK);
+  CHECK(memcmp(copied, qpos, sizeof(double) * (size_t)nq) == 0);
+
+  gmj_cmd_list_clear(list);
+  CHECK(gmj_cmd_list_size(list) == 0);
+
+  gmj_data_free(direct);
+  gmj_data_free(listed);
+  gmj_cmd_list_free(list);
+  gmj_model_free(model);
+}
+
+static void test_task_auto_reset(void) {
+  gmj_model* model = test_load();
+  gmj_task* always = gmj_task_create(model);
+  gmj_task* timed = gmj_task_create(model);
+  gmj_data* data = gmj_data_create(model);
+  gmj_batch* batch = gmj_batch_create(model, 2);
+  const int nq = gmj_nq(model);
+  double qpos0[TEST_MAX_NQ];
+  double qpos[TEST_MAX_NQ];
+  double rewards[2] = {0.0, 0.0};
+  unsigned char done[2] = {0, 0};
+  double reward = 0.0;
+  int steps = 0;
+
+  CHECK(always != NULL && timed != NULL && data != NULL && batch != NULL);
+  CHECK(gmj_get_qpos_slice(model, data, 0, nq, qpos0) == GMJ_OK);
+
+  /* The torso is always below 100 m, so every step terminates and the
+     data comes back at qpos0, or at the keyframe when one is set. */
+  CHECK(gmj_task_add_termination(always, GMJ_TERMINATE_BELOW, 1, 2, 100.0) ==
+        GMJ_OK);
+  CHECK(gmj_task_step(always, data, 3, &reward, done) == GMJ_OK);
+  CHECK(done[0] == GMJ_DONE_TERMINATED);
+  CHECK(gmj_get_qpos_slice(model, data, 0, nq, qpos) == GMJ_OK);
+  CHECK(memcmp(qpos, qpos0, sizeof(double) * (size_t)nq) == 0);
+  CHECK(gmj_task_set_reset_keyframe(always, 0) == GMJ_OK);
+  CHECK(gmj_task_step(always, data, 1, &reward, done) == GMJ_OK);
+  CHECK(gmj_get_qpos_slice(model, data, 0, nq, qpos) == GMJ_OK);
+  CHECK(qpos[2] == 2.0);
+  CHECK(gmj_task_set_reset_keyframe(always, 5) ==
+        GMJ_ERR_INDEX_OUT_OF_RANGE);
+
+  CHECK(gmj_task_add_reward(timed, GMJ_REWARD_FORWARD, 1, 0, 0.0, 1.0) ==
+        GMJ_OK);
+  CHECK(gmj_task_set_time_limit(timed, 0.0201) == GMJ_OK);
+  CHECK(gmj_reset_data(model, data) == GMJ_OK);
+  CHECK(gmj_set_ctrl(model, data, 0, 1.0) == GMJ_OK);
+  done[0] = GMJ_DONE_NONE;
+  for (steps = 0; steps < 10 && done[0] == GMJ_DONE_NONE; ++steps) {
+    CHECK(gmj_task_step(timed, data, 1, &reward, done) == GMJ_OK);
+    if (done[0] == GMJ_DONE_NONE) {
+      CHECK(reward > 0.0);
+    }
+  }
+  CHECK(steps == 5 && done[0] == GMJ_DONE_TRUNCATED);
+  CHECK(test_time(model, data) == 0.0);
+
+  CHECK(gmj_batch_step_task(batch, always, NULL, 1, rewards, done) == GMJ_OK);
+  CHECK(done[0] == GMJ_DONE_TERMINATED && done[1] == GMJ_DONE_TERMINATED);
+
+  gmj_batch_free(batch);
+  gmj_data_free(data);
+  gmj_task_free(timed);
+  gmj_task_free(always);
+  gmj_model_free(model);
+}
+
+static void test_sim_thread(void) {
+  gmj_model* model = test_load();
+  gmj_data* data = gmj_data_create(model);
+  gmj_sim_thread* sim = NULL;
+  gmj_sim_state state;
+  gmj_sim_stats stats;
+  const double push[2] = {2.0, 0.0};
+  int waited = 0;
+
+  CHECK(data != NULL);
+  sim = gmj_sim_thread_start(model, data, NULL, 0.0, 2, 8);
+  CHECK(sim != NULL);
+  if (sim == NULL) {
+    gmj_data_free(data);
+    gmj_model_free(model);
+    return;
+  }
+  CHECK(gmj_sim_post_ctrl(sim, 0, 2, push) == GMJ_OK);
+  CHECK(gmj_sim_post_ctrl(sim, 1, 2, push) == GMJ_ERR_INDEX_OUT_OF_RANGE);
+  memset(&state, 0, sizeof(state));
+  for (waited = 0; waited < 2000 && state.tick < 20; ++waited) {
+    CHECK(gmj_sim_latest_state(sim, &state, &stats) == GMJ_OK);
+    test_sleep_ms(1);
+  }
+  CHECK(state.tick >= 20);
+  CHECK(state.nq == gmj_nq(model) && state.nbody == gmj_nbody(model));
+  CHECK(state.ctrl != NULL && state.ctrl[0] == 2.0);
+  CHECK(state.qpos != NULL && state.qpos[0] > 0.0);
+  CHECK(stats.ticks > 0 && stats.steps >= stats.ticks);
+  CHECK(stats.commands_applied == 1);
+
+  CHECK(gmj_sim_post_reset(sim) == GMJ_OK);
+  for (waited = 0; waited < 2000 && stats.resets == 0; ++waited) {
+    CHECK(gmj_sim_latest_state(sim, &state, &stats) == GMJ_OK);
+    test_sleep_ms(1);
+  }
+  CHECK(stats.resets == 1);
+  gmj_sim_thread_stop(sim);
+
+  CHECK(gmj_step(model, data, 1) == GMJ_OK);
+  gmj_data_free(data);
+  gmj_model_free(model);
+}
+
+/* Idle data keep their model alive after the caller's own reference is
+   gone; trimming releases it. */
+static void test_pool_refcount(void) {
+  gmj_model* model = test_load();
+  gmj_data_pool* pool = gmj_data_pool_create(0);
+  gmj_model* other = NULL;
+  gmj_data_pool_info info;
+  gmj_data* first = NULL;
+  gmj_data* second = NULL;
+  gmj_data* again = NULL;
+  gmj_stats stats;
+
+  CHECK(pool != NULL);
+  CHECK(gmj_model_refcount(model) == 1);
+  first = gmj_data_pool_acquire(pool, model, 0);
+  second = gmj_data_pool_acquire(pool, model, 0);
+  CHECK(first != NULL && second != NULL && first != second);
+  gmj_data_pool_release(pool, model, second);
+  CHECK(gmj_step(model, first, 3) == GMJ_OK);
+  gmj_data_pool_release(pool, model, first);
+  CHECK(gmj_model_refcount(model) == 3);
+
+  /* Most recently released first, reset and with fresh stats. */
+  again = gmj_data_pool_acquire(pool, model, 0);
+  CHECK(again == first);
+  CHECK(gmj_model_refcount(model) == 2);
+  CHECK(test_time(model, again) == 0.0);
+  CHECK(gmj_data_stats(model, again, &stats) == GMJ_OK);
+  CHECK(stats.steps == 0);
+  gmj_data_pool_release(pool, model, again);
+  CHECK(gmj_data_pool_stats(pool, &info) == GMJ_OK);
+  CHECK(info.idle == 2 && info.created == 2 && info.reused == 1);
+  CHECK(info.idle_bytes > 0);
+
+  /* Rejected sizes create nothing. */
+  CHECK(gmj_data_pool_acquire(pool, model, 1) == NULL);
+  CHECK(gmj_data_pool_acquire(pool, NULL, 0) == NULL);
+  CHECK(gmj_data_pool_stats(pool, &info) == GMJ_OK);
+  CHECK(info.created == 2 && info.idle == 2);
+
+  gmj_model_free(model);
+  CHECK(gmj_model_refcount(model) == 2);
+  CHECK(gmj_data_pool_trim(pool, model) == 2);
+  CHECK(gmj_data_pool_stats(pool, &info) == GMJ_OK);
+  CHECK(info.idle == 0 && info.idle_bytes == 0);
+  gmj_data_pool_free(pool);
+
+  /* Trimming one model leaves the other model's idle data alone. */
+  model = test_load();
+  other = test_load();
+  pool = gmj_data_pool_create(0);
+  gmj_data_pool_release(pool, model, gmj_data_pool_acquire(pool, model, 0));
+  gmj_data_pool_release(pool, other, gmj_data_pool_acquire(pool, other, 0));
+  gmj_data_pool_release(pool, other, gmj_data_pool_acquire(pool, other, 0));
+  CHECK(gmj_model_refcount(model) == 2 && gmj_model_refcount(other) == 2);
+  CHECK(gmj_data_pool_trim(pool, model) == 1);
+  CHECK(gmj_model_refcount(model) == 1 && gmj_model_refcount(other) == 2);
+  CHECK(gmj_data_pool_stats(pool, &info) == GMJ_OK);
+  CHECK(info.idle == 1 && info.created == 2 && info.reused == 1);
+  CHECK(gmj_data_pool_trim(pool, NULL) == 1);
+  CHECK(gmj_data_pool_trim(pool, NULL) == 0);
+  CHECK(gmj_model_refcount(other) == 1);
+  gmj_data_pool_free(pool);
+  gmj_model_free(other);
+  gmj_model_free(model);
+
+  /* max_idle bounds the idle list; extra releases are freed. */
+  model = test_load();
+  pool = gmj_data_pool_create(1);
+  first = gmj_data_pool_acquire(pool, model, 0);
+  second = gmj_data_pool_acquire(pool, model, 0);
+  gmj_data_pool_release(pool, model, first);
+  gmj_data_pool_release(pool, model, second);
+  CHECK(gmj_data_pool_stats(pool, &info) == GMJ_OK);
+  CHECK(info.idle == 1);
+  CHECK(gmj_model_refcount(model) == 2);
+  gmj_data_pool_free(pool);
+  CHECK(gmj_model_refcount(model) == 1);
+  gmj_model_free(model);
+  CHECK(gmj_data_pool_create(-1) == NULL);
+}
+
+int main(void) {
+  printf("MuJoCo %s\n", gmj_mujoco_version());
+  test_step_and_reset();
+  test_warning_counts();
+  test_content_hash();
+  test_acquire_cache();
+  test_reloader();
+  test_policy_activation();
+  test_batch_matches_single();
+  test_batch_all_or_nothing();
+  test_cmd_list();
+  test_task_auto_reset();
+  test_sim_thread();
+  test_pool_refcount();
+  printf("%d checks, %d failed\n", test_checks, test_failures);
+  return test_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,246 @@
+#define _GNU_SOURCE
+
+#include "gmj_env_shm.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Runs gmj_env_server (path in argv[1]) as a child and talks to it like an
+   external trainer would: from the header alone, with sequence numbers
+   started a few requests short of 2^32 so the ring wraps mid-test. */
+
+#define CHECK(condition)                                                \
+  do {                                                                  \
+    test_checks += 1;                                                   \
+    if (!(condition)) {                                                 \
+      test_failures += 1;                                               \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,  \
+              #condition);                                              \
+    }                                                                   \
+  } while (0)
+
+#define TEST_ENVS 3
+#define TEST_SLOTS 4
+#define TEST_FIRST_SEQ "0xFFFFFFFA"
+
+static int test_checks = 0;
+static int test_failures = 0;
+
+static const char TEST_XML[] =
+    "<mujoco model=\"gmj_env_test\">\n"
+    "  <option timestep=\"0.005\"/>\n"
+    "  <worldbody>\n"
+    "    <geom type=\"plane\" size=\"5 5 0.1\"/>\n"
+    "    <body name=\"torso\" pos=\"0 0 1\">\n"
+    "      <freejoint/>\n"
+    "      <geom type=\"sphere\" size=\"0.1\" mass=\"1\"/>\n"
+    "      <site name=\"thrust\"/>\n"
+    "      <body name=\"leg\" pos=\"0.1 0 0\">\n"
+    "        <geom type=\"capsule\" fromto=\"0 0 0 0 0 -0.2\" size=\"0.03\"\n"
+    "              mass=\"0.2\"/>\n"
+    "      </body>\n"
+    "    </body>\n"
+    "  </worldbody>\n"
+    "  <actuator>\n"
+    "    <general site=\"thrust\" gear=\"1 0 0 0 0 0\"/>\n"
+    "    <general site=\"thrust\" gear=\"0 1 0 0 0 0\"/>\n"
+    "  </actuator>\n"
+    "</mujoco>\n";
+
+static double test_now_seconds(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+static void test_sleep_us(long microseconds) {
+  struct timespec ts;
+  ts.tv_sec = 0;
+  ts.tv_nsec = microseconds * 1000L;
+  nanosleep(&ts, NULL);
+}
+
+/* Maps the object once the server has sized it and set ready. */
+static gmj_shm_header* test_attach(const char* name, pid_t server) {
+  const double deadline = test_now_seconds() + 30.0;
+  while (test_now_seconds() < deadline) {
+    struct stat st;
+    const int fd = shm_open(name, O_RDWR, 0);
+    if (fd >= 0) {
+      if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(gmj_shm_header)) {
+        gmj_shm_header* header = (gmj_shm_header*)mmap(
+            NULL, sizeof(gmj_shm_header), PROT_READ | PROT_WRITE, MAP_SHARED,
+            fd, 0);
+        if (header != MAP_FAILED &&
+            __atomic_load_n(&header->ready, __ATOMIC_SEQ_CST) != 0) {
+          const size_t total = (size_t)header->total_size;
+          munmap(header, sizeof(gmj_shm_header));
+          header = (gmj_shm_header*)mmap(NULL, total, PROT_READ | PROT_WRITE,
+                                         MAP_SHARED, fd, 0);
+          close(fd);
+          return header == MAP_FAILED ? NULL : header;
+        }
+        if (header != MAP_FAILED) {
+          munmap(header, sizeof(gmj_shm_header));
+        }
+      }
+      close(fd);
+    }
+    if (waitpid(server, NULL, WNOHANG) == server) {
+      return NULL;
+    }
+    test_sleep_us(1000);
+  }
+  return NULL;
+}
+
+static unsigned char* test_slot(gmj_shm_header* header, uint32_t n) {
+  return (unsigned char*)header + header->slot_offset +
+         header->slot_stride *
+             (uint64_t)(n & (uint32_t)(header->slot_count - 1));
+}
+
+/* Issues request n and waits for its answer; returns the status, or -1
+   when the server stopped or went quiet. */
+static int test_request(gmj_shm_header* header, uint32_t n, uint32_t kind,
+                        float action) {
+  unsigned char* slot = test_slot(header, n);
+  float* actions = (float*)(slot + header->act_offset);
+  const uint32_t target = n + 1u;
+  const double deadline = test_now_seconds() + 30.0;
+  int i = 0;
+
+  ((uint32_t*)slot)[0] = kind;
+  ((uint32_t*)slot)[1] = 0xFFFFFFFFu;
+  for (i = 0; i < header->env_count * header->act_dim; ++i) {
+    actions[i] = action;
+  }
+  __atomic_store_n(&header->request_seq, target, __ATOMIC_SEQ_CST);
+  if (__atomic_load_n(&header->server_waiting, __ATOMIC_SEQ_CST) != 0) {
+    syscall(SYS_futex, &header->request_seq, FUTEX_WAKE, 1, NULL, NULL, 0);
+  }
+  while ((int32_t)(__atomic_load_n(&header->response_seq, __ATOMIC_SEQ_CST) -
+                   target) < 0) {
+    if (__atomic_load_n(&header->stopped, __ATOMIC_SEQ_CST) != 0 ||
+        test_now_seconds() > deadline) {
+      return -1;
+    }
+    test_sleep_us(20);
+  }
+  return (int)((uint32_t*)slot)[1];
+}
+
+int main(int argc, char** argv) {
+  char dir[] = "/tmp/gmj_env_test_XXXXXX";
+  char model_path[64];
+  char name[64];
+  gmj_shm_header* header = NULL;
+  FILE* file = NULL;
+  pid_t server = -1;
+  uint32_t n = 0;
+  uint32_t first = 0;
+  int status = 0;
+  int i = 0;
+
+  if (argc != 2) {
+    fprintf(stderr, "usage: gmj_env_server_test PATH_TO_GMJ_ENV_SERVER\n");
+    return 2;
+  }
+  if (mkdtemp(dir) == NULL) {
+    perror("mkdtemp");
+    return 1;
+  }
+  snprintf(model_path, sizeof(model_path), "%s/model.xml", dir);
+  file = fopen(model_path, "w");
+  if (file == NULL || fputs(TEST_XML, file) < 0 || fclose(file) != 0) {
+    perror(model_path);
+    return 1;
+  }
+  snprintf(name, sizeof(name), "/gmj_env_test_%ld", (long)getpid());
+
+  server = fork();
+  if (server == 0) {
+    execl(argv[1], argv[1], "--model", model_path, "--name", name, "--envs",
+          "3", "--slots", "4", "--seed", "1", "--first-seq", TEST_FIRST_SEQ,
+          (char*)NULL);
+    perror("execl");
+    _exit(127);
+  }
+  CHECK(server > 0);
+
+  header = server > 0 ? test_attach(name, server) : NULL;
+  CHECK(header != NULL);
+  if (header != NULL) {
+    CHECK(header->magic == GMJ_SHM_MAGIC);
+    CHECK(header->version == GMJ_SHM_VERSION);
+    CHECK(header->env_count == TEST_ENVS);
+    CHECK(header->slot_count == TEST_SLOTS);
+    CHECK(header->act_dim == 2);
+    CHECK(header->obs_dim == 7 + 6);
+    CHECK(header->server_pid == server);
+    CHECK(header->stopped == 0);
+    first = __atomic_load_n(&header->response_seq, __ATOMIC_SEQ_CST);
+    CHECK(first == (uint32_t)strtoul(TEST_FIRST_SEQ, NULL, 0));
+    CHECK(header->request_seq == first);
+
+    n = first;
+    CHECK(test_request(header, n++, GMJ_SHM_RESET, 0.0f) == GMJ_SHM_OK);
+    for (i = 0; i < 12; ++i) {
+      CHECK(test_request(header, n++, GMJ_SHM_STEP, 1.0f) == GMJ_SHM_OK);
+    }
+    CHECK(n < first); /* wrapped */
+    {
+      const unsigned char* slot = test_slot(header, n - 1u);
+      const float* obs = (const float*)(slot + header->obs_offset);
+      const double* rewards = (const double*)(slot + header->reward_offset);
+      for (i = 0; i < TEST_ENVS; ++i) {
+        CHECK(obs[i * header->obs_dim] > 0.0f); /* pushed along +x */
+        CHECK(rewards[i] > 0.0);
+        CHECK(slot[header->done_offset + (uint64_t)i] == 0);
+      }
+    }
+
+    /* An unknown kind is answered and leaves the slot's arrays alone. */
+    {
+      const unsigned char* slot = test_slot(header, n);
+      float before = 0.0f;
+      memcpy(&before, slot + header->obs_offset, sizeof(before));
+      CHECK(test_request(header, n++, 7u, 0.0f) == GMJ_SHM_BAD_KIND);
+      CHECK(memcmp(&before, slot + header->obs_offset, sizeof(before)) == 0);
+    }
+    CHECK(test_request(header, n++, GMJ_SHM_RESET, 0.0f) == GMJ_SHM_OK);
+    {
+      const unsigned char* slot = test_slot(header, n - 1u);
+      const float* obs = (const float*)(slot + header->obs_offset);
+      CHECK(obs[0] == 0.0f && obs[2] == 1.0f);
+    }
+
+    CHECK(test_request(header, n++, GMJ_SHM_CLOSE, 0.0f) == GMJ_SHM_OK);
+    CHECK(waitpid(server, &status, 0) == server);
+    CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    CHECK(__atomic_load_n(&header->stopped, __ATOMIC_SEQ_CST) == 1);
+    CHECK(header->response_seq == n);
+    CHECK(shm_open(name, O_RDWR, 0) < 0 && errno == ENOENT);
+    munmap(header, (size_t)header->total_size);
+  } else if (server > 0) {
+    kill(server, SIGTERM);
+    waitpid(server, &status, 0);
+  }
+
+  unlink(model_path);
+  rmdir(dir);
+  printf("%d checks, %d failed\n", test_checks, test_failures);
+  return test_failures == 0 ? 0 : 1;
+}